@@ -11,7 +11,8 @@ DEFAULT_CONFIG = {
     "host": "192.168.1.100",
     "port": 8080,
     "password": "IoTDevice2024",
-    "window_geometry": "700x800"
+    "window_geometry": "700x800",
+    "telemetry_file": "telemetry.ests"
 }
 
 def load_config():
@@ -0,0 +1,84 @@
+"""
+Benchmark of PotentiometerGaugeWidget updates per second
+
+Sweeps the gauge through every value and lets Tk render after each update,
+the way telemetry drives it from the GUI. Compares moving the persistent
+indicator items against recreating them on every update, which is what the
+widget did before, and against redrawing the whole dial.
+
+Needs a display:  python gauge_bench.py [--updates N]
+"""
+
+import argparse
+import math
+import time
+import tkinter as tk
+
+from widgets import PotentiometerGaugeWidget
+
+
+def recreate_indicator(gauge, value):
+    """Previous set_value: delete the needle and value text and create them anew"""
+    gauge.value = max(0, min(100, value))
+    gauge.delete("indicator")
+    angle = math.radians(270 + (gauge.value / 100.0) * 360)
+    indicator_x = gauge.center_x + (gauge.radius - 20) * math.cos(angle)
+    indicator_y = gauge.center_y + (gauge.radius - 20) * math.sin(angle)
+    gauge.create_line(gauge.center_x, gauge.center_y, indicator_x, indicator_y,
+                      fill='red', width=4, tags='indicator')
+    gauge.create_oval(indicator_x - 4, indicator_y - 4, indicator_x + 4, indicator_y + 4,
+                      fill='red', outline='darkred', tags='indicator')
+    gauge.delete("value_text")
+    gauge.create_text(gauge.center_x, gauge.center_y + 30, text=f"{gauge.value}%",
+                      font=('Arial', 14, 'bold'), tags='value_text')
+
+
+def redraw_all(gauge, value):
+    gauge.value = max(0, min(100, value))
+    gauge.draw_gauge()
+
+
+def move_indicator(gauge, value):
+    gauge.set_value(value)
+
+
+def run(root, gauge, update, updates):
+    # Every update is a different value so the unchanged-value shortcut never hits
+    values = [(i + 1) % 101 for i in range(updates)]
+    gauge.set_value(0)
+    root.update()
+    start = time.perf_counter()
+    for value in values:
+        update(gauge, value)
+        root.update_idletasks()
+    elapsed = time.perf_counter() - start
+    return updates / elapsed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Gauge update benchmark")
+    parser.add_argument("--updates", type=int, default=5000)
+    args = parser.parse_args()
+
+    root = tk.Tk()
+    root.title("Gauge benchmark")
+    cases = [
+        ("redraw whole dial", redraw_all),
+        ("recreate indicator items", recreate_indicator),
+        ("move indicator items", move_indicator),
+    ]
+    results = []
+    for name, update in cases:
+        # A fresh gauge per case so deleted items do not skew the next one
+        gauge = PotentiometerGaugeWidget(root, width=220, height=220)
+        gauge.pack()
+        results.append((name, run(root, gauge, update, args.updates)))
+        gauge.destroy()
+    root.destroy()
+
+    for name, rate in results:
+        print(f"{name:<26} {rate:10.0f} updates/s")
+
+
+if __name__ == "__main__":
+    main()
@@ -4,12 +4,23 @@ Main GUI for ESP32 IoT Control System
 
 import tkinter as tk
 from tkinter import ttk, messagebox
+import os
+import threading
 import time
 
-from connection import ESP32Client
-from widgets import PotentiometerGaugeWidget
+from connection import ESP32Client, HistoryBackfill, TimeSeriesStore
+from widgets import PotentiometerGaugeWidget, TimeSeriesPlotWidget
 from config import load_config, save_config
 
+# Status is shown at display rate, however fast the ESP32 sends it
+STATUS_DISPLAY_INTERVAL_MS = 33
+
+# Lines kept in the status log
+LOG_MAX_LINES = 500
+
+# How often an open history window takes in new telemetry
+HISTORY_REFRESH_MS = 1000
+
 class ESP32GUI:
     def __init__(self, root):
         self.root = root
@@ -26,6 +37,18 @@ class ESP32GUI:
         self.current_servo_angle = 90
         self.updating_servo_controls = False
 
+        # Latest status from the client thread, taken by _drain_status()
+        self.status_lock = threading.Lock()
+        self.pending_status = None
+        # Text and colors the status widgets show, so unchanged ones are skipped
+        self.shown = {}
+
+        # Every status received, kept across sessions for the history plot
+        self.telemetry = self.load_telemetry()
+        # Fills the telemetry gaps of disconnects from what the ESP32 recorded meanwhile
+        self.backfill = HistoryBackfill(self.telemetry)
+        self.backfill.register_callback(self.on_history_backfill)
+
         # Create all GUI panels
         self.create_connection_panel()
         self.create_led_control_panel()
@@ -34,6 +57,8 @@ class ESP32GUI:
         self.create_button_panel()
         self.create_status_panel()
 
+        self.root.after(STATUS_DISPLAY_INTERVAL_MS, self._drain_status)
+
     def create_connection_panel(self):
         """Create connection control panel"""
         conn_frame = ttk.Frame(self.root)
@@ -215,6 +240,7 @@ class ESP32GUI:
         ttk.Button(control_frame, text="Get Status", command=self.request_status).pack(side="left", padx=5)
         ttk.Button(control_frame, text="Clear Log", command=self.clear_status).pack(side="left", padx=5)
         ttk.Button(control_frame, text="Ping", command=self.ping_server).pack(side="left", padx=5)
+        ttk.Button(control_frame, text="History", command=self.show_history).pack(side="left", padx=5)
 
     def connect_to_esp32(self):
         """Connect to ESP32 device"""
@@ -242,6 +268,8 @@ class ESP32GUI:
         # Register callbacks
         self.client.register_connection_callback(self.on_connection_event)
         self.client.register_status_callback(self.on_status_update)
+        self.telemetry.attach(self.client)
+        self.backfill.attach(self.client)
         
         if self.client.connect():
             if self.client.authenticate():
@@ -257,6 +285,9 @@ class ESP32GUI:
                 # Request initial status
                 self.client.get_status()
                 
+                # And the telemetry the ESP32 recorded while disconnected
+                self.client.subscribe_history(self.backfill.begin())
+                
                 self.log_message(f"Connected to ESP32 at {host}:{port}")
             else:
                 self.client.close()
@@ -292,18 +323,46 @@ class ESP32GUI:
             if message:
                 self.log_message(message)
 
+    def on_history_backfill(self, inserted, dropped):
+        """Log what a history message added to the telemetry (client thread)"""
+        if dropped:
+            self.root.after(0, self.log_message,
+                            f"History: {inserted} samples backfilled, {dropped} outside the gap skipped")
+
     def on_status_update(self, status):
-        """Handle status updates from ESP32"""
-        self.root.after(0, self._update_gui_from_status, status)
+        """Handle status updates from ESP32 (client thread)
+
+        Only the latest status is kept; statuses replaced before the next
+        display tick would never have been visible anyway.
+        """
+        with self.status_lock:
+            self.pending_status = status
+
+    def _drain_status(self):
+        """Show the latest status, once per display interval (runs in main thread)"""
+        with self.status_lock:
+            status, self.pending_status = self.pending_status, None
+        if status is not None:
+            self._update_gui_from_status(status)
+        self.root.after(STATUS_DISPLAY_INTERVAL_MS, self._drain_status)
+
+    def _changed(self, key, value):
+        """Whether the widget behind key shows something other than value, remembering value"""
+        if self.shown.get(key) == value:
+            return False
+        self.shown[key] = value
+        return True
 
     def _update_gui_from_status(self, status):
-        """Update GUI elements based on received status (runs in main thread)"""
+        """Update GUI elements that differ from the received status (runs in main thread)"""
         try:
-            # Update LED states
+            # Update LED states, compared with the variables since clicks change them too
             if "leds" in status:
                 for i, led in enumerate(status["leds"]):
                     if i < len(self.led_vars):
-                        self.led_vars[i].set(led.get("state", False))
+                        state = bool(led.get("state", False))
+                        if self.led_vars[i].get() != state:
+                            self.led_vars[i].set(state)
 
             # Update potentiometer display
             if "potentiometer" in status:
@@ -311,21 +370,29 @@ class ESP32GUI:
                 
                 # Update gauge
                 percent = pot_data.get("percent", 0)
-                self.pot_gauge.set_value(percent)
+                if self._changed("pot_gauge", percent):
+                    self.pot_gauge.set_value(percent)
                 
                 # Update labels
-                self.pot_raw_label.config(text=f"Raw Value: {pot_data.get('raw', '--')}")
-                self.pot_voltage_label.config(text=f"Voltage: {pot_data.get('voltage', '--'):.2f}V")
-                self.pot_percent_label.config(text=f"Percentage: {percent}%")
+                raw_text = f"Raw Value: {pot_data.get('raw', '--')}"
+                if self._changed("pot_raw", raw_text):
+                    self.pot_raw_label.config(text=raw_text)
+                voltage_text = f"Voltage: {pot_data.get('voltage', '--'):.2f}V"
+                if self._changed("pot_voltage", voltage_text):
+                    self.pot_voltage_label.config(text=voltage_text)
+                percent_text = f"Percentage: {percent}%"
+                if self._changed("pot_percent", percent_text):
+                    self.pot_percent_label.config(text=percent_text)
 
             # Update servo angle
             if "servo" in status:
                 angle = status["servo"].get("angle", 90)
                 self.current_servo_angle = angle
-                self.servo_angle_label.config(text=f"Current Angle: {angle}°")
+                if self._changed("servo_angle", angle):
+                    self.servo_angle_label.config(text=f"Current Angle: {angle}°")
                 
                 # Update servo controls (but don't trigger callbacks)
-                if not self.updating_servo_controls:
+                if not self.updating_servo_controls and self.servo_var.get() != angle:
                     self.updating_servo_controls = True
                     self.servo_var.set(angle)
                     self.servo_value_label.config(text=f"{angle}°")
@@ -336,6 +403,8 @@ class ESP32GUI:
                 for i, btn in enumerate(status["buttons"]):
                     if i < len(self.button_labels):
                         pressed = btn.get("pressed", False)
+                        if not self._changed(f"button{i}", pressed):
+                            continue
                         state_text = "Pressed" if pressed else "Released"
                         color = "lightcoral" if pressed else "lightgreen"
                         self.button_labels[i].config(
@@ -354,6 +423,7 @@ class ESP32GUI:
 
         state = self.led_vars[led_number-1].get()
         self.client.control_led(led_number, state)
+        self.client.get_status()
         self.log_message(f"LED {led_number} {'ON' if state else 'OFF'}")
 
     def control_all_leds(self, state):
@@ -363,6 +433,7 @@ class ESP32GUI:
             return
 
         self.client.control_all_leds(state)
+        self.client.get_status()
         self.log_message(f"All LEDs {'ON' if state else 'OFF'}")
 
     def trigger_led_sequence(self):
@@ -394,6 +465,7 @@ class ESP32GUI:
         self.updating_servo_controls = False
 
         self.client.control_servo(angle)
+        self.client.get_status()
         self.log_message(f"Servo set to {angle}° (manual override)")
 
     def request_status(self):
@@ -422,13 +494,59 @@ class ESP32GUI:
         """Add a message to the status log"""
         timestamp = time.strftime("%H:%M:%S")
         self.status_text.insert(tk.END, f"[{timestamp}] {message}\n")
+        # Keep the last LOG_MAX_LINES lines, the Text widget slows down as it grows
+        lines = int(self.status_text.index("end-1c").split(".")[0]) - 1
+        if lines > LOG_MAX_LINES:
+            self.status_text.delete("1.0", f"{lines - LOG_MAX_LINES + 1}.0")
         self.status_text.see(tk.END)
 
+    def load_telemetry(self):
+        """Load the recorded telemetry, or start a new recording"""
+        path = self.config.get("telemetry_file", "telemetry.ests")
+        if os.path.exists(path):
+            try:
+                return TimeSeriesStore.load(path)
+            except (OSError, ValueError) as e:
+                print(f"Could not load telemetry from {path}: {e}")
+        return TimeSeriesStore()
+
+    def show_history(self):
+        """Open a window plotting the recorded telemetry"""
+        window = tk.Toplevel(self.root)
+        window.title("Telemetry History")
+        
+        signals = self.telemetry.signals() or ["potentiometer.percent"]
+        signal_var = tk.StringVar(value="potentiometer.percent" if "potentiometer.percent" in signals else signals[0])
+        combo = ttk.Combobox(window, textvariable=signal_var, values=signals, state="readonly", width=30,
+                             postcommand=lambda: combo.configure(values=self.telemetry.signals()))
+        combo.pack(pady=5)
+        
+        plot = TimeSeriesPlotWidget(window, self.telemetry, signal_var.get(), width=640, height=260)
+        plot.pack(padx=10, pady=5)
+        ttk.Label(window, text="Mouse wheel zooms, dragging pans", font=('Arial', 9)).pack(pady=5)
+        
+        def select_signal(*args):
+            plot.signal = signal_var.get()
+            plot.refresh()
+        signal_var.trace_add("write", select_signal)
+        
+        def refresh():
+            if plot.winfo_exists():
+                plot.refresh()
+                window.after(HISTORY_REFRESH_MS, refresh)
+        refresh()
+
     def on_closing(self):
         """Handle application closing"""
         if self.connected:
             self.disconnect_from_esp32()
         
+        # Keep the telemetry for the next session
+        try:
+            self.telemetry.save(self.config.get("telemetry_file", "telemetry.ests"))
+        except OSError as e:
+            print(f"Could not save telemetry: {e}")
+        
         # Save window geometry
         self.config["window_geometry"] = self.root.geometry()
         save_config(self.config)
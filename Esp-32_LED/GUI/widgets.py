@@ -4,6 +4,7 @@ Custom widgets for ESP32 IoT Control System
 
 import tkinter as tk
 import math
+import time
 
 class PotentiometerGaugeWidget(tk.Canvas):
     """Custom widget for potentiometer visualization with circular gauge"""
@@ -20,7 +21,11 @@ class PotentiometerGaugeWidget(tk.Canvas):
         self.draw_gauge()
     
     def draw_gauge(self):
-        """Draw the gauge background and markings"""
+        """Draw the gauge background and markings, and create the indicator items
+
+        Called once; value changes only move the indicator, so the dial with
+        its markings and labels is never redrawn.
+        """
         self.delete("all")
         
         # Draw outer circle
@@ -54,7 +59,8 @@ class PotentiometerGaugeWidget(tk.Canvas):
             self.create_text(label_x, label_y, text=f"{percent}%", font=('Arial', 8))
         
         # Draw value indicator
-        self.draw_indicator()
+        self.create_line(0, 0, 0, 0, fill='red', width=4, tags=('indicator', 'needle'))
+        self.create_oval(0, 0, 0, 0, fill='red', outline='darkred', tags=('indicator', 'needle_dot'))
         
         # Draw center circle
         self.create_oval(
@@ -66,41 +72,128 @@ class PotentiometerGaugeWidget(tk.Canvas):
         # Draw current value text
         self.create_text(
             self.center_x, self.center_y + 30,
-            text=f"{self.value}%", font=('Arial', 14, 'bold'),
+            text="", font=('Arial', 14, 'bold'),
             tags='value_text'
         )
+        self.draw_indicator()
     
     def draw_indicator(self):
-        """Draw the indicator needle based on current value"""
+        """Move the indicator needle and value text to the current value"""
         # Calculate angle based on percentage (0% = top, 100% = full circle)
         angle = math.radians(270 + (self.value / 100.0) * 360)
         
         indicator_x = self.center_x + (self.radius - 20) * math.cos(angle)
         indicator_y = self.center_y + (self.radius - 20) * math.sin(angle)
         
-        self.delete('indicator')
-        
-        # Draw indicator line
-        self.create_line(
-            self.center_x, self.center_y, indicator_x, indicator_y,
-            fill='red', width=4, tags='indicator'
-        )
-        
-        # Draw indicator dot
-        self.create_oval(
-            indicator_x - 4, indicator_y - 4, indicator_x + 4, indicator_y + 4,
-            fill='red', outline='darkred', tags='indicator'
-        )
+        # The items already exist, only their geometry and text change
+        self.coords('needle', self.center_x, self.center_y, indicator_x, indicator_y)
+        self.coords('needle_dot', indicator_x - 4, indicator_y - 4, indicator_x + 4, indicator_y + 4)
+        self.itemconfigure('value_text', text=f"{self.value}%")
     
     def set_value(self, value):
-        """Set percentage value and redraw indicator"""
-        self.value = max(0, min(100, value))
+        """Set percentage value and move the indicator"""
+        value = max(0, min(100, value))
+        if value == self.value:
+            return
+        self.value = value
         self.draw_indicator()
+
+class TimeSeriesPlotWidget(tk.Canvas):
+    """Zoomable plot of one signal of a TimeSeriesStore
+
+    Shows the min/max band and the mean of the finest level the store has
+    for the visible span, about one point per pixel. Mouse wheel zooms,
+    dragging pans; the plot follows the newest data until panned back.
+    """
+    
+    MIN_SPAN = 10.0
+    
+    def __init__(self, parent, store, signal, width=600, height=250, span=600.0):
+        super().__init__(parent, width=width, height=height, bg='white', highlightthickness=1)
+        self.store = store
+        self.signal = signal
+        self.width = width
+        self.height = height
+        self.margin = 40
+        self.span = span
+        self.end = None  # Newest sample when None
+        self.drag_x = None
         
-        # Update text
-        self.delete('value_text')
-        self.create_text(
-            self.center_x, self.center_y + 30,
-            text=f"{self.value}%", font=('Arial', 14, 'bold'),
-            tags='value_text'
-        )
\ No newline at end of file
+        # Plot items are created once and moved by refresh()
+        self.create_rectangle(self.margin, 10, width - 10, height - 25, outline='lightgray')
+        self.band = self.create_polygon(0, 0, 0, 0, 0, 0, fill='lightblue', outline='', state='hidden')
+        self.line = self.create_line(0, 0, 0, 0, fill='darkblue', width=1, state='hidden')
+        self.top_label = self.create_text(self.margin - 4, 10, anchor='ne', font=('Arial', 8))
+        self.bottom_label = self.create_text(self.margin - 4, height - 25, anchor='ne', font=('Arial', 8))
+        self.span_label = self.create_text(width - 10, height - 8, anchor='e', font=('Arial', 8))
+        
+        self.bind("<MouseWheel>", lambda e: self.zoom(0.8 if e.delta > 0 else 1.25))
+        self.bind("<Button-4>", lambda e: self.zoom(0.8))
+        self.bind("<Button-5>", lambda e: self.zoom(1.25))
+        self.bind("<ButtonPress-1>", self.on_press)
+        self.bind("<B1-Motion>", self.on_drag)
+    
+    def zoom(self, factor):
+        """Scale the visible span around its end"""
+        self.span = max(self.MIN_SPAN, self.span * factor)
+        self.refresh()
+    
+    def on_press(self, event):
+        self.drag_x = event.x
+    
+    def on_drag(self, event):
+        """Pan, back to following the newest data once dragged past it"""
+        time_range = self.store.time_range(self.signal)
+        if time_range is None or self.drag_x is None:
+            return
+        plot_width = self.width - self.margin - 10
+        end = (self.end or time_range[1]) - (event.x - self.drag_x) * self.span / plot_width
+        self.drag_x = event.x
+        self.end = None if end >= time_range[1] else max(end, time_range[0] + self.span)
+        self.refresh()
+    
+    def refresh(self):
+        """Redraw the visible span from the store"""
+        time_range = self.store.time_range(self.signal)
+        if time_range is None:
+            self.itemconfigure(self.band, state='hidden')
+            self.itemconfigure(self.line, state='hidden')
+            return
+        end = self.end or time_range[1]
+        start = end - self.span
+        left, right = self.margin, self.width - 10
+        top, bottom = 10, self.height - 25
+        series = self.store.query(self.signal, start, end, max_points=right - left)
+        if len(series.times) < 2:
+            self.itemconfigure(self.band, state='hidden')
+            self.itemconfigure(self.line, state='hidden')
+            return
+        
+        low, high = min(series.mins), max(series.maxs)
+        if high == low:
+            low, high = low - 1, high + 1
+        x_scale = (right - left) / self.span
+        y_scale = (bottom - top) / (high - low)
+        xs = [left + (t - start) * x_scale for t in series.times]
+        
+        line = []
+        for x, value in zip(xs, series.means):
+            line += (x, bottom - (value - low) * y_scale)
+        upper = []
+        for x, value in zip(xs, series.maxs):
+            upper += (x, bottom - (value - low) * y_scale)
+        lower = []
+        for x, value in zip(reversed(xs), reversed(series.mins)):
+            lower += (x, bottom - (value - low) * y_scale)
+        
+        self.coords(self.line, line)
+        self.coords(self.band, upper + lower)
+        self.itemconfigure(self.line, state='normal')
+        self.itemconfigure(self.band, state='normal')
+        self.itemconfigure(self.top_label, text=f"{high:g}")
+        self.itemconfigure(self.bottom_label, text=f"{low:g}")
+        if self.end is None:
+            span_text = f"{self.signal}, last {self.span / 60:.1f} min"
+        else:
+            span_text = f"{self.signal}, {self.span / 60:.1f} min to {time.strftime('%H:%M:%S', time.localtime(end))}"
+        self.itemconfigure(self.span_label, text=span_text)
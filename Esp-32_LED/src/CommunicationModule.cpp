@@ -1,10 +1,13 @@
 #include "CommunicationModule.h"
+#include <base64.h>
 
-CommunicationModule::CommunicationModule(HardwareModule* hw) 
-    : server(SERVER_PORT), hardware(hw) {
+CommunicationModule::CommunicationModule(HardwareModule* hw, TelemetryModule* tm) 
+    : server(SERVER_PORT), hardware(hw), telemetry(tm) {
     activeClients = 0;
     lastUpdate = 0;
     lastStatusPrint = 0;
+    lastHistorySend = 0;
+    nextHistoryClient = 0;
     
     // Initialize client array
     for (int i = 0; i < MAX_CLIENTS; i++) {
@@ -12,6 +15,8 @@ CommunicationModule::CommunicationModule(HardwareModule* hw)
         clients[i].active = false;
         clients[i].lastHeartbeat = 0;
         clients[i].clientId = "";
+        clients[i].historySubscribed = false;
+        clients[i].historySequence = 0;
     }
 }
 
@@ -48,6 +53,7 @@ void CommunicationModule::init() {
 void CommunicationModule::update() {
     handleNewClients();
     handleClientMessages();
+    sendHistory();
     
     // Send periodic updates
     if (millis() - lastUpdate > UPDATE_INTERVAL) {
@@ -73,6 +79,7 @@ void CommunicationModule::handleNewClients() {
             clients[slot].authenticated = false;
             clients[slot].lastHeartbeat = millis();
             clients[slot].clientId = "Client_" + String(slot + 1);
+            clients[slot].historySubscribed = false;
             activeClients++;
             
             Serial.printf("[COMM] New client connected: %s (Slot %d)\n", 
@@ -114,6 +121,46 @@ void CommunicationModule::sendDataToClients() {
     }
 }
 
+void CommunicationModule::sendHistory() {
+    if (millis() - lastHistorySend < HISTORY_INTERVAL) {
+        return;
+    }
+    
+    // History is low priority: it waits while any client has a command pending
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clients[i].active && clients[i].client.connected() && clients[i].client.available()) {
+            return;
+        }
+    }
+    
+    // One block per call, taking turns between subscribed clients
+    for (int n = 0; n < MAX_CLIENTS; n++) {
+        int i = (nextHistoryClient + n) % MAX_CLIENTS;
+        if (!clients[i].active || !clients[i].authenticated || !clients[i].historySubscribed) {
+            continue;
+        }
+        nextHistoryClient = (i + 1) % MAX_CLIENTS;
+        lastHistorySend = millis();
+        
+        // Blocks overwritten since the subscription are lost
+        if (clients[i].historySequence < telemetry->oldestSequence()) {
+            clients[i].historySequence = telemetry->oldestSequence();
+        }
+        bool last = clients[i].historySequence >= telemetry->newestSequence();
+        const TelemetryBlock* block = telemetry->getBlock(clients[i].historySequence);
+        if (block != nullptr && (block->count > 0 || last)) {
+            sendResponse(i, createHistoryJson(*block, last));
+        }
+        if (last) {
+            clients[i].historySubscribed = false;
+            Serial.printf("[COMM] History sent to %s\n", clients[i].clientId.c_str());
+        } else {
+            clients[i].historySequence++;
+        }
+        return;
+    }
+}
+
 void CommunicationModule::removeInactiveClients() {
     for (int i = 0; i < MAX_CLIENTS; i++) {
         if (clients[i].active) {
@@ -194,6 +241,15 @@ void CommunicationModule::processClientMessage(int clientIndex, String message)
     else if (command == "get_status") {
         sendResponse(clientIndex, createStatusJson());
     }
+    else if (command == "subscribe_history") {
+        // Backfill of the telemetry recorded after since (millis() of the board), 0 for all
+        uint32_t since = jsonDoc["since"] | 0UL;
+        uint32_t first = since == 0 ? telemetry->oldestSequence() : telemetry->firstSequenceAfter(since);
+        clients[clientIndex].historySequence = first;
+        clients[clientIndex].historySubscribed = true;
+        sendResponse(clientIndex, createResponseJson("success", 
+                    "Sending " + String(telemetry->newestSequence() - first + 1) + " history blocks"));
+    }
     else if (command == "ping") {
         sendResponse(clientIndex, createResponseJson("success", "pong"));
     }
@@ -265,6 +321,23 @@ String CommunicationModule::createResponseJson(const String& status, const Strin
     return String(jsonBuffer);
 }
 
+// Written by hand, the base64 data does not fit jsonBuffer
+String CommunicationModule::createHistoryJson(const TelemetryBlock& block, bool last) {
+    String json = "{\"type\":\"history\",\"seq\":" + String(block.sequence) +
+                  ",\"t0\":" + String(block.firstTime) +
+                  ",\"count\":" + String(block.count) +
+                  ",\"last\":" + (last ? "true" : "false") +
+                  ",\"channels\":[";
+    for (int i = 0; i < TelemetryModule::CHANNELS; i++) {
+        if (i > 0) {
+            json += ",";
+        }
+        json += "\"" + String(TelemetryModule::CHANNEL_NAMES[i]) + "\"";
+    }
+    json += "],\"data\":\"" + base64::encode(block.data, (block.bits + 7) / 8) + "\"}";
+    return json;
+}
+
 void CommunicationModule::printServerStatus() {
     Serial.println("\n=== Server Status ===");
     Serial.printf("Active Clients: %d/%d\n", activeClients, MAX_CLIENTS);
@@ -296,6 +369,7 @@ void CommunicationModule::closeClient(int clientIndex) {
         clients[clientIndex].client.stop();
         clients[clientIndex].active = false;
         clients[clientIndex].authenticated = false;
+        clients[clientIndex].historySubscribed = false;
         clients[clientIndex].clientId = "";
         activeClients--;
     }
@@ -5,6 +5,7 @@
 #include <WiFiServer.h>
 #include <ArduinoJson.h>
 #include "HardwareModule.h"
+#include "TelemetryModule.h"
 
 struct ClientInfo {
     WiFiClient client;           // TCP client connection
@@ -12,6 +13,8 @@ struct ClientInfo {
     unsigned long lastHeartbeat; // Last activity timestamp
     String clientId;            // Unique client identifier
     bool active;                // Connection status
+    bool historySubscribed;     // Backfill of recorded telemetry pending
+    uint32_t historySequence;   // Next telemetry block to send
 };
 
 class CommunicationModule {
@@ -27,24 +30,28 @@ private:
     static const int MAX_CLIENTS = 5;
     static const unsigned long HEARTBEAT_TIMEOUT = 300000; // 300 seconds
     static const unsigned long UPDATE_INTERVAL = 1000;    // 1 second
+    static const unsigned long HISTORY_INTERVAL = 20;     // At most one history block per 20ms
     
     // Client Management
     ClientInfo clients[MAX_CLIENTS];
     int activeClients;
     
-    // Hardware Reference
+    // Hardware and Telemetry References
     HardwareModule* hardware;
+    TelemetryModule* telemetry;
     
     // Timing
     unsigned long lastUpdate;
     unsigned long lastStatusPrint;
+    unsigned long lastHistorySend;
+    int nextHistoryClient;
     
     // JSON Documents
     StaticJsonDocument<1024> jsonDoc;
     char jsonBuffer[1024];
     
 public:
-    CommunicationModule(HardwareModule* hw);
+    CommunicationModule(HardwareModule* hw, TelemetryModule* tm);
     void init();
     void update();
     
@@ -54,6 +61,7 @@ private:
     void handleClientMessages();
     void sendDataToClients();
     void removeInactiveClients();
+    void sendHistory();
 
     // Message processing functions
     void processClientMessage(int clientIndex, String message);
@@ -67,6 +75,7 @@ private:
     // JSON helper functions
     String createStatusJson();
     String createResponseJson(const String& status, const String& message);
+    String createHistoryJson(const TelemetryBlock& block, bool last);
     void printServerStatus();
     int findFreeClientSlot();
     void closeClient(int clientIndex);
@@ -0,0 +1,196 @@
+#include "TelemetryModule.h"
+
+const char* const TelemetryModule::CHANNEL_NAMES[TelemetryModule::CHANNELS] = {
+    "potentiometer.raw", "potentiometer.percent", "servo.angle",
+    "leds.1.state", "leds.2.state", "leds.3.state", "leds.4.state", "leds.5.state",
+    "buttons.1.pressed", "buttons.2.pressed", "buttons.3.pressed", "buttons.4.pressed", "buttons.5.pressed"
+};
+
+TelemetryModule::TelemetryModule(HardwareModule* hw) : hardware(hw) {
+    blocks = nullptr;
+    blockCount = 0;
+    currentSequence = 0;
+    lastSample = 0;
+    previousTime = 0;
+    previousDelta = 0;
+}
+
+void TelemetryModule::init() {
+    Serial.println("[TELEM] Initializing Telemetry Module...");
+
+    // PSRAM holds a much longer history, internal RAM is shared with WiFi
+    if (psramFound()) {
+        blocks = (TelemetryBlock*)ps_malloc(PSRAM_BLOCKS * sizeof(TelemetryBlock));
+        blockCount = PSRAM_BLOCKS;
+    }
+    if (blocks == nullptr) {
+        blocks = (TelemetryBlock*)malloc(RAM_BLOCKS * sizeof(TelemetryBlock));
+        blockCount = RAM_BLOCKS;
+    }
+    if (blocks == nullptr) {
+        blockCount = 0;
+        Serial.println("[TELEM] Not enough memory, telemetry history disabled");
+        return;
+    }
+
+    blocks[0].sequence = 0;
+    blocks[0].count = 0;
+    blocks[0].bits = 0;
+    Serial.printf("[TELEM] Recording %d channels every %lums into %d KB\n",
+                 CHANNELS, SAMPLE_INTERVAL, blockCount * TelemetryBlock::DATA_BYTES / 1024);
+}
+
+void TelemetryModule::update() {
+    if (millis() - lastSample < SAMPLE_INTERVAL) {
+        return;
+    }
+    lastSample = millis();
+
+    float values[CHANNELS];
+    values[0] = hardware->getAnalogValue();
+    values[1] = hardware->getAnalogPercent();
+    values[2] = hardware->getServoAngle();
+    for (int i = 0; i < 5; i++) {
+        values[3 + i] = hardware->getLEDState(i) ? 1 : 0;
+        values[8 + i] = hardware->getButtonState(i) ? 1 : 0;
+    }
+    record(lastSample, values);
+}
+
+void TelemetryModule::record(uint32_t time, const float* values) {
+    if (blockCount == 0) {
+        return;
+    }
+
+    uint32_t bits[CHANNELS];
+    memcpy(bits, values, sizeof(bits));
+
+    TelemetryBlock& block = currentBlock();
+    if (block.count == 0) {
+        startBlock(time, bits);
+        return;
+    }
+    if (block.bits + MAX_SAMPLE_BITS > TelemetryBlock::DATA_BYTES * 8 || block.count == 0xFFFF) {
+        // Full, continue in the next block and overwrite the oldest one
+        currentSequence++;
+        startBlock(time, bits);
+        return;
+    }
+
+    encodeTime(time);
+    for (int i = 0; i < CHANNELS; i++) {
+        encodeValue(i, bits[i]);
+    }
+    block.count++;
+    block.lastTime = time;
+}
+
+uint32_t TelemetryModule::oldestSequence() {
+    return currentSequence >= (uint32_t)blockCount ? currentSequence - blockCount + 1 : 0;
+}
+
+uint32_t TelemetryModule::newestSequence() {
+    return currentSequence;
+}
+
+uint32_t TelemetryModule::firstSequenceAfter(uint32_t time) {
+    for (uint32_t sequence = oldestSequence(); sequence < currentSequence; sequence++) {
+        // Wrap safe comparison of millis() values
+        if ((int32_t)(blocks[sequence % blockCount].lastTime - time) > 0) {
+            return sequence;
+        }
+    }
+    return currentSequence;
+}
+
+const TelemetryBlock* TelemetryModule::getBlock(uint32_t sequence) {
+    if (blockCount == 0 || sequence < oldestSequence() || sequence > currentSequence) {
+        return nullptr;
+    }
+    return &blocks[sequence % blockCount];
+}
+
+TelemetryBlock& TelemetryModule::currentBlock() {
+    return blocks[currentSequence % blockCount];
+}
+
+void TelemetryModule::startBlock(uint32_t time, const uint32_t* values) {
+    TelemetryBlock& block = currentBlock();
+    memset(block.data, 0, sizeof(block.data));
+    block.sequence = currentSequence;
+    block.firstTime = time;
+    block.lastTime = time;
+    block.count = 1;
+    block.bits = 0;
+
+    // The first sample is stored as is, the time in the header
+    previousTime = time;
+    previousDelta = 0;
+    for (int i = 0; i < CHANNELS; i++) {
+        writeBits(values[i], 32);
+        previousValues[i] = values[i];
+        previousLeading[i] = NO_WINDOW;
+        previousTrailing[i] = 0;
+    }
+}
+
+void TelemetryModule::writeBits(uint32_t value, int count) {
+    TelemetryBlock& block = currentBlock();
+    for (int i = count - 1; i >= 0; i--) {
+        if ((value >> i) & 1) {
+            block.data[block.bits >> 3] |= 0x80 >> (block.bits & 7);
+        }
+        block.bits++;
+    }
+}
+
+void TelemetryModule::encodeTime(uint32_t time) {
+    int32_t delta = (int32_t)(time - previousTime);
+    int32_t deltaOfDelta = delta - previousDelta;
+    previousTime = time;
+    previousDelta = delta;
+
+    if (deltaOfDelta == 0) {
+        writeBits(0b0, 1);
+    } else if (deltaOfDelta >= -63 && deltaOfDelta <= 64) {
+        writeBits(0b10, 2);
+        writeBits(deltaOfDelta + 63, 7);
+    } else if (deltaOfDelta >= -255 && deltaOfDelta <= 256) {
+        writeBits(0b110, 3);
+        writeBits(deltaOfDelta + 255, 9);
+    } else if (deltaOfDelta >= -2047 && deltaOfDelta <= 2048) {
+        writeBits(0b1110, 4);
+        writeBits(deltaOfDelta + 2047, 12);
+    } else {
+        writeBits(0b1111, 4);
+        writeBits((uint32_t)deltaOfDelta, 32);
+    }
+}
+
+void TelemetryModule::encodeValue(int channel, uint32_t value) {
+    uint32_t x = value ^ previousValues[channel];
+    previousValues[channel] = value;
+
+    if (x == 0) {
+        writeBits(0b0, 1);
+        return;
+    }
+
+    int leading = __builtin_clz(x);
+    int trailing = __builtin_ctz(x);
+    if (previousLeading[channel] != NO_WINDOW &&
+        leading >= previousLeading[channel] && trailing >= previousTrailing[channel]) {
+        // Fits the meaningful bits of the previous value
+        writeBits(0b10, 2);
+        writeBits(x >> previousTrailing[channel], 32 - previousLeading[channel] - previousTrailing[channel]);
+        return;
+    }
+
+    int length = 32 - leading - trailing;
+    writeBits(0b11, 2);
+    writeBits(leading, 5);
+    writeBits(length - 1, 5);
+    writeBits(x >> trailing, length);
+    previousLeading[channel] = leading;
+    previousTrailing[channel] = trailing;
+}
@@ -0,0 +1,72 @@
+#ifndef TELEMETRY_MODULE_H
+#define TELEMETRY_MODULE_H
+
+#include <Arduino.h>
+#include "HardwareModule.h"
+
+// Block of compressed telemetry samples. Timestamps are stored as delta of
+// delta and values as the XOR with the previous value (Gorilla encoding),
+// so a sample where nothing changed takes a few bits.
+struct TelemetryBlock {
+    static const int DATA_BYTES = 1024;
+
+    uint32_t sequence;           // Increases by one per block
+    uint32_t firstTime;          // millis() of the first sample
+    uint32_t lastTime;           // millis() of the last sample
+    uint16_t count;              // Number of samples
+    uint16_t bits;               // Bits of data used
+    uint8_t data[DATA_BYTES];
+};
+
+class TelemetryModule {
+public:
+    static const int CHANNELS = 13;
+    static const char* const CHANNEL_NAMES[CHANNELS];
+
+private:
+    static const unsigned long SAMPLE_INTERVAL = 250;  // 4 samples per second
+    static const int RAM_BLOCKS = 32;                  // 32 KB of RAM, about 20 minutes
+    static const int PSRAM_BLOCKS = 1024;              // 1 MB when the board has PSRAM
+    // Longest possible encoding of one sample
+    static const int MAX_SAMPLE_BITS = 4 + 32 + CHANNELS * (2 + 5 + 5 + 32);
+    static const uint8_t NO_WINDOW = 0xFF;
+
+    // Hardware Reference
+    HardwareModule* hardware;
+
+    // Ring of blocks, the oldest one is overwritten when it is full
+    TelemetryBlock* blocks;
+    int blockCount;
+    uint32_t currentSequence;    // Block being written
+    unsigned long lastSample;
+
+    // Encoder state of the block being written
+    uint32_t previousTime;
+    int32_t previousDelta;
+    uint32_t previousValues[CHANNELS];
+    uint8_t previousLeading[CHANNELS];
+    uint8_t previousTrailing[CHANNELS];
+
+public:
+    TelemetryModule(HardwareModule* hw);
+    void init();
+    void update();
+
+    // Add one sample, values in CHANNEL_NAMES order
+    void record(uint32_t time, const float* values);
+
+    // Blocks for backfill, by sequence number
+    uint32_t oldestSequence();
+    uint32_t newestSequence();                    // The block still being written
+    uint32_t firstSequenceAfter(uint32_t time);   // Oldest block with samples newer than time
+    const TelemetryBlock* getBlock(uint32_t sequence);  // nullptr when overwritten
+
+private:
+    TelemetryBlock& currentBlock();
+    void startBlock(uint32_t time, const uint32_t* values);
+    void writeBits(uint32_t value, int count);
+    void encodeTime(uint32_t time);
+    void encodeValue(int channel, uint32_t value);
+};
+
+#endif
@@ -8,6 +8,7 @@
  * - WiFi Station mode (connects to router)
  * - TCP Socket server with JSON communication
  * - Multi-client support with authentication
+ * - Telemetry history recorded on the board, backfilled after disconnects
  * - Modular design (separate .h and .cpp files)
  * 
  * Network Configuration:
@@ -31,14 +32,18 @@
  * - HardwareModule.cpp
  * - CommunicationModule.h
  * - CommunicationModule.cpp
+ * - TelemetryModule.h
+ * - TelemetryModule.cpp
  */
 
 #include "HardwareModule.h"
+#include "TelemetryModule.h"
 #include "CommunicationModule.h"
 
 // Global objects
 HardwareModule hardware;
-CommunicationModule communication(&hardware);
+TelemetryModule telemetry(&hardware);
+CommunicationModule communication(&hardware, &telemetry);
 
 // Helper function to repeat a character
 String repeatChar(char c, int count) {
@@ -66,6 +71,9 @@ void setup() {
     hardware.init();
     delay(500);
     
+    // Initialize telemetry recording, it keeps running while WiFi is down
+    telemetry.init();
+    
     // Initialize communication module
     communication.init();
     delay(500);
@@ -98,6 +106,9 @@ void loop() {
         }
     }
     
+    // Record telemetry history
+    telemetry.update();
+    
     // Handle network communication
     communication.update();
     
@@ -140,6 +151,16 @@ void loop() {
  *    Send: {"command":"ping"}
  *    Response: {"status":"success","message":"pong","timestamp":12345}
  * 
+ * 7. Telemetry history (pot, servo, LEDs and buttons, 4 samples per second):
+ *    Send: {"command":"subscribe_history","since":12345}
+ *    Response: {"status":"success","message":"Sending 3 history blocks","timestamp":12400}
+ *    Then, between commands and at most one per 20ms, the blocks recorded
+ *    after "since" (board millis(), 0 for everything kept):
+ *    {"type":"history","seq":7,"t0":12000,"count":150,"last":false,
+ *     "channels":["potentiometer.raw",...],"data":"<base64>"}
+ *    "last" is true on the final block. The data is Gorilla encoded, see
+ *    TelemetryModule.cpp and esp32link/history.py.
+ * 
  * Automatic Status Updates (every 1 second):
  * {
  *   "type": "status",
@@ -6,81 +6,17 @@ ESP32 Servo Control - Minimal GUI Client (with Last IP Memory)
 - Remembers last IP and Port
 """
 
-import socket
-import json
-import time
 import tkinter as tk
 from tkinter import ttk, messagebox
 import os
+import sys
 
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", ".."))
 
-class ESP32Client:
-    def __init__(self, host, port=8080, auth_password="IoTDevice2024"):
-        self.host = host
-        self.port = port
-        self.auth_password = auth_password
-        self.socket = None
-        self.authenticated = False
+from esp32link import ESP32Client, LatestValueSender
 
-    def connect(self) -> bool:
-        try:
-            self.socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-            self.socket.settimeout(10)
-            self.socket.connect((self.host, self.port))
-            self.receive_message()  # auth challenge
-            return True
-        except Exception as e:
-            messagebox.showerror("Connection Error", f"Could not connect: {e}")
-            return False
-
-    def authenticate(self) -> bool:
-        try:
-            self.send_message({"command": "auth", "password": self.auth_password})
-            time.sleep(0.5)
-            response = self.receive_message()
-            if response and response.get("status") == "success":
-                self.authenticated = True
-                return True
-            else:
-                messagebox.showerror("Auth Failed", str(response))
-                return False
-        except Exception as e:
-            messagebox.showerror("Auth Error", str(e))
-            return False
-
-    def send_message(self, message: dict) -> None:
-        try:
-            if self.socket:
-                self.socket.send((json.dumps(message) + "\n").encode())
-        except Exception as e:
-            print(f"Send error: {e}")
-
-    def receive_message(self) -> dict:
-        try:
-            if self.socket:
-                data = self.socket.recv(1024).decode()
-                if not data:
-                    return {}
-                for line in data.strip().splitlines():
-                    try:
-                        return json.loads(line)
-                    except:
-                        continue
-        except Exception as e:
-            print(f"Receive error: {e}")
-        return {}
-
-    def control_servo(self, angle: int) -> None:
-        self.send_message({"command": "set_servo", "angle": angle})
-
-    def close(self) -> None:
-        if self.socket:
-            try:
-                self.socket.close()
-            except:
-                pass
-            self.socket = None
-        self.authenticated = False
+# Slider commands per second while dragging
+SERVO_SEND_RATE_HZ = 20
 
 
 class ServoGUI:
@@ -91,6 +27,7 @@ class ServoGUI:
         self.root.title("ESP32 Servo Control")
         self.client = None
         self.connected = False
+        self.servo_sender = LatestValueSender(self.send_servo_angle, root.after, SERVO_SEND_RATE_HZ)
 
         # Connection panel
         conn_frame = ttk.Frame(root)
@@ -130,6 +67,7 @@ class ServoGUI:
             command=self.on_servo_scale_change
         )
         self.servo_scale.pack(side="left", padx=10)
+        self.servo_scale.bind("<ButtonRelease-1>", lambda event: self.servo_sender.flush())
 
         self.servo_value_label = ttk.Label(servo_frame, text="90°")
         self.servo_value_label.pack(side="left")
@@ -174,6 +112,10 @@ class ServoGUI:
             self.disconnect_btn.config(state="normal")
             self.save_last_ip(host, port)
             messagebox.showinfo("Connected", f"Connected to ESP32 at {host}:{port}")
+        else:
+            messagebox.showerror("Connection Error", self.client.error)
+            self.client.close()
+            self.client = None
 
     def disconnect_from_esp32(self):
         if not self.connected:
@@ -184,15 +126,20 @@ class ServoGUI:
             self.client = None
 
         self.connected = False
+        self.servo_sender.reset()
         self.connect_btn.config(state="normal")
         self.disconnect_btn.config(state="disabled")
         messagebox.showinfo("Disconnected", "Disconnected from ESP32")
 
     def on_servo_scale_change(self, value):
-        """Send servo angle whenever slider moves"""
+        """Send servo angle while the slider moves, at most SERVO_SEND_RATE_HZ times a second"""
         angle = int(float(value))
         self.servo_value_label.config(text=f"{angle}°")
 
+        if self.connected:
+            self.servo_sender.update(0, angle)
+
+    def send_servo_angle(self, key, angle):
         if self.connected and self.client:
             self.client.control_servo(angle)
 
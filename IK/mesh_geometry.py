@@ -0,0 +1,90 @@
+"""
+Batched geometry helpers for the matplotlib robot visualizations.
+Meshes are unit templates cached per resolution and transformed as whole
+(..., 3) arrays, so a pose costs a few numpy operations instead of a Python
+loop per vertex.
+"""
+
+from functools import lru_cache
+
+import numpy as np
+
+Z_AXIS = np.array([0.0, 0.0, 1.0])
+
+
+def rotation_between(from_dir, to_dir):
+    """Rotation matrix turning from_dir onto to_dir (Rodrigues' formula)"""
+    from_dir = np.asarray(from_dir, dtype=float)
+    to_dir = np.asarray(to_dir, dtype=float)
+    from_dir = from_dir / np.linalg.norm(from_dir)
+    to_dir = to_dir / np.linalg.norm(to_dir)
+
+    axis = np.cross(from_dir, to_dir)
+    sin_angle = np.linalg.norm(axis)
+    cos_angle = np.clip(np.dot(from_dir, to_dir), -1, 1)
+    if sin_angle < 1e-10:
+        if cos_angle > 0:
+            return np.eye(3)
+        # Opposite directions: turn half a circle around any perpendicular axis
+        perpendicular = np.cross(from_dir, [1.0, 0.0, 0.0])
+        if np.linalg.norm(perpendicular) < 1e-10:
+            perpendicular = np.cross(from_dir, [0.0, 1.0, 0.0])
+        axis = perpendicular / np.linalg.norm(perpendicular)
+        return 2.0 * np.outer(axis, axis) - np.eye(3)
+
+    axis = axis / sin_angle
+    K = np.array([
+        [0, -axis[2], axis[1]],
+        [axis[2], 0, -axis[0]],
+        [-axis[1], axis[0], 0]
+    ])
+    return np.eye(3) + sin_angle * K + (1 - cos_angle) * (K @ K)
+
+
+def rotate_points(points, from_dir, to_dir):
+    """Rotate an (..., 3) array of points from one direction to another"""
+    return np.asarray(points, dtype=float) @ rotation_between(from_dir, to_dir).T
+
+
+@lru_cache(maxsize=None)
+def unit_cylinder(n_theta=20, n_z=10):
+    """Cylinder of radius 1 and length 1 along z, as an (n_z, n_theta, 3) grid"""
+    theta, z = np.meshgrid(np.linspace(0, 2*np.pi, n_theta), np.linspace(0, 1, n_z))
+    mesh = np.stack([np.cos(theta), np.sin(theta), z], axis=-1)
+    mesh.setflags(write=False)
+    return mesh
+
+
+@lru_cache(maxsize=None)
+def unit_sphere(n_u=20, n_v=20):
+    """Sphere of radius 1 around the origin, as an (n_u, n_v, 3) grid"""
+    u = np.linspace(0, 2 * np.pi, n_u)
+    v = np.linspace(0, np.pi, n_v)
+    mesh = np.stack([
+        np.outer(np.cos(u), np.sin(v)),
+        np.outer(np.sin(u), np.sin(v)),
+        np.outer(np.ones(np.size(u)), np.cos(v))
+    ], axis=-1)
+    mesh.setflags(write=False)
+    return mesh
+
+
+def cylinder_between(start, end, radius, n_theta=20, n_z=10):
+    """Cylinder mesh from start to end, or None for a zero length link"""
+    start = np.asarray(start, dtype=float)
+    axis = np.asarray(end, dtype=float) - start
+    length = np.linalg.norm(axis)
+    if length == 0:
+        return None
+    mesh = unit_cylinder(n_theta, n_z) * np.array([radius, radius, length])
+    return rotate_points(mesh, Z_AXIS, axis) + start
+
+
+def sphere_at(center, radius, n_u=20, n_v=20):
+    """Sphere mesh around center"""
+    return unit_sphere(n_u, n_v) * radius + np.asarray(center, dtype=float)
+
+
+def surface_args(mesh):
+    """Split an (..., 3) mesh into the X, Y, Z grids plot_surface expects"""
+    return mesh[..., 0], mesh[..., 1], mesh[..., 2]
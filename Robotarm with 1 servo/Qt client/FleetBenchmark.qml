@@ -0,0 +1,128 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+import QtQuick
+import QtQuick3D
+import Backend
+
+// Frame time of the fleet view against one RoboticArm node tree per arm.
+// Started by fleetbench, which turns vsync off and prints the table.
+Window {
+    id: window
+    width: 1280
+    height: 720
+    visible: true
+    title: qsTr("Fleet benchmark")
+
+    property list<int> armCounts: [1, 10, 100]
+    property int warmupFrames: 60
+    property int measuredFrames: 600
+
+    // Current run, instanced runs first
+    property int runIndex: 0
+    readonly property int runCount: armCounts.length * 2
+    readonly property bool instanced: runIndex < armCounts.length
+    readonly property int arms: armCounts[runIndex % armCounts.length]
+
+    property int frame: 0
+    property var frameTimes: []
+
+    ArmFleet {
+        id: fleet
+        count: window.arms
+    }
+
+    View3D {
+        id: view
+        anchors.fill: parent
+        camera: camera
+
+        environment: SceneEnvironment {
+            clearColor: "#202020"
+            backgroundMode: SceneEnvironment.Color
+            antialiasingMode: SceneEnvironment.MSAA
+            antialiasingQuality: SceneEnvironment.VeryHigh
+        }
+
+        DirectionalLight {
+            eulerRotation.z: 30
+            eulerRotation.y: -165
+        }
+
+        DirectionalLight {
+            brightness: 0.4
+            eulerRotation.x: -60
+        }
+
+        PerspectiveCamera {
+            id: camera
+            readonly property real extent: fleet.columns * fleet.spacing
+            clipFar: extent * 10
+            position: Qt.vector3d(extent / 2, extent * 0.8 + 800, extent * 1.4 + 1200)
+            eulerRotation.x: -30
+        }
+
+        FleetView {
+            fleet: fleet
+            visible: window.instanced
+        }
+
+        Repeater3D {
+            model: window.instanced ? 0 : fleet.count
+
+            RoboticArm {
+                required property int index
+                readonly property var pose: {
+                    poseTick.frame // re-evaluate every frame
+                    return fleet.pose(index)
+                }
+                position: fleet.armPosition(index)
+                rotation1: pose[0]
+                rotation2: pose[1]
+                rotation3: pose[2]
+                rotation4: pose[3]
+                clawsAngle: pose[4]
+            }
+        }
+    }
+
+    // Poses change every frame in both modes, bindings of the node trees
+    // pick them up through this counter
+    QtObject {
+        id: poseTick
+        property int frame: 0
+    }
+
+    FrameAnimation {
+        running: true
+        onTriggered: {
+            fleet.wave(elapsedTime)
+            poseTick.frame++
+
+            window.frame++
+            if (window.frame <= window.warmupFrames)
+                return
+            window.frameTimes.push(frameTime * 1000)
+            if (window.frameTimes.length < window.measuredFrames)
+                return
+
+            const times = window.frameTimes.slice().sort((a, b) => a - b)
+            const mean = times.reduce((sum, t) => sum + t, 0) / times.length
+            const p95 = times[Math.floor(times.length * 0.95)]
+            const drawCalls = view.renderStats.drawCallCount !== undefined
+                    ? view.renderStats.drawCallCount : "n/a"
+            console.log("%1 %2 %3 %4 %5".arg(String(window.arms).padStart(5))
+                        .arg((window.instanced ? "instanced" : "nodes").padEnd(10))
+                        .arg(mean.toFixed(2).padStart(8))
+                        .arg(p95.toFixed(2).padStart(8))
+                        .arg(String(drawCalls).padStart(10)))
+
+            window.frame = 0
+            window.frameTimes = []
+            if (++window.runIndex >= window.runCount)
+                Qt.quit()
+        }
+    }
+
+    Component.onCompleted: console.log(" arms mode        mean_ms   p95_ms draw_calls")
+}
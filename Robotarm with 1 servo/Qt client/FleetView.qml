@@ -0,0 +1,111 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+import QtQuick
+import QtQuick3D
+import Backend
+
+// Every arm of an ArmFleet, drawn with one instanced Model per mesh of
+// RoboticArm.qml. The draw call count stays the same for 1 or 100 arms,
+// only the instance tables grow.
+Node {
+    id: fleetNode
+    required property ArmFleet fleet
+
+    DefaultMaterial {
+        id: steel_material
+        diffuseColor: "#ff595959"
+    }
+
+    DefaultMaterial {
+        id: plastic_material
+    }
+
+    DefaultMaterial {
+        id: plastic_color_material
+        diffuseColor: "#41cd52"
+    }
+
+    DefaultMaterial {
+        id: plastic_qt_material
+        diffuseMap: Texture {
+            source: "maps/qt.png"
+            pivotU: 0.5
+            pivotV: 0.5
+            generateMipmaps: true
+            mipFilter: Texture.Linear
+        }
+    }
+
+    Model {
+        source: "meshes/base.mesh"
+        materials: [steel_material, plastic_material]
+        instancing: ArmFleetInstancing { fleet: fleetNode.fleet; link: ArmFleet.Base }
+    }
+
+    Model {
+        source: "meshes/root.mesh"
+        materials: [plastic_material, plastic_color_material, steel_material]
+        instancing: ArmFleetInstancing { fleet: fleetNode.fleet; link: ArmFleet.Root }
+    }
+
+    Model {
+        source: "meshes/forearm.mesh"
+        materials: [plastic_material, steel_material]
+        instancing: ArmFleetInstancing { fleet: fleetNode.fleet; link: ArmFleet.Forearm }
+    }
+
+    Model {
+        source: "meshes/arm.mesh"
+        materials: [plastic_material, plastic_qt_material, steel_material]
+        instancing: ArmFleetInstancing { fleet: fleetNode.fleet; link: ArmFleet.Arm }
+    }
+
+    Model {
+        source: "meshes/hand_hinge.mesh"
+        materials: [plastic_material]
+        instancing: ArmFleetInstancing { fleet: fleetNode.fleet; link: ArmFleet.HandHinge }
+    }
+
+    Model {
+        source: "meshes/hand.mesh"
+        materials: [plastic_material, steel_material]
+        instancing: ArmFleetInstancing { fleet: fleetNode.fleet; link: ArmFleet.Hand }
+    }
+
+    Model {
+        source: "meshes/hand_grab_t_hinge_2.mesh"
+        materials: [steel_material]
+        instancing: ArmFleetInstancing { fleet: fleetNode.fleet; link: ArmFleet.ClawTopHinge2 }
+    }
+
+    Model {
+        source: "meshes/hand_grab_t_hinge_1.mesh"
+        materials: [steel_material]
+        instancing: ArmFleetInstancing { fleet: fleetNode.fleet; link: ArmFleet.ClawTopHinge1 }
+    }
+
+    Model {
+        source: "meshes/hand_grab_t.mesh"
+        materials: [plastic_color_material, steel_material]
+        instancing: ArmFleetInstancing { fleet: fleetNode.fleet; link: ArmFleet.ClawTop }
+    }
+
+    Model {
+        source: "meshes/hand_grab_b_hinge_1.mesh"
+        materials: [steel_material]
+        instancing: ArmFleetInstancing { fleet: fleetNode.fleet; link: ArmFleet.ClawBottomHinge1 }
+    }
+
+    Model {
+        source: "meshes/hand_grab_b.mesh"
+        materials: [plastic_color_material, steel_material]
+        instancing: ArmFleetInstancing { fleet: fleetNode.fleet; link: ArmFleet.ClawBottom }
+    }
+
+    Model {
+        source: "meshes/hand_grab_b_hinge_2.mesh"
+        materials: [steel_material]
+        instancing: ArmFleetInstancing { fleet: fleetNode.fleet; link: ArmFleet.ClawBottomHinge2 }
+    }
+}
@@ -40,6 +40,44 @@ Pane {
                 backend.connectToDevice(ipAddressField.text, parseInt(portField.text))
             }
         }
+
+        // Jogging from a gamepad is opt-in, input devices are only opened
+        // when asked for
+        Switch {
+            id: gamepadSwitch
+            text: gamepad.active ? gamepad.deviceName : qsTr("Gamepad")
+            onToggled: {
+                if (checked)
+                    checked = gamepad.start()
+                else
+                    gamepad.stop()
+            }
+        }
+
+        // Other programs may only drive the arm once the user allows it
+        Switch {
+            id: scriptSwitch
+            text: qsTr("Scripting")
+            onToggled: {
+                if (checked)
+                    checked = scriptServer.start()
+                else
+                    scriptServer.stop()
+            }
+        }
+
+        // scene.json is an example work cell, not the user's, so it is only
+        // loaded on request
+        Switch {
+            id: sceneSwitch
+            text: qsTr("Example scene")
+            onToggled: {
+                if (checked)
+                    checked = backend.loadScene(":/Backend/scene.json")
+                else
+                    backend.clearScene()
+            }
+        }
     }
     id: root
     Material.theme: darkModeToggle.checked ? Material.Dark : Material.Light
@@ -47,6 +85,22 @@ Pane {
     readonly property bool mobile: Qt.platform.os === "android"
     readonly property bool horizontal: width > height
     property real sliderWidth: width * 0.15
+
+    function setSliders(joints) {
+        rotation1Slider.value = joints[0]
+        rotation2Slider.value = joints[1]
+        rotation3Slider.value = joints[2]
+        rotation4Slider.value = joints[3]
+    }
+
+    // Plays the precomputed trajectory to a pose of poses.json, or moves the
+    // sliders there directly when the library has no way to get there
+    function goToPreset(name) {
+        const joints = backend.poseJoints(name)
+        if (!backend.goToPose(name) && joints.length === 4)
+            setSliders(joints)
+    }
+
     property real buttonRowWidth: width * 0.12
     property real buttonMinWidth: 65
 
@@ -61,11 +115,41 @@ Pane {
 
     Backend {
         id: backend
+        window: root.Window.window
         rotation1Angle: rotation1Slider.value
         rotation2Angle: rotation2Slider.value
         rotation3Angle: rotation3Slider.value
         rotation4Angle: rotation4Slider.value
         clawsAngle: clawToggle.checked ? 0 : 90
+        Component.onCompleted: {
+            loadPoseLibrary(":/Backend/poses.json")
+            loadReachabilityMap(":/Backend/arm.reach")
+        }
+
+        // Jogging moves the targets, the sliders follow so that the next
+        // slider touch continues from there
+        onJogged: (joints) => root.setSliders(joints)
+
+        // The sliders catch up with the arm when a trajectory is done,
+        // stopped or replaced, so that the next slider touch starts there
+        onTrajectoryFinished: root.setSliders(targetPose())
+    }
+
+    // Jogs the arm from the first gamepad found, see gamepadSwitch
+    GamepadInput {
+        id: gamepad
+        backend: backend
+        onActiveChanged: gamepadSwitch.checked = active
+        onErrorOccurred: (error) => gamepadSwitch.ToolTip.show(error, 3000)
+    }
+
+    // Scripting API on the local socket "esp32-arm", see scriptserver.h
+    // and scriptSwitch
+    ScriptServer {
+        id: scriptServer
+        backend: backend
+        onListeningChanged: scriptSwitch.checked = listening
+        onErrorOccurred: (error) => scriptSwitch.ToolTip.show(error, 3000)
     }
 
     Toggle {
@@ -144,12 +228,7 @@ Pane {
 
             Connections {
                 target: pose1
-                onClicked: {
-                    rotation1Slider.value = 30
-                    rotation2Slider.value = 60
-                    rotation3Slider.value = 90
-                    rotation4Slider.value = 145
-                }
+                onClicked: root.goToPreset("Pose 1")
             }
         }
 
@@ -162,12 +241,7 @@ Pane {
 
             Connections {
                 target: pose2
-                onClicked: {
-                    rotation1Slider.value = 60
-                    rotation2Slider.value = 45
-                    rotation3Slider.value = 45
-                    rotation4Slider.value = 60
-                }
+                onClicked: root.goToPreset("Pose 2")
             }
         }
 
@@ -180,12 +254,7 @@ Pane {
 
             Connections {
                 target: pose3
-                onClicked: {
-                    rotation1Slider.value = -90
-                    rotation2Slider.value = -60
-                    rotation3Slider.value = -45
-                    rotation4Slider.value = -180
-                }
+                onClicked: root.goToPreset("Pose 3")
             }
         }
 
@@ -199,10 +268,7 @@ Pane {
             Connections {
                 target: resetPose
                 onClicked: {
-                    rotation1Slider.value = 0
-                    rotation2Slider.value = 0
-                    rotation3Slider.value = 0
-                    rotation4Slider.value = 0
+                    root.goToPreset("Reset")
                     clawToggle.checked = false
                 }
             }
@@ -246,12 +312,25 @@ Pane {
             }
             RoboticArm {
                 id: roboArm
-                rotation1: backend.rotation1Angle
-                rotation2: backend.rotation2Angle
-                rotation3: backend.rotation3Angle
-                rotation4: backend.rotation4Angle
+                // Where the hardware is estimated to be now, not where it
+                // reported itself one link latency ago
+                rotation1: backend.predictedPose[0]
+                rotation2: backend.predictedPose[1]
+                rotation3: backend.predictedPose[2]
+                rotation4: backend.predictedPose[3]
                 clawsAngle: backend.clawsAngle
             }
+
+            // Work cell fixtures of scene.json, all in one draw call
+            Model {
+                visible: backend.obstacleCount > 0
+                geometry: ObstacleGeometry {
+                    backend: backend
+                }
+                materials: DefaultMaterial {
+                    diffuseColor: "#ff8d8f94"
+                }
+            }
         }
 
         NodeIndicator {
@@ -307,6 +386,19 @@ Pane {
         anchors.topMargin: 15
     }
 
+    Label {
+        id: predictionStatus
+        visible: backend.predictionStats.samples > 0
+        text: qsTr("Prediction error %1° rms (holding the last sample %2°), latency %3 ms")
+              .arg(backend.predictionStats.rmsErrorDeg.toFixed(1))
+              .arg(backend.predictionStats.holdRmsErrorDeg.toFixed(1))
+              .arg(Math.round(backend.predictionStats.linkLatencyMs))
+        anchors.top: robotStatus.bottom
+        font.pointSize: robotStatus.font.pointSize * 0.8
+        anchors.horizontalCenter: parent.horizontalCenter
+        anchors.topMargin: 4
+    }
+
     states: [
         State {
             name: "mobileHorizontal"
@@ -6,10 +6,10 @@ import QtQuick3D
 
 Node {
     id: rootNode
-    property int rotation1
-    property int rotation2
-    property int rotation3
-    property int rotation4
+    property real rotation1
+    property real rotation2
+    property real rotation3
+    property real rotation4
     property int clawsAngle
 
     readonly property alias hand_position: hand_grab_t.scenePosition
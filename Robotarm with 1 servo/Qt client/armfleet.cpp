@@ -0,0 +1,223 @@
+#include "armfleet.h"
+
+#include <QQuaternion>
+#include <QtMath>
+
+namespace {
+
+// Local node offsets from RoboticArm.qml
+const QVector3D RootOffset(0.0f, -5.96047e-08f, 1.0472f);
+const QVector3D ForearmOffset(5.32907e-15f, -0.165542f, 1.53472f);
+const QVector3D ArmOffset(-7.43453e-07f, 0.667101f, 2.23365f);
+const QVector3D HandHingeOffset(7.43453e-07f, 0.0635689f, 2.12289f);
+const QVector3D HandOffset(3.35649e-06f, 2.38419e-07f, 0.366503f);
+const QVector3D ClawTopHinge2Offset(-9.5112e-07f, 0.323057f, 0.472305f);
+const QVector3D ClawTopHinge1Offset(-9.3061e-07f, 0.143685f, 0.728553f);
+const QVector3D ClawTopOffset(-2.42588e-06f, -0.0327932f, 0.414757f);
+const QVector3D ClawBottomHinge1Offset(-9.38738e-07f, -0.143685f, 0.728553f);
+const QVector3D ClawBottomOffset(-2.41775e-06f, 0.0327224f, 0.413965f);
+const QVector3D ClawBottomHinge2Offset(-9.5112e-07f, -0.323058f, 0.472305f);
+constexpr float BaseScale = 100.0f;
+
+// Same composition as a Qt Quick 3D Node: translate, rotate, no pivot
+QMatrix4x4 child(const QMatrix4x4 &parent, const QVector3D &position, const QVector3D &eulerRotation)
+{
+    QMatrix4x4 m = parent;
+    m.translate(position);
+    m.rotate(QQuaternion::fromEulerAngles(eulerRotation));
+    return m;
+}
+
+QVector3D aroundX(float degrees)
+{
+    return QVector3D(degrees, 0.0f, 0.0f);
+}
+
+} // namespace
+
+ArmFleet::ArmFleet(QObject *parent) : QObject(parent)
+{
+}
+
+int ArmFleet::count() const
+{
+    return int(m_poses.size());
+}
+
+void ArmFleet::setCount(int count)
+{
+    count = qMax(count, 0);
+    if (count == ArmFleet::count())
+        return;
+    m_poses.resize(size_t(count), Pose {});
+    emit countChanged();
+    posesModified();
+}
+
+qreal ArmFleet::spacing() const
+{
+    return m_spacing;
+}
+
+void ArmFleet::setSpacing(qreal spacing)
+{
+    if (qFuzzyCompare(spacing, m_spacing))
+        return;
+    m_spacing = spacing;
+    emit spacingChanged();
+    posesModified();
+}
+
+int ArmFleet::columns() const
+{
+    return qMax(1, qCeil(qSqrt(qreal(count()))));
+}
+
+void ArmFleet::setPose(int arm, const QVariantList &angles)
+{
+    if (arm < 0 || arm >= count())
+        return;
+    Pose &pose = m_poses[size_t(arm)];
+    for (int i = 0; i < AngleCount && i < angles.size(); i++)
+        pose[size_t(i)] = angles[i].toFloat();
+    posesModified();
+}
+
+QVariantList ArmFleet::pose(int arm) const
+{
+    if (arm < 0 || arm >= count())
+        return {};
+    QVariantList angles;
+    for (const float angle : m_poses[size_t(arm)])
+        angles.append(angle);
+    return angles;
+}
+
+void ArmFleet::setPoses(const QVariantList &angles)
+{
+    const int arms = qMin(count(), int(angles.size() / AngleCount));
+    for (int arm = 0; arm < arms; arm++) {
+        for (int i = 0; i < AngleCount; i++)
+            m_poses[size_t(arm)][size_t(i)] = angles[arm * AngleCount + i].toFloat();
+    }
+    posesModified();
+}
+
+QVector3D ArmFleet::armPosition(int arm) const
+{
+    const int column = arm % columns();
+    const int row = arm / columns();
+    return QVector3D(float(column * m_spacing), 0.0f, float(row * m_spacing));
+}
+
+void ArmFleet::wave(qreal seconds)
+{
+    for (size_t arm = 0; arm < m_poses.size(); arm++) {
+        const float t = float(seconds) + 0.37f * float(arm);
+        m_poses[arm] = { 60.0f * qSin(1.3f * t), 70.0f * qSin(0.9f * t), 45.0f * qSin(0.7f * t),
+                         120.0f * qSin(0.4f * t), 45.0f + 45.0f * qSin(2.0f * t) };
+    }
+    posesModified();
+}
+
+const QMatrix4x4 &ArmFleet::linkTransform(int arm, int link) const
+{
+    if (m_transformsDirty)
+        updateTransforms();
+    return m_transforms[size_t(arm) * LinkCount + size_t(link)];
+}
+
+void ArmFleet::posesModified()
+{
+    m_transformsDirty = true;
+    emit posesChanged();
+}
+
+void ArmFleet::updateTransforms() const
+{
+    m_transforms.resize(m_poses.size() * LinkCount);
+    for (size_t arm = 0; arm < m_poses.size(); arm++) {
+        const Pose &pose = m_poses[arm];
+        const float rotation1 = pose[0];
+        const float rotation2 = pose[1];
+        const float rotation3 = pose[2];
+        const float rotation4 = pose[3];
+        const float claws = pose[4];
+        QMatrix4x4 *t = &m_transforms[arm * LinkCount];
+
+        QMatrix4x4 base;
+        base.translate(armPosition(int(arm)));
+        base.rotate(QQuaternion::fromEulerAngles(aroundX(-90.0f)));
+        base.scale(BaseScale);
+        t[Base] = base;
+        t[Root] = child(t[Base], RootOffset, QVector3D(0.0f, 0.0f, rotation4));
+        t[Forearm] = child(t[Root], ForearmOffset, aroundX(rotation3));
+        t[Arm] = child(t[Forearm], ArmOffset, aroundX(rotation2));
+        t[HandHinge] = child(t[Arm], HandHingeOffset, aroundX(rotation1));
+        t[Hand] = child(t[HandHinge], HandOffset, QVector3D());
+        t[ClawTopHinge2] = child(t[Hand], ClawTopHinge2Offset, aroundX(-claws));
+        t[ClawTopHinge1] = child(t[Hand], ClawTopHinge1Offset, aroundX(-claws));
+        t[ClawTop] = child(t[ClawTopHinge1], ClawTopOffset, aroundX(claws));
+        t[ClawBottomHinge1] = child(t[Hand], ClawBottomHinge1Offset, aroundX(claws));
+        t[ClawBottom] = child(t[ClawBottomHinge1], ClawBottomOffset, aroundX(-claws));
+        t[ClawBottomHinge2] = child(t[Hand], ClawBottomHinge2Offset, aroundX(claws));
+    }
+    m_transformsDirty = false;
+}
+
+ArmFleetInstancing::ArmFleetInstancing(QQuick3DObject *parent) : QQuick3DInstancing(parent)
+{
+}
+
+ArmFleet *ArmFleetInstancing::fleet() const
+{
+    return m_fleet;
+}
+
+void ArmFleetInstancing::setFleet(ArmFleet *fleet)
+{
+    if (fleet == m_fleet)
+        return;
+    disconnect(m_posesConnection);
+    m_fleet = fleet;
+    if (m_fleet)
+        m_posesConnection = connect(m_fleet, &ArmFleet::posesChanged, this, [this]() { markDirty(); });
+    emit fleetChanged();
+    markDirty();
+}
+
+int ArmFleetInstancing::link() const
+{
+    return m_link;
+}
+
+void ArmFleetInstancing::setLink(int link)
+{
+    if (link == m_link || link < 0 || link >= ArmFleet::LinkCount)
+        return;
+    m_link = link;
+    emit linkChanged();
+    markDirty();
+}
+
+QByteArray ArmFleetInstancing::getInstanceBuffer(int *instanceCount)
+{
+    const int arms = m_fleet ? m_fleet->count() : 0;
+    m_buffer.resize(qsizetype(arms) * qsizetype(sizeof(InstanceTableEntry)));
+    auto *entries = reinterpret_cast<InstanceTableEntry *>(m_buffer.data());
+
+    // The table holds the top three rows of each instance's transform
+    for (int arm = 0; arm < arms; arm++) {
+        const QMatrix4x4 &m = m_fleet->linkTransform(arm, m_link);
+        InstanceTableEntry &entry = entries[arm];
+        entry.row0 = m.row(0);
+        entry.row1 = m.row(1);
+        entry.row2 = m.row(2);
+        entry.color = QVector4D(1.0f, 1.0f, 1.0f, 1.0f);
+        entry.instanceData = QVector4D(float(arm), 0.0f, 0.0f, 0.0f);
+    }
+
+    if (instanceCount)
+        *instanceCount = arms;
+    return m_buffer;
+}
@@ -0,0 +1,116 @@
+#ifndef ARMFLEET_H
+#define ARMFLEET_H
+
+#include <QMatrix4x4>
+#include <QObject>
+#include <QPointer>
+#include <QVariantList>
+#include <QVector3D>
+#include <QtQuick3D/qquick3dinstancing.h>
+#include <array>
+#include <qqmlregistration.h>
+#include <vector>
+
+// Poses of a fleet of arms laid out on a square grid, plus the scene
+// transform of every mesh of every arm. The transforms follow the node tree
+// of RoboticArm.qml and are rebuilt lazily, once per pose change, into one
+// contiguous array that the ArmFleetInstancing tables read from.
+class ArmFleet : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(int count READ count WRITE setCount NOTIFY countChanged)
+    Q_PROPERTY(qreal spacing READ spacing WRITE setSpacing NOTIFY spacingChanged)
+    Q_PROPERTY(int columns READ columns NOTIFY countChanged)
+
+public:
+    // One entry per Model in RoboticArm.qml
+    enum Link {
+        Base,
+        Root,
+        Forearm,
+        Arm,
+        HandHinge,
+        Hand,
+        ClawTopHinge2,
+        ClawTopHinge1,
+        ClawTop,
+        ClawBottomHinge1,
+        ClawBottom,
+        ClawBottomHinge2,
+        LinkCount
+    };
+    Q_ENUM(Link)
+
+    explicit ArmFleet(QObject *parent = nullptr);
+
+    int count() const;
+    void setCount(int count);
+    qreal spacing() const;
+    void setSpacing(qreal spacing);
+    int columns() const;
+
+    // Angles in the order of the Backend properties:
+    // rotation1, rotation2, rotation3, rotation4, clawsAngle
+    Q_INVOKABLE void setPose(int arm, const QVariantList &angles);
+    Q_INVOKABLE QVariantList pose(int arm) const;
+    // All arms at once, five angles per arm
+    Q_INVOKABLE void setPoses(const QVariantList &angles);
+    Q_INVOKABLE QVector3D armPosition(int arm) const;
+
+    // Deterministic motion for benchmarks and demos, every arm out of phase
+    Q_INVOKABLE void wave(qreal seconds);
+
+    const QMatrix4x4 &linkTransform(int arm, int link) const;
+
+signals:
+    void countChanged();
+    void spacingChanged();
+    void posesChanged();
+
+private:
+    static constexpr int AngleCount = 5;
+    using Pose = std::array<float, AngleCount>;
+
+    void updateTransforms() const;
+    void posesModified();
+
+    std::vector<Pose> m_poses;
+    qreal m_spacing = 800.0;
+    mutable std::vector<QMatrix4x4> m_transforms; // arm * LinkCount + link
+    mutable bool m_transformsDirty = true;
+};
+
+// Instance table of one RoboticArm mesh across the whole fleet. A Model
+// using it draws every arm's copy of that mesh in a single draw call.
+// The Model itself should have an identity transform.
+class ArmFleetInstancing : public QQuick3DInstancing
+{
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(ArmFleet *fleet READ fleet WRITE setFleet NOTIFY fleetChanged)
+    Q_PROPERTY(int link READ link WRITE setLink NOTIFY linkChanged)
+
+public:
+    explicit ArmFleetInstancing(QQuick3DObject *parent = nullptr);
+
+    ArmFleet *fleet() const;
+    void setFleet(ArmFleet *fleet);
+    int link() const;
+    void setLink(int link);
+
+signals:
+    void fleetChanged();
+    void linkChanged();
+
+protected:
+    QByteArray getInstanceBuffer(int *instanceCount) override;
+
+private:
+    QPointer<ArmFleet> m_fleet;
+    QMetaObject::Connection m_posesConnection;
+    int m_link = ArmFleet::Base;
+    QByteArray m_buffer;
+};
+
+#endif // ARMFLEET_H
@@ -0,0 +1,350 @@
+#include "armmodel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ArmModel {
+
+namespace {
+
+// Hardcoded model dimensions, same values as the original QPolygon based check
+constexpr double BaseTilt = 8.7;
+constexpr double ShoulderHeight = 259.0;
+constexpr double ForearmOffset = -20.0;
+constexpr double ArmOffset = 15.0;
+
+constexpr double BaseWidth = 70.0;
+constexpr double BaseHeight = 300.0;
+constexpr double ForearmWidth = 35.0;
+constexpr double ForearmLength = 233.0;
+constexpr double ArmWidth = 27.0;
+constexpr double ArmLength = 212.0;
+constexpr double HandWidth = 42.0;
+constexpr double HandLength = 180.0;
+
+constexpr double Pi = 3.14159265358979323846;
+constexpr double DegToRad = Pi / 180.0;
+constexpr double RadToDeg = 180.0 / Pi;
+
+const JointLimits Limits[JointCount] = {
+    { -90.0, 90.0 },   // Rotation 1
+    { -135.0, 135.0 }, // Rotation 2
+    { -90.0, 90.0 },   // Rotation 3
+    { -180.0, 180.0 }, // Rotation 4
+};
+
+Vec2 rotated(double degrees, double x, double y)
+{
+    const double c = std::cos(degrees * DegToRad);
+    const double s = std::sin(degrees * DegToRad);
+    return { x * c - y * s, x * s + y * c };
+}
+
+Vec2 add(const Vec2 &a, const Vec2 &b) { return { a.x + b.x, a.y + b.y }; }
+
+// Rectangle x in [-width, 0], y in [0, length] of a frame at origin/angle
+LinkBox frameBox(const Vec2 &origin, double angle, double width, double length)
+{
+    LinkBox box;
+    box.corners[0] = add(origin, rotated(angle, -width, 0.0));
+    box.corners[1] = add(origin, rotated(angle, 0.0, 0.0));
+    box.corners[2] = add(origin, rotated(angle, 0.0, length));
+    box.corners[3] = add(origin, rotated(angle, -width, length));
+    return box;
+}
+
+double pointSegmentDistance(const Vec2 &p, const Vec2 &a, const Vec2 &b)
+{
+    const double dx = b.x - a.x;
+    const double dy = b.y - a.y;
+    const double lengthSquared = dx * dx + dy * dy;
+    double t = 0.0;
+    if (lengthSquared > 0.0)
+        t = std::clamp(((p.x - a.x) * dx + (p.y - a.y) * dy) / lengthSquared, 0.0, 1.0);
+    const double ex = a.x + t * dx - p.x;
+    const double ey = a.y + t * dy - p.y;
+    return std::sqrt(ex * ex + ey * ey);
+}
+
+// Smallest overlap of the projections on the edge normals of a (separating
+// axis test). A negative result means a separating axis exists.
+double minOverlap(const LinkBox &a, const LinkBox &b)
+{
+    double overlap = std::numeric_limits<double>::infinity();
+    for (int edge = 0; edge < 2; ++edge) {
+        const Vec2 &p0 = a.corners[edge];
+        const Vec2 &p1 = a.corners[edge + 1];
+        double nx = p0.y - p1.y;
+        double ny = p1.x - p0.x;
+        const double length = std::sqrt(nx * nx + ny * ny);
+        if (length == 0.0)
+            continue;
+        nx /= length;
+        ny /= length;
+
+        double minA = std::numeric_limits<double>::infinity(), maxA = -minA;
+        double minB = minA, maxB = -minA;
+        for (int i = 0; i < 4; ++i) {
+            const double pa = a.corners[i].x * nx + a.corners[i].y * ny;
+            const double pb = b.corners[i].x * nx + b.corners[i].y * ny;
+            minA = std::min(minA, pa);
+            maxA = std::max(maxA, pa);
+            minB = std::min(minB, pb);
+            maxB = std::max(maxB, pb);
+        }
+        overlap = std::min(overlap, std::min(maxA, maxB) - std::max(minA, minB));
+    }
+    return overlap;
+}
+
+// Link rectangle of frameBox() as an oriented box: center, the cosine and
+// sine of its angle and the half extents along its x and y axes
+struct Obb
+{
+    double cx, cy, c, s, hx, hy;
+};
+
+// Separating axis test of two oriented boxes without branches. Touching
+// counts as overlapping, like boxDistance() <= 0.
+inline bool obbOverlap(const Obb &a, const Obb &b)
+{
+    const double dx = b.cx - a.cx;
+    const double dy = b.cy - a.cy;
+    const double cosine = std::abs(a.c * b.c + a.s * b.s);
+    const double sine = std::abs(a.s * b.c - a.c * b.s);
+    const bool ax = std::abs(dx * a.c + dy * a.s) <= a.hx + b.hx * cosine + b.hy * sine;
+    const bool ay = std::abs(dy * a.c - dx * a.s) <= a.hy + b.hx * sine + b.hy * cosine;
+    const bool bx = std::abs(dx * b.c + dy * b.s) <= b.hx + a.hx * cosine + a.hy * sine;
+    const bool by = std::abs(dy * b.c - dx * b.s) <= b.hy + a.hx * sine + a.hy * cosine;
+    return ax & ay & bx & by;
+}
+
+inline Obb frameObb(double ox, double oy, double c, double s, double width, double length)
+{
+    // Center of x in [-width, 0], y in [0, length] in the rotated frame
+    const double x = -0.5 * width;
+    const double y = 0.5 * length;
+    return { ox + x * c - y * s, oy + x * s + y * c, c, s, 0.5 * width, 0.5 * length };
+}
+
+double wrapToPi(double angle)
+{
+    angle = std::fmod(angle + Pi, 2.0 * Pi);
+    if (angle < 0.0)
+        angle += 2.0 * Pi;
+    return angle - Pi;
+}
+
+} // namespace
+
+JointLimits jointLimits(int joint)
+{
+    return Limits[joint];
+}
+
+Vec2 shoulderPosition()
+{
+    return rotated(BaseTilt, 0.0, ShoulderHeight);
+}
+
+double forearmLength() { return ForearmLength; }
+double armLength() { return ArmLength; }
+double handLength() { return HandLength; }
+
+LinkBoxes linkBoxes(const JointVector &joints)
+{
+    LinkBoxes boxes;
+    boxes[BaseLink] = frameBox({ 0.0, 0.0 }, 0.0, BaseWidth, BaseHeight);
+
+    const Vec2 shoulder = shoulderPosition();
+    const double forearmAngle = BaseTilt + ForearmOffset + joints[Rotation3];
+    boxes[ForearmLink] = frameBox(shoulder, forearmAngle, ForearmWidth, ForearmLength);
+
+    const Vec2 elbow = add(shoulder, rotated(forearmAngle, 0.0, ForearmLength));
+    const double armAngle = forearmAngle + ArmOffset + joints[Rotation2];
+    boxes[ArmLink] = frameBox(elbow, armAngle, ArmWidth, ArmLength);
+
+    const Vec2 wrist = add(elbow, rotated(armAngle, 0.0, ArmLength));
+    const double handAngle = armAngle + joints[Rotation1];
+    boxes[HandLink] = frameBox(wrist, handAngle, HandWidth, HandLength);
+    return boxes;
+}
+
+Vec2 wristPosition(const JointVector &joints)
+{
+    const double forearmAngle = BaseTilt + ForearmOffset + joints[Rotation3];
+    const double armAngle = forearmAngle + ArmOffset + joints[Rotation2];
+    const Vec2 elbow = add(shoulderPosition(), rotated(forearmAngle, 0.0, ForearmLength));
+    return add(elbow, rotated(armAngle, 0.0, ArmLength));
+}
+
+double wristManipulability(const JointVector &joints)
+{
+    const double elbow = (ArmOffset + joints[Rotation2]) * DegToRad;
+    return ForearmLength * ArmLength * std::abs(std::sin(elbow));
+}
+
+double boxDistance(const LinkBox &a, const LinkBox &b)
+{
+    const double overlap = std::min(minOverlap(a, b), minOverlap(b, a));
+    if (overlap >= 0.0)
+        return -overlap;
+
+    double distance = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < 4; ++i) {
+        const int j = (i + 1) % 4;
+        for (int k = 0; k < 4; ++k) {
+            distance = std::min(distance, pointSegmentDistance(b.corners[k], a.corners[i], a.corners[j]));
+            distance = std::min(distance, pointSegmentDistance(a.corners[k], b.corners[i], b.corners[j]));
+        }
+    }
+    return distance;
+}
+
+double selfClearance(const LinkBoxes &boxes)
+{
+    return std::min({ boxDistance(boxes[BaseLink], boxes[ArmLink]),
+                      boxDistance(boxes[BaseLink], boxes[HandLink]),
+                      boxDistance(boxes[ForearmLink], boxes[HandLink]) });
+}
+
+double selfClearance(const JointVector &joints)
+{
+    return selfClearance(linkBoxes(joints));
+}
+
+bool isSelfColliding(const JointVector &joints)
+{
+    return selfClearance(joints) <= 0.0;
+}
+
+void isSelfCollidingBatch(const double *rotation1, const double *rotation2, const double *rotation3,
+                          size_t count, unsigned char *colliding)
+{
+    constexpr size_t Block = 64;
+    const Obb base = frameObb(0.0, 0.0, 1.0, 0.0, BaseWidth, BaseHeight);
+    const Vec2 shoulder = shoulderPosition();
+
+    // Angles go through std::cos/std::sin in one pass, the geometry and the
+    // box tests run in a second pass over plain arrays
+    double forearmCos[Block], forearmSin[Block], armCos[Block], armSin[Block], handCos[Block], handSin[Block];
+    for (size_t start = 0; start < count; start += Block) {
+        const size_t n = std::min(Block, count - start);
+        for (size_t i = 0; i < n; i++) {
+            const double forearm = (BaseTilt + ForearmOffset + rotation3[start + i]) * DegToRad;
+            const double arm = forearm + (ArmOffset + rotation2[start + i]) * DegToRad;
+            const double hand = arm + rotation1[start + i] * DegToRad;
+            forearmCos[i] = std::cos(forearm);
+            forearmSin[i] = std::sin(forearm);
+            armCos[i] = std::cos(arm);
+            armSin[i] = std::sin(arm);
+            handCos[i] = std::cos(hand);
+            handSin[i] = std::sin(hand);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            const Obb forearm = frameObb(shoulder.x, shoulder.y, forearmCos[i], forearmSin[i], ForearmWidth,
+                                         ForearmLength);
+            const double elbowX = shoulder.x - ForearmLength * forearmSin[i];
+            const double elbowY = shoulder.y + ForearmLength * forearmCos[i];
+            const Obb arm = frameObb(elbowX, elbowY, armCos[i], armSin[i], ArmWidth, ArmLength);
+            const double wristX = elbowX - ArmLength * armSin[i];
+            const double wristY = elbowY + ArmLength * armCos[i];
+            const Obb hand = frameObb(wristX, wristY, handCos[i], handSin[i], HandWidth, HandLength);
+            colliding[start + i] = obbOverlap(base, arm) | obbOverlap(base, hand) | obbOverlap(forearm, hand);
+        }
+    }
+}
+
+int analyticIk2Link(double x, double y, double l1, double l2, Ik2LinkSolution out[2])
+{
+    constexpr double Tolerance = 1e-9;
+    double d = (x * x + y * y - l1 * l1 - l2 * l2) / (2.0 * l1 * l2);
+    if (d > 1.0 + Tolerance || d < -1.0 - Tolerance)
+        return 0; // unreachable
+    d = std::clamp(d, -1.0, 1.0);
+    const double s = std::sqrt(std::max(0.0, 1.0 - d * d));
+
+    // two possible theta2 (elbow up / down)
+    int count = 0;
+    for (const double theta2 : { std::atan2(s, d), std::atan2(-s, d) }) {
+        const double k1 = l1 + l2 * std::cos(theta2);
+        const double k2 = l2 * std::sin(theta2);
+        const double theta1 = std::atan2(y, x) - std::atan2(k2, k1);
+        const Ik2LinkSolution solution = { wrapToPi(theta1), wrapToPi(theta2) };
+        // both are the same when the arm is fully stretched or folded
+        if (count == 1 && std::abs(solution.theta1 - out[0].theta1) < 1e-6
+            && std::abs(solution.theta2 - out[0].theta2) < 1e-6)
+            break;
+        out[count++] = solution;
+    }
+    return count;
+}
+
+double ikCost(const JointVector &candidate, const JointVector &current, const IkWeights &weights)
+{
+    double cost = 0.0;
+    for (int joint = 0; joint < JointCount; ++joint) {
+        const double value = candidate[joint];
+        if (value < Limits[joint].min || value > Limits[joint].max)
+            return std::numeric_limits<double>::infinity();
+
+        cost += weights.travel[joint] * std::abs(value - current[joint]);
+
+        const double margin = std::min(value - Limits[joint].min, Limits[joint].max - value);
+        if (margin < weights.limitZone) {
+            const double depth = weights.limitZone - margin;
+            cost += weights.limit * depth * depth;
+        }
+    }
+
+    const double clearance = selfClearance(candidate);
+    if (clearance <= 0.0)
+        return std::numeric_limits<double>::infinity();
+    if (clearance < weights.clearanceZone) {
+        const double depth = weights.clearanceZone - clearance;
+        cost += weights.clearance * depth * depth;
+    }
+    return cost;
+}
+
+IkResult solveWrist(const Vec2 &target, const JointVector &current, const IkWeights &weights)
+{
+    IkResult result;
+    result.cost = std::numeric_limits<double>::infinity();
+
+    const Vec2 shoulder = shoulderPosition();
+    Ik2LinkSolution solutions[2];
+    const int count = analyticIk2Link(target.x - shoulder.x, target.y - shoulder.y,
+                                      ForearmLength, ArmLength, solutions);
+
+    for (int i = 0; i < count; ++i) {
+        // The solver measures link angles from the x axis, the model frames
+        // point along y, hence the 90 degrees.
+        const double rotation3 = solutions[i].theta1 * RadToDeg - 90.0 - BaseTilt - ForearmOffset;
+        const double rotation2 = solutions[i].theta2 * RadToDeg - ArmOffset;
+
+        for (const double wrap3 : { -360.0, 0.0, 360.0 }) {
+            for (const double wrap2 : { -360.0, 0.0, 360.0 }) {
+                JointVector candidate = current;
+                candidate[Rotation3] = rotation3 + wrap3;
+                candidate[Rotation2] = rotation2 + wrap2;
+                if (candidate[Rotation3] < Limits[Rotation3].min || candidate[Rotation3] > Limits[Rotation3].max
+                    || candidate[Rotation2] < Limits[Rotation2].min || candidate[Rotation2] > Limits[Rotation2].max)
+                    continue;
+
+                ++result.candidates;
+                const double cost = ikCost(candidate, current, weights);
+                if (cost < result.cost) {
+                    result.valid = true;
+                    result.cost = cost;
+                    result.joints = candidate;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace ArmModel
@@ -0,0 +1,113 @@
+#ifndef ARMMODEL_H
+#define ARMMODEL_H
+
+#include <array>
+#include <cstddef>
+
+// Planar geometry and inverse kinematics of the robot arm.
+// This uses the same hardcoded link rectangles as the original collision
+// check in Backend, so the IK and the "Collision!" status always agree.
+// It has no Qt dependency so that command line tools can reuse it.
+namespace ArmModel {
+
+// Joint order follows the Backend properties rotation1Angle..rotation4Angle.
+// Angles are in degrees.
+enum Joint { Rotation1, Rotation2, Rotation3, Rotation4, JointCount };
+using JointVector = std::array<double, JointCount>;
+
+struct JointLimits
+{
+    double min;
+    double max;
+};
+
+// Slider ranges from MainScreen.qml
+JointLimits jointLimits(int joint);
+
+struct Vec2
+{
+    double x;
+    double y;
+};
+
+enum Link { BaseLink, ForearmLink, ArmLink, HandLink, LinkCount };
+
+// Oriented rectangle of one link in the arm plane, corners in winding order
+struct LinkBox
+{
+    Vec2 corners[4];
+};
+
+using LinkBoxes = std::array<LinkBox, LinkCount>;
+
+LinkBoxes linkBoxes(const JointVector &joints);
+
+// Signed distance between two link boxes, negative when they overlap
+double boxDistance(const LinkBox &a, const LinkBox &b);
+
+// Smallest distance between the link pairs that can hit each other
+// (base/arm, base/hand, forearm/hand). Zero or less means collision.
+double selfClearance(const JointVector &joints);
+double selfClearance(const LinkBoxes &boxes);
+bool isSelfColliding(const JointVector &joints);
+
+// isSelfColliding() for count configurations given as one array per joint
+// (rotation4 does not change the arm plane, so it is not needed). Writes 1
+// for colliding configurations to colliding. The link pairs are tested as
+// oriented boxes with branch-free arithmetic over blocks of configurations,
+// which the compiler can vectorize; use this for paths and planning.
+void isSelfCollidingBatch(const double *rotation1, const double *rotation2, const double *rotation3,
+                          size_t count, unsigned char *colliding);
+
+Vec2 shoulderPosition();
+Vec2 wristPosition(const JointVector &joints);
+double forearmLength();
+double armLength();
+double handLength();
+
+// Yoshikawa manipulability of the forearm/arm chain at the wrist,
+// l1 * l2 * |sin(elbow angle)|. Zero when fully stretched or folded.
+double wristManipulability(const JointVector &joints);
+
+// Analytic IK for a 2-link planar arm, ported from IK/IK.py.
+// Angles are in radians, theta2 is relative to theta1.
+// Returns the number of distinct solutions written to out (0, 1 or 2).
+struct Ik2LinkSolution
+{
+    double theta1;
+    double theta2;
+};
+int analyticIk2Link(double x, double y, double l1, double l2, Ik2LinkSolution out[2]);
+
+// Weights used to rank IK candidates. The cost of a candidate is its weighted
+// joint travel from the current pose, plus quadratic penalties when a joint
+// gets closer than limitZone degrees to its limit or the links get closer
+// than clearanceZone units to each other. Colliding candidates are rejected.
+struct IkWeights
+{
+    JointVector travel = { 1.0, 1.0, 1.0, 1.0 };
+    double limit = 0.5;
+    double limitZone = 10.0;
+    double clearance = 0.5;
+    double clearanceZone = 25.0;
+};
+
+double ikCost(const JointVector &candidate, const JointVector &current, const IkWeights &weights);
+
+struct IkResult
+{
+    bool valid = false;
+    JointVector joints = {};
+    double cost = 0.0;
+    int candidates = 0;
+};
+
+// Places the wrist (hand hinge) at target in the arm plane. rotation1 and
+// rotation4 keep their current values; rotation2 and rotation3 are picked
+// from the elbow-up/elbow-down solutions and their 360 degree equivalents.
+IkResult solveWrist(const Vec2 &target, const JointVector &current,
+                    const IkWeights &weights = IkWeights());
+
+} // namespace ArmModel
+
+#endif // ARMMODEL_H
@@ -0,0 +1,273 @@
+#include "armtrajectory.h"
+
+#include "collisionbatch.h"
+#include "obstaclescene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ArmModel {
+
+namespace {
+
+// Bump when the planner output changes for the same inputs
+constexpr uint32_t PlannerVersion = 1;
+constexpr double ValidationStepDeg = 0.5;
+
+// Trapezoidal profile of the path parameter s, 0 at the start pose and 1 at
+// the end pose. Every joint moves by s times its distance, so the slowest
+// joint sets the velocity and acceleration limits of s.
+struct Profile
+{
+    double velocity = 0.0;
+    double acceleration = 0.0;
+    double rampTime = 0.0;
+    double duration = 0.0;
+};
+
+Profile profileOf(const JointVector &from, const JointVector &to, const MotionLimits &limits)
+{
+    double velocity = std::numeric_limits<double>::infinity();
+    double acceleration = std::numeric_limits<double>::infinity();
+    for (int joint = 0; joint < JointCount; joint++) {
+        const double distance = std::abs(to[joint] - from[joint]);
+        if (distance < 1e-9)
+            continue;
+        velocity = std::min(velocity, limits.maxVelocity[joint] / distance);
+        acceleration = std::min(acceleration, limits.maxAcceleration[joint] / distance);
+    }
+
+    Profile profile;
+    if (std::isinf(velocity))
+        return profile;
+    if (velocity * velocity / acceleration >= 1.0) {
+        // Triangle: top speed is never reached
+        profile.rampTime = std::sqrt(1.0 / acceleration);
+        profile.velocity = acceleration * profile.rampTime;
+        profile.duration = 2.0 * profile.rampTime;
+    } else {
+        profile.rampTime = velocity / acceleration;
+        profile.velocity = velocity;
+        profile.duration = 1.0 / velocity + velocity / acceleration;
+    }
+    profile.acceleration = acceleration;
+    return profile;
+}
+
+double positionAt(const Profile &profile, double t)
+{
+    if (t <= 0.0)
+        return 0.0;
+    if (t >= profile.duration)
+        return 1.0;
+    const double a = profile.acceleration;
+    const double ramp = profile.rampTime;
+    if (t < ramp)
+        return 0.5 * a * t * t;
+    if (t < profile.duration - ramp)
+        return 0.5 * a * ramp * ramp + profile.velocity * (t - ramp);
+    const double left = profile.duration - t;
+    return 1.0 - 0.5 * a * left * left;
+}
+
+JointVector lerp(const JointVector &from, const JointVector &to, double s)
+{
+    JointVector joints;
+    for (int joint = 0; joint < JointCount; joint++)
+        joints[joint] = from[joint] + (to[joint] - from[joint]) * s;
+    return joints;
+}
+
+bool withinLimits(const JointVector &joints)
+{
+    for (int joint = 0; joint < JointCount; joint++) {
+        const JointLimits limits = jointLimits(joint);
+        if (joints[joint] < limits.min || joints[joint] > limits.max)
+            return false;
+    }
+    return true;
+}
+
+JointBatch segmentSamples(const JointVector &from, const JointVector &to, double maxStepDeg)
+{
+    double travel = 0.0;
+    for (int joint = 0; joint < JointCount; joint++)
+        travel = std::max(travel, std::abs(to[joint] - from[joint]));
+    JointBatch samples;
+    samples.appendSegment(from, to, size_t(std::max(1.0, std::ceil(travel / maxStepDeg))));
+    return samples;
+}
+
+bool segmentIsSceneClear(const JointBatch &samples, const ObstacleScene &scene)
+{
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (isSceneColliding(scene, samples.at(i)))
+            return false;
+    }
+    return true;
+}
+
+bool segmentIsClear(const JointVector &from, const JointVector &to, double maxStepDeg,
+                    const ObstacleScene *scene = nullptr)
+{
+    const JointBatch samples = segmentSamples(from, to, maxStepDeg);
+    if (CollisionChecker().firstCollision(samples) != CollisionChecker::NoCollision)
+        return false;
+    return !scene || scene->isEmpty() || segmentIsSceneClear(samples, *scene);
+}
+
+// Appends a straight move to a trajectory that ends at from
+void appendMove(Trajectory &trajectory, const JointVector &from, const JointVector &to, const MotionLimits &limits)
+{
+    if (trajectory.empty())
+        trajectory.push_back({ 0.0, from });
+    const Profile profile = profileOf(from, to, limits);
+    const double start = trajectory.back().timeMs;
+    const double durationMs = profile.duration * 1000.0;
+    for (double t = TrajectorySampleMs; t < durationMs; t += TrajectorySampleMs)
+        trajectory.push_back({ start + t, lerp(from, to, positionAt(profile, t / 1000.0)) });
+    if (durationMs > 0.0)
+        trajectory.push_back({ start + durationMs, to });
+}
+
+struct Candidate
+{
+    JointVector via;
+    bool direct;
+    double duration;
+};
+
+void hash(uint64_t &h, const void *data, size_t size)
+{
+    // FNV-1a
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+}
+
+void hash(uint64_t &h, double value)
+{
+    hash(h, &value, sizeof(value));
+}
+
+void hash(uint64_t &h, const Vec3 &v)
+{
+    hash(h, v.x);
+    hash(h, v.y);
+    hash(h, v.z);
+}
+
+void hashScene(uint64_t &h, const ObstacleScene &scene)
+{
+    for (int obstacle = 0; obstacle < scene.obstacleCount(); obstacle++) {
+        const ObstacleScene::Shape shape = scene.shape(obstacle);
+        hash(h, &shape, sizeof(shape));
+        switch (shape) {
+        case ObstacleScene::Box: {
+            const BoxObstacle &box = scene.box(obstacle);
+            hash(h, box.center);
+            hash(h, box.halfExtents);
+            hash(h, box.yaw);
+            break;
+        }
+        case ObstacleScene::Cylinder: {
+            const CylinderObstacle &cylinder = scene.cylinder(obstacle);
+            hash(h, cylinder.center);
+            hash(h, cylinder.radius);
+            hash(h, cylinder.halfHeight);
+            break;
+        }
+        case ObstacleScene::Mesh: {
+            const MeshObstacle &mesh = scene.mesh(obstacle);
+            for (const Vec3 &vertex : mesh.vertices)
+                hash(h, vertex);
+            hash(h, mesh.triangles.data(), mesh.triangles.size() * sizeof(mesh.triangles[0]));
+            break;
+        }
+        }
+    }
+}
+
+} // namespace
+
+Trajectory planTrajectory(const JointVector &from, const JointVector &to, const MotionLimits &limits,
+                          const ObstacleScene *scene)
+{
+    if (!withinLimits(from) || !withinLimits(to) || isSelfColliding(from) || isSelfColliding(to))
+        return {};
+    if (scene && (isSceneColliding(*scene, from) || isSceneColliding(*scene, to)))
+        return {};
+
+    std::vector<Candidate> candidates;
+    candidates.push_back({ to, true, profileOf(from, to, limits).duration });
+    for (unsigned mask = 1; mask + 1 < (1u << JointCount); mask++) {
+        JointVector via = from;
+        for (int joint = 0; joint < JointCount; joint++) {
+            if (mask & (1u << joint))
+                via[joint] = to[joint];
+        }
+        candidates.push_back({ via, false, 0.0 });
+    }
+    candidates.push_back({ JointVector {}, false, 0.0 });
+    for (Candidate &candidate : candidates) {
+        if (!candidate.direct)
+            candidate.duration = profileOf(from, candidate.via, limits).duration
+                    + profileOf(candidate.via, to, limits).duration;
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Candidate &a, const Candidate &b) { return a.duration < b.duration; });
+
+    for (const Candidate &candidate : candidates) {
+        Trajectory trajectory;
+        if (candidate.direct) {
+            if (!segmentIsClear(from, to, ValidationStepDeg, scene))
+                continue;
+            appendMove(trajectory, from, to, limits);
+        } else {
+            if (!segmentIsClear(from, candidate.via, ValidationStepDeg, scene)
+                || !segmentIsClear(candidate.via, to, ValidationStepDeg, scene))
+                continue;
+            appendMove(trajectory, from, candidate.via, limits);
+            appendMove(trajectory, candidate.via, to, limits);
+        }
+        return trajectory;
+    }
+    return {};
+}
+
+uint64_t planFingerprint(const MotionLimits &limits, const ObstacleScene *scene)
+{
+    uint64_t h = 14695981039346656037ull;
+    hash(h, &PlannerVersion, sizeof(PlannerVersion));
+    hash(h, TrajectorySampleMs);
+    hash(h, ValidationStepDeg);
+    for (int joint = 0; joint < JointCount; joint++) {
+        hash(h, jointLimits(joint).min);
+        hash(h, jointLimits(joint).max);
+        hash(h, limits.maxVelocity[joint]);
+        hash(h, limits.maxAcceleration[joint]);
+    }
+
+    // The link geometry, seen through the boxes at a few poses
+    const JointVector poses[] = {
+        { 0.0, 0.0, 0.0, 0.0 },
+        { 45.0, -60.0, 30.0, 90.0 },
+        { -80.0, 120.0, -75.0, -150.0 },
+    };
+    for (const JointVector &pose : poses) {
+        for (const LinkBox &box : linkBoxes(pose)) {
+            for (const Vec2 &corner : box.corners) {
+                hash(h, corner.x);
+                hash(h, corner.y);
+            }
+        }
+    }
+    if (scene)
+        hashScene(h, *scene);
+    return h;
+}
+
+} // namespace ArmModel
@@ -0,0 +1,52 @@
+#ifndef ARMTRAJECTORY_H
+#define ARMTRAJECTORY_H
+
+#include "armmodel.h"
+
+#include <cstdint>
+#include <vector>
+
+// Collision-checked point-to-point trajectories for the arm model.
+// It has no Qt dependency so that command line tools can reuse it.
+namespace ArmModel {
+
+class ObstacleScene;
+
+struct MotionLimits
+{
+    JointVector maxVelocity = { 300.0, 300.0, 300.0, 300.0 };          // deg/s, servo slew
+    JointVector maxAcceleration = { 1500.0, 1500.0, 1500.0, 1500.0 }; // deg/s^2
+};
+
+struct TrajectoryPoint
+{
+    double timeMs;
+    JointVector joints;
+};
+
+using Trajectory = std::vector<TrajectoryPoint>;
+
+// Samples of a trajectory are this far apart, one set_servo per PWM frame
+constexpr double TrajectorySampleMs = 20.0;
+
+// Time-optimal move from one pose to another under the limits. The straight
+// line in joint space is tried first, with a trapezoidal velocity profile
+// shared by all joints so that they start and stop together. When it hits
+// the base or the forearm, two-segment moves through a via pose are tried:
+// the corner poses that move one group of joints before the others, and the
+// all-zero pose. The fastest collision-free one wins. With a scene, the
+// moves must also keep clear of its obstacles.
+// Returns an empty trajectory when no candidate is collision-free or a pose
+// is outside the joint limits.
+Trajectory planTrajectory(const JointVector &from, const JointVector &to,
+                          const MotionLimits &limits = MotionLimits(), const ObstacleScene *scene = nullptr);
+
+// Hash of everything a planned trajectory depends on: the joint limits, the
+// link geometry, the motion limits, the planner itself and the obstacles of
+// the scene, if any. Trajectories cached under a different fingerprint are
+// stale.
+uint64_t planFingerprint(const MotionLimits &limits, const ObstacleScene *scene = nullptr);
+
+} // namespace ArmModel
+
+#endif // ARMTRAJECTORY_H
@@ -3,19 +3,56 @@
 
 #include "backend.h"
 #include "esp32client.h" // Include the header for the network client
-#include <QTransform>
+#include "scenefile.h"
+#include "speedscaling.h"
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+// Slider range [-90, 90] maps to the servo range [0, 180]
+constexpr int ServoOffset = 90;
+
+// Redraw rate of the predicted pose while telemetry is coming in
+constexpr int PredictionIntervalMs = 16;
+
+// Trajectory sampling, faster than the 20 ms the client sends at
+constexpr int TrajectoryIntervalMs = 10;
+
+// A trajectory whose clock has run below this fraction of real time for
+// TrajectoryStallMs is held up by an obstacle and given up
+constexpr double MinTrajectorySpeedScale = 0.05;
+constexpr double TrajectoryStallMs = 1000.0;
+
+} // namespace
 
 Backend::Backend(QObject *parent) : QObject(parent)
 {
     // Initialize the connection status property to false
     m_isConnected.setValue(false);
 
-    // --- Existing connections for robot arm UI updates ---
-    connect(&m_rotation1Angle, &AnimatedParam::valueChanged, this, &Backend::rot1AngleChanged);
-    connect(&m_rotation2Angle, &AnimatedParam::valueChanged, this, &Backend::rot2AngleChanged);
-    connect(&m_rotation3Angle, &AnimatedParam::valueChanged, this, &Backend::rot3AngleChanged);
-    connect(&m_rotation4Angle, &AnimatedParam::valueChanged, this, &Backend::rot4AngleChanged);
-    connect(&m_clawsAngle, &AnimatedParam::valueChanged, this, &Backend::clawsAngleChanged);
+    // --- Robot arm UI updates ---
+    // One notification per frame for all joints, collision detection and the
+    // predicted pose only run when an arm joint actually moved
+    connect(&m_animator, &JointAnimator::updated, this, &Backend::onJointsUpdated);
+
+    // Every animation step of the arm is checked against the scene, so it
+    // moves at full speed in the open and slows down near obstacles
+    m_animator.setStepLimiter([this](const JointAnimator::Values &position, const JointAnimator::Values &step,
+                                     double dt) {
+        ArmModel::JointVector from, delta;
+        for (int joint = 0; joint < ArmModel::JointCount; joint++) {
+            from[joint] = position[joint];
+            delta[joint] = step[joint];
+        }
+        return ArmModel::stepScale(m_scene, from, delta, dt);
+    });
+    m_speedScaleNotifier = m_animator.bindableStepScale().addNotifier([this]() { emit speedScaleChanged(); });
+    m_poseLibrary.setScene(&m_scene);
 
     // --- CORRECTED Status Binding ---
     // The status text now depends on the m_isConnected property.
@@ -28,19 +65,21 @@ Backend::Backend(QObject *parent) : QObject(parent)
             return QString("Connected to Servo");
 
         // Check arm animation state
-        if (m_rotation1Angle.isRunning() || m_rotation2Angle.isRunning() || m_rotation3Angle.isRunning()
-            || m_rotation4Angle.isRunning())
+        if (m_animator.isRunning())
             return QString("Busy");
 
         // Default state
         return QString("Ready");
     });
 
-    // --- Existing connections for collision detection ---
-    connect(&m_rotation1Angle, &AnimatedParam::valueChanged, this, &Backend::detectCollision);
-    connect(&m_rotation2Angle, &AnimatedParam::valueChanged, this, &Backend::detectCollision);
-    connect(&m_rotation3Angle, &AnimatedParam::valueChanged, this, &Backend::detectCollision);
-    connect(&m_rotation4Angle, &AnimatedParam::valueChanged, this, &Backend::detectCollision);
+    m_clock.start();
+    m_predictionTimer.setInterval(PredictionIntervalMs);
+    m_predictionTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_predictionTimer, &QTimer::timeout, this, &Backend::updatePredictedPose);
+
+    m_trajectoryTimer.setInterval(TrajectoryIntervalMs);
+    m_trajectoryTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_trajectoryTimer, &QTimer::timeout, this, &Backend::advanceTrajectory);
 }
 
 Backend::~Backend()
@@ -76,6 +115,20 @@ void Backend::connectToDevice(const QString &ip, int port)
         m_isConnected.setValue(false);
     });
 
+    m_espClient->setTrace(&m_trace);
+    connect(m_espClient, &ESP32Client::servoPositionReceived, this, &Backend::onServoPosition);
+    connect(m_espClient, &ESP32Client::roundTripMeasured, this, &Backend::onRoundTrip);
+    // The client coalesces commands, the predictor needs the ones that went out
+    connect(m_espClient, &ESP32Client::servoCommandSent, this, [this](int angle) {
+        m_predictor.command(angle, m_clock.nsecsElapsed() / 1e6);
+        if (m_hasTelemetry)
+            m_predictionTimer.start();
+    });
+
+    // The device pose is unknown until telemetry arrives
+    m_predictor.reset(rotation1Angle() + ServoOffset, m_clock.nsecsElapsed() / 1e6);
+    m_hasTelemetry = false;
+
     m_status.setValue("Connecting...");
     m_espClient->connectToHost();
 }
@@ -89,55 +142,523 @@ void Backend::disconnectFromDevice()
     }
     // CORRECTED: Set our property to false. The binding will update the UI status.
     m_isConnected.setValue(false);
+
+    m_predictionTimer.stop();
+    m_hasTelemetry = false;
+    emit predictedPoseChanged();
 }
 
 
+void Backend::startTrace()
+{
+    m_trace.start();
+}
+
+bool Backend::saveTrace(const QString &path)
+{
+    m_trace.stop();
+    if (!m_trace.writeChromeTrace(path.toStdString())) {
+        qWarning() << "Cannot write command trace" << path;
+        return false;
+    }
+    return true;
+}
+
+void Backend::setWindow(QQuickWindow *window)
+{
+    if (window == m_animator.window())
+        return;
+    m_animator.setWindow(window);
+    emit windowChanged();
+}
+
 // --- MODIFIED Setter for Rotation 1 ---
 void Backend::setRot1Angle(const int angle)
 {
     // This first part is the original logic: it updates the angle for the 3D model.
-    m_rotation1Angle.setValue(angle);
+    if (!setSliderTarget(JointAnimator::Rotation1, angle))
+        return;
+    m_trace.input(angle + ServoOffset);
+    followRotation1();
+}
 
+bool Backend::rotation1IsUnscaled() const
+{
+    if (m_scene.isEmpty())
+        return true;
+    // The hand tip at the servo's slew rate is the fastest the servo can
+    // close in on the scene
+    const double tipSpeed = ArmModel::handLength() * qDegreesToRadians(m_predictor.plant().maxSlewDps);
+    return speedScale() >= 1.0 && m_sceneClearance > ArmModel::slowDownDistance(tipSpeed);
+}
+
+void Backend::followRotation1(bool force)
+{
+    // Speed scaling only holds back the animation. In the open the servo
+    // heads straight for the target, within the slow-down distance a servo
+    // sent the target would outrun the animation into the obstacle, so it
+    // is sent the speed limited animation instead
+    const int angle = rotation1IsUnscaled() ? qRound(m_animator.target(JointAnimator::Rotation1)) : rotation1Angle();
+    if (angle == m_followedRotation1 && !force)
+        return;
+    m_followedRotation1 = angle;
+    sendRotation1(angle);
+}
+
+void Backend::sendRotation1(int angle)
+{
     // --- NEW LOGIC: Send data to ESP32 ---
     // Check if the client object exists and is successfully connected.
     if (m_espClient && m_espClient->isConnected()) {
         // Map the slider's range [-90, 90] to the servo's range [0, 180].
-        int servoAngle = angle + 90;
+        int servoAngle = angle + ServoOffset;
         m_espClient->controlServo(servoAngle);
+    } else {
+        m_trace.discardInput();
     }
 }
 
+// Sliders hold whole degrees while jogging and trajectories move the targets
+// in fractions, a slider following the target must not round it back
+bool Backend::setSliderTarget(int joint, int angle)
+{
+    if (qRound(m_animator.target(joint)) == angle)
+        return false;
+    m_animator.setTarget(joint, angle);
+    return true;
+}
+
+ArmModel::JointVector Backend::jointTargets() const
+{
+    return { m_animator.target(JointAnimator::Rotation1), m_animator.target(JointAnimator::Rotation2),
+             m_animator.target(JointAnimator::Rotation3), m_animator.target(JointAnimator::Rotation4) };
+}
+
+void Backend::setJointTargets(const ArmModel::JointVector &joints)
+{
+    for (int joint = 0; joint < ArmModel::JointCount; joint++)
+        m_animator.setTarget(joint, joints[joint]);
+    followRotation1();
+}
+
+void Backend::jogJoints(const ArmModel::JointVector &degreesPerSecond, double clawsDegreesPerSecond, double dt)
+{
+    // While the arm is held back near an obstacle the targets would run away
+    // from it, so jogging continues from where the arm actually is
+    ArmModel::JointVector joints = jointTargets();
+    if (speedScale() < 1.0) {
+        for (int joint = 0; joint < ArmModel::JointCount; joint++)
+            joints[joint] = m_animator.value(joint);
+    }
+    for (int joint = 0; joint < ArmModel::JointCount; joint++) {
+        const ArmModel::JointLimits limits = ArmModel::jointLimits(joint);
+        joints[joint] = qBound(limits.min, joints[joint] + degreesPerSecond[joint] * dt, limits.max);
+    }
+    if (joints != jointTargets()) {
+        setJointTargets(joints);
+        emit jogged({ joints[0], joints[1], joints[2], joints[3] });
+    }
+
+    // Same range as the claw toggle of MainScreen.qml
+    const double claws = m_animator.target(JointAnimator::Claws) + clawsDegreesPerSecond * dt;
+    m_animator.setTarget(JointAnimator::Claws, qBound(0.0, claws, 90.0));
+}
+
+bool Backend::jogWrist(double vx, double vy, double dt)
+{
+    const ArmModel::JointVector current = jointTargets();
+    const ArmModel::Vec2 wrist = ArmModel::wristPosition(current);
+    const ArmModel::Vec2 target { wrist.x + vx * dt, wrist.y + vy * dt };
+    if (m_reachabilityMap.isValid()) {
+        const double yaw = qDegreesToRadians(current[ArmModel::Rotation4]);
+        if (!isReachable(target.x * qCos(yaw), target.y, target.x * qSin(yaw)))
+            return false;
+    }
+    const ArmModel::IkResult result = ArmModel::solveWrist(target, current);
+    if (!result.valid)
+        return false;
+    setJointTargets(result.joints);
+    emit jogged({ result.joints[0], result.joints[1], result.joints[2], result.joints[3] });
+    return true;
+}
+
 // --- ALL FUNCTIONS BELOW THIS POINT ARE UNCHANGED ---
 
-int Backend::rotation1Angle() const { return m_rotation1Angle.value(); }
-int Backend::rotation2Angle() const { return m_rotation2Angle.value(); }
-void Backend::setRot2Angle(const int angle) { m_rotation2Angle.setValue(angle); }
-int Backend::rotation3Angle() const { return m_rotation3Angle.value(); }
-void Backend::setRot3Angle(const int angle) { m_rotation3Angle.setValue(angle); }
-int Backend::rotation4Angle() const { return m_rotation4Angle.value(); }
-void Backend::setRot4Angle(const int angle) { m_rotation4Angle.setValue(angle); }
-int Backend::clawsAngle() const { return m_clawsAngle.value(); }
-void Backend::setClawsAngle(const int angle) { m_clawsAngle.setValue(angle); }
+int Backend::rotation1Angle() const { return qRound(m_animator.value(JointAnimator::Rotation1)); }
+int Backend::rotation2Angle() const { return qRound(m_animator.value(JointAnimator::Rotation2)); }
+void Backend::setRot2Angle(const int angle) { setSliderTarget(JointAnimator::Rotation2, angle); }
+int Backend::rotation3Angle() const { return qRound(m_animator.value(JointAnimator::Rotation3)); }
+void Backend::setRot3Angle(const int angle) { setSliderTarget(JointAnimator::Rotation3, angle); }
+int Backend::rotation4Angle() const { return qRound(m_animator.value(JointAnimator::Rotation4)); }
+void Backend::setRot4Angle(const int angle) { setSliderTarget(JointAnimator::Rotation4, angle); }
+int Backend::clawsAngle() const { return qRound(m_animator.value(JointAnimator::Claws)); }
+void Backend::setClawsAngle(const int angle) { m_animator.setTarget(JointAnimator::Claws, angle); }
+QQuickWindow *Backend::window() const { return m_animator.window(); }
 QString Backend::status() const { return m_status; }
 QBindable<QString> Backend::bindableStatus() const { return &m_status; }
 
+ArmModel::JointVector Backend::jointVector() const
+{
+    return { double(rotation1Angle()), double(rotation2Angle()), double(rotation3Angle()),
+             double(rotation4Angle()) };
+}
+
+QVariantList Backend::solveWristTarget(qreal x, qreal y) const
+{
+    // The arm plane is turned by rotation4 around the vertical axis, the same
+    // check as jogWrist()
+    if (m_reachabilityMap.isValid()) {
+        const qreal yaw = qDegreesToRadians(qreal(rotation4Angle()));
+        if (!isReachable(x * qCos(yaw), y, x * qSin(yaw)))
+            return {};
+    }
+
+    // Picks the elbow-up/elbow-down solution closest to the current pose that
+    // stays inside the slider limits and clear of the base.
+    const ArmModel::IkResult result = ArmModel::solveWrist({ x, y }, jointVector());
+    if (!result.valid)
+        return {};
+
+    QVariantList angles;
+    for (const double angle : result.joints)
+        angles.append(qRound(angle));
+    return angles;
+}
+
+bool Backend::loadReachabilityMap(const QString &path)
+{
+    m_reachabilityMap.detach();
+    m_reachabilityFile.close();
+
+    m_reachabilityFile.setFileName(path);
+    if (!m_reachabilityFile.open(QIODevice::ReadOnly))
+        return false;
+
+    // The file stays mapped for the lifetime of the map, nothing is copied
+    const uchar *data = m_reachabilityFile.map(0, m_reachabilityFile.size());
+    if (!data || !m_reachabilityMap.attach(data, size_t(m_reachabilityFile.size()))) {
+        m_reachabilityFile.close();
+        return false;
+    }
+    return true;
+}
+
+bool Backend::isReachable(qreal x, qreal y, qreal z) const
+{
+    return m_reachabilityMap.isReachable(x, y, z);
+}
+
+bool Backend::loadServoCalibration(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    const QJsonArray joints = doc.object()["joints"].toArray();
+    for (const QJsonValue &value : joints) {
+        const QJsonObject joint = value.toObject();
+        if (joint["joint"].toInt() != 0)
+            continue;
+
+        const ServoPlant defaults;
+        ServoPlant plant;
+        plant.delayMs = joint["delay_ms"].toDouble(defaults.delayMs);
+        plant.timeConstantMs = joint["time_constant_ms"].toDouble(defaults.timeConstantMs);
+        plant.maxSlewDps = joint["max_slew_dps"].toDouble(defaults.maxSlewDps);
+        plant.deadbandDeg = joint["deadband_deg"].toDouble(defaults.deadbandDeg);
+        plant.noiseDeg = joint["noise_deg"].toDouble(defaults.noiseDeg);
+        m_predictor.setPlant(plant);
+        return true;
+    }
+    return false;
+}
+
+void Backend::resetPredictionStats()
+{
+    m_predictionStats = PredictionStats();
+    emit predictionStatsChanged();
+}
+
+QVariantList Backend::predictedPose() const
+{
+    qreal rotation1 = rotation1Angle();
+    if (m_hasTelemetry)
+        rotation1 = m_predictor.predict(m_clock.nsecsElapsed() / 1e6) - ServoOffset;
+    return { rotation1, rotation2Angle(), rotation3Angle(), rotation4Angle() };
+}
+
+QVariantMap Backend::predictionStats() const
+{
+    const PredictionStats &stats = m_predictionStats;
+    const int n = qMax(stats.samples, 1);
+    return {
+        { "samples", stats.samples },
+        { "rmsErrorDeg", qSqrt(stats.sumSquares / n) },
+        { "maxErrorDeg", stats.maxError },
+        { "holdRmsErrorDeg", qSqrt(stats.holdSumSquares / n) },
+        { "linkLatencyMs", m_linkLatencyMs },
+    };
+}
+
+void Backend::onServoPosition(int index, double position)
+{
+    emit telemetryReceived(index, position);
+    if (index != 0)
+        return;
+
+    const double error = m_predictor.measure(position, m_clock.nsecsElapsed() / 1e6);
+    if (m_hasTelemetry) {
+        // The first sample only seeds the filter
+        PredictionStats &stats = m_predictionStats;
+        stats.samples++;
+        stats.sumSquares += error * error;
+        stats.holdSumSquares += (position - m_lastSample) * (position - m_lastSample);
+        stats.maxError = qMax(stats.maxError, qAbs(error));
+        emit predictionStatsChanged();
+    }
+    m_lastSample = position;
+
+    // The sample may have moved the estimate, keep redrawing while it moves
+    m_hasTelemetry = true;
+    emit predictedPoseChanged();
+    if (!m_predictionTimer.isActive() && !m_predictor.isSettled(m_clock.nsecsElapsed() / 1e6))
+        m_predictionTimer.start();
+}
+
+void Backend::updatePredictedPose()
+{
+    emit predictedPoseChanged();
+    // Idle arm, nothing to animate until the next command or sample
+    if (m_predictor.isSettled(m_clock.nsecsElapsed() / 1e6))
+        m_predictionTimer.stop();
+}
+
+void Backend::onRoundTrip(double milliseconds)
+{
+    // Half the acknowledgement time, smoothed against WiFi jitter
+    const double oneWay = milliseconds / 2.0;
+    m_linkLatencyMs = m_linkLatencyMs > 0.0 ? 0.9 * m_linkLatencyMs + 0.1 * oneWay : oneWay;
+    m_predictor.setLinkLatency(m_linkLatencyMs);
+}
+
+bool Backend::playTrajectory(const QVariantList &points)
+{
+    ArmModel::Trajectory trajectory;
+    trajectory.reserve(size_t(points.size()));
+    for (const QVariant &value : points) {
+        const QVariantMap point = value.toMap();
+        const QVariantList joints = point.value("joints").toList();
+        if (!point.contains("t_ms") || joints.size() != ArmModel::JointCount)
+            return false;
+
+        ArmModel::TrajectoryPoint entry { point.value("t_ms").toDouble(), {} };
+        if (!trajectory.empty() && entry.timeMs < trajectory.back().timeMs)
+            return false;
+        for (int joint = 0; joint < ArmModel::JointCount; joint++) {
+            const ArmModel::JointLimits limits = ArmModel::jointLimits(joint);
+            entry.joints[joint] = joints[joint].toDouble();
+            if (entry.joints[joint] < limits.min || entry.joints[joint] > limits.max)
+                return false;
+        }
+        if (ArmModel::isSelfColliding(entry.joints) || ArmModel::isSceneColliding(m_scene, entry.joints))
+            return false;
+        trajectory.push_back(entry);
+    }
+    if (trajectory.empty())
+        return false;
+
+    startTrajectory(std::move(trajectory));
+    return true;
+}
+
+void Backend::startTrajectory(ArmModel::Trajectory trajectory)
+{
+    if (isTrajectoryRunning())
+        finishTrajectory(false);
+    m_trajectory = std::move(trajectory);
+    m_trajectoryTimeMs = 0.0;
+    m_trajectoryClockMs = m_clock.nsecsElapsed() / 1e6;
+    m_trajectoryStallMs = 0.0;
+    m_trajectoryTimer.start();
+    emit trajectoryRunningChanged();
+    advanceTrajectory();
+}
+
+void Backend::stopTrajectory()
+{
+    if (isTrajectoryRunning())
+        finishTrajectory(false);
+}
+
+bool Backend::isTrajectoryRunning() const
+{
+    return m_trajectoryTimer.isActive();
+}
+
+QVariantList Backend::targetPose() const
+{
+    const ArmModel::JointVector joints = jointTargets();
+    return { joints[0], joints[1], joints[2], joints[3] };
+}
+
+bool Backend::loadPoseLibrary(const QString &path)
+{
+    QString error;
+    const bool loaded = m_poseLibrary.load(path, &error);
+    if (!loaded)
+        qWarning() << "Cannot load pose library" << path << error;
+    emit poseLibraryChanged();
+    return loaded;
+}
+
+bool Backend::goToPose(const QString &name)
+{
+    const int index = m_poseLibrary.indexOf(name);
+    if (index < 0)
+        return false;
+
+    // The common case, preset to preset, is a lookup
+    const ArmModel::JointVector current = jointTargets();
+    const int from = m_poseLibrary.poseAt(current);
+    if (from == index && !isTrajectoryRunning())
+        return true;
+    // The library is planned against the current scene
+    const ArmModel::Trajectory *cached = m_poseLibrary.trajectory(from, index);
+    if (cached) {
+        startTrajectory(*cached);
+        return true;
+    }
+
+    ArmModel::Trajectory trajectory = ArmModel::planTrajectory(current, m_poseLibrary.poses()[index].joints,
+                                                               m_poseLibrary.motionLimits(), &m_scene);
+    if (trajectory.empty())
+        return false;
+    startTrajectory(std::move(trajectory));
+    return true;
+}
+
+QVariantList Backend::poseJoints(const QString &name) const
+{
+    const int index = m_poseLibrary.indexOf(name);
+    if (index < 0)
+        return {};
+    QVariantList joints;
+    for (const double angle : m_poseLibrary.poses()[index].joints)
+        joints.append(angle);
+    return joints;
+}
+
+QStringList Backend::poseNames() const
+{
+    QStringList names;
+    for (const PoseLibrary::Pose &pose : m_poseLibrary.poses())
+        names.append(pose.name);
+    return names;
+}
+
+bool Backend::loadScene(const QString &path)
+{
+    QString error;
+    const bool loaded = loadSceneFile(path, m_scene, &error);
+    if (!loaded)
+        qWarning() << "Cannot load scene" << path << error;
+    m_poseLibrary.setScene(&m_scene);
+    emit sceneChanged();
+    detectCollision();
+    if (!m_scene.isEmpty())
+        followRotation1(true);
+    return loaded;
+}
+
+void Backend::clearScene()
+{
+    m_scene.clear();
+    m_poseLibrary.setScene(&m_scene);
+    emit sceneChanged();
+    detectCollision();
+    followRotation1(true);
+}
+
+void Backend::advanceTrajectory()
+{
+    const double now = m_clock.nsecsElapsed() / 1e6;
+    const double elapsed = now - m_trajectoryClockMs;
+    m_trajectoryTimeMs += elapsed * speedScale();
+    m_trajectoryStallMs = speedScale() < MinTrajectorySpeedScale ? m_trajectoryStallMs + elapsed : 0.0;
+    m_trajectoryClockMs = now;
+    if (m_trajectoryStallMs >= TrajectoryStallMs) {
+        // The arm rests where the obstacle stopped it
+        ArmModel::JointVector joints;
+        for (int joint = 0; joint < ArmModel::JointCount; joint++)
+            joints[joint] = m_animator.value(joint);
+        setJointTargets(joints);
+        finishTrajectory(false);
+        return;
+    }
+    const double t = m_trajectoryTimeMs;
+    const auto next = std::upper_bound(m_trajectory.begin(), m_trajectory.end(), t,
+                                       [](double time, const ArmModel::TrajectoryPoint &p) { return time < p.timeMs; });
+    if (next == m_trajectory.end()) {
+        setJointTargets(m_trajectory.back().joints);
+        finishTrajectory(true);
+        return;
+    }
+    if (next == m_trajectory.begin()) {
+        setJointTargets(next->joints);
+        return;
+    }
+
+    const ArmModel::TrajectoryPoint &a = *(next - 1);
+    const ArmModel::TrajectoryPoint &b = *next;
+    const double f = (t - a.timeMs) / (b.timeMs - a.timeMs);
+    ArmModel::JointVector joints;
+    for (int joint = 0; joint < ArmModel::JointCount; joint++)
+        joints[joint] = a.joints[joint] + (b.joints[joint] - a.joints[joint]) * f;
+    setJointTargets(joints);
+}
+
+void Backend::finishTrajectory(bool completed)
+{
+    m_trajectoryTimer.stop();
+    m_trajectory.clear();
+    emit trajectoryRunningChanged();
+    emit trajectoryFinished(completed);
+}
+
+void Backend::onJointsUpdated(unsigned changedChannels)
+{
+    // Property notifications stay per joint so QML bindings only re-evaluate
+    // for joints that moved
+    if (changedChannels & (1u << JointAnimator::Rotation1))
+        emit rot1AngleChanged();
+    if (changedChannels & (1u << JointAnimator::Rotation2))
+        emit rot2AngleChanged();
+    if (changedChannels & (1u << JointAnimator::Rotation3))
+        emit rot3AngleChanged();
+    if (changedChannels & (1u << JointAnimator::Rotation4))
+        emit rot4AngleChanged();
+    if (changedChannels & (1u << JointAnimator::Claws))
+        emit clawsAngleChanged();
+
+    // Any arm joint changes the clearance, which decides whether the servo
+    // gets the target or the animation
+    if (changedChannels & ~(1u << JointAnimator::Claws)) {
+        detectCollision();
+        emit predictedPoseChanged();
+        followRotation1();
+    }
+}
+
 void Backend::detectCollision()
 {
     // simple aproximate collision detection, uses hardcoded model dimensions
-    QPolygon pol1(QRect(-70, 0, 70, 300));
-    QTransform t;
-    t.rotate(8.7);
-    t.translate(0, 259);
-    t.rotate(-20.);
-    t.rotate(rotation3Angle());
-    QPolygon pol2 = t.mapToPolygon(QRect(-35, 0, 35, 233));
-    t.translate(0, 233);
-    t.rotate(15);
-    t.rotate(rotation2Angle());
-    QPolygon pol3 = t.mapToPolygon(QRect(-27, 0, 27, 212));
-    t.translate(0, 212);
-    t.rotate(rotation1Angle());
-    QPolygon pol4 = t.mapToPolygon(QRect(-42, 0, 42, 180));
-    m_isCollision.setValue(pol1.intersects(pol3) || pol1.intersects(pol4) || pol2.intersects(pol4));
+    m_collisionChecks++;
+    const ArmModel::JointVector joints = jointVector();
+    const double clearance = ArmModel::sceneClearance(m_scene, joints).distance;
+    if (clearance != m_sceneClearance) {
+        m_sceneClearance = clearance;
+        emit sceneClearanceChanged();
+    }
+    m_isCollision.setValue(ArmModel::isSelfColliding(joints) || clearance <= 0.0);
 }
-
@@ -4,8 +4,22 @@
 #ifndef BACKEND_H
 #define BACKEND_H
 
-#include "animatedparam.h"
+#include "armmodel.h"
+#include "armtrajectory.h"
+#include "commandtrace.h"
+#include "jointanimator.h"
+#include "obstaclescene.h"
+#include "poselibrary.h"
+#include "reachabilitymap.h"
+#include "servopredictor.h"
+#include <QElapsedTimer>
+#include <QFile>
 #include <QObject>
+#include <QQuickWindow>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantList>
+#include <QVariantMap>
 #include <qqmlregistration.h>
 
 // Forward-declare the ESP32Client class to avoid including its full header here.
@@ -22,6 +36,17 @@ class Backend : public QObject
     Q_PROPERTY(int rotation4Angle READ rotation4Angle WRITE setRot4Angle NOTIFY rot4AngleChanged)
     Q_PROPERTY(int clawsAngle READ clawsAngle WRITE setClawsAngle NOTIFY clawsAngleChanged)
     Q_PROPERTY(QString status READ status BINDABLE bindableStatus)
+    // Window whose frames drive the joint animation
+    Q_PROPERTY(QQuickWindow *window READ window WRITE setWindow NOTIFY windowChanged)
+    Q_PROPERTY(QVariantList predictedPose READ predictedPose NOTIFY predictedPoseChanged)
+    Q_PROPERTY(QVariantMap predictionStats READ predictionStats NOTIFY predictionStatsChanged)
+    Q_PROPERTY(bool trajectoryRunning READ isTrajectoryRunning NOTIFY trajectoryRunningChanged)
+    Q_PROPERTY(QStringList poseNames READ poseNames NOTIFY poseLibraryChanged)
+    Q_PROPERTY(int obstacleCount READ obstacleCount NOTIFY sceneChanged)
+    // Distance between the arm and the nearest obstacle, infinite without a scene
+    Q_PROPERTY(qreal sceneClearance READ sceneClearance NOTIFY sceneClearanceChanged)
+    // Fraction of full speed the arm moves at, below 1 while closing in on an obstacle
+    Q_PROPERTY(qreal speedScale READ speedScale NOTIFY speedScaleChanged)
 
 public:
     explicit Backend(QObject *parent = nullptr);
@@ -32,6 +57,66 @@ public:
     Q_INVOKABLE void connectToDevice(const QString &ip, int port);
     Q_INVOKABLE void disconnectFromDevice();
 
+    // Inverse kinematics for the hand hinge in the plane of the collision model.
+    // Returns [rotation1, rotation2, rotation3, rotation4] or an empty list when
+    // the target is unreachable, so QML can move the sliders to it.
+    Q_INVOKABLE QVariantList solveWristTarget(qreal x, qreal y) const;
+
+    // Memory-maps a wrist reachability map written by reachmapgen; the build
+    // ships one as ":/Backend/arm.reach", loaded by MainScreen.qml. While a
+    // map is loaded, solveWristTarget() and jogWrist() reject targets outside
+    // it before running the IK.
+    Q_INVOKABLE bool loadReachabilityMap(const QString &path);
+    Q_INVOKABLE bool isReachable(qreal x, qreal y, qreal z) const;
+
+    // Loads the servo_fit calibration used by the predicted pose. Without one
+    // the predictor uses generic hobby servo parameters.
+    Q_INVOKABLE bool loadServoCalibration(const QString &path);
+    Q_INVOKABLE void resetPredictionStats();
+
+    // Records every rotation1 command from the setter to the servo (see
+    // commandtrace.h). saveTrace() stops the recording and writes it as a
+    // Chrome trace JSON file for Perfetto, false when it cannot be written.
+    Q_INVOKABLE void startTrace();
+    Q_INVOKABLE bool saveTrace(const QString &path);
+    const CommandTrace &commandTrace() const { return m_trace; }
+
+    // Plays a timed joint trajectory, linearly interpolated between points:
+    // [{"t_ms": 0, "joints": [r1, r2, r3, r4]}, {"t_ms": 500, ...}, ...]
+    // Times are relative to the start and must not decrease. Returns false,
+    // without moving, when a point is malformed, outside the slider limits
+    // or self-colliding.
+    Q_INVOKABLE bool playTrajectory(const QVariantList &points);
+    Q_INVOKABLE void stopTrajectory();
+    bool isTrajectoryRunning() const;
+    // [rotation1, rotation2, rotation3, rotation4] the arm is heading to, in
+    // fractions of a degree while a trajectory plays
+    Q_INVOKABLE QVariantList targetPose() const;
+
+    // Loads a PoseLibrary. goToPose() then plays the precomputed trajectory
+    // from the library pose the arm is at, or plans one from anywhere else.
+    // Returns false when the pose is unknown or cannot be reached.
+    Q_INVOKABLE bool loadPoseLibrary(const QString &path);
+    Q_INVOKABLE bool goToPose(const QString &name);
+    // [rotation1, rotation2, rotation3, rotation4] of a library pose, or []
+    Q_INVOKABLE QVariantList poseJoints(const QString &name) const;
+    QStringList poseNames() const;
+
+    // Loads the work cell fixtures from a scene file (see scenefile.h). The
+    // arm counts as colliding when it touches one, and trajectories, those of
+    // the pose library included, are kept clear of them. A scene that fails
+    // to load leaves no obstacles.
+    // With a scene the arm slows down as it closes in on an obstacle (see
+    // speedscaling.h). Within the slow-down distance the servo follows that
+    // motion instead of being sent the slider targets; farther out, at full
+    // speed, it still heads straight for them.
+    Q_INVOKABLE bool loadScene(const QString &path);
+    Q_INVOKABLE void clearScene();
+    const ArmModel::ObstacleScene &obstacleScene() const { return m_scene; }
+    int obstacleCount() const { return m_scene.obstacleCount(); }
+    qreal sceneClearance() const { return m_sceneClearance; }
+    qreal speedScale() const { return m_animator.stepScale(); }
+
     // --- Existing Getters/Setters ---
     int rotation1Angle() const;
     void setRot1Angle(const int angle);
@@ -51,20 +136,68 @@ public:
     QString status() const;
     QBindable<QString> bindableStatus() const;
 
+    QQuickWindow *window() const;
+    void setWindow(QQuickWindow *window);
+
+    // Current connection, or nullptr. Not exposed to QML.
+    ESP32Client *client() const { return m_espClient; }
+
+    // Velocity control for continuous input devices such as GamepadInput,
+    // called at a fixed rate with the time step. Both integrate from the
+    // current targets, so they mix freely with the sliders.
+    void jogJoints(const ArmModel::JointVector &degreesPerSecond, double clawsDegreesPerSecond, double dt);
+    // Moves the wrist in the arm plane (see solveWristTarget) in model units
+    // per second. Returns false, leaving the pose alone, when the target is
+    // outside the reachability map or the IK fails.
+    bool jogWrist(double vx, double vy, double dt);
+
+    bool isConnected() const { return m_isConnected.value(); }
+    bool isColliding() const { return m_isCollision.value(); }
+
+    // Number of collision checks run so far, for the benchmarks
+    quint64 collisionCheckCount() const { return m_collisionChecks; }
+
+    // [rotation1, rotation2, rotation3, rotation4] where the hardware is
+    // estimated to be right now. Joints without telemetry use the commanded
+    // angle, so this can always be rendered instead of the sliders.
+    // Position telemetry is the "servos" array of status pushes, which only
+    // servo_sim sends so far. Against the firmwares in this repository the
+    // prediction never engages and the commanded angles are shown.
+    QVariantList predictedPose() const;
+
+    // How well each telemetry sample was anticipated before it arrived:
+    // samples, rmsErrorDeg and maxErrorDeg of the filter's estimate for the
+    // sample time, holdRmsErrorDeg of holding the previous sample instead,
+    // the estimate a display without prediction would show, and
+    // linkLatencyMs. Both errors are taken against the same samples.
+    QVariantMap predictionStats() const;
+
 signals:
     void rot1AngleChanged();
     void rot2AngleChanged();
     void rot3AngleChanged();
     void rot4AngleChanged();
     void clawsAngleChanged();
+    void windowChanged();
+    void predictedPoseChanged();
+    void predictionStatsChanged();
+    void trajectoryRunningChanged();
+    void poseLibraryChanged();
+    void sceneChanged();
+    void sceneClearanceChanged();
+    void speedScaleChanged();
+    // completed is false when the trajectory was stopped, replaced or held
+    // up at an obstacle for a second, where the arm then stays
+    void trajectoryFinished(bool completed);
+    // Position sample of a servo from the device, in servo degrees
+    void telemetryReceived(int index, double position);
+    // jogJoints() or jogWrist() moved the targets to joints, [rotation1,
+    // rotation2, rotation3, rotation4], for the sliders to follow
+    void jogged(const QVariantList &joints);
 
 private:
-    // --- Existing Animation Parameters ---
-    AnimatedParam m_rotation1Angle;
-    AnimatedParam m_rotation2Angle;
-    AnimatedParam m_rotation3Angle;
-    AnimatedParam m_rotation4Angle;
-    AnimatedParam m_clawsAngle;
+    // --- Joint animation ---
+    JointAnimator m_animator;
 
     // --- Status & Collision Properties ---
     QProperty<QString> m_status;
@@ -74,7 +207,56 @@ private:
     // Pointer to hold the instance of our network client.
     ESP32Client *m_espClient = nullptr;
     QProperty<bool> m_isConnected; // <-- ADD THIS LINE
+
+    QFile m_reachabilityFile;
+    ReachabilityMap m_reachabilityMap;
+
+    // Servo 0 drives rotation1, the only joint wired to hardware
+    ServoPredictor m_predictor;
+    QElapsedTimer m_clock;
+    QTimer m_predictionTimer;
+    bool m_hasTelemetry = false;
+    double m_linkLatencyMs = 0.0;
+    double m_lastSample = 0.0;
+
+    struct PredictionStats
+    {
+        int samples = 0;
+        double sumSquares = 0.0;
+        double holdSumSquares = 0.0;
+        double maxError = 0.0;
+    };
+    PredictionStats m_predictionStats;
+    quint64 m_collisionChecks = 0;
+    CommandTrace m_trace;
+
+    ArmModel::Trajectory m_trajectory;
+    QTimer m_trajectoryTimer;
+    // Trajectory time runs slower while the arm is slowed down
+    double m_trajectoryTimeMs = 0.0;
+    double m_trajectoryClockMs = 0.0;
+    double m_trajectoryStallMs = 0.0; // time spent nearly stopped by an obstacle
+    PoseLibrary m_poseLibrary;
+    ArmModel::ObstacleScene m_scene;
+    double m_sceneClearance = std::numeric_limits<double>::infinity();
+    QPropertyNotifier m_speedScaleNotifier;
+    int m_followedRotation1 = 0;
+
     void detectCollision();
+    void onJointsUpdated(unsigned changedChannels);
+    void onServoPosition(int index, double position);
+    void updatePredictedPose();
+    void onRoundTrip(double milliseconds);
+    ArmModel::JointVector jointVector() const;
+    ArmModel::JointVector jointTargets() const;
+    void setJointTargets(const ArmModel::JointVector &joints);
+    bool setSliderTarget(int joint, int angle);
+    void sendRotation1(int angle);
+    bool rotation1IsUnscaled() const;
+    void followRotation1(bool force = false);
+    void startTrajectory(ArmModel::Trajectory trajectory);
+    void advanceTrajectory();
+    void finishTrajectory(bool completed);
 };
 
 #endif // BACKEND_H
@@ -0,0 +1,484 @@
+// Headless performance harness for backendmodule
+//
+// Drives Backend through its property setters, as the sliders and preset
+// buttons of MainScreen.qml would, while it talks to a firmware stand-in
+// over TCP. Reports CPU time, heap allocations, socket traffic and the
+// set_servo round trip distribution, optionally as JSON and with limits
+// that turn a regression into a non-zero exit code.
+//
+// Usage:
+//   backendbench [--sim path/to/servo_sim | --host 127.0.0.1 --port 8080]
+//                [--script file] [--repeat N] [--json report.json] [--trace trace.json]
+//                [--max-cpu-ms X] [--max-allocs-per-command X] [--max-rtt-p95-ms X]
+//
+// --sim starts servo_sim on a free port with 50 ms status pushes, so the
+// telemetry path is exercised too. --trace records every command through
+// Backend's command trace, prints the per-stage latencies and writes the
+// Chrome trace for Perfetto. Script lines, '#' starts a comment:
+//   preset R1 R2 R3 R4              set rotation1..4 at once, like the buttons
+//   sweep JOINT FROM TO MS          drag a slider at 60 Hz, JOINT is
+//                                   rotation1..rotation4 or claws
+//   claws ANGLE
+//   wait MS
+
+#include "backend.h"
+#include "esp32client.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <vector>
+
+// --- Allocation counting ---
+// Replaces the global allocator for this executable only
+
+namespace {
+std::atomic<quint64> allocationCount { 0 };
+std::atomic<quint64> allocationBytes { 0 };
+}
+
+void *operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+const char DefaultScript[] = R"(# Presets from MainScreen.qml, then every slider end to end
+preset 30 60 90 145
+wait 1500
+preset 60 45 45 60
+wait 1500
+preset -90 -60 -45 -180
+wait 1500
+preset 0 0 0 0
+wait 1500
+sweep rotation1 -90 90 2000
+sweep rotation1 90 -90 2000
+sweep rotation2 -135 135 2000
+sweep rotation3 -90 90 2000
+sweep rotation4 -180 180 3000
+claws 0
+wait 500
+claws 90
+sweep rotation1 0 90 300
+sweep rotation1 90 -90 300
+sweep rotation1 -90 0 300
+wait 1000
+)";
+
+constexpr int SliderIntervalMs = 16;
+constexpr int DrainMs = 500;
+
+struct ScriptStep
+{
+    QString command;
+    QStringList args;
+    int line;
+};
+
+struct Options
+{
+    QString simPath;
+    QString host = QStringLiteral("127.0.0.1");
+    int port = 8080;
+    QString scriptPath;
+    int repeat = 1;
+    QString jsonPath;
+    QString tracePath;
+    double maxCpuMs = -1.0;
+    double maxAllocsPerCommand = -1.0;
+    double maxRttP95Ms = -1.0;
+};
+
+double cpuMilliseconds()
+{
+    return std::clock() * 1000.0 / CLOCKS_PER_SEC;
+}
+
+double percentile(std::vector<double> sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0.0;
+    const size_t index = std::min(sorted.size() - 1, size_t(fraction * double(sorted.size())));
+    return sorted[index];
+}
+
+bool parseScript(const QString &text, QList<ScriptStep> &steps)
+{
+    int lineNumber = 0;
+    for (QString line : text.split('\n')) {
+        lineNumber++;
+        line = line.section('#', 0, 0).trimmed();
+        if (line.isEmpty())
+            continue;
+
+        QStringList words = line.split(' ', Qt::SkipEmptyParts);
+        ScriptStep step { words.takeFirst(), words, lineNumber };
+        const int expected = step.command == "preset" ? 4
+                : step.command == "sweep"             ? 4
+                : step.command == "claws"             ? 1
+                : step.command == "wait"              ? 1
+                                                      : -1;
+        if (expected != step.args.size()) {
+            fprintf(stderr, "Script line %d: cannot parse \"%s\"\n", lineNumber, qPrintable(line));
+            return false;
+        }
+        steps.append(step);
+    }
+    return true;
+}
+
+// Plays a script against Backend in real time, one slider update per tick
+class ScriptRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    ScriptRunner(Backend &backend, const QList<ScriptStep> &steps)
+        : m_backend(backend), m_steps(steps)
+    {
+        m_ticker.setInterval(SliderIntervalMs);
+        m_ticker.setTimerType(Qt::PreciseTimer);
+        connect(&m_ticker, &QTimer::timeout, this, &ScriptRunner::tick);
+    }
+
+    void start()
+    {
+        m_index = 0;
+        m_stepClock.start();
+        m_ticker.start();
+        tick();
+    }
+
+    int commands() const { return m_commands; }
+
+signals:
+    void finished();
+
+private:
+    void setJoint(const QString &joint, int angle)
+    {
+        m_commands++;
+        if (joint == "rotation1")
+            m_backend.setRot1Angle(angle);
+        else if (joint == "rotation2")
+            m_backend.setRot2Angle(angle);
+        else if (joint == "rotation3")
+            m_backend.setRot3Angle(angle);
+        else if (joint == "rotation4")
+            m_backend.setRot4Angle(angle);
+        else if (joint == "claws")
+            m_backend.setClawsAngle(angle);
+    }
+
+    void nextStep()
+    {
+        m_index++;
+        m_stepClock.restart();
+    }
+
+    void tick()
+    {
+        while (m_index < m_steps.size()) {
+            const ScriptStep &step = m_steps[m_index];
+            const qint64 elapsed = m_stepClock.elapsed();
+
+            if (step.command == "preset") {
+                for (int joint = 0; joint < 4; joint++)
+                    setJoint(QString("rotation%1").arg(joint + 1), step.args[joint].toInt());
+                nextStep();
+            } else if (step.command == "claws") {
+                setJoint("claws", step.args[0].toInt());
+                nextStep();
+            } else if (step.command == "wait") {
+                if (elapsed < step.args[0].toInt())
+                    return;
+                nextStep();
+            } else if (step.command == "sweep") {
+                const double from = step.args[1].toDouble();
+                const double to = step.args[2].toDouble();
+                const double duration = qMax(1, step.args[3].toInt());
+                const double t = qMin(1.0, elapsed / duration);
+                setJoint(step.args[0], qRound(from + (to - from) * t));
+                if (t < 1.0)
+                    return;
+                nextStep();
+            }
+        }
+
+        m_ticker.stop();
+        emit finished();
+    }
+
+    Backend &m_backend;
+    QList<ScriptStep> m_steps;
+    int m_index = 0;
+    int m_commands = 0;
+    QElapsedTimer m_stepClock;
+    QTimer m_ticker;
+};
+
+bool parseArguments(const QStringList &args, Options &options)
+{
+    for (int i = 1; i < args.size(); i++) {
+        const QString &arg = args[i];
+        if (i + 1 >= args.size())
+            return false;
+        const QString value = args[++i];
+
+        if (arg == "--sim")
+            options.simPath = value;
+        else if (arg == "--host")
+            options.host = value;
+        else if (arg == "--port")
+            options.port = value.toInt();
+        else if (arg == "--script")
+            options.scriptPath = value;
+        else if (arg == "--repeat")
+            options.repeat = qMax(1, value.toInt());
+        else if (arg == "--json")
+            options.jsonPath = value;
+        else if (arg == "--trace")
+            options.tracePath = value;
+        else if (arg == "--max-cpu-ms")
+            options.maxCpuMs = value.toDouble();
+        else if (arg == "--max-allocs-per-command")
+            options.maxAllocsPerCommand = value.toDouble();
+        else if (arg == "--max-rtt-p95-ms")
+            options.maxRttP95Ms = value.toDouble();
+        else
+            return false;
+    }
+    return true;
+}
+
+// Starts servo_sim on a free port and returns that port, or -1
+int startSimulator(QProcess &process, const QString &path)
+{
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.start(path, { "--port", "0", "--status-ms", "50" });
+    if (!process.waitForStarted(3000))
+        return -1;
+
+    QElapsedTimer timeout;
+    timeout.start();
+    while (timeout.elapsed() < 3000) {
+        if (!process.canReadLine() && !process.waitForReadyRead(100))
+            continue;
+        const QString line = QString::fromUtf8(process.readLine()).trimmed();
+        if (line.startsWith("Listening on port "))
+            return line.section(' ', 3, 3).toInt();
+    }
+    return -1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    Options options;
+    if (!parseArguments(app.arguments(), options)) {
+        fprintf(stderr,
+                "usage: backendbench [--sim servo_sim | --host H --port N] [--script file] [--repeat N]\n"
+                "                    [--json report.json] [--trace trace.json] [--max-cpu-ms X]\n"
+                "                    [--max-allocs-per-command X] [--max-rtt-p95-ms X]\n");
+        return 1;
+    }
+
+    QString scriptText = QString::fromLatin1(DefaultScript);
+    if (!options.scriptPath.isEmpty()) {
+        QFile file(options.scriptPath);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            fprintf(stderr, "Cannot open %s\n", qPrintable(options.scriptPath));
+            return 1;
+        }
+        scriptText = QString::fromUtf8(file.readAll());
+    }
+    QList<ScriptStep> script;
+    if (!parseScript(scriptText, script))
+        return 1;
+    QList<ScriptStep> steps;
+    for (int i = 0; i < options.repeat; i++)
+        steps += script;
+
+    QProcess simulator;
+    if (!options.simPath.isEmpty()) {
+        options.host = QStringLiteral("127.0.0.1");
+        options.port = startSimulator(simulator, options.simPath);
+        if (options.port < 0) {
+            fprintf(stderr, "Could not start %s\n", qPrintable(options.simPath));
+            return 1;
+        }
+    }
+
+    Backend backend;
+    ScriptRunner runner(backend, steps);
+    std::vector<double> roundTrips;
+
+    double cpuStart = 0.0;
+    quint64 allocationsStart = 0;
+    quint64 allocationBytesStart = 0;
+    QElapsedTimer wallClock;
+    int exitCode = 0;
+
+    backend.connectToDevice(options.host, options.port);
+    ESP32Client *client = backend.client();
+    QObject::connect(client, &ESP32Client::roundTripMeasured, &app,
+                     [&](double milliseconds) { roundTrips.push_back(milliseconds); });
+    QObject::connect(client, &ESP32Client::errorOccurred, &app, [&](const QString &error) {
+        fprintf(stderr, "%s\n", qPrintable(error));
+        exitCode = 1;
+        app.quit();
+    });
+    QObject::connect(client, &ESP32Client::connectionStateChanged, &app, [&](bool connected) {
+        if (!connected)
+            return;
+        roundTrips.reserve(size_t(steps.size()) * 256);
+        cpuStart = cpuMilliseconds();
+        allocationsStart = allocationCount.load();
+        allocationBytesStart = allocationBytes.load();
+        wallClock.start();
+        if (!options.tracePath.isEmpty())
+            backend.startTrace();
+        runner.start();
+    });
+    QObject::connect(&runner, &ScriptRunner::finished, &app, [&]() {
+        // Let the last acknowledgements come in
+        QTimer::singleShot(DrainMs, &app, &QCoreApplication::quit);
+    });
+
+    QTimer::singleShot(5000, &app, [&]() {
+        if (!wallClock.isValid()) {
+            fprintf(stderr, "No connection to %s:%d\n", qPrintable(options.host), options.port);
+            exitCode = 1;
+            app.quit();
+        }
+    });
+
+    app.exec();
+    if (exitCode != 0 || !wallClock.isValid())
+        return exitCode ? exitCode : 1;
+
+    const double cpuMs = cpuMilliseconds() - cpuStart;
+    const quint64 allocations = allocationCount.load() - allocationsStart;
+    const quint64 allocatedBytes = allocationBytes.load() - allocationBytesStart;
+    const ESP32Client::Stats traffic = backend.client() ? backend.client()->stats() : ESP32Client::Stats();
+    const int commands = qMax(1, runner.commands());
+    const double allocsPerCommand = double(allocations) / commands;
+
+    std::sort(roundTrips.begin(), roundTrips.end());
+    const double p50 = percentile(roundTrips, 0.50);
+    const double p95 = percentile(roundTrips, 0.95);
+    const double p99 = percentile(roundTrips, 0.99);
+    const double rttMax = roundTrips.empty() ? 0.0 : roundTrips.back();
+
+    printf("script           %s x%d, %.1f s wall\n",
+           options.scriptPath.isEmpty() ? "default" : qPrintable(options.scriptPath), options.repeat,
+           wallClock.elapsed() / 1000.0);
+    printf("commands         %d\n", runner.commands());
+    printf("cpu              %.1f ms (%.1f us per command)\n", cpuMs, cpuMs * 1000.0 / commands);
+    printf("allocations      %llu (%.1f per command), %.1f kB\n", static_cast<unsigned long long>(allocations),
+           allocsPerCommand, allocatedBytes / 1024.0);
+    printf("socket writes    %llu messages, %.1f kB\n", static_cast<unsigned long long>(traffic.messagesSent),
+           traffic.bytesSent / 1024.0);
+    printf("socket reads     %llu messages, %.1f kB\n", static_cast<unsigned long long>(traffic.messagesReceived),
+           traffic.bytesReceived / 1024.0);
+    printf("rtt (n=%zu)       p50 %.2f ms  p95 %.2f ms  p99 %.2f ms  max %.2f ms\n", roundTrips.size(), p50, p95,
+           p99, rttMax);
+
+    QJsonArray stages;
+    if (!options.tracePath.isEmpty()) {
+        const CommandTrace &trace = backend.commandTrace();
+        printf("trace            %zu commands, %zu events dropped\n", trace.commandCount(), trace.droppedCount());
+        for (const CommandTrace::StageStats &stage : trace.summary()) {
+            printf("  %-14s (n=%zu)  p50 %.3f ms  p95 %.3f ms  max %.3f ms\n", stage.name.c_str(), stage.count,
+                   stage.p50Ms, stage.p95Ms, stage.maxMs);
+            stages.append(QJsonObject { { "name", QString::fromStdString(stage.name) },
+                                        { "count", double(stage.count) },
+                                        { "p50_ms", stage.p50Ms },
+                                        { "p95_ms", stage.p95Ms },
+                                        { "max_ms", stage.maxMs } });
+        }
+        if (!backend.saveTrace(options.tracePath))
+            return 1;
+    }
+
+    if (!options.jsonPath.isEmpty()) {
+        QJsonObject report {
+            { "commands", runner.commands() },
+            { "wall_ms", double(wallClock.elapsed()) },
+            { "cpu_ms", cpuMs },
+            { "allocations", double(allocations) },
+            { "allocated_bytes", double(allocatedBytes) },
+            { "messages_sent", double(traffic.messagesSent) },
+            { "bytes_sent", double(traffic.bytesSent) },
+            { "messages_received", double(traffic.messagesReceived) },
+            { "bytes_received", double(traffic.bytesReceived) },
+            { "rtt_count", double(roundTrips.size()) },
+            { "rtt_p50_ms", p50 },
+            { "rtt_p95_ms", p95 },
+            { "rtt_p99_ms", p99 },
+            { "rtt_max_ms", rttMax },
+        };
+        if (!stages.isEmpty())
+            report["stages"] = stages;
+        QFile file(options.jsonPath);
+        if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(report).toJson()) < 0) {
+            fprintf(stderr, "Cannot write %s\n", qPrintable(options.jsonPath));
+            return 1;
+        }
+    }
+
+    bool regressed = false;
+    if (options.maxCpuMs >= 0.0 && cpuMs > options.maxCpuMs) {
+        fprintf(stderr, "FAIL: cpu %.1f ms > %.1f ms\n", cpuMs, options.maxCpuMs);
+        regressed = true;
+    }
+    if (options.maxAllocsPerCommand >= 0.0 && allocsPerCommand > options.maxAllocsPerCommand) {
+        fprintf(stderr, "FAIL: %.1f allocations per command > %.1f\n", allocsPerCommand,
+                options.maxAllocsPerCommand);
+        regressed = true;
+    }
+    if (options.maxRttP95Ms >= 0.0 && p95 > options.maxRttP95Ms) {
+        fprintf(stderr, "FAIL: rtt p95 %.2f ms > %.2f ms\n", p95, options.maxRttP95Ms);
+        regressed = true;
+    }
+
+    backend.disconnectFromDevice();
+    if (simulator.state() != QProcess::NotRunning) {
+        simulator.terminate();
+        simulator.waitForFinished(2000);
+    }
+    return regressed ? 2 : 0;
+}
+
+#include "backendbench.moc"
@@ -0,0 +1,107 @@
+#include "collisionbatch.h"
+
+#include "workstealingpool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace ArmModel {
+
+namespace {
+
+// Sub-blocks of a task in firstCollision(), checked in order so that a task
+// stops soon after a hit
+constexpr size_t PathBlock = 128;
+
+// Results of [begin, end) go to colliding[0, end - begin)
+void checkRange(const JointBatch &batch, size_t begin, size_t end, unsigned char *colliding)
+{
+    isSelfCollidingBatch(batch.joints[Rotation1].data() + begin, batch.joints[Rotation2].data() + begin,
+                         batch.joints[Rotation3].data() + begin, end - begin, colliding);
+}
+
+} // namespace
+
+void JointBatch::reserve(size_t count)
+{
+    for (std::vector<double> &values : joints)
+        values.reserve(count);
+}
+
+void JointBatch::clear()
+{
+    for (std::vector<double> &values : joints)
+        values.clear();
+}
+
+void JointBatch::append(const JointVector &configuration)
+{
+    for (int joint = 0; joint < JointCount; joint++)
+        joints[joint].push_back(configuration[joint]);
+}
+
+JointVector JointBatch::at(size_t index) const
+{
+    JointVector configuration;
+    for (int joint = 0; joint < JointCount; joint++)
+        configuration[joint] = joints[joint][index];
+    return configuration;
+}
+
+void JointBatch::appendSegment(const JointVector &a, const JointVector &b, size_t count)
+{
+    count = std::max<size_t>(1, count);
+    for (int joint = 0; joint < JointCount; joint++) {
+        std::vector<double> &values = joints[joint];
+        const double step = (b[joint] - a[joint]) / double(count);
+        for (size_t i = 0; i < count; i++)
+            values.push_back(a[joint] + step * double(i));
+        values.push_back(b[joint]);
+    }
+}
+
+size_t CollisionChecker::check(const JointBatch &batch, unsigned char *colliding) const
+{
+    const size_t count = batch.size();
+    if (m_pool) {
+        m_pool->parallelFor(count, Grain, [&](size_t begin, size_t end) {
+            checkRange(batch, begin, end, colliding + begin);
+            return true;
+        });
+    } else {
+        checkRange(batch, 0, count, colliding);
+    }
+    return size_t(std::count(colliding, colliding + count, 1));
+}
+
+size_t CollisionChecker::firstCollision(const JointBatch &path) const
+{
+    std::atomic<size_t> first { NoCollision };
+    auto scan = [&](size_t begin, size_t end) {
+        unsigned char colliding[PathBlock];
+        for (size_t start = begin; start < end; start += PathBlock) {
+            // Everything from here on is after a known hit
+            if (start >= first.load(std::memory_order_relaxed))
+                return true;
+            const size_t n = std::min(PathBlock, end - start);
+            checkRange(path, start, start + n, colliding);
+            const unsigned char *hit = std::find(colliding, colliding + n, 1);
+            if (hit != colliding + n) {
+                const size_t index = start + size_t(hit - colliding);
+                size_t known = first.load(std::memory_order_relaxed);
+                while (index < known && !first.compare_exchange_weak(known, index, std::memory_order_relaxed)) {
+                }
+                return true;
+            }
+        }
+        return true;
+    };
+
+    if (m_pool)
+        m_pool->parallelFor(path.size(), Grain, scan);
+    else
+        scan(0, path.size());
+    return first.load();
+}
+
+} // namespace ArmModel
@@ -0,0 +1,56 @@
+#ifndef COLLISIONBATCH_H
+#define COLLISIONBATCH_H
+
+#include "armmodel.h"
+
+#include <cstddef>
+#include <vector>
+
+class WorkStealingPool;
+
+namespace ArmModel {
+
+// Many configurations in structure-of-arrays layout, one contiguous array
+// per joint, as consumed by isSelfCollidingBatch()
+struct JointBatch
+{
+    std::vector<double> joints[JointCount];
+
+    size_t size() const { return joints[0].size(); }
+    void reserve(size_t count);
+    void clear();
+    void append(const JointVector &configuration);
+    JointVector at(size_t index) const;
+
+    // count + 1 evenly spaced configurations from a to b, both included
+    void appendSegment(const JointVector &a, const JointVector &b, size_t count);
+};
+
+// Batched self-collision queries, spread over a WorkStealingPool when one
+// is given and run on the calling thread otherwise
+class CollisionChecker
+{
+public:
+    static constexpr size_t NoCollision = size_t(-1);
+
+    explicit CollisionChecker(WorkStealingPool *pool = nullptr) : m_pool(pool) {}
+
+    // colliding[i] = 1 when configuration i collides, returns how many do
+    size_t check(const JointBatch &batch, unsigned char *colliding) const;
+
+    // Index of the first colliding configuration of a path, or NoCollision.
+    // Work on configurations past a known hit is skipped, so a path that
+    // collides early returns early.
+    size_t firstCollision(const JointBatch &path) const;
+
+    // Configurations per task; small enough to balance, large enough to
+    // keep the per-task overhead down
+    static constexpr size_t Grain = 1024;
+
+private:
+    WorkStealingPool *m_pool;
+};
+
+} // namespace ArmModel
+
+#endif // COLLISIONBATCH_H
@@ -0,0 +1,149 @@
+// Throughput of the batched self-collision check.
+//
+// usage: collisionbench [--queries n] [--threads n] [--repeat n] [--seed n]
+//
+// Checks random configurations within the joint limits, first one at a time
+// with ArmModel::isSelfColliding as the baseline, then with CollisionChecker
+// on a WorkStealingPool of 1 to --threads threads, and reports queries per
+// second and the scaling over one thread. The batched results are compared
+// with the baseline. Finally a long path that collides a tenth of the way
+// in is checked with firstCollision(), which should return long before a
+// full check of the path would.
+
+#include "armmodel.h"
+#include "collisionbatch.h"
+#include "workstealingpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+    size_t queries = 2000000;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    int repeat = 3;
+    unsigned seed = 1;
+};
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        const char *value = argv[++i];
+        if (arg == "--queries")
+            options.queries = size_t(std::atoll(value));
+        else if (arg == "--threads")
+            options.threads = unsigned(std::max(1, std::atoi(value)));
+        else if (arg == "--repeat")
+            options.repeat = std::max(1, std::atoi(value));
+        else if (arg == "--seed")
+            options.seed = unsigned(std::atoi(value));
+        else
+            return false;
+    }
+    return options.queries > 0;
+}
+
+double seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Best of repeat runs
+template<typename F>
+double bestTime(int repeat, F &&run)
+{
+    double best = 1e300;
+    for (int i = 0; i < repeat; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        best = std::min(best, seconds(start));
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [--queries n] [--threads n] [--repeat n] [--seed n]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937 random(options.seed);
+    ArmModel::JointBatch batch;
+    batch.reserve(options.queries);
+    for (size_t i = 0; i < options.queries; i++) {
+        ArmModel::JointVector joints;
+        for (int joint = 0; joint < ArmModel::JointCount; joint++) {
+            const ArmModel::JointLimits limits = ArmModel::jointLimits(joint);
+            joints[joint] = std::uniform_real_distribution<double>(limits.min, limits.max)(random);
+        }
+        batch.append(joints);
+    }
+
+    // --- Baseline, one query at a time ---
+    const size_t baselineCount = std::min<size_t>(options.queries, 200000);
+    std::vector<unsigned char> expected(baselineCount);
+    const double baselineTime = bestTime(options.repeat, [&]() {
+        for (size_t i = 0; i < baselineCount; i++)
+            expected[i] = ArmModel::isSelfColliding(batch.at(i));
+    });
+    const double baselineRate = double(baselineCount) / baselineTime;
+    printf("%zu configurations, %u threads max\n", options.queries, options.threads);
+    printf("isSelfColliding       %12.0f queries/s\n", baselineRate);
+
+    // --- Batched, 1..N threads ---
+    std::vector<unsigned char> colliding(options.queries);
+    size_t mismatches = 0;
+    size_t hits = 0;
+    double singleRate = 0.0;
+    for (unsigned threads = 1; threads <= options.threads; threads++) {
+        WorkStealingPool pool(threads);
+        const ArmModel::CollisionChecker checker(&pool);
+        const double time = bestTime(options.repeat, [&]() { hits = checker.check(batch, colliding.data()); });
+        const double rate = double(options.queries) / time;
+        if (threads == 1)
+            singleRate = rate;
+        printf("batch, %2u thread%s     %12.0f queries/s  %5.2fx of 1 thread  %5.1fx of isSelfColliding\n",
+               threads, threads == 1 ? " " : "s", rate, rate / singleRate, rate / baselineRate);
+        for (size_t i = 0; i < baselineCount; i++)
+            mismatches += colliding[i] != expected[i];
+    }
+    printf("colliding             %zu (%.2f%%), %zu mismatches against isSelfColliding\n", hits,
+           100.0 * double(hits) / double(options.queries), mismatches);
+
+    // --- Early exit on a path ---
+    // Folding forearm and hand towards each other, colliding about a tenth
+    // of the way along
+    ArmModel::JointBatch path;
+    const size_t pathLength = options.queries;
+    const ArmModel::JointVector start = { 67.0, 100.0, 67.0, 0.0 };
+    const ArmModel::JointVector end = { 90.0, 135.0, 90.0, 0.0 };
+    path.appendSegment(start, end, pathLength - 1);
+    {
+        WorkStealingPool pool(options.threads);
+        const ArmModel::CollisionChecker checker(&pool);
+        size_t first = ArmModel::CollisionChecker::NoCollision;
+        const double earlyTime = bestTime(options.repeat, [&]() { first = checker.firstCollision(path); });
+        const double fullTime = bestTime(options.repeat, [&]() { checker.check(path, colliding.data()); });
+        if (first == ArmModel::CollisionChecker::NoCollision)
+            printf("path of %zu           no collision, %.2f ms\n", pathLength, earlyTime * 1e3);
+        else
+            printf("path of %zu           first hit at %zu (%.0f%%) in %.2f ms, full check %.2f ms\n", pathLength,
+                   first, 100.0 * double(first) / double(pathLength), earlyTime * 1e3, fullTime * 1e3);
+    }
+    return mismatches == 0 ? 0 : 2;
+}
@@ -0,0 +1,338 @@
+#include "commandtrace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <iterator>
+
+namespace {
+
+// Offset estimates the clock sync picks the best one from, at 50 commands
+// per second a bit more than the last quarter second
+constexpr size_t SyncWindow = 16;
+
+// A position sample this close to the commanded angle ends the move,
+// above the measurement noise and deadband of a hobby servo
+constexpr double EchoToleranceDeg = 2.0;
+
+// Process and thread ids of the tracks in the Chrome trace
+constexpr int ClientPid = 1;
+constexpr int DevicePid = 2;
+constexpr int BackendTid = 1;
+constexpr int ClientTid = 2;
+constexpr int LoopTid = 1;
+constexpr int ServoTid = 2;
+
+double percentile(std::vector<double> &values, double fraction)
+{
+    std::sort(values.begin(), values.end());
+    const size_t index = std::min(values.size() - 1, size_t(fraction * double(values.size())));
+    return values[index];
+}
+
+void appendEvent(std::string &out, const char *format, ...)
+{
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    out += out.empty() ? "\n" : ",\n";
+    out += buffer;
+}
+
+void appendMetadata(std::string &out, const char *kind, int pid, int tid, const char *name)
+{
+    if (tid < 0)
+        appendEvent(out, R"({"name":"%s","ph":"M","pid":%d,"args":{"name":"%s"}})", kind, pid, name);
+    else
+        appendEvent(out, R"({"name":"%s","ph":"M","pid":%d,"tid":%d,"args":{"name":"%s"}})", kind, pid, tid,
+                    name);
+}
+
+// Nestable async slice of one command on the client
+void appendAsync(std::string &out, const char *name, uint64_t id, int64_t beginUs, int64_t endUs)
+{
+    appendEvent(out, R"({"name":"%s","cat":"set_servo","ph":"b","id":%llu,"pid":%d,"tid":%d,"ts":%lld})", name,
+                static_cast<unsigned long long>(id), ClientPid, ClientTid, static_cast<long long>(beginUs));
+    appendEvent(out, R"({"name":"%s","cat":"set_servo","ph":"e","id":%llu,"pid":%d,"tid":%d,"ts":%lld})", name,
+                static_cast<unsigned long long>(id), ClientPid, ClientTid, static_cast<long long>(endUs));
+}
+
+void appendComplete(std::string &out, const char *name, int pid, int tid, int64_t beginUs, int64_t endUs,
+                    uint64_t id)
+{
+    appendEvent(out, R"({"name":"%s","ph":"X","pid":%d,"tid":%d,"ts":%lld,"dur":%lld,"args":{"id":%llu}})", name,
+                pid, tid, static_cast<long long>(beginUs), static_cast<long long>(endUs - beginUs),
+                static_cast<unsigned long long>(id));
+}
+
+} // namespace
+
+void CommandTrace::start()
+{
+    m_start = std::chrono::steady_clock::now();
+    m_commands.clear();
+    m_inputs.clear();
+    m_dropped = 0;
+    m_pendingInputUs = -1;
+    m_awaitingEcho = SIZE_MAX;
+    m_syncSamples.clear();
+    m_offsetUs = 0;
+    m_haveDeviceTime = false;
+    m_active = true;
+}
+
+int64_t CommandTrace::nowUs() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start)
+            .count();
+}
+
+void CommandTrace::input(int angle)
+{
+    if (!m_active)
+        return;
+    const int64_t now = nowUs();
+    if (m_pendingInputUs < 0)
+        m_pendingInputUs = now;
+    if (m_inputs.size() < MaxInputs)
+        m_inputs.push_back({ now, angle });
+    else
+        m_dropped++;
+}
+
+void CommandTrace::sent(uint64_t id, int angle)
+{
+    if (!m_active)
+        return;
+    const int64_t now = nowUs();
+    // Commands not coming from input(), e.g. a trajectory, have no queue stage
+    const int64_t inputUs = m_pendingInputUs >= 0 ? m_pendingInputUs : now;
+    m_pendingInputUs = -1;
+    if (m_commands.size() >= MaxCommands) {
+        m_dropped++;
+        m_awaitingEcho = SIZE_MAX;
+        return;
+    }
+
+    Command command;
+    command.id = id;
+    command.angle = angle;
+    command.inputUs = inputUs;
+    command.sentUs = now;
+    m_commands.push_back(command);
+    // The previous move is superseded
+    m_awaitingEcho = m_commands.size() - 1;
+}
+
+void CommandTrace::acknowledged(uint64_t id, bool ok, const DeviceTimes *device)
+{
+    if (!m_active)
+        return;
+    Command *command = find(id);
+    if (!command || command->ackUs >= 0)
+        return;
+    command->ackUs = nowUs();
+    command->ok = ok;
+    if (!device)
+        return;
+
+    // NTP: offset from the send and receive times on both sides, trusting
+    // the sample with the least time spent in the network
+    const int64_t received = unwrapDevice(device->receivedUs);
+    const int64_t replied = unwrapDevice(device->repliedUs);
+    SyncSample sample;
+    sample.offsetUs = ((received - command->sentUs) + (replied - command->ackUs)) / 2;
+    sample.delayUs = (command->ackUs - command->sentUs) - (replied - received);
+    m_syncSamples.push_back(sample);
+    if (m_syncSamples.size() > SyncWindow)
+        m_syncSamples.pop_front();
+    m_offsetUs = std::min_element(m_syncSamples.begin(), m_syncSamples.end(),
+                                  [](const SyncSample &a, const SyncSample &b) { return a.delayUs < b.delayUs; })
+                         ->offsetUs;
+
+    // Kept in order between send and acknowledgement, the estimate is only
+    // as good as the network is symmetric
+    int64_t previous = command->sentUs;
+    auto place = [&](uint32_t us) {
+        previous = std::clamp(toClient(us), previous, command->ackUs);
+        return previous;
+    };
+    command->receivedUs = place(device->receivedUs);
+    command->parsedUs = place(device->parsedUs);
+    command->writeUs = place(device->writeUs);
+    command->writtenUs = place(device->writtenUs);
+    command->repliedUs = place(device->repliedUs);
+    command->hasDevice = true;
+}
+
+void CommandTrace::servoPosition(int index, double position)
+{
+    if (!m_active || index != 0 || m_awaitingEcho >= m_commands.size())
+        return;
+    Command &command = m_commands[m_awaitingEcho];
+    if (std::abs(position - command.angle) > EchoToleranceDeg)
+        return;
+    command.echoUs = nowUs();
+    command.echoPosition = position;
+    m_awaitingEcho = SIZE_MAX;
+}
+
+CommandTrace::Command *CommandTrace::find(uint64_t id)
+{
+    // Acknowledgements arrive in order with few commands in flight
+    for (auto it = m_commands.rbegin(); it != m_commands.rend(); ++it) {
+        if (it->id == id)
+            return &*it;
+        if (it->id < id)
+            break;
+    }
+    return nullptr;
+}
+
+int64_t CommandTrace::unwrapDevice(uint32_t us)
+{
+    // micros() wraps after 71 minutes, the difference to the previous
+    // reading is small and tells which way
+    if (!m_haveDeviceTime) {
+        m_haveDeviceTime = true;
+        m_lastDeviceUnwrappedUs = us;
+    } else {
+        m_lastDeviceUnwrappedUs += int32_t(us - m_lastDeviceUs);
+    }
+    m_lastDeviceUs = us;
+    return m_lastDeviceUnwrappedUs;
+}
+
+int64_t CommandTrace::toClient(uint32_t us)
+{
+    return unwrapDevice(us) - m_offsetUs;
+}
+
+std::vector<CommandTrace::StageStats> CommandTrace::summary() const
+{
+    static const char *const names[] = { "queue",       "uplink", "device",   "receive",    "dispatch",
+                                         "servo.write", "reply",  "downlink", "round trip", "settle" };
+    std::vector<std::vector<double>> durations(std::size(names));
+    auto add = [&](size_t stage, int64_t beginUs, int64_t endUs) {
+        if (beginUs >= 0 && endUs >= beginUs)
+            durations[stage].push_back((endUs - beginUs) / 1000.0);
+    };
+
+    for (const Command &command : m_commands) {
+        add(0, command.inputUs, command.sentUs);
+        if (command.ackUs < 0)
+            continue;
+        if (command.hasDevice) {
+            add(1, command.sentUs, command.receivedUs);
+            add(2, command.receivedUs, command.repliedUs);
+            add(3, command.receivedUs, command.parsedUs);
+            add(4, command.parsedUs, command.writeUs);
+            add(5, command.writeUs, command.writtenUs);
+            add(6, command.writtenUs, command.repliedUs);
+            add(7, command.repliedUs, command.ackUs);
+            if (command.echoUs >= 0)
+                add(9, command.writtenUs, command.echoUs);
+        }
+        add(8, command.sentUs, command.ackUs);
+    }
+
+    std::vector<StageStats> stats;
+    for (size_t stage = 0; stage < durations.size(); stage++) {
+        StageStats entry;
+        entry.name = names[stage];
+        entry.count = durations[stage].size();
+        if (entry.count) {
+            entry.p50Ms = percentile(durations[stage], 0.50);
+            entry.p95Ms = percentile(durations[stage], 0.95);
+            entry.maxMs = durations[stage].back();
+        }
+        stats.push_back(entry);
+    }
+    return stats;
+}
+
+std::string CommandTrace::chromeTraceJson() const
+{
+    std::string events;
+    appendMetadata(events, "process_name", ClientPid, -1, "Qt client");
+    appendMetadata(events, "process_name", DevicePid, -1, "ESP32");
+    appendMetadata(events, "thread_name", ClientPid, BackendTid, "Backend");
+    appendMetadata(events, "thread_name", ClientPid, ClientTid, "ESP32Client");
+    appendMetadata(events, "thread_name", DevicePid, LoopTid, "loop()");
+    appendMetadata(events, "thread_name", DevicePid, ServoTid, "Servo");
+
+    for (const Input &input : m_inputs) {
+        appendEvent(events, R"({"name":"setRot1Angle","ph":"i","s":"t","pid":%d,"tid":%d,"ts":%lld,"args":{"angle":%d}})",
+                    ClientPid, BackendTid, static_cast<long long>(input.timeUs), input.angle);
+    }
+
+    for (size_t i = 0; i < m_commands.size(); i++) {
+        const Command &command = m_commands[i];
+        const unsigned long long id = command.id;
+        const int64_t endUs = command.ackUs >= 0 ? command.ackUs : command.sentUs;
+
+        // Client side, one async track per command in flight
+        appendEvent(events,
+                    R"({"name":"set_servo","cat":"set_servo","ph":"b","id":%llu,"pid":%d,"tid":%d,"ts":%lld,)"
+                    R"("args":{"id":%llu,"angle":%d,"acknowledged":%s,"ok":%s}})",
+                    id, ClientPid, ClientTid, static_cast<long long>(command.inputUs), id, command.angle,
+                    command.ackUs >= 0 ? "true" : "false", command.ok ? "true" : "false");
+        appendAsync(events, "queue", id, command.inputUs, command.sentUs);
+        if (command.hasDevice) {
+            appendAsync(events, "uplink", id, command.sentUs, command.receivedUs);
+            appendAsync(events, "device", id, command.receivedUs, command.repliedUs);
+            appendAsync(events, "downlink", id, command.repliedUs, command.ackUs);
+        } else if (command.ackUs >= 0) {
+            appendAsync(events, "round trip", id, command.sentUs, command.ackUs);
+        }
+        appendEvent(events, R"({"name":"set_servo","cat":"set_servo","ph":"e","id":%llu,"pid":%d,"tid":%d,"ts":%lld})",
+                    id, ClientPid, ClientTid, static_cast<long long>(endUs));
+
+        if (command.echoUs >= 0) {
+            appendEvent(events,
+                        R"({"name":"status echo","ph":"i","s":"t","pid":%d,"tid":%d,"ts":%lld,)"
+                        R"("args":{"id":%llu,"angle":%d,"position":%.2f}})",
+                        ClientPid, ClientTid, static_cast<long long>(command.echoUs), id, command.angle,
+                        command.echoPosition);
+        }
+        if (!command.hasDevice)
+            continue;
+
+        // Device side, the firmware handles one command at a time
+        appendComplete(events, "set_servo", DevicePid, LoopTid, command.receivedUs, command.repliedUs, id);
+        appendComplete(events, "receive", DevicePid, LoopTid, command.receivedUs, command.parsedUs, id);
+        appendComplete(events, "dispatch", DevicePid, LoopTid, command.parsedUs, command.writeUs, id);
+        appendComplete(events, "servo.write", DevicePid, LoopTid, command.writeUs, command.writtenUs, id);
+        appendComplete(events, "reply", DevicePid, LoopTid, command.writtenUs, command.repliedUs, id);
+
+        // The move lasts until the status echo or the next command
+        int64_t moveEndUs = command.echoUs;
+        for (size_t next = i + 1; next < m_commands.size(); next++) {
+            if (m_commands[next].hasDevice) {
+                if (moveEndUs < 0 || m_commands[next].writtenUs < moveEndUs)
+                    moveEndUs = m_commands[next].writtenUs;
+                break;
+            }
+        }
+        if (moveEndUs > command.writtenUs)
+            appendComplete(events, "move", DevicePid, ServoTid, command.writtenUs, moveEndUs, id);
+    }
+
+    char other[160];
+    snprintf(other, sizeof(other), R"("otherData":{"commands":%zu,"dropped":%zu,"clock_offset_us":%lld})",
+             m_commands.size(), m_dropped, static_cast<long long>(m_offsetUs));
+    return "{\"displayTimeUnit\":\"ms\"," + std::string(other) + ",\"traceEvents\":[" + events + "\n]}\n";
+}
+
+bool CommandTrace::writeChromeTrace(const std::string &path) const
+{
+    const std::string json = chromeTraceJson();
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    const bool written = fwrite(json.data(), 1, json.size(), file) == json.size();
+    return fclose(file) == 0 && written;
+}
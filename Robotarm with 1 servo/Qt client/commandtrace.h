@@ -0,0 +1,130 @@
+#ifndef COMMANDTRACE_H
+#define COMMANDTRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Per-stage latency of set_servo commands, from the slider to the servo.
+//
+// Backend reports slider input, ESP32Client each command it sends and its
+// acknowledgement, which carries the firmware's micros() at every handling
+// stage (rx, parsed, write, written, tx), and the position telemetry. The
+// device clock is mapped onto the client clock NTP style: each
+// acknowledgement gives an offset estimate from the four timestamps, and
+// the one with the shortest network delay among the recent ones is used,
+// which follows crystal drift over long sessions.
+//
+// Times are microseconds since start() on a steady clock. Recording is
+// bounded, commands past MaxCommands are only counted. The result is a
+// Chrome trace for Perfetto or chrome://tracing and a per-stage summary.
+// It has no Qt dependency so that command line tools can reuse it.
+class CommandTrace
+{
+public:
+    // micros() of the firmware while handling one command
+    struct DeviceTimes
+    {
+        uint32_t receivedUs = 0;
+        uint32_t parsedUs = 0;
+        uint32_t writeUs = 0;
+        uint32_t writtenUs = 0;
+        uint32_t repliedUs = 0;
+    };
+
+    struct StageStats
+    {
+        std::string name;
+        size_t count = 0;
+        double p50Ms = 0.0;
+        double p95Ms = 0.0;
+        double maxMs = 0.0;
+    };
+
+    static constexpr size_t MaxCommands = 100000;
+    static constexpr size_t MaxInputs = 400000;
+
+    // Clears the recording and starts a new one
+    void start();
+    void stop() { m_active = false; }
+    bool isActive() const { return m_active; }
+
+    int64_t nowUs() const;
+
+    // A slider or other input asked for angle (servo degrees)
+    void input(int angle);
+    // The input since the last command will not be sent, e.g. it repeated
+    // the angle already sent or there is no connection
+    void discardInput() { m_pendingInputUs = -1; }
+    // set_servo number id went out on the socket
+    void sent(uint64_t id, int angle);
+    // Its reply arrived, device is nullptr when the firmware did not trace it
+    void acknowledged(uint64_t id, bool ok, const DeviceTimes *device);
+    // Position telemetry, the first sample close to the last command ends its move
+    void servoPosition(int index, double position);
+
+    size_t commandCount() const { return m_commands.size(); }
+    size_t droppedCount() const { return m_dropped; }
+
+    // queue, uplink, device, receive, servo.write, reply, downlink,
+    // round trip and settle, in milliseconds
+    std::vector<StageStats> summary() const;
+
+    std::string chromeTraceJson() const;
+    bool writeChromeTrace(const std::string &path) const;
+
+private:
+    struct Command
+    {
+        uint64_t id = 0;
+        int angle = 0;
+        bool ok = false;
+        bool hasDevice = false;
+        int64_t inputUs = -1;
+        int64_t sentUs = -1;
+        int64_t ackUs = -1;
+        int64_t echoUs = -1;
+        double echoPosition = 0.0;
+        // Device stages on the client clock
+        int64_t receivedUs = -1;
+        int64_t parsedUs = -1;
+        int64_t writeUs = -1;
+        int64_t writtenUs = -1;
+        int64_t repliedUs = -1;
+    };
+
+    struct Input
+    {
+        int64_t timeUs;
+        int angle;
+    };
+
+    struct SyncSample
+    {
+        int64_t offsetUs; // device minus client
+        int64_t delayUs;  // round trip without the time on the device
+    };
+
+    Command *find(uint64_t id);
+    int64_t unwrapDevice(uint32_t us);
+    int64_t toClient(uint32_t us);
+
+    bool m_active = false;
+    std::chrono::steady_clock::time_point m_start;
+    std::vector<Command> m_commands;
+    std::vector<Input> m_inputs;
+    size_t m_dropped = 0;
+    int64_t m_pendingInputUs = -1;
+    size_t m_awaitingEcho = SIZE_MAX; // index of the command whose move is still open
+
+    // Clock sync
+    std::deque<SyncSample> m_syncSamples;
+    int64_t m_offsetUs = 0;
+    bool m_haveDeviceTime = false;
+    uint32_t m_lastDeviceUs = 0;
+    int64_t m_lastDeviceUnwrappedUs = 0;
+};
+
+#endif // COMMANDTRACE_H
@@ -1,8 +1,18 @@
 #include "esp32client.h"
+#include "commandtrace.h"
 #include <QDebug>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 
+namespace {
+
+// One command per PWM frame of the servo, faster updates are never seen
+constexpr qint64 MinServoIntervalNs = 20 * 1000000;
+constexpr int MaxCommandsInFlight = 2;
+
+} // namespace
+
 ESP32Client::ESP32Client(const QString &host, int port, const QString &authPassword, QObject *parent)
     : QObject(parent)
     , socket(new QTcpSocket(this))
@@ -16,6 +26,11 @@ ESP32Client::ESP32Client(const QString &host, int port, const QString &authPassw
     connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::errorOccurred),
             this, &ESP32Client::onSocketError);
     connect(socket, &QTcpSocket::readyRead, this, &ESP32Client::onDataReceived);
+    clock.start();
+
+    servoFlushTimer.setSingleShot(true);
+    servoFlushTimer.setTimerType(Qt::PreciseTimer);
+    connect(&servoFlushTimer, &QTimer::timeout, this, &ESP32Client::flushServo);
 }
 
 ESP32Client::~ESP32Client()
@@ -34,6 +49,11 @@ void ESP32Client::connectToHost()
 
     authenticated = false;
     messageBuffer.clear();
+    pendingCommands.clear();
+    acknowledgedServoId = servoCommandId;
+    pendingServoAngle = -1;
+    lastSentServoAngle = -1;
+    receivedPositionTelemetry = false;
     socket->connectToHost(host, port);
 }
 
@@ -56,11 +76,59 @@ bool ESP32Client::isConnected() const
 void ESP32Client::controlServo(int angle)
 {
     if (!isConnected()) return;
+    // The firmware refuses anything else, and a negative angle would read as
+    // "nothing pending" below
+    if (angle < 0 || angle > 180) {
+        qWarning() << "Servo angle" << angle << "outside [0, 180] not sent";
+        if (m_trace)
+            m_trace->discardInput();
+        return;
+    }
+
+    pendingServoAngle = angle;
+    flushServo();
+}
+
+void ESP32Client::flushServo()
+{
+    if (pendingServoAngle < 0 || !isConnected()) return;
+
+    // Nothing new for the servo
+    if (pendingServoAngle == lastSentServoAngle) {
+        pendingServoAngle = -1;
+        if (m_trace)
+            m_trace->discardInput();
+        return;
+    }
+
+    // Wait for an acknowledgement, flushServo() runs again when it arrives
+    if (pendingCommands.size() >= MaxCommandsInFlight) return;
 
+    const qint64 now = clock.nsecsElapsed();
+    const qint64 wait = lastServoSendTime + MinServoIntervalNs - now;
+    if (lastSentServoAngle >= 0 && wait > 0) {
+        if (!servoFlushTimer.isActive())
+            servoFlushTimer.start(int((wait + 999999) / 1000000));
+        return;
+    }
+
+    const int angle = pendingServoAngle;
+    pendingServoAngle = -1;
+    lastSentServoAngle = angle;
+    lastServoSendTime = now;
+
+    const bool tracing = m_trace && m_trace->isActive();
     QJsonObject message;
     message["command"] = "set_servo";
     message["angle"] = angle;
+    if (tracing)
+        message["id"] = double(servoCommandId + 1);
     sendMessage(message);
+    // Both firmwares acknowledge every set_servo in order
+    pendingCommands.enqueue({ now, ++servoCommandId, angle });
+    if (tracing)
+        m_trace->sent(servoCommandId, angle);
+    emit servoCommandSent(angle);
 }
 
 void ESP32Client::onSocketConnected()
@@ -100,6 +168,7 @@ void ESP32Client::onSocketError(QAbstractSocket::SocketError error)
 void ESP32Client::onDataReceived()
 {
     QByteArray data = socket->readAll();
+    m_stats.bytesReceived += quint64(data.size());
     messageBuffer += QString::fromUtf8(data);
 
     while (messageBuffer.contains('\n')) {
@@ -113,6 +182,7 @@ void ESP32Client::onDataReceived()
         QJsonDocument doc = QJsonDocument::fromJson(line.toUtf8(), &error);
 
         if (error.error == QJsonParseError::NoError && doc.isObject()) {
+            m_stats.messagesReceived++;
             processMessage(doc.object());
         }
     }
@@ -125,12 +195,38 @@ void ESP32Client::sendMessage(const QJsonObject &message)
     QJsonDocument doc(message);
     QByteArray data = doc.toJson(QJsonDocument::Compact) + "\n";
     socket->write(data);
+    m_stats.messagesSent++;
+    m_stats.bytesSent += quint64(data.size());
 }
 
 void ESP32Client::processMessage(const QJsonObject &message)
 {
+    if (message["type"].toString() == "status") {
+        // Position telemetry, only sent by firmware that can measure it
+        const QJsonArray servos = message["servos"].toArray();
+        for (const QJsonValue &servo : servos) {
+            const QJsonObject entry = servo.toObject();
+            if (!entry.contains("position"))
+                continue;
+            receivedPositionTelemetry = true;
+            if (m_trace)
+                m_trace->servoPosition(entry["index"].toInt(), entry["position"].toDouble());
+            emit servoPositionReceived(entry["index"].toInt(), entry["position"].toDouble());
+        }
+        return;
+    }
+
     if (message.contains("status")) {
         QString status = message["status"].toString();
+        if (authenticated && !pendingCommands.isEmpty()) {
+            const PendingCommand command = pendingCommands.dequeue();
+            acknowledgedServoId = command.id;
+            emit roundTripMeasured((clock.nsecsElapsed() - command.sentNs) / 1e6);
+            if (m_trace)
+                traceAcknowledgement(command.id, status == "success", message);
+            emit servoCommandAcknowledged(command.id, command.angle, status == "success");
+            flushServo();
+        }
         if (status == "success" && !authenticated) {
             authenticated = true;
             emit connectionStateChanged(true);
@@ -153,3 +249,20 @@ void ESP32Client::authenticate()
     authMessage["password"] = authPassword;
     sendMessage(authMessage);
 }
+
+void ESP32Client::traceAcknowledgement(quint64 id, bool ok, const QJsonObject &message)
+{
+    // Firmware without tracing answers without the id and stage times
+    const QJsonObject trace = message["trace"].toObject();
+    if (message["id"].toDouble() != double(id) || trace.isEmpty()) {
+        m_trace->acknowledged(id, ok, nullptr);
+        return;
+    }
+    CommandTrace::DeviceTimes device;
+    device.receivedUs = quint32(trace["rx"].toDouble());
+    device.parsedUs = quint32(trace["parsed"].toDouble());
+    device.writeUs = quint32(trace["write"].toDouble());
+    device.writtenUs = quint32(trace["written"].toDouble());
+    device.repliedUs = quint32(trace["tx"].toDouble());
+    m_trace->acknowledged(id, ok, &device);
+}
@@ -1,11 +1,15 @@
 #ifndef ESP32CLIENT_H
 #define ESP32CLIENT_H
 
+#include <QElapsedTimer>
 #include <QObject>
+#include <QQueue>
 #include <QTcpSocket>
 #include <QTimer>
 #include <QJsonObject>
 
+class CommandTrace;
+
 class ESP32Client : public QObject
 {
     Q_OBJECT
@@ -19,11 +23,52 @@ public:
     void connectToHost();
     void disconnect();
     bool isConnected() const;
+
+    // Coalescing: the angle is sent right away when the link is idle,
+    // otherwise it replaces any angle still waiting, and goes out once the
+    // minimum interval has passed and fewer than MaxCommandsInFlight
+    // commands are unacknowledged. Fast input sources can call this at any
+    // rate without queueing stale positions behind the socket. Angles
+    // outside [0, 180] are dropped.
     void controlServo(int angle);
 
+    // Traffic counters since construction, for the performance harness
+    struct Stats
+    {
+        quint64 messagesSent = 0;
+        quint64 bytesSent = 0;
+        quint64 messagesReceived = 0;
+        quint64 bytesReceived = 0;
+    };
+    Stats stats() const { return m_stats; }
+
+    // set_servo commands are numbered from 1 as they go out on the socket.
+    // The firmware acknowledges them in order, so everything up to
+    // acknowledgedServoCommandId() has been answered.
+    quint64 lastServoCommandId() const { return servoCommandId; }
+    quint64 acknowledgedServoCommandId() const { return acknowledgedServoId; }
+    int lastServoAngle() const { return lastSentServoAngle; }
+    bool hasPendingServo() const { return pendingServoAngle >= 0; }
+    // Whether this connection has delivered position telemetry. Only
+    // servo_sim measures positions, the firmware never sends them.
+    bool hasPositionTelemetry() const { return receivedPositionTelemetry; }
+
+    // While trace is recording, set_servo commands carry their id so the
+    // firmware answers with its stage times, and sends, acknowledgements
+    // and position telemetry are reported to it. Not owned.
+    void setTrace(CommandTrace *trace) { m_trace = trace; }
+
 signals:
     void connectionStateChanged(bool connected);
     void errorOccurred(const QString &error);
+    // Measured servo angle from a status push, in servo degrees [0, 180]
+    void servoPositionReceived(int index, double position);
+    // Time from sending a command to its acknowledgement
+    void roundTripMeasured(double milliseconds);
+    // A set_servo actually went out on the socket
+    void servoCommandSent(int angle);
+    // The firmware answered set_servo number id, ok is false on an error reply
+    void servoCommandAcknowledged(quint64 id, int angle, bool ok);
 
 private slots:
     void onSocketConnected();
@@ -35,6 +80,8 @@ private:
     void sendMessage(const QJsonObject &message);
     void processMessage(const QJsonObject &message);
     void authenticate();
+    void flushServo();
+    void traceAcknowledgement(quint64 id, bool ok, const QJsonObject &message);
 
     QTcpSocket *socket;
     QString host;
@@ -42,6 +89,25 @@ private:
     QString authPassword;
     bool authenticated;
     QString messageBuffer;
+    QElapsedTimer clock;
+    struct PendingCommand
+    {
+        qint64 sentNs;
+        quint64 id;
+        int angle;
+    };
+    QQueue<PendingCommand> pendingCommands; // unacknowledged set_servo commands
+    quint64 servoCommandId = 0;
+    quint64 acknowledgedServoId = 0;
+    Stats m_stats;
+    CommandTrace *m_trace = nullptr;
+
+    // Latest angle not sent yet, -1 when there is none
+    int pendingServoAngle = -1;
+    int lastSentServoAngle = -1;
+    qint64 lastServoSendTime = 0;
+    bool receivedPositionTelemetry = false;
+    QTimer servoFlushTimer;
 };
 
 #endif // ESP32CLIENT_H
@@ -0,0 +1,294 @@
+#include "evdevgamepad.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t BitsPerLong = sizeof(unsigned long) * 8;
+
+bool testBit(const unsigned long *bits, int bit)
+{
+    return (bits[bit / BitsPerLong] >> (bit % BitsPerLong)) & 1UL;
+}
+
+const int ButtonCodes[EvdevGamepad::ButtonCount] = {
+    BTN_SOUTH, BTN_EAST, BTN_WEST, BTN_NORTH, BTN_SELECT, BTN_START,
+};
+
+// Absolute axis bits of an open device
+struct AbsBits
+{
+    unsigned long bits[ABS_CNT / BitsPerLong + 1] = {};
+
+    bool has(int code) const { return testBit(bits, code); }
+};
+
+bool readAbsBits(int fd, AbsBits &abs)
+{
+    return ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(abs.bits)), abs.bits) >= 0;
+}
+
+// Touchpads, touchscreens and tablets report ABS_X/ABS_Y too, only devices
+// with gamepad or joystick buttons count as sticks
+bool isGamepad(int fd)
+{
+    AbsBits abs;
+    unsigned long keys[KEY_CNT / BitsPerLong + 1] = {};
+    if (!readAbsBits(fd, abs) || !abs.has(ABS_X) || !abs.has(ABS_Y)
+        || ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keys)), keys) < 0)
+        return false;
+    return testBit(keys, BTN_GAMEPAD) || testBit(keys, BTN_JOYSTICK);
+}
+
+} // namespace
+
+EvdevGamepad::~EvdevGamepad()
+{
+    close();
+}
+
+std::string EvdevGamepad::findDevice()
+{
+    DIR *dir = opendir("/dev/input");
+    if (!dir)
+        return {};
+
+    std::string found;
+    while (dirent *entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "event", 5) != 0)
+            continue;
+        const std::string path = std::string("/dev/input/") + entry->d_name;
+        const int fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        const bool isStick = isGamepad(fd);
+        ::close(fd);
+        // Lowest event number wins, readdir order is arbitrary
+        if (isStick && (found.empty() || path.size() < found.size() || (path.size() == found.size() && path < found)))
+            found = path;
+    }
+    closedir(dir);
+    return found;
+}
+
+bool EvdevGamepad::open(const std::string &path, std::string *error)
+{
+    close();
+
+    m_fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0) {
+        if (error)
+            *error = path + ": " + strerror(errno);
+        return false;
+    }
+
+    char name[256] = {};
+    ioctl(m_fd, EVIOCGNAME(sizeof(name) - 1), name);
+    m_name = name;
+
+    AbsBits abs;
+    if (!isGamepad(m_fd) || !readAbsBits(m_fd, abs)) {
+        if (error)
+            *error = path + " is not a gamepad or joystick";
+        close();
+        return false;
+    }
+
+    // Gamepad spec layout, or the older one with the right stick on Z/RZ
+    m_axes = {};
+    m_axes[LeftX].code = ABS_X;
+    m_axes[LeftY].code = ABS_Y;
+    if (abs.has(ABS_RX) && abs.has(ABS_RY)) {
+        m_axes[RightX].code = ABS_RX;
+        m_axes[RightY].code = ABS_RY;
+        if (abs.has(ABS_Z))
+            m_axes[LeftTrigger].code = ABS_Z;
+        if (abs.has(ABS_RZ))
+            m_axes[RightTrigger].code = ABS_RZ;
+    } else if (abs.has(ABS_Z) && abs.has(ABS_RZ)) {
+        m_axes[RightX].code = ABS_Z;
+        m_axes[RightY].code = ABS_RZ;
+    }
+    m_axes[LeftTrigger].trigger = true;
+    m_axes[RightTrigger].trigger = true;
+
+    std::copy(std::begin(ButtonCodes), std::end(ButtonCodes), m_buttonCodes.begin());
+    resync();
+    return true;
+}
+
+void EvdevGamepad::close()
+{
+    stop();
+    if (m_fd >= 0)
+        ::close(m_fd);
+    m_fd = -1;
+    m_name.clear();
+}
+
+bool EvdevGamepad::start(double rateHz, TickCallback onTick, ErrorCallback onError)
+{
+    if (m_fd < 0 || m_running || rateHz <= 0.0 || !onTick)
+        return false;
+
+    m_stopRequested = false;
+    m_running = true;
+    m_thread = std::thread(&EvdevGamepad::run, this, rateHz, m_shaping, std::move(onTick), std::move(onError));
+    return true;
+}
+
+void EvdevGamepad::stop()
+{
+    m_stopRequested = true;
+    if (m_thread.joinable())
+        m_thread.join();
+    m_running = false;
+}
+
+double EvdevGamepad::shape(double value, const Shaping &shaping)
+{
+    const double magnitude = std::fabs(value);
+    if (magnitude <= shaping.deadzone)
+        return 0.0;
+    // Rescale so the output starts at zero at the edge of the deadzone
+    const double x = std::min(1.0, (magnitude - shaping.deadzone) / (1.0 - shaping.deadzone));
+    const double y = (1.0 - shaping.expo) * x + shaping.expo * x * x * x;
+    return std::copysign(y, value);
+}
+
+double EvdevGamepad::normalised(const AxisInfo &axis)
+{
+    if (axis.code < 0 || axis.maximum <= axis.minimum)
+        return 0.0;
+    const double range = double(axis.maximum) - double(axis.minimum);
+    if (axis.trigger)
+        return std::clamp((double(axis.value) - axis.minimum) / range, 0.0, 1.0);
+    const double center = (double(axis.minimum) + double(axis.maximum)) / 2.0;
+    return std::clamp((double(axis.value) - center) / (range / 2.0), -1.0, 1.0);
+}
+
+void EvdevGamepad::resync()
+{
+    for (AxisInfo &axis : m_axes) {
+        input_absinfo info {};
+        if (axis.code >= 0 && ioctl(m_fd, EVIOCGABS(axis.code), &info) >= 0) {
+            axis.minimum = info.minimum;
+            axis.maximum = info.maximum;
+            axis.value = info.value;
+        }
+    }
+}
+
+void EvdevGamepad::resyncButtons(State &state) const
+{
+    unsigned long keys[KEY_CNT / BitsPerLong + 1] = {};
+    if (ioctl(m_fd, EVIOCGKEY(sizeof(keys)), keys) < 0)
+        return;
+    for (int b = 0; b < ButtonCount; b++) {
+        const bool down = testBit(keys, m_buttonCodes[b]);
+        // A press lost with the dropped events still counts
+        if (down && !state.buttons[b])
+            state.pressed |= 1u << b;
+        state.buttons[b] = down;
+    }
+}
+
+void EvdevGamepad::run(double rateHz, Shaping shaping, TickCallback onTick, ErrorCallback onError)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rateHz));
+
+    State state;
+    auto last = Clock::now();
+    auto next = last + period;
+    std::string error;
+    pollfd pfd { m_fd, POLLIN, 0 };
+    bool dropping = false;
+
+    while (!m_stopRequested) {
+        auto now = Clock::now();
+        if (now >= next) {
+            for (int i = 0; i < AxisCount; i++)
+                state.axes[i] = shape(normalised(m_axes[i]), shaping);
+            onTick(state, std::chrono::duration<double>(now - last).count());
+            state.pressed = 0;
+            last = now;
+            // Skip ticks that were missed rather than bursting to catch up
+            next += period;
+            if (next <= now)
+                next = now + period;
+            continue;
+        }
+
+        const auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(next - now);
+        const timespec timeout { time_t(wait.count() / 1000000000), long(wait.count() % 1000000000) };
+        const int ready = ppoll(&pfd, 1, &timeout, nullptr);
+        if (ready < 0 && errno != EINTR) {
+            error = strerror(errno);
+            break;
+        }
+        if (ready <= 0)
+            continue;
+        if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            error = "device disconnected";
+            break;
+        }
+
+        input_event events[64];
+        for (;;) {
+            const ssize_t bytes = read(m_fd, events, sizeof(events));
+            if (bytes == 0) {
+                error = "device disconnected";
+                break;
+            }
+            if (bytes < 0) {
+                if (errno != EAGAIN && errno != EINTR)
+                    error = strerror(errno);
+                break;
+            }
+            for (size_t i = 0; i < size_t(bytes) / sizeof(input_event); i++) {
+                const input_event &event = events[i];
+                if (event.type == EV_SYN && event.code == SYN_DROPPED) {
+                    // The kernel buffer overflowed: the events up to the next
+                    // report are incomplete, the state is read back after it
+                    dropping = true;
+                } else if (dropping) {
+                    if (event.type == EV_SYN && event.code == SYN_REPORT) {
+                        dropping = false;
+                        resync();
+                        resyncButtons(state);
+                    }
+                } else if (event.type == EV_ABS) {
+                    for (AxisInfo &axis : m_axes) {
+                        if (axis.code == event.code)
+                            axis.value = event.value;
+                    }
+                } else if (event.type == EV_KEY) {
+                    for (int b = 0; b < ButtonCount; b++) {
+                        if (m_buttonCodes[b] != event.code)
+                            continue;
+                        state.buttons[b] = event.value != 0;
+                        if (event.value == 1)
+                            state.pressed |= 1u << b;
+                    }
+                }
+            }
+        }
+        if (!error.empty())
+            break;
+    }
+
+    if (!error.empty() && onError)
+        onError(error);
+    m_running = false;
+}
@@ -0,0 +1,93 @@
+#ifndef EVDEVGAMEPAD_H
+#define EVDEVGAMEPAD_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+// Linux evdev joystick/gamepad reader.
+//
+// Events are read on a dedicated thread, which also runs a fixed-rate tick:
+// at every tick the latest axis values are normalised, passed through the
+// deadzone and expo curve and handed to the tick callback together with the
+// time since the previous tick. Everything runs on that thread, so the
+// callback has to hand its results over to whoever consumes them.
+// It has no Qt dependency so that command line tools can reuse it.
+class EvdevGamepad
+{
+public:
+    // Standard gamepad layout of the Linux gamepad spec
+    enum Axis { LeftX, LeftY, RightX, RightY, LeftTrigger, RightTrigger, AxisCount };
+    enum Button { South, East, West, North, Select, Start, ButtonCount };
+
+    struct Shaping
+    {
+        double deadzone = 0.1; // fraction of the stick travel ignored around the center
+        double expo = 0.4;     // 0 = linear, 1 = cubic, for fine control near the center
+    };
+
+    struct State
+    {
+        std::array<double, AxisCount> axes {}; // sticks in [-1, 1], triggers in [0, 1]
+        std::array<bool, ButtonCount> buttons {};
+        uint32_t pressed = 0; // bit per button pressed since the previous tick
+    };
+
+    using TickCallback = std::function<void(const State &state, double dt)>;
+    using ErrorCallback = std::function<void(const std::string &error)>;
+
+    EvdevGamepad() = default;
+    ~EvdevGamepad();
+    EvdevGamepad(const EvdevGamepad &) = delete;
+    EvdevGamepad &operator=(const EvdevGamepad &) = delete;
+
+    // First /dev/input/event* node with at least two absolute stick axes and
+    // gamepad or joystick buttons, or an empty string
+    static std::string findDevice();
+
+    bool open(const std::string &path, std::string *error = nullptr);
+    void close();
+    bool isOpen() const { return m_fd >= 0; }
+    const std::string &name() const { return m_name; }
+
+    // Takes effect on the next start()
+    void setShaping(const Shaping &shaping) { m_shaping = shaping; }
+
+    // Starts the reader thread. onError is called from that thread when the
+    // device goes away, after which the thread ends.
+    bool start(double rateHz, TickCallback onTick, ErrorCallback onError = nullptr);
+    void stop();
+    bool isRunning() const { return m_running; }
+
+    // Deadzone and expo of one normalised stick value, exposed for tools
+    static double shape(double value, const Shaping &shaping);
+
+private:
+    struct AxisInfo
+    {
+        int code = -1;
+        int32_t minimum = 0;
+        int32_t maximum = 0;
+        int32_t value = 0;
+        bool trigger = false;
+    };
+
+    void run(double rateHz, Shaping shaping, TickCallback onTick, ErrorCallback onError);
+    void resync();
+    void resyncButtons(State &state) const;
+    static double normalised(const AxisInfo &axis);
+
+    int m_fd = -1;
+    std::string m_name;
+    Shaping m_shaping;
+    std::array<AxisInfo, AxisCount> m_axes {};
+    std::array<int, ButtonCount> m_buttonCodes {};
+    std::thread m_thread;
+    std::atomic<bool> m_running { false };
+    std::atomic<bool> m_stopRequested { false };
+};
+
+#endif // EVDEVGAMEPAD_H
@@ -0,0 +1,57 @@
+// Frame time benchmark of the instanced fleet view (FleetView.qml) against
+// one RoboticArm node tree per arm, for 1, 10 and 100 arms.
+//
+// Usage: fleetbench [--frames N] [--warmup N] [--arms 1,10,100] [FleetBenchmark.qml]
+//
+// The QML file has to sit next to RoboticArm.qml and its meshes/ and maps/
+// directories. Vsync is turned off so the numbers are the real frame cost.
+
+#include <QGuiApplication>
+#include <QQmlApplicationEngine>
+#include <QSurfaceFormat>
+#include <QUrl>
+#include <QtQml/qqmlextensionplugin.h>
+#include <QtQuick3D/qquick3d.h>
+
+Q_IMPORT_QML_PLUGIN(BackendPlugin)
+
+int main(int argc, char *argv[])
+{
+    QSurfaceFormat format = QQuick3D::idealSurfaceFormat();
+    format.setSwapInterval(0);
+    QSurfaceFormat::setDefaultFormat(format);
+    // GUI and render work on one thread, so a frame interval is the whole cost
+    qputenv("QSG_RENDER_LOOP", "basic");
+    qSetMessagePattern("%{message}");
+
+    QGuiApplication app(argc, argv);
+
+    QVariantMap properties;
+    QString qmlFile = QStringLiteral(FLEETBENCH_QML);
+    const QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); i++) {
+        const QString &arg = args[i];
+        if (arg == "--frames" && i + 1 < args.size()) {
+            properties["measuredFrames"] = args[++i].toInt();
+        } else if (arg == "--warmup" && i + 1 < args.size()) {
+            properties["warmupFrames"] = args[++i].toInt();
+        } else if (arg == "--arms" && i + 1 < args.size()) {
+            QList<int> counts;
+            for (const QString &count : args[++i].split(','))
+                counts.append(count.toInt());
+            properties["armCounts"] = QVariant::fromValue(counts);
+        } else if (!arg.startsWith("--")) {
+            qmlFile = arg;
+        } else {
+            qWarning("usage: fleetbench [--frames N] [--warmup N] [--arms 1,10,100] [FleetBenchmark.qml]");
+            return 1;
+        }
+    }
+
+    QQmlApplicationEngine engine;
+    engine.setInitialProperties(properties);
+    QObject::connect(&engine, &QQmlApplicationEngine::objectCreationFailed, &app,
+                     []() { QCoreApplication::exit(1); }, Qt::QueuedConnection);
+    engine.load(QUrl::fromLocalFile(qmlFile));
+    return app.exec();
+}
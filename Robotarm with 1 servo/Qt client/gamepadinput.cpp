@@ -0,0 +1,144 @@
+#include "gamepadinput.h"
+
+#include "backend.h"
+
+namespace {
+
+constexpr double ClawSpeed = 180.0;
+
+} // namespace
+
+GamepadInput::GamepadInput(QObject *parent) : QObject(parent)
+{
+}
+
+GamepadInput::~GamepadInput()
+{
+    // Joins the reader thread before anything it posts to goes away
+    m_gamepad.close();
+}
+
+Backend *GamepadInput::backend() const
+{
+    return m_backend;
+}
+
+void GamepadInput::setBackend(Backend *backend)
+{
+    if (backend == m_backend)
+        return;
+    m_backend = backend;
+    emit backendChanged();
+}
+
+QString GamepadInput::device() const
+{
+    return m_device;
+}
+
+void GamepadInput::setDevice(const QString &device)
+{
+    if (device == m_device)
+        return;
+    m_device = device;
+    emit deviceChanged();
+}
+
+QString GamepadInput::deviceName() const
+{
+    return QString::fromStdString(m_gamepad.name());
+}
+
+bool GamepadInput::isActive() const
+{
+    return m_active;
+}
+
+bool GamepadInput::isCartesian() const
+{
+    return m_cartesian;
+}
+
+void GamepadInput::setCartesian(bool cartesian)
+{
+    if (cartesian == m_cartesian)
+        return;
+    m_cartesian = cartesian;
+    emit cartesianChanged();
+}
+
+bool GamepadInput::start()
+{
+    stop();
+
+    const std::string path = m_device.isEmpty() ? EvdevGamepad::findDevice() : m_device.toStdString();
+    std::string error;
+    if (path.empty()) {
+        emit errorOccurred(tr("No gamepad found"));
+        return false;
+    }
+    if (!m_gamepad.open(path, &error)) {
+        emit errorOccurred(QString::fromStdString(error));
+        return false;
+    }
+
+    m_gamepad.setShaping({ m_deadzone, m_expo });
+    const bool started = m_gamepad.start(
+            m_rate,
+            [this](const EvdevGamepad::State &state, double dt) {
+                // Reader thread: hand the tick over, Backend lives on the GUI thread
+                QMetaObject::invokeMethod(this, [this, state, dt]() { applyTick(state, dt); },
+                                          Qt::QueuedConnection);
+            },
+            [this](const std::string &error) {
+                const QString message = QString::fromStdString(error);
+                QMetaObject::invokeMethod(this, [this, message]() {
+                    m_active = false;
+                    emit activeChanged();
+                    emit errorOccurred(message);
+                }, Qt::QueuedConnection);
+            });
+
+    m_active = started;
+    emit activeChanged();
+    return started;
+}
+
+void GamepadInput::stop()
+{
+    m_gamepad.close();
+    if (m_active) {
+        m_active = false;
+        emit activeChanged();
+    }
+}
+
+void GamepadInput::applyTick(const EvdevGamepad::State &state, double dt)
+{
+    if (!m_active)
+        return;
+    if (state.pressed & (1u << EvdevGamepad::South))
+        setCartesian(!m_cartesian);
+    if (!m_backend)
+        return;
+
+    using Pad = EvdevGamepad;
+    // Stick Y axes grow downwards
+    const double leftX = state.axes[Pad::LeftX];
+    const double leftY = -state.axes[Pad::LeftY];
+    const double rightX = state.axes[Pad::RightX];
+    const double rightY = -state.axes[Pad::RightY];
+    const double claws = (state.axes[Pad::LeftTrigger] - state.axes[Pad::RightTrigger]) * ClawSpeed;
+
+    ArmModel::JointVector velocity {};
+    velocity[ArmModel::Rotation4] = leftX * m_jointSpeed;
+    velocity[ArmModel::Rotation1] = rightX * m_jointSpeed;
+    if (!m_cartesian) {
+        velocity[ArmModel::Rotation3] = leftY * m_jointSpeed;
+        velocity[ArmModel::Rotation2] = rightY * m_jointSpeed;
+    }
+    m_backend->jogJoints(velocity, claws, dt);
+
+    if (m_cartesian && (leftY != 0.0 || rightY != 0.0))
+        m_backend->jogWrist(rightY * m_cartesianSpeed, leftY * m_cartesianSpeed, dt);
+}
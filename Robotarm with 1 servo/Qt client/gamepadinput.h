@@ -0,0 +1,80 @@
+#ifndef GAMEPADINPUT_H
+#define GAMEPADINPUT_H
+
+#include "evdevgamepad.h"
+#include <QObject>
+#include <QPointer>
+#include <qqmlregistration.h>
+
+class Backend;
+
+// Jogs a Backend from a Linux gamepad or joystick.
+//
+// The device is read by EvdevGamepad on its own thread, which ticks at
+// rate Hz; every tick is handed to the GUI thread and turned into a joint
+// or wrist velocity step on the Backend. Commands to the servo go through
+// ESP32Client's coalescing, so the tick rate can be well above the link rate.
+//
+// Joint mode: left stick X/Y -> rotation4/rotation3, right stick Y/X ->
+// rotation2/rotation1. Cartesian mode: left stick Y and right stick Y move
+// the wrist up/down and in/out in the arm plane, the X axes stay on
+// rotation4 and rotation1. Triggers close (right) and open (left) the claws,
+// South toggles the mode.
+class GamepadInput : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(Backend *backend READ backend WRITE setBackend NOTIFY backendChanged)
+    // Event node such as /dev/input/event5, empty picks the first gamepad
+    Q_PROPERTY(QString device READ device WRITE setDevice NOTIFY deviceChanged)
+    Q_PROPERTY(QString deviceName READ deviceName NOTIFY activeChanged)
+    Q_PROPERTY(bool active READ isActive NOTIFY activeChanged)
+    Q_PROPERTY(bool cartesian READ isCartesian WRITE setCartesian NOTIFY cartesianChanged)
+    Q_PROPERTY(qreal rate MEMBER m_rate NOTIFY settingsChanged)
+    Q_PROPERTY(qreal deadzone MEMBER m_deadzone NOTIFY settingsChanged)
+    Q_PROPERTY(qreal expo MEMBER m_expo NOTIFY settingsChanged)
+    // Speeds at full stick deflection
+    Q_PROPERTY(qreal jointSpeed MEMBER m_jointSpeed NOTIFY settingsChanged)
+    Q_PROPERTY(qreal cartesianSpeed MEMBER m_cartesianSpeed NOTIFY settingsChanged)
+
+public:
+    explicit GamepadInput(QObject *parent = nullptr);
+    ~GamepadInput();
+
+    Backend *backend() const;
+    void setBackend(Backend *backend);
+    QString device() const;
+    void setDevice(const QString &device);
+    QString deviceName() const;
+    bool isActive() const;
+    bool isCartesian() const;
+    void setCartesian(bool cartesian);
+
+    // Opens the device and starts jogging, rate/deadzone/expo are read here
+    Q_INVOKABLE bool start();
+    Q_INVOKABLE void stop();
+
+signals:
+    void backendChanged();
+    void deviceChanged();
+    void activeChanged();
+    void cartesianChanged();
+    void settingsChanged();
+    void errorOccurred(const QString &error);
+
+private:
+    void applyTick(const EvdevGamepad::State &state, double dt);
+
+    EvdevGamepad m_gamepad;
+    QPointer<Backend> m_backend;
+    QString m_device;
+    bool m_active = false;
+    bool m_cartesian = false;
+    qreal m_rate = 200.0;
+    qreal m_deadzone = 0.1;
+    qreal m_expo = 0.4;
+    qreal m_jointSpeed = 90.0;
+    qreal m_cartesianSpeed = 150.0;
+};
+
+#endif // GAMEPADINPUT_H
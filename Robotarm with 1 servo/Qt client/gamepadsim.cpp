@@ -0,0 +1,233 @@
+// Virtual gamepad for exercising GamepadInput without hardware
+//
+// Creates a uinput device with the axes and buttons of a standard gamepad
+// and moves the sticks along slow sine waves, pressing South every few
+// seconds. The client picks it up like a real pad (GamepadInput with an
+// empty device). With --check it also reads the device back through
+// EvdevGamepad at --rate Hz and reports the tick rate and the difference
+// between the shaped axes and what was written.
+//
+// Usage: gamepadsim [--seconds 10] [--check] [--rate 200]
+//
+// Needs write access to /dev/uinput (root, or a udev rule for the user).
+
+#include "evdevgamepad.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <mutex>
+#include <string>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr int AxisRange = 32767;
+constexpr double Pi = 3.14159265358979323846;
+
+struct Options
+{
+    double seconds = 10.0;
+    bool check = false;
+    double rate = 200.0;
+};
+
+bool emitEvent(int fd, int type, int code, int value)
+{
+    input_event event {};
+    event.type = type;
+    event.code = code;
+    event.value = value;
+    return write(fd, &event, sizeof(event)) == sizeof(event);
+}
+
+int createDevice(std::string &eventNode)
+{
+    const int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+    if (fd < 0) {
+        fprintf(stderr, "/dev/uinput: %s\n", strerror(errno));
+        return -1;
+    }
+
+    ioctl(fd, UI_SET_EVBIT, EV_KEY);
+    for (const int button : { BTN_SOUTH, BTN_EAST, BTN_WEST, BTN_NORTH, BTN_SELECT, BTN_START })
+        ioctl(fd, UI_SET_KEYBIT, button);
+
+    ioctl(fd, UI_SET_EVBIT, EV_ABS);
+    for (const int axis : { ABS_X, ABS_Y, ABS_RX, ABS_RY, ABS_Z, ABS_RZ }) {
+        const bool trigger = axis == ABS_Z || axis == ABS_RZ;
+        uinput_abs_setup abs {};
+        abs.code = axis;
+        abs.absinfo.minimum = trigger ? 0 : -AxisRange;
+        abs.absinfo.maximum = AxisRange;
+        ioctl(fd, UI_ABS_SETUP, &abs);
+    }
+
+    uinput_setup setup {};
+    setup.id.bustype = BUS_VIRTUAL;
+    setup.id.vendor = 0x1209;
+    setup.id.product = 0x0e32;
+    snprintf(setup.name, UINPUT_MAX_NAME_SIZE, "ESP32 arm virtual gamepad");
+    if (ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ioctl(fd, UI_DEV_CREATE) < 0) {
+        fprintf(stderr, "Cannot create the uinput device: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    // /sys/devices/virtual/input/<sysname>/eventN names the node
+    char sysname[64] = {};
+    if (ioctl(fd, UI_GET_SYSNAME(sizeof(sysname)), sysname) >= 0) {
+        for (int i = 0; i < 256 && eventNode.empty(); i++) {
+            const std::string path = std::string("/sys/devices/virtual/input/") + sysname + "/event" + std::to_string(i);
+            if (access(path.c_str(), F_OK) == 0)
+                eventNode = "/dev/input/event" + std::to_string(i);
+        }
+    }
+    return fd;
+}
+
+// Axis values at time t, sticks in [-1, 1] and triggers in [0, 1]
+std::array<double, EvdevGamepad::AxisCount> pattern(double t)
+{
+    return { std::sin(2 * Pi * 0.20 * t), std::sin(2 * Pi * 0.13 * t), std::sin(2 * Pi * 0.17 * t),
+             std::cos(2 * Pi * 0.11 * t), 0.5 + 0.5 * std::sin(2 * Pi * 0.07 * t),
+             0.5 - 0.5 * std::sin(2 * Pi * 0.07 * t) };
+}
+
+bool parseArguments(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--check") {
+            options.check = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            return false;
+        const char *value = argv[++i];
+        if (arg == "--seconds")
+            options.seconds = atof(value);
+        else if (arg == "--rate")
+            options.rate = atof(value);
+        else
+            return false;
+    }
+    return options.seconds > 0.0 && options.rate > 0.0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [--seconds 10] [--check] [--rate 200]\n", argv[0]);
+        return 1;
+    }
+
+    std::string eventNode;
+    const int fd = createDevice(eventNode);
+    if (fd < 0)
+        return 1;
+    printf("Created %s\n", eventNode.empty() ? "virtual gamepad" : eventNode.c_str());
+    fflush(stdout);
+
+    // udev needs a moment to create the node
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    auto elapsed = [&]() { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+    // --- Read back ---
+    EvdevGamepad gamepad;
+    const EvdevGamepad::Shaping shaping;
+    std::mutex mutex;
+    std::vector<double> tickIntervals;
+    double maxError = 0.0;
+    std::array<double, EvdevGamepad::AxisCount> written {};
+    std::atomic<int> presses { 0 };
+
+    if (options.check) {
+        std::string error;
+        if (eventNode.empty() || !gamepad.open(eventNode, &error)) {
+            fprintf(stderr, "Cannot open the virtual gamepad: %s\n", error.c_str());
+            ioctl(fd, UI_DEV_DESTROY);
+            close(fd);
+            return 1;
+        }
+        gamepad.setShaping(shaping);
+        gamepad.start(options.rate, [&](const EvdevGamepad::State &state, double dt) {
+            std::lock_guard<std::mutex> lock(mutex);
+            tickIntervals.push_back(dt);
+            if (state.pressed & (1u << EvdevGamepad::South))
+                presses++;
+            for (int i = 0; i < EvdevGamepad::AxisCount; i++)
+                maxError = std::max(maxError, std::fabs(state.axes[i] - EvdevGamepad::shape(written[i], shaping)));
+        });
+    }
+
+    // --- Playback at 500 Hz ---
+    int pressesSent = 0;
+    bool southDown = false;
+    while (elapsed() < options.seconds) {
+        const double t = elapsed();
+        const auto values = pattern(t);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const int codes[] = { ABS_X, ABS_Y, ABS_RX, ABS_RY, ABS_Z, ABS_RZ };
+            for (int i = 0; i < EvdevGamepad::AxisCount; i++) {
+                emitEvent(fd, EV_ABS, codes[i], int(std::lround(values[i] * AxisRange)));
+                written[i] = std::round(values[i] * AxisRange) / AxisRange;
+                // Triggers are normalised against [0, max], sticks around zero
+                if (i >= EvdevGamepad::LeftTrigger)
+                    written[i] = std::clamp(written[i], 0.0, 1.0);
+            }
+        }
+
+        // Press South for 100 ms every 3 s
+        const bool down = std::fmod(t, 3.0) > 2.9;
+        if (down != southDown) {
+            emitEvent(fd, EV_KEY, BTN_SOUTH, down ? 1 : 0);
+            southDown = down;
+            pressesSent += down;
+        }
+        emitEvent(fd, EV_SYN, SYN_REPORT, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    gamepad.close();
+    ioctl(fd, UI_DEV_DESTROY);
+    close(fd);
+
+    if (!options.check)
+        return 0;
+
+    std::sort(tickIntervals.begin(), tickIntervals.end());
+    if (tickIntervals.empty()) {
+        fprintf(stderr, "No ticks received\n");
+        return 1;
+    }
+    const double rate = double(tickIntervals.size()) / options.seconds;
+    printf("ticks            %zu (%.1f Hz, asked for %.1f Hz)\n", tickIntervals.size(), rate, options.rate);
+    printf("tick interval    p50 %.3f ms  p99 %.3f ms  max %.3f ms\n", tickIntervals[tickIntervals.size() / 2] * 1e3,
+           tickIntervals[std::min(tickIntervals.size() - 1, tickIntervals.size() * 99 / 100)] * 1e3,
+           tickIntervals.back() * 1e3);
+    printf("button presses   %d seen, %d sent\n", presses.load(), pressesSent);
+    // Includes up to one playback step of lag between writer and reader
+    printf("max axis error   %.4f\n", maxError);
+
+    const bool ok = rate > options.rate * 0.9 && presses == pressesSent;
+    printf("%s\n", ok ? "OK" : "FAIL");
+    return ok ? 0 : 2;
+}
@@ -0,0 +1,162 @@
+#include "jointanimator.h"
+
+#include <QQuickWindow>
+#include <QtMath>
+
+namespace {
+
+// (1 + w t) e^(-w t) drops below 1% at w t = 6.64
+constexpr double SettleFactor = 6.64;
+constexpr double DefaultSettleTime = 1.0;
+constexpr double ClawsSettleTime = 0.5;
+
+// Close enough to the target to stop integrating
+constexpr double RestDistance = 0.01;
+constexpr double RestVelocity = 0.05;
+
+// Longest step taken after a stall, so a hitch doesn't look like a jump
+constexpr double MaxFrameTime = 0.1;
+
+constexpr int FallbackIntervalMs = 16;
+
+} // namespace
+
+JointAnimator::JointAnimator(QObject *parent) : QObject(parent)
+{
+    m_omega.fill(SettleFactor / DefaultSettleTime);
+    m_omega[Claws] = SettleFactor / ClawsSettleTime;
+
+    m_fallbackTimer.setInterval(FallbackIntervalMs);
+    m_fallbackTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_fallbackTimer, &QTimer::timeout, this, &JointAnimator::tick);
+    m_clock.start();
+}
+
+void JointAnimator::setWindow(QQuickWindow *window)
+{
+    if (window == m_window)
+        return;
+
+    disconnect(m_frameConnection);
+    m_window = window;
+    if (m_window) {
+        // afterAnimating is emitted on the GUI thread once per frame, right
+        // before the scene graph synchronizes, so the new pose makes it into
+        // the frame being prepared
+        m_frameConnection = connect(m_window, &QQuickWindow::afterAnimating, this, &JointAnimator::tick);
+        m_fallbackTimer.stop();
+    }
+    if (m_active)
+        start();
+}
+
+QQuickWindow *JointAnimator::window() const
+{
+    return m_window;
+}
+
+void JointAnimator::setSettleTime(int channel, double seconds)
+{
+    m_omega[channel] = SettleFactor / qMax(seconds, 1e-3);
+}
+
+void JointAnimator::setStepLimiter(StepLimiter limiter)
+{
+    m_stepLimiter = std::move(limiter);
+    m_stepScale.setValue(1.0);
+}
+
+void JointAnimator::setTarget(int channel, double value)
+{
+    if (m_target[channel] == value)
+        return;
+
+    m_target[channel] = value;
+    const bool wasActive = m_active != 0;
+    m_active |= 1u << channel;
+    if (!wasActive)
+        start();
+}
+
+void JointAnimator::start()
+{
+    m_lastTickNs = m_clock.nsecsElapsed();
+    m_running.setValue(true);
+    if (m_window)
+        m_window->update();
+    else if (!m_fallbackTimer.isActive())
+        m_fallbackTimer.start();
+}
+
+void JointAnimator::tick()
+{
+    if (!m_active)
+        return;
+
+    const qint64 now = m_clock.nsecsElapsed();
+    const double dt = qMin((now - m_lastTickNs) / 1e9, MaxFrameTime);
+    m_lastTickNs = now;
+    advance(dt);
+
+    if (!m_active) {
+        m_fallbackTimer.stop();
+        m_running.setValue(false);
+        m_stepScale.setValue(1.0);
+    } else if (m_window) {
+        // Keep frames coming while anything moves
+        m_window->update();
+    }
+}
+
+void JointAnimator::advance(double dt)
+{
+    // Spring step of every moving channel first, so the limiter sees the
+    // whole step at once
+    Values position = m_position;
+    Values velocity = m_velocity;
+    for (int i = 0; i < ChannelCount; i++) {
+        if (!(m_active & (1u << i)))
+            continue;
+
+        // Exact solution of the critically damped spring over dt, stable for
+        // any frame time
+        const double w = m_omega[i];
+        const double error = m_position[i] - m_target[i];
+        const double c = m_velocity[i] + w * error;
+        const double decay = qExp(-w * dt);
+        position[i] = m_target[i] + (error + c * dt) * decay;
+        velocity[i] = (m_velocity[i] - w * c * dt) * decay;
+    }
+
+    double scale = 1.0;
+    if (m_stepLimiter && (m_active & ~(1u << Claws))) {
+        Values step;
+        for (int i = 0; i < ChannelCount; i++)
+            step[i] = position[i] - m_position[i];
+        scale = qBound(0.0, m_stepLimiter(m_position, step, dt), 1.0);
+    }
+
+    unsigned changed = 0;
+    for (int i = 0; i < ChannelCount; i++) {
+        if (!(m_active & (1u << i)))
+            continue;
+
+        if (i != Claws && scale < 1.0) {
+            position[i] = m_position[i] + (position[i] - m_position[i]) * scale;
+            velocity[i] *= scale;
+        }
+        if (qAbs(position[i] - m_target[i]) < RestDistance && qAbs(velocity[i]) < RestVelocity) {
+            position[i] = m_target[i];
+            velocity[i] = 0.0;
+            m_active &= ~(1u << i);
+        }
+        if (position[i] != m_position[i])
+            changed |= 1u << i;
+        m_position[i] = position[i];
+        m_velocity[i] = velocity[i];
+    }
+    m_stepScale.setValue(scale);
+
+    if (changed)
+        emit updated(changed);
+}
@@ -0,0 +1,84 @@
+#ifndef JOINTANIMATOR_H
+#define JOINTANIMATOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QProperty>
+#include <QTimer>
+#include <array>
+#include <functional>
+
+class QQuickWindow;
+
+// Moves all arm joints towards their targets with critically damped springs.
+// The state of every joint lives in one set of arrays that is integrated in a
+// single pass per frame, followed by one updated() signal, instead of one
+// animation object and one notification chain per joint.
+//
+// With a window attached the animator is ticked by the scene graph once per
+// frame; without one (e.g. headless) a 16 ms timer stands in.
+class JointAnimator : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Channel { Rotation1, Rotation2, Rotation3, Rotation4, Claws, ChannelCount };
+    using Values = std::array<double, ChannelCount>;
+
+    // Called every tick with the positions before it, the step the springs
+    // are about to take and the tick length. Returns the fraction of the step
+    // the arm joints may take, the claws are not limited.
+    using StepLimiter = std::function<double(const Values &position, const Values &step, double dt)>;
+
+    explicit JointAnimator(QObject *parent = nullptr);
+
+    void setWindow(QQuickWindow *window);
+    QQuickWindow *window() const;
+
+    // Time for a joint to get within ~1% of a new target
+    void setSettleTime(int channel, double seconds);
+
+    // Slows the arm down without touching the targets, see StepLimiter.
+    // A held back joint keeps its spring at rest, so it sets off again as
+    // soon as the limiter lets it.
+    void setStepLimiter(StepLimiter limiter);
+    // Fraction the last tick was allowed to take, 1 when nothing held it back
+    double stepScale() const { return m_stepScale.value(); }
+    QBindable<double> bindableStepScale() const { return &m_stepScale; }
+
+    void setTarget(int channel, double value);
+    double target(int channel) const { return m_target[channel]; }
+    double value(int channel) const { return m_position[channel]; }
+
+    bool isRunning() const { return m_running.value(); }
+    QBindable<bool> bindableRunning() const { return &m_running; }
+
+    // Advances all joints by dt seconds, called from the frame tick
+    void advance(double dt);
+
+signals:
+    // Emitted once per tick with a bit set for every channel that moved
+    void updated(unsigned changedChannels);
+
+private:
+    void tick();
+    void start();
+
+    Values m_position {};
+    Values m_velocity {};
+    Values m_target {};
+    Values m_omega {};
+    unsigned m_active = 0; // bit per channel still moving
+    StepLimiter m_stepLimiter;
+    QProperty<double> m_stepScale { 1.0 };
+
+    QProperty<bool> m_running { false };
+    QPointer<QQuickWindow> m_window;
+    QMetaObject::Connection m_frameConnection;
+    QTimer m_fallbackTimer;
+    QElapsedTimer m_clock;
+    qint64 m_lastTickNs = 0;
+};
+
+#endif // JOINTANIMATOR_H
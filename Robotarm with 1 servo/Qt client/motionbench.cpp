@@ -0,0 +1,288 @@
+// Cycle time of a motion sequence: coroutines against padded timers
+//
+// Runs the same pick-and-place style sequence of servo 0 against a firmware
+// stand-in twice: chained with QTimer::singleShot and a fixed pad per move,
+// the way sequences were written before MotionScript, and as a coroutine
+// that awaits the acknowledgement and the telemetry of every move. Reports
+// the cycle time of both and, for the timer version, how many moves had not
+// settled when their pad ran out.
+//
+// Usage:
+//   motionbench [--sim path/to/servo_sim | --host 127.0.0.1 --port 8080]
+//               [--cycles 5] [--pad-ms 800] [--tolerance 2]
+//
+// --sim starts servo_sim on a free port with 10 ms status pushes. Settling
+// is detected from those; the firmware sends no positions, so against a
+// board waitSettled() falls back to a fixed settle time and the comparison
+// only measures that.
+// Exits with 2 when the coroutine version is not faster than the timers.
+
+#include "esp32client.h"
+#include "motionscript.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+// Servo degrees, starting and ending at the home position
+const int Sequence[] = { 30, 150, 90, 10, 170, 90 };
+constexpr int HomeAngle = 90;
+
+struct Options
+{
+    QString simPath;
+    QString host = QStringLiteral("127.0.0.1");
+    int port = 8080;
+    int cycles = 5;
+    int padMs = 800;
+    double tolerance = 2.0;
+};
+
+struct Result
+{
+    std::vector<double> cycleMs;
+    int moves = 0;
+    int unsettled = 0;
+
+    double mean() const
+    {
+        double sum = 0.0;
+        for (const double value : cycleMs)
+            sum += value;
+        return cycleMs.empty() ? 0.0 : sum / double(cycleMs.size());
+    }
+
+    void print(const char *name) const
+    {
+        if (cycleMs.empty())
+            return;
+        const auto [min, max] = std::minmax_element(cycleMs.begin(), cycleMs.end());
+        printf("%-12s cycle mean %7.1f ms  min %7.1f ms  max %7.1f ms", name, mean(), *min, *max);
+        if (unsettled > 0)
+            printf("  (%d/%d moves not settled)", unsettled, moves);
+        printf("\n");
+    }
+};
+
+MotionTask home(MotionScript &arm, double tolerance)
+{
+    co_return co_await arm.moveTo(HomeAngle) && co_await arm.waitSettled(tolerance);
+}
+
+MotionTask runCoroutines(MotionScript &arm, const Options &options, Result &result)
+{
+    QElapsedTimer cycle;
+    for (int i = 0; i < options.cycles; i++) {
+        cycle.start();
+        for (const int angle : Sequence) {
+            if (!co_await arm.moveTo(angle) || !co_await arm.waitSettled(options.tolerance))
+                co_return false;
+            result.moves++;
+        }
+        result.cycleMs.push_back(cycle.nsecsElapsed() / 1e6);
+    }
+    co_return true;
+}
+
+// The same sequence with a fixed pad after every command
+class TimerSequence
+{
+public:
+    TimerSequence(ESP32Client &client, const Options &options, const double &position, Result &result)
+        : m_client(client), m_options(options), m_position(position), m_result(result)
+    {
+    }
+
+    void start(std::function<void()> done)
+    {
+        m_done = std::move(done);
+        m_step = 0;
+        next();
+    }
+
+private:
+    void next()
+    {
+        const int length = int(std::size(Sequence));
+        if (m_step > 0) {
+            m_result.moves++;
+            if (std::abs(m_position - Sequence[(m_step - 1) % length]) > m_options.tolerance)
+                m_result.unsettled++;
+        }
+        if (m_step % length == 0) {
+            if (m_step > 0)
+                m_result.cycleMs.push_back(m_cycle.nsecsElapsed() / 1e6);
+            m_cycle.start();
+        }
+        if (m_step == m_options.cycles * length) {
+            m_done();
+            return;
+        }
+
+        m_client.controlServo(Sequence[m_step % length]);
+        m_step++;
+        QTimer::singleShot(m_options.padMs, &m_client, [this]() { next(); });
+    }
+
+    ESP32Client &m_client;
+    const Options &m_options;
+    const double &m_position;
+    Result &m_result;
+    std::function<void()> m_done;
+    QElapsedTimer m_cycle;
+    int m_step = 0;
+};
+
+bool parseArguments(const QStringList &args, Options &options)
+{
+    for (int i = 1; i < args.size(); i++) {
+        const QString &arg = args[i];
+        if (i + 1 >= args.size())
+            return false;
+        const QString value = args[++i];
+
+        if (arg == "--sim")
+            options.simPath = value;
+        else if (arg == "--host")
+            options.host = value;
+        else if (arg == "--port")
+            options.port = value.toInt();
+        else if (arg == "--cycles")
+            options.cycles = qMax(1, value.toInt());
+        else if (arg == "--pad-ms")
+            options.padMs = qMax(1, value.toInt());
+        else if (arg == "--tolerance")
+            options.tolerance = value.toDouble();
+        else
+            return false;
+    }
+    return true;
+}
+
+// Starts servo_sim on a free port and returns that port, or -1
+int startSimulator(QProcess &process, const QString &path)
+{
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.start(path, { "--port", "0", "--status-ms", "10" });
+    if (!process.waitForStarted(3000))
+        return -1;
+
+    QElapsedTimer timeout;
+    timeout.start();
+    while (timeout.elapsed() < 3000) {
+        if (!process.canReadLine() && !process.waitForReadyRead(100))
+            continue;
+        const QString line = QString::fromUtf8(process.readLine()).trimmed();
+        if (line.startsWith("Listening on port "))
+            return line.section(' ', 3, 3).toInt();
+    }
+    return -1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    Options options;
+    if (!parseArguments(app.arguments(), options)) {
+        fprintf(stderr, "usage: motionbench [--sim servo_sim | --host H --port N] [--cycles N] [--pad-ms X]\n"
+                        "                   [--tolerance X]\n");
+        return 1;
+    }
+
+    QProcess simulator;
+    if (!options.simPath.isEmpty()) {
+        options.host = QStringLiteral("127.0.0.1");
+        options.port = startSimulator(simulator, options.simPath);
+        if (options.port < 0) {
+            fprintf(stderr, "Could not start %s\n", qPrintable(options.simPath));
+            return 1;
+        }
+    }
+
+    ESP32Client client(options.host, options.port);
+    MotionScript arm(&client);
+    double position = -1.0;
+    Result timers;
+    Result coroutines;
+    TimerSequence timerSequence(client, options, position, timers);
+    MotionTask task;
+    int exitCode = 0;
+    bool started = false;
+
+    auto fail = [&](const char *what) {
+        fprintf(stderr, "%s\n", what);
+        exitCode = 1;
+        app.quit();
+    };
+
+    QObject::connect(&client, &ESP32Client::servoPositionReceived, &app, [&](int index, double value) {
+        if (index == 0)
+            position = value;
+    });
+    QObject::connect(&client, &ESP32Client::errorOccurred, &app, [&](const QString &error) {
+        fprintf(stderr, "%s\n", qPrintable(error));
+        exitCode = 1;
+        app.quit();
+    });
+    QObject::connect(&client, &ESP32Client::connectionStateChanged, &app, [&](bool connected) {
+        if (!connected || started)
+            return;
+        started = true;
+
+        // home, timers, home, coroutines
+        task = home(arm, options.tolerance);
+        task.onFinished([&](bool homed) {
+            if (!homed)
+                return fail("Servo 0 did not reach the home position, no telemetry?");
+            timerSequence.start([&]() {
+                task = home(arm, options.tolerance);
+                task.onFinished([&](bool homedAgain) {
+                    if (!homedAgain)
+                        return fail("Servo 0 did not reach the home position");
+                    task = runCoroutines(arm, options, coroutines);
+                    task.onFinished([&](bool ok) {
+                        if (!ok)
+                            return fail("Coroutine sequence failed");
+                        app.quit();
+                    });
+                });
+            });
+        });
+    });
+
+    QTimer::singleShot(5000, &app, [&]() {
+        if (!started)
+            fail("No connection");
+    });
+
+    client.connectToHost();
+    app.exec();
+
+    client.disconnect();
+    if (simulator.state() != QProcess::NotRunning) {
+        simulator.terminate();
+        simulator.waitForFinished(2000);
+    }
+    if (exitCode != 0)
+        return exitCode;
+
+    printf("%d cycles of %d moves, tolerance %.1f deg\n", options.cycles, int(std::size(Sequence)),
+           options.tolerance);
+    timers.print("timers");
+    coroutines.print("coroutines");
+    const double speedup = coroutines.mean() > 0.0 ? timers.mean() / coroutines.mean() : 0.0;
+    printf("speedup      %.2fx (pad %d ms)\n", speedup, options.padMs);
+    return speedup > 1.0 ? 0 : 2;
+}
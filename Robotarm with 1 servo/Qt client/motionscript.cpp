@@ -0,0 +1,246 @@
+#include "motionscript.h"
+
+#include "esp32client.h"
+#include "servopredictor.h"
+#include <QCoreApplication>
+#include <QObject>
+#include <QTimer>
+#include <cmath>
+#include <exception>
+#include <utility>
+
+// --- MotionTask ---
+
+std::coroutine_handle<> MotionTask::FinalAwaiter::await_suspend(Handle handle) noexcept
+{
+    // The callback may destroy the task and with it this frame, so take
+    // everything needed out of the promise first
+    promise_type &promise = handle.promise();
+    const std::coroutine_handle<> continuation = promise.continuation;
+    const std::function<void(bool)> finished = std::move(promise.finished);
+    if (finished)
+        finished(promise.result);
+    return continuation ? continuation : std::noop_coroutine();
+}
+
+void MotionTask::promise_type::unhandled_exception()
+{
+    // The client is built without relying on exceptions
+    std::terminate();
+}
+
+MotionTask::MotionTask(MotionTask &&other) noexcept : m_handle(std::exchange(other.m_handle, {}))
+{
+}
+
+MotionTask &MotionTask::operator=(MotionTask &&other) noexcept
+{
+    if (this != &other) {
+        if (m_handle)
+            m_handle.destroy();
+        m_handle = std::exchange(other.m_handle, {});
+    }
+    return *this;
+}
+
+MotionTask::~MotionTask()
+{
+    // Destroys the awaiter the sequence is suspended on, which disconnects it
+    if (m_handle)
+        m_handle.destroy();
+}
+
+void MotionTask::onFinished(std::function<void(bool)> callback)
+{
+    if (!m_handle)
+        return;
+    if (m_handle.done()) {
+        callback(m_handle.promise().result);
+        return;
+    }
+    m_handle.promise().finished = std::move(callback);
+}
+
+// --- MotionAwaiter ---
+
+MotionAwaiter::MotionAwaiter(ESP32Client *client, int timeoutMs)
+    : m_client(client)
+    , m_context(new QObject)
+    , m_alive(std::make_shared<bool>(true))
+    , m_timeoutMs(timeoutMs)
+{
+}
+
+MotionAwaiter::~MotionAwaiter() = default;
+
+void MotionAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    m_handle = handle;
+    if (m_client) {
+        QObject::connect(m_client, &QObject::destroyed, context(), [this]() { finish(false); });
+        QObject::connect(m_client, &ESP32Client::connectionStateChanged, context(), [this](bool connected) {
+            if (!connected)
+                finish(false);
+        });
+    }
+    if (m_timeoutMs > 0)
+        QTimer::singleShot(m_timeoutMs, context(), [this]() { finish(false); });
+    watch();
+}
+
+void MotionAwaiter::finishNow(bool result)
+{
+    m_ready = true;
+    m_finished = true;
+    m_result = result;
+}
+
+void MotionAwaiter::finish(bool result)
+{
+    if (m_finished)
+        return;
+    m_finished = true;
+    m_result = result;
+
+    // Resume from the event loop so that the sequence never runs inside an
+    // ESP32Client signal. The connections stay until the awaiter goes away
+    // with the frame, m_finished makes them no-ops meanwhile; destroying the
+    // frame first expires the token and cancels the resume.
+    QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [handle = m_handle, alive = std::weak_ptr<bool>(m_alive)]() {
+                if (!alive.expired())
+                    handle.resume();
+            },
+            Qt::QueuedConnection);
+}
+
+// --- MotionScript ---
+
+MotionScript::MoveAwaiter::MoveAwaiter(ESP32Client *client, int angle, int timeoutMs)
+    : MotionAwaiter(client, timeoutMs)
+    , m_angle(angle)
+{
+    if (!client || !client->isConnected()) {
+        finishNow(false);
+        return;
+    }
+    client->controlServo(angle);
+
+    // Already there: duplicate angles are not sent again
+    if (!client->hasPendingServo() && client->lastServoAngle() == angle
+        && client->acknowledgedServoCommandId() == client->lastServoCommandId())
+        finishNow(true);
+}
+
+void MotionScript::MoveAwaiter::watch()
+{
+    QObject::connect(m_client, &ESP32Client::servoCommandAcknowledged, context(),
+                     [this](quint64, int angle, bool ok) {
+        if (!ok)
+            finish(false);
+        else if (angle == m_angle)
+            finish(true);
+    });
+}
+
+MotionScript::SettleAwaiter::SettleAwaiter(ESP32Client *client, double toleranceDeg, int timeoutMs)
+    : MotionAwaiter(client, timeoutMs)
+    , m_tolerance(toleranceDeg)
+{
+    if (!client || !client->isConnected() || client->lastServoAngle() < 0)
+        finishNow(false);
+}
+
+void MotionScript::SettleAwaiter::watch()
+{
+    QObject::connect(m_client, &ESP32Client::servoPositionReceived, context(), [this](int index, double position) {
+        if (index == 0 && std::abs(position - m_client->lastServoAngle()) <= m_tolerance)
+            finish(true);
+    });
+    if (m_client->hasPositionTelemetry())
+        return;
+
+    // No position telemetry: wait until the last command has been answered
+    // and give the servo the time it needs for any move
+    if (!m_client->hasPendingServo() && m_client->acknowledgedServoCommandId() == m_client->lastServoCommandId()) {
+        startSettleTimer();
+        return;
+    }
+    QObject::connect(m_client, &ESP32Client::servoCommandAcknowledged, context(), [this](quint64 id, int, bool ok) {
+        if (!ok)
+            finish(false);
+        else if (id >= m_client->lastServoCommandId() && !m_client->hasPendingServo())
+            startSettleTimer();
+    });
+}
+
+void MotionScript::SettleAwaiter::startSettleTimer()
+{
+    if (m_settleTimerStarted)
+        return;
+    m_settleTimerStarted = true;
+    const ServoPlant plant;
+    const double settleMs = plant.delayMs + 180.0 / plant.maxSlewDps * 1000.0 + 3.0 * plant.timeConstantMs;
+    QTimer::singleShot(int(std::ceil(settleMs)), context(), [this]() { finish(true); });
+}
+
+MotionScript::AckAwaiter::AckAwaiter(ESP32Client *client, quint64 id, int timeoutMs)
+    : MotionAwaiter(client, timeoutMs)
+    , m_id(id)
+{
+    if (!client)
+        finishNow(false);
+    else if (client->acknowledgedServoCommandId() >= id)
+        finishNow(true);
+    else if (!client->isConnected())
+        finishNow(false);
+}
+
+void MotionScript::AckAwaiter::watch()
+{
+    QObject::connect(m_client, &ESP32Client::servoCommandAcknowledged, context(), [this](quint64 id, int, bool ok) {
+        if (id >= m_id)
+            finish(ok);
+    });
+}
+
+MotionScript::DelayAwaiter::DelayAwaiter(int milliseconds)
+    : MotionAwaiter(nullptr, 0)
+    , m_milliseconds(milliseconds)
+{
+}
+
+void MotionScript::DelayAwaiter::watch()
+{
+    QTimer::singleShot(qMax(0, m_milliseconds), context(), [this]() { finish(true); });
+}
+
+MotionScript::MotionScript(ESP32Client *client) : m_client(client)
+{
+}
+
+ESP32Client *MotionScript::client() const
+{
+    return m_client;
+}
+
+MotionScript::MoveAwaiter MotionScript::moveTo(int angle) const
+{
+    return MoveAwaiter(m_client, angle, m_timeoutMs);
+}
+
+MotionScript::SettleAwaiter MotionScript::waitSettled(double toleranceDeg) const
+{
+    return SettleAwaiter(m_client, toleranceDeg, m_timeoutMs);
+}
+
+MotionScript::AckAwaiter MotionScript::ack(quint64 id) const
+{
+    return AckAwaiter(m_client, id, m_timeoutMs);
+}
+
+MotionScript::DelayAwaiter MotionScript::delay(int milliseconds) const
+{
+    return DelayAwaiter(milliseconds);
+}
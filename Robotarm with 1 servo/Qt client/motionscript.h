@@ -0,0 +1,197 @@
+#ifndef MOTIONSCRIPT_H
+#define MOTIONSCRIPT_H
+
+#include <QPointer>
+#include <QtGlobal>
+#include <coroutine>
+#include <functional>
+#include <memory>
+
+class ESP32Client;
+class QObject;
+
+// C++20 coroutine layer over ESP32Client for motion sequences.
+//
+// A sequence is a coroutine returning MotionTask that awaits protocol
+// events instead of chaining timers:
+//
+//   MotionTask pickAndPlace(MotionScript &arm)
+//   {
+//       if (!co_await arm.moveTo(30) || !co_await arm.waitSettled())
+//           co_return false;
+//       co_await arm.delay(200);
+//       co_return co_await arm.moveTo(150);
+//   }
+//
+// Every await resumes with true on success and false when the link drops,
+// the client goes away, the firmware answers with an error or the timeout
+// of the MotionScript passes, so a sequence stops at the first failure.
+// Coroutines resume from the event loop of the client's thread, never
+// from inside an ESP32Client signal, so a sequence may freely send or
+// disconnect. Destroying a MotionTask cancels the sequence.
+//
+// Only servo 0 is wired to the firmware, so poses are its angle in servo
+// degrees [0, 180].
+
+class MotionTask
+{
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(Handle handle) noexcept;
+        void await_resume() const noexcept {}
+    };
+
+    struct promise_type
+    {
+        bool result = false;
+        std::coroutine_handle<> continuation;
+        std::function<void(bool)> finished;
+
+        MotionTask get_return_object() { return MotionTask(Handle::from_promise(*this)); }
+        // Sequences start running when called
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_value(bool value) { result = value; }
+        void unhandled_exception();
+    };
+
+    MotionTask() = default;
+    MotionTask(MotionTask &&other) noexcept;
+    MotionTask &operator=(MotionTask &&other) noexcept;
+    MotionTask(const MotionTask &) = delete;
+    MotionTask &operator=(const MotionTask &) = delete;
+    ~MotionTask();
+
+    bool isValid() const { return bool(m_handle); }
+    bool isDone() const { return m_handle && m_handle.done(); }
+    bool result() const { return isDone() && m_handle.promise().result; }
+
+    // Called with the result when the sequence returns, right away when it
+    // already has. The callback may destroy the task.
+    void onFinished(std::function<void(bool)> callback);
+
+    // Awaiting a task from another sequence runs it as a sub-sequence
+    bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+    void await_suspend(std::coroutine_handle<> continuation) { m_handle.promise().continuation = continuation; }
+    bool await_resume() const { return result(); }
+
+private:
+    explicit MotionTask(Handle handle) : m_handle(handle) {}
+
+    Handle m_handle;
+};
+
+// Base of the awaitables of MotionScript
+class MotionAwaiter
+{
+public:
+    MotionAwaiter(const MotionAwaiter &) = delete;
+    MotionAwaiter &operator=(const MotionAwaiter &) = delete;
+    virtual ~MotionAwaiter();
+
+    bool await_ready() const noexcept { return m_ready; }
+    void await_suspend(std::coroutine_handle<> handle);
+    bool await_resume() const noexcept { return m_result; }
+
+protected:
+    MotionAwaiter(ESP32Client *client, int timeoutMs);
+
+    // Connects the signals that finish the wait, once suspended
+    virtual void watch() = 0;
+    // Finishes without suspending, from the constructor
+    void finishNow(bool result);
+    // Resumes the coroutine with result from the event loop
+    void finish(bool result);
+    QObject *context() const { return m_context.get(); }
+
+    QPointer<ESP32Client> m_client;
+
+private:
+    std::unique_ptr<QObject> m_context; // receiver of every connection, deleting it disconnects
+    std::shared_ptr<bool> m_alive;      // expires with the awaiter
+    std::coroutine_handle<> m_handle;
+    int m_timeoutMs;
+    bool m_ready = false;
+    bool m_result = false;
+    bool m_finished = false;
+};
+
+class MotionScript
+{
+public:
+    // Sends the angle through the client's coalescing and resumes when the
+    // firmware acknowledges it
+    class MoveAwaiter : public MotionAwaiter
+    {
+    public:
+        MoveAwaiter(ESP32Client *client, int angle, int timeoutMs);
+
+    private:
+        void watch() override;
+        int m_angle;
+    };
+
+    // Resumes on the first telemetry sample of servo 0 within tolerance of
+    // the last commanded angle. Position telemetry only comes from
+    // servo_sim; on a connection without it (the real firmware) this falls
+    // back to waiting for the acknowledgement of the last command plus the
+    // time a full-range move of the default ServoPlant takes to settle.
+    class SettleAwaiter : public MotionAwaiter
+    {
+    public:
+        SettleAwaiter(ESP32Client *client, double toleranceDeg, int timeoutMs);
+
+    private:
+        void watch() override;
+        void startSettleTimer();
+        double m_tolerance;
+        bool m_settleTimerStarted = false;
+    };
+
+    // Resumes once set_servo number id and everything before it has been
+    // answered, see ESP32Client::lastServoCommandId()
+    class AckAwaiter : public MotionAwaiter
+    {
+    public:
+        AckAwaiter(ESP32Client *client, quint64 id, int timeoutMs);
+
+    private:
+        void watch() override;
+        quint64 m_id;
+    };
+
+    // Plain wait, for dwell times that belong to the task itself
+    class DelayAwaiter : public MotionAwaiter
+    {
+    public:
+        explicit DelayAwaiter(int milliseconds);
+
+    private:
+        void watch() override;
+        int m_milliseconds;
+    };
+
+    explicit MotionScript(ESP32Client *client);
+
+    ESP32Client *client() const;
+
+    // Upper bound of every wait, 0 waits forever
+    void setTimeout(int milliseconds) { m_timeoutMs = milliseconds; }
+    int timeout() const { return m_timeoutMs; }
+
+    MoveAwaiter moveTo(int angle) const;
+    SettleAwaiter waitSettled(double toleranceDeg = 2.0) const;
+    AckAwaiter ack(quint64 id) const;
+    DelayAwaiter delay(int milliseconds) const;
+
+private:
+    QPointer<ESP32Client> m_client;
+    int m_timeoutMs = 3000;
+};
+
+#endif // MOTIONSCRIPT_H
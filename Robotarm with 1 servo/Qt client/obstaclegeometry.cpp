@@ -0,0 +1,162 @@
+#include "obstaclegeometry.h"
+
+#include <QVector3D>
+#include <QtMath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Sides of a tessellated cylinder
+constexpr int CylinderSegments = 24;
+
+// Position and normal per vertex
+constexpr int FloatsPerVertex = 6;
+
+QVector3D toVector(const ArmModel::Vec3 &v)
+{
+    return QVector3D(float(v.x), float(v.y), float(v.z));
+}
+
+class TriangleWriter
+{
+public:
+    // Flat shaded triangle. When inside is given the triangle is wound to
+    // face away from it, which is all that convex shapes need.
+    void add(QVector3D a, QVector3D b, QVector3D c, const QVector3D *inside = nullptr)
+    {
+        QVector3D normal = QVector3D::crossProduct(b - a, c - a).normalized();
+        if (inside && QVector3D::dotProduct(normal, (a + b + c) / 3.0f - *inside) < 0.0f) {
+            std::swap(b, c);
+            normal = -normal;
+        }
+        for (const QVector3D &p : { a, b, c }) {
+            m_floats.insert(m_floats.end(), { p.x(), p.y(), p.z(), normal.x(), normal.y(), normal.z() });
+            m_min = QVector3D(qMin(m_min.x(), p.x()), qMin(m_min.y(), p.y()), qMin(m_min.z(), p.z()));
+            m_max = QVector3D(qMax(m_max.x(), p.x()), qMax(m_max.y(), p.y()), qMax(m_max.z(), p.z()));
+        }
+    }
+
+    void addBox(const ArmModel::BoxObstacle &box)
+    {
+        // Same turn as ObstacleScene applies to boxes and placed meshes
+        const float c = float(qCos(qDegreesToRadians(box.yaw)));
+        const float s = float(qSin(qDegreesToRadians(box.yaw)));
+        const QVector3D center = toVector(box.center);
+        QVector3D corners[8];
+        for (int i = 0; i < 8; i++) {
+            const float x = float((i & 1) ? box.halfExtents.x : -box.halfExtents.x);
+            const float y = float((i & 2) ? box.halfExtents.y : -box.halfExtents.y);
+            const float z = float((i & 4) ? box.halfExtents.z : -box.halfExtents.z);
+            corners[i] = center + QVector3D(c * x + s * z, y, -s * x + c * z);
+        }
+        // Two triangles per face, faces as corner bit masks
+        static constexpr int Faces[6][4] = {
+            { 0, 2, 6, 4 }, { 1, 3, 7, 5 }, // -x, +x
+            { 0, 1, 5, 4 }, { 2, 3, 7, 6 }, // -y, +y
+            { 0, 1, 3, 2 }, { 4, 5, 7, 6 }, // -z, +z
+        };
+        for (const auto &face : Faces) {
+            add(corners[face[0]], corners[face[1]], corners[face[2]], &center);
+            add(corners[face[0]], corners[face[2]], corners[face[3]], &center);
+        }
+    }
+
+    void addCylinder(const ArmModel::CylinderObstacle &cylinder)
+    {
+        const QVector3D center = toVector(cylinder.center);
+        const QVector3D up(0.0f, float(cylinder.halfHeight), 0.0f);
+        auto rim = [&](int i) {
+            const qreal angle = 2.0 * M_PI * i / CylinderSegments;
+            return center + QVector3D(float(cylinder.radius * qCos(angle)), 0.0f, float(cylinder.radius * qSin(angle)));
+        };
+        for (int i = 0; i < CylinderSegments; i++) {
+            const QVector3D a = rim(i), b = rim(i + 1);
+            add(a - up, b - up, b + up, &center);
+            add(a - up, b + up, a + up, &center);
+            add(center + up, a + up, b + up, &center);
+            add(center - up, a - up, b - up, &center);
+        }
+    }
+
+    // The winding of mesh files cannot be relied on, so both sides are drawn
+    void addMesh(const ArmModel::MeshObstacle &mesh)
+    {
+        for (const std::array<uint32_t, 3> &triangle : mesh.triangles) {
+            const QVector3D a = toVector(mesh.vertices[triangle[0]]);
+            const QVector3D b = toVector(mesh.vertices[triangle[1]]);
+            const QVector3D c = toVector(mesh.vertices[triangle[2]]);
+            add(a, b, c);
+            add(a, c, b);
+        }
+    }
+
+    const std::vector<float> &floats() const { return m_floats; }
+    QVector3D min() const { return m_min; }
+    QVector3D max() const { return m_max; }
+
+private:
+    std::vector<float> m_floats;
+    static constexpr float Inf = std::numeric_limits<float>::infinity();
+    QVector3D m_min = QVector3D(Inf, Inf, Inf);
+    QVector3D m_max = QVector3D(-Inf, -Inf, -Inf);
+};
+
+} // namespace
+
+ObstacleGeometry::ObstacleGeometry(QQuick3DObject *parent) : QQuick3DGeometry(parent)
+{
+}
+
+Backend *ObstacleGeometry::backend() const
+{
+    return m_backend;
+}
+
+void ObstacleGeometry::setBackend(Backend *backend)
+{
+    if (backend == m_backend)
+        return;
+    disconnect(m_sceneConnection);
+    m_backend = backend;
+    if (m_backend)
+        m_sceneConnection = connect(m_backend, &Backend::sceneChanged, this, &ObstacleGeometry::rebuild);
+    emit backendChanged();
+    rebuild();
+}
+
+void ObstacleGeometry::rebuild()
+{
+    TriangleWriter writer;
+    if (m_backend) {
+        const ArmModel::ObstacleScene &scene = m_backend->obstacleScene();
+        for (int obstacle = 0; obstacle < scene.obstacleCount(); obstacle++) {
+            switch (scene.shape(obstacle)) {
+            case ArmModel::ObstacleScene::Box:
+                writer.addBox(scene.box(obstacle));
+                break;
+            case ArmModel::ObstacleScene::Cylinder:
+                writer.addCylinder(scene.cylinder(obstacle));
+                break;
+            case ArmModel::ObstacleScene::Mesh:
+                writer.addMesh(scene.mesh(obstacle));
+                break;
+            }
+        }
+    }
+
+    clear();
+    const std::vector<float> &floats = writer.floats();
+    if (!floats.empty()) {
+        setVertexData(QByteArray(reinterpret_cast<const char *>(floats.data()),
+                                 qsizetype(floats.size() * sizeof(float))));
+        setStride(FloatsPerVertex * sizeof(float));
+        setPrimitiveType(QQuick3DGeometry::PrimitiveType::Triangles);
+        addAttribute(QQuick3DGeometry::Attribute::PositionSemantic, 0, QQuick3DGeometry::Attribute::F32Type);
+        addAttribute(QQuick3DGeometry::Attribute::NormalSemantic, 3 * sizeof(float),
+                     QQuick3DGeometry::Attribute::F32Type);
+        setBounds(writer.min(), writer.max());
+    }
+    update();
+}
@@ -0,0 +1,35 @@
+#ifndef OBSTACLEGEOMETRY_H
+#define OBSTACLEGEOMETRY_H
+
+#include "backend.h"
+#include <QPointer>
+#include <QtQuick3D/qquick3dgeometry.h>
+#include <qqmlregistration.h>
+
+// Triangles of every obstacle in the Backend scene, so a single Model draws
+// the whole work cell in one draw call. Boxes and cylinders are tessellated
+// here, meshes are used as loaded, all with flat normals. Rebuilt when the
+// scene changes.
+class ObstacleGeometry : public QQuick3DGeometry
+{
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(Backend *backend READ backend WRITE setBackend NOTIFY backendChanged)
+
+public:
+    explicit ObstacleGeometry(QQuick3DObject *parent = nullptr);
+
+    Backend *backend() const;
+    void setBackend(Backend *backend);
+
+signals:
+    void backendChanged();
+
+private:
+    void rebuild();
+
+    QPointer<Backend> m_backend;
+    QMetaObject::Connection m_sceneConnection;
+};
+
+#endif // OBSTACLEGEOMETRY_H
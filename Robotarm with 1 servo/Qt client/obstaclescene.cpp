@@ -0,0 +1,409 @@
+#include "obstaclescene.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ArmModel {
+
+namespace {
+
+constexpr double Pi = 3.14159265358979323846;
+constexpr double DegToRad = Pi / 180.0;
+
+// Primitives per leaf of the hierarchy
+constexpr uint32_t LeafSize = 4;
+// Deep enough for any tree built from 32-bit primitive counts
+constexpr int StackSize = 64;
+
+Vec3 sub(const Vec3 &a, const Vec3 &b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+Vec3 add(const Vec3 &a, const Vec3 &b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+Vec3 scale(const Vec3 &a, double f) { return { a.x * f, a.y * f, a.z * f }; }
+double dot(const Vec3 &a, const Vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+Aabb emptyBounds()
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    return { { inf, inf, inf }, { -inf, -inf, -inf } };
+}
+
+void grow(Aabb &bounds, const Vec3 &p)
+{
+    bounds.min = { std::min(bounds.min.x, p.x), std::min(bounds.min.y, p.y), std::min(bounds.min.z, p.z) };
+    bounds.max = { std::max(bounds.max.x, p.x), std::max(bounds.max.y, p.y), std::max(bounds.max.z, p.z) };
+}
+
+void grow(Aabb &bounds, const Aabb &other)
+{
+    grow(bounds, other.min);
+    grow(bounds, other.max);
+}
+
+double axis(const Vec3 &v, int i) { return i == 0 ? v.x : i == 1 ? v.y : v.z; }
+
+double centroid(const Aabb &bounds, int i) { return axis(bounds.min, i) + axis(bounds.max, i); }
+
+// Squared distance from p to the box, zero inside
+double distanceSquared(const Aabb &bounds, const Vec3 &p)
+{
+    const double dx = std::max({ bounds.min.x - p.x, 0.0, p.x - bounds.max.x });
+    const double dy = std::max({ bounds.min.y - p.y, 0.0, p.y - bounds.max.y });
+    const double dz = std::max({ bounds.min.z - p.z, 0.0, p.z - bounds.max.z });
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Whether nothing in bounds can be closer to p than limit. Signed distances
+// go below zero only inside an obstacle, so with a limit of zero or less
+// only boxes that do not contain p can be skipped.
+bool beyond(const Aabb &bounds, const Vec3 &p, double limit)
+{
+    const double d2 = distanceSquared(bounds, p);
+    return d2 > 0.0 && (limit <= 0.0 || d2 >= limit * limit);
+}
+
+// Signed distance from the origin-centered box to p
+double boxDistance(const Vec3 &p, const Vec3 &halfExtents)
+{
+    const double qx = std::abs(p.x) - halfExtents.x;
+    const double qy = std::abs(p.y) - halfExtents.y;
+    const double qz = std::abs(p.z) - halfExtents.z;
+    const double ox = std::max(qx, 0.0), oy = std::max(qy, 0.0), oz = std::max(qz, 0.0);
+    return std::sqrt(ox * ox + oy * oy + oz * oz) + std::min(std::max({ qx, qy, qz }), 0.0);
+}
+
+// Box frame of a yawed box, matching the rotation of ObstacleGeometry
+Vec3 toBoxFrame(const BoxObstacle &box, const Vec3 &p)
+{
+    const double c = std::cos(box.yaw * DegToRad);
+    const double s = std::sin(box.yaw * DegToRad);
+    const Vec3 d = sub(p, box.center);
+    return { c * d.x - s * d.z, d.y, s * d.x + c * d.z };
+}
+
+double cylinderDistance(const CylinderObstacle &cylinder, const Vec3 &p)
+{
+    const Vec3 d = sub(p, cylinder.center);
+    const double radial = std::sqrt(d.x * d.x + d.z * d.z) - cylinder.radius;
+    const double axial = std::abs(d.y) - cylinder.halfHeight;
+    const double ro = std::max(radial, 0.0), ao = std::max(axial, 0.0);
+    return std::sqrt(ro * ro + ao * ao) + std::min(std::max(radial, axial), 0.0);
+}
+
+// Closest point on a triangle, Ericson, Real-Time Collision Detection 5.1.5
+Vec3 closestOnTriangle(const Vec3 &p, const Vec3 &a, const Vec3 &b, const Vec3 &c)
+{
+    const Vec3 ab = sub(b, a), ac = sub(c, a), ap = sub(p, a);
+    const double d1 = dot(ab, ap), d2 = dot(ac, ap);
+    if (d1 <= 0.0 && d2 <= 0.0)
+        return a;
+    const Vec3 bp = sub(p, b);
+    const double d3 = dot(ab, bp), d4 = dot(ac, bp);
+    if (d3 >= 0.0 && d4 <= d3)
+        return b;
+    const double vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+        return add(a, scale(ab, d1 / (d1 - d3)));
+    const Vec3 cp = sub(p, c);
+    const double d5 = dot(ab, cp), d6 = dot(ac, cp);
+    if (d6 >= 0.0 && d5 <= d6)
+        return c;
+    const double vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+        return add(a, scale(ac, d2 / (d2 - d6)));
+    const double va = d3 * d6 - d5 * d4;
+    if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+        return add(b, scale(sub(c, b), (d4 - d3) / ((d4 - d3) + (d5 - d6))));
+    const double denominator = 1.0 / (va + vb + vc);
+    return add(a, add(scale(ab, vb * denominator), scale(ac, vc * denominator)));
+}
+
+} // namespace
+
+int ObstacleScene::addBox(const BoxObstacle &box)
+{
+    const int obstacle = obstacleCount();
+    const uint32_t index = uint32_t(m_boxes.size());
+    m_boxes.push_back(box);
+    m_obstacles.push_back({ Box, index });
+
+    const double c = std::abs(std::cos(box.yaw * DegToRad));
+    const double s = std::abs(std::sin(box.yaw * DegToRad));
+    const Vec3 extent = { c * box.halfExtents.x + s * box.halfExtents.z, box.halfExtents.y,
+                          s * box.halfExtents.x + c * box.halfExtents.z };
+    addPrimitive(Box, index, obstacle, { sub(box.center, extent), add(box.center, extent) });
+    return obstacle;
+}
+
+int ObstacleScene::addCylinder(const CylinderObstacle &cylinder)
+{
+    const int obstacle = obstacleCount();
+    const uint32_t index = uint32_t(m_cylinders.size());
+    m_cylinders.push_back(cylinder);
+    m_obstacles.push_back({ Cylinder, index });
+
+    const Vec3 extent = { cylinder.radius, cylinder.halfHeight, cylinder.radius };
+    addPrimitive(Cylinder, index, obstacle, { sub(cylinder.center, extent), add(cylinder.center, extent) });
+    return obstacle;
+}
+
+int ObstacleScene::addMesh(const MeshObstacle &mesh)
+{
+    const int obstacle = obstacleCount();
+    m_obstacles.push_back({ Mesh, uint32_t(m_meshes.size()) });
+    m_meshes.push_back(mesh);
+
+    for (const std::array<uint32_t, 3> &triangle : mesh.triangles) {
+        const Triangle t = { mesh.vertices[triangle[0]], mesh.vertices[triangle[1]], mesh.vertices[triangle[2]] };
+        Aabb bounds = emptyBounds();
+        grow(bounds, t.a);
+        grow(bounds, t.b);
+        grow(bounds, t.c);
+        addPrimitive(Mesh, uint32_t(m_triangles.size()), obstacle, bounds);
+        m_triangles.push_back(t);
+    }
+    return obstacle;
+}
+
+void ObstacleScene::addPrimitive(Shape shape, uint32_t index, int obstacle, const Aabb &bounds)
+{
+    m_primitives.push_back({ shape, index, obstacle, bounds });
+    m_nodes.clear();
+}
+
+void ObstacleScene::clear()
+{
+    m_obstacles.clear();
+    m_boxes.clear();
+    m_cylinders.clear();
+    m_meshes.clear();
+    m_triangles.clear();
+    m_primitives.clear();
+    m_nodes.clear();
+}
+
+void ObstacleScene::build()
+{
+    m_nodes.clear();
+    if (m_primitives.empty())
+        return;
+    m_nodes.reserve(2 * (m_primitives.size() / LeafSize + 1));
+    m_nodes.push_back({});
+    buildNode(0, 0, uint32_t(m_primitives.size()));
+}
+
+void ObstacleScene::buildNode(uint32_t node, uint32_t first, uint32_t count)
+{
+    Aabb bounds = emptyBounds();
+    Aabb centroids = emptyBounds();
+    for (uint32_t i = first; i < first + count; i++) {
+        const Aabb &primitive = m_primitives[i].bounds;
+        grow(bounds, primitive);
+        grow(centroids, Vec3 { centroid(primitive, 0), centroid(primitive, 1), centroid(primitive, 2) });
+    }
+    m_nodes[node] = { bounds, first, count };
+    if (count <= LeafSize)
+        return;
+
+    // Median split along the longest axis of the centroids
+    const Vec3 size = sub(centroids.max, centroids.min);
+    const int split = size.x >= size.y && size.x >= size.z ? 0 : size.y >= size.z ? 1 : 2;
+    const uint32_t half = count / 2;
+    std::nth_element(m_primitives.begin() + first, m_primitives.begin() + first + half,
+                     m_primitives.begin() + first + count, [split](const Primitive &a, const Primitive &b) {
+                         return centroid(a.bounds, split) < centroid(b.bounds, split);
+                     });
+
+    const uint32_t children = uint32_t(m_nodes.size());
+    m_nodes.push_back({});
+    m_nodes.push_back({});
+    m_nodes[node] = { bounds, children, 0 };
+    buildNode(children, first, half);
+    buildNode(children + 1, first + half, count - half);
+}
+
+const BoxObstacle &ObstacleScene::box(int obstacle) const
+{
+    return m_boxes[m_obstacles[size_t(obstacle)].index];
+}
+
+const CylinderObstacle &ObstacleScene::cylinder(int obstacle) const
+{
+    return m_cylinders[m_obstacles[size_t(obstacle)].index];
+}
+
+const MeshObstacle &ObstacleScene::mesh(int obstacle) const
+{
+    return m_meshes[m_obstacles[size_t(obstacle)].index];
+}
+
+Aabb ObstacleScene::bounds() const
+{
+    Aabb bounds = emptyBounds();
+    for (const Primitive &primitive : m_primitives)
+        grow(bounds, primitive.bounds);
+    return bounds;
+}
+
+double ObstacleScene::primitiveDistance(const Primitive &primitive, const Vec3 &point) const
+{
+    switch (primitive.shape) {
+    case Box: {
+        const BoxObstacle &box = m_boxes[primitive.index];
+        return boxDistance(toBoxFrame(box, point), box.halfExtents);
+    }
+    case Cylinder:
+        return cylinderDistance(m_cylinders[primitive.index], point);
+    case Mesh: {
+        const Triangle &t = m_triangles[primitive.index];
+        const Vec3 d = sub(point, closestOnTriangle(point, t.a, t.b, t.c));
+        return std::sqrt(dot(d, d));
+    }
+    }
+    return std::numeric_limits<double>::infinity();
+}
+
+double ObstacleScene::distance(const Vec3 &point, double maxDistance, int *obstacle) const
+{
+    double best = maxDistance;
+    int nearest = NoObstacle;
+    if (!m_nodes.empty() && !beyond(m_nodes[0].bounds, point, best)) {
+        uint32_t stack[StackSize];
+        int depth = 0;
+        stack[depth++] = 0;
+        while (depth > 0) {
+            const Node &node = m_nodes[stack[--depth]];
+            // best may have shrunk since the node was pushed
+            if (beyond(node.bounds, point, best))
+                continue;
+
+            if (node.count > 0) {
+                for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                    const Primitive &primitive = m_primitives[i];
+                    if (beyond(primitive.bounds, point, best))
+                        continue;
+                    const double d = primitiveDistance(primitive, point);
+                    if (d < best) {
+                        best = d;
+                        nearest = primitive.obstacle;
+                    }
+                }
+                continue;
+            }
+
+            // The nearer child goes on top so that it is searched first
+            uint32_t nearer = node.first, farther = node.first + 1;
+            if (distanceSquared(m_nodes[farther].bounds, point) < distanceSquared(m_nodes[nearer].bounds, point))
+                std::swap(nearer, farther);
+            stack[depth++] = farther;
+            stack[depth++] = nearer;
+        }
+    }
+
+    if (obstacle)
+        *obstacle = nearest;
+    return best;
+}
+
+bool ObstacleScene::overlaps(const Sphere &sphere) const
+{
+    if (m_nodes.empty())
+        return false;
+    const double radiusSquared = sphere.radius * sphere.radius;
+    uint32_t stack[StackSize];
+    int depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0) {
+        const Node &node = m_nodes[stack[--depth]];
+        if (distanceSquared(node.bounds, sphere.center) > radiusSquared)
+            continue;
+        if (node.count == 0) {
+            stack[depth++] = node.first;
+            stack[depth++] = node.first + 1;
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; i++) {
+            const Primitive &primitive = m_primitives[i];
+            if (distanceSquared(primitive.bounds, sphere.center) <= radiusSquared
+                && primitiveDistance(primitive, sphere.center) <= sphere.radius)
+                return true;
+        }
+    }
+    return false;
+}
+
+Vec3 scenePoint(const Vec2 &planePoint, double rotation4)
+{
+    // RoboticArm.qml turns the arm around the vertical by rotation4, the
+    // plane x axis starts out along -z
+    const double c = std::cos(rotation4 * DegToRad);
+    const double s = std::sin(rotation4 * DegToRad);
+    return { -planePoint.x * s, planePoint.y, -planePoint.x * c };
+}
+
+void linkSpheres(const LinkBox &box, double rotation4, LinkSpheres &spheres)
+{
+    // Center line from the middle of the near edge to the middle of the far
+    // edge, see frameBox() in armmodel.cpp for the corner order
+    const Vec2 start = { 0.5 * (box.corners[0].x + box.corners[1].x), 0.5 * (box.corners[0].y + box.corners[1].y) };
+    const Vec2 end = { 0.5 * (box.corners[2].x + box.corners[3].x), 0.5 * (box.corners[2].y + box.corners[3].y) };
+    const double radius = 0.5 * std::hypot(box.corners[1].x - box.corners[0].x, box.corners[1].y - box.corners[0].y);
+    const double length = std::hypot(end.x - start.x, end.y - start.y);
+
+    // Spheres at most radius apart; growing them by half the spacing covers
+    // the capsule between the centers
+    const int count = std::max(2, int(std::ceil(length / radius)) + 1);
+    const double spacing = length / (count - 1);
+    const double sphereRadius = std::sqrt(radius * radius + 0.25 * spacing * spacing);
+    for (int i = 0; i < count; i++) {
+        const double f = double(i) / (count - 1);
+        const Vec2 p = { start.x + (end.x - start.x) * f, start.y + (end.y - start.y) * f };
+        spheres.push_back({ scenePoint(p, rotation4), sphereRadius });
+    }
+}
+
+SceneClearance sceneClearance(const ObstacleScene &scene, const JointVector &joints, double maxDistance)
+{
+    SceneClearance clearance;
+    clearance.distance = maxDistance;
+    if (scene.isEmpty())
+        return clearance;
+
+    const LinkBoxes boxes = linkBoxes(joints);
+    LinkSpheres spheres;
+    spheres.reserve(64);
+    for (const int link : { HandLink, ArmLink, ForearmLink }) {
+        spheres.clear();
+        linkSpheres(boxes[link], joints[Rotation4], spheres);
+        for (const Sphere &sphere : spheres) {
+            int obstacle = ObstacleScene::NoObstacle;
+            const double d = scene.distance(sphere.center, clearance.distance + sphere.radius, &obstacle)
+                    - sphere.radius;
+            if (obstacle != ObstacleScene::NoObstacle && d < clearance.distance) {
+                clearance.distance = d;
+                clearance.link = link;
+                clearance.obstacle = obstacle;
+            }
+        }
+    }
+    return clearance;
+}
+
+bool isSceneColliding(const ObstacleScene &scene, const JointVector &joints)
+{
+    if (scene.isEmpty())
+        return false;
+
+    const LinkBoxes boxes = linkBoxes(joints);
+    LinkSpheres spheres;
+    spheres.reserve(64);
+    for (const int link : { HandLink, ArmLink, ForearmLink }) {
+        spheres.clear();
+        linkSpheres(boxes[link], joints[Rotation4], spheres);
+        for (const Sphere &sphere : spheres) {
+            if (scene.overlaps(sphere))
+                return true;
+        }
+    }
+    return false;
+}
+
+} // namespace ArmModel
@@ -0,0 +1,166 @@
+#ifndef OBSTACLESCENE_H
+#define OBSTACLESCENE_H
+
+#include "armmodel.h"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Fixtures around the arm and the distance between them and the arm.
+//
+// Scene coordinates are those of the View3D in MainScreen.qml, in the units
+// of the arm model: y is up, the arm base stands at the origin and the arm
+// plane is turned around y by rotation4, its x axis pointing along -z at
+// rotation4 = 0. build() puts every box, cylinder and mesh triangle into a
+// bounding volume hierarchy, so a query only visits the obstacles near it.
+// It has no Qt dependency so that command line tools can reuse it.
+namespace ArmModel {
+
+struct Vec3
+{
+    double x;
+    double y;
+    double z;
+};
+
+struct Aabb
+{
+    Vec3 min;
+    Vec3 max;
+};
+
+// yaw turns the box around its vertical axis, in degrees
+struct BoxObstacle
+{
+    Vec3 center;
+    Vec3 halfExtents;
+    double yaw = 0.0;
+};
+
+// Upright cylinder, center is halfway up the axis
+struct CylinderObstacle
+{
+    Vec3 center;
+    double radius;
+    double halfHeight;
+};
+
+// Triangles in scene coordinates. Meshes are treated as surfaces: a sphere
+// entirely inside a closed mesh does not touch it.
+struct MeshObstacle
+{
+    std::vector<Vec3> vertices;
+    std::vector<std::array<uint32_t, 3>> triangles;
+};
+
+struct Sphere
+{
+    Vec3 center;
+    double radius;
+};
+
+class ObstacleScene
+{
+public:
+    enum Shape { Box, Cylinder, Mesh };
+    static constexpr int NoObstacle = -1;
+
+    // Each returns the index of the new obstacle. Queries need build() first.
+    int addBox(const BoxObstacle &box);
+    int addCylinder(const CylinderObstacle &cylinder);
+    int addMesh(const MeshObstacle &mesh);
+    void clear();
+    void build();
+
+    bool isEmpty() const { return m_obstacles.empty(); }
+    int obstacleCount() const { return int(m_obstacles.size()); }
+    Shape shape(int obstacle) const { return m_obstacles[size_t(obstacle)].shape; }
+    const BoxObstacle &box(int obstacle) const;
+    const CylinderObstacle &cylinder(int obstacle) const;
+    const MeshObstacle &mesh(int obstacle) const;
+    Aabb bounds() const;
+
+    // Distance from point to the nearest obstacle surface, negative inside
+    // a box or cylinder. Obstacles farther than maxDistance are skipped and
+    // maxDistance is returned when there is none closer. obstacle receives
+    // the index of the nearest one, or NoObstacle.
+    double distance(const Vec3 &point, double maxDistance = std::numeric_limits<double>::infinity(),
+                    int *obstacle = nullptr) const;
+
+    // True when the sphere touches an obstacle. Cheaper than distance(),
+    // since only the boxes around the sphere are visited.
+    bool overlaps(const Sphere &sphere) const;
+
+private:
+    struct Obstacle
+    {
+        Shape shape;
+        uint32_t index; // into m_boxes, m_cylinders or m_meshes
+    };
+
+    // What the hierarchy stores: a box, a cylinder or one mesh triangle
+    struct Primitive
+    {
+        Shape shape;
+        uint32_t index; // into m_boxes, m_cylinders or m_triangles
+        int obstacle;
+        Aabb bounds;
+    };
+
+    struct Triangle
+    {
+        Vec3 a;
+        Vec3 b;
+        Vec3 c;
+    };
+
+    // Leaves hold primitives [first, first + count), inner nodes have
+    // count 0 and their children at first and first + 1
+    struct Node
+    {
+        Aabb bounds;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    void addPrimitive(Shape shape, uint32_t index, int obstacle, const Aabb &bounds);
+    void buildNode(uint32_t node, uint32_t first, uint32_t count);
+    double primitiveDistance(const Primitive &primitive, const Vec3 &point) const;
+
+    std::vector<Obstacle> m_obstacles;
+    std::vector<BoxObstacle> m_boxes;
+    std::vector<CylinderObstacle> m_cylinders;
+    std::vector<MeshObstacle> m_meshes;
+    std::vector<Triangle> m_triangles;
+    std::vector<Primitive> m_primitives;
+    std::vector<Node> m_nodes;
+};
+
+// Scene position of a point of the arm plane at a rotation4 angle
+Vec3 scenePoint(const Vec2 &planePoint, double rotation4);
+
+// Spheres covering a moving link (forearm, arm or hand). The link is taken
+// to be as deep as it is wide, a capsule around its center line, and the
+// spheres are sized so that their union contains that capsule. The base does
+// not move, so an obstacle that overlaps it is a scene error and not checked.
+using LinkSpheres = std::vector<Sphere>;
+void linkSpheres(const LinkBox &box, double rotation4, LinkSpheres &spheres);
+
+struct SceneClearance
+{
+    double distance = std::numeric_limits<double>::infinity(); // zero or less is a collision
+    int link = -1;
+    int obstacle = ObstacleScene::NoObstacle;
+};
+
+// Smallest distance between the moving links and the scene, and where it is.
+// Distances beyond maxDistance are not resolved.
+SceneClearance sceneClearance(const ObstacleScene &scene, const JointVector &joints,
+                              double maxDistance = std::numeric_limits<double>::infinity());
+bool isSceneColliding(const ObstacleScene &scene, const JointVector &joints);
+
+} // namespace ArmModel
+
+#endif // OBSTACLESCENE_H
@@ -0,0 +1,225 @@
+#include "poselibrary.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+
+bool readJoints(const QJsonValue &value, ArmModel::JointVector &joints)
+{
+    const QJsonArray array = value.toArray();
+    if (array.size() != ArmModel::JointCount)
+        return false;
+    for (int joint = 0; joint < ArmModel::JointCount; joint++) {
+        if (!array[joint].isDouble())
+            return false;
+        joints[joint] = array[joint].toDouble();
+    }
+    return true;
+}
+
+quint64 libraryFingerprint(const QList<PoseLibrary::Pose> &poses, const ArmModel::MotionLimits &limits,
+                           const ArmModel::ObstacleScene *scene)
+{
+    // Continues the FNV-1a hash of the planner inputs with the poses
+    quint64 h = ArmModel::planFingerprint(limits, scene);
+    auto add = [&h](const void *data, size_t size) {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++) {
+            h ^= bytes[i];
+            h *= 1099511628211ull;
+        }
+    };
+    for (const PoseLibrary::Pose &pose : poses) {
+        const QByteArray name = pose.name.toUtf8();
+        add(name.constData(), size_t(name.size()) + 1);
+        add(pose.joints.data(), sizeof(pose.joints));
+    }
+    return h;
+}
+
+} // namespace
+
+bool PoseLibrary::load(const QString &path, QString *error)
+{
+    clear();
+    auto fail = [error](const QString &message) {
+        if (error)
+            *error = message;
+        return false;
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return fail(file.errorString());
+    QJsonParseError parseError;
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll(), &parseError).object();
+    if (parseError.error != QJsonParseError::NoError)
+        return fail(parseError.errorString());
+
+    QList<Pose> poses;
+    for (const QJsonValue &value : root["poses"].toArray()) {
+        const QJsonObject entry = value.toObject();
+        Pose pose { entry["name"].toString(), {} };
+        if (pose.name.isEmpty() || !readJoints(entry["joints"], pose.joints))
+            return fail(QStringLiteral("Invalid pose %1").arg(poses.size()));
+        poses.append(pose);
+    }
+    if (poses.isEmpty())
+        return fail(QStringLiteral("No poses"));
+
+    ArmModel::MotionLimits limits;
+    const QJsonObject limitsObject = root["limits"].toObject();
+    if ((limitsObject.contains("velocity") && !readJoints(limitsObject["velocity"], limits.maxVelocity))
+        || (limitsObject.contains("acceleration") && !readJoints(limitsObject["acceleration"], limits.maxAcceleration)))
+        return fail(QStringLiteral("Invalid limits"));
+
+    m_path = path;
+    m_poses = poses;
+    m_limits = limits;
+    prepare();
+    return true;
+}
+
+void PoseLibrary::clear()
+{
+    m_path.clear();
+    m_poses.clear();
+    m_trajectories.clear();
+    m_limits = ArmModel::MotionLimits();
+    m_fingerprint = 0;
+}
+
+void PoseLibrary::setScene(const ArmModel::ObstacleScene *scene)
+{
+    m_scene = scene;
+    if (!m_poses.isEmpty())
+        prepare();
+}
+
+int PoseLibrary::indexOf(const QString &name) const
+{
+    for (int i = 0; i < m_poses.size(); i++) {
+        if (m_poses[i].name == name)
+            return i;
+    }
+    return -1;
+}
+
+int PoseLibrary::poseAt(const ArmModel::JointVector &joints, double toleranceDeg) const
+{
+    for (int i = 0; i < m_poses.size(); i++) {
+        bool matches = true;
+        for (int joint = 0; joint < ArmModel::JointCount && matches; joint++)
+            matches = qAbs(m_poses[i].joints[joint] - joints[joint]) <= toleranceDeg;
+        if (matches)
+            return i;
+    }
+    return -1;
+}
+
+const ArmModel::Trajectory *PoseLibrary::trajectory(int from, int to) const
+{
+    if (from < 0 || to < 0 || from >= m_poses.size() || to >= m_poses.size())
+        return nullptr;
+    const ArmModel::Trajectory &trajectory = m_trajectories[size_t(from) * size_t(m_poses.size()) + size_t(to)];
+    return trajectory.empty() ? nullptr : &trajectory;
+}
+
+QString PoseLibrary::cachePath(const QString &libraryPath, quint64 fingerprint)
+{
+    const QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    return QDir(directory).filePath(QString("%1.%2.trajectories.json")
+                                            .arg(QFileInfo(libraryPath).completeBaseName())
+                                            .arg(fingerprint, 16, 16, QChar('0')));
+}
+
+void PoseLibrary::prepare()
+{
+    m_fingerprint = libraryFingerprint(m_poses, m_limits, m_scene);
+    const QString cache = cachePath(m_path, m_fingerprint);
+    if (!readCache(cache)) {
+        plan();
+        // A cache that cannot be written only costs the planning time
+        writeCache(cache);
+    }
+}
+
+void PoseLibrary::plan()
+{
+    const size_t count = size_t(m_poses.size());
+    m_trajectories.assign(count * count, {});
+    for (size_t from = 0; from < count; from++) {
+        for (size_t to = 0; to < count; to++) {
+            if (from != to)
+                m_trajectories[from * count + to] =
+                        ArmModel::planTrajectory(m_poses[from].joints, m_poses[to].joints, m_limits, m_scene);
+        }
+    }
+}
+
+bool PoseLibrary::readCache(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root["fingerprint"].toString() != QString::number(m_fingerprint, 16))
+        return false;
+
+    const size_t count = size_t(m_poses.size());
+    const QJsonArray entries = root["trajectories"].toArray();
+    if (size_t(entries.size()) != count * count)
+        return false;
+
+    std::vector<ArmModel::Trajectory> trajectories(count * count);
+    for (size_t i = 0; i < trajectories.size(); i++) {
+        const QJsonArray points = entries[qsizetype(i)].toArray();
+        ArmModel::Trajectory &trajectory = trajectories[i];
+        trajectory.reserve(size_t(points.size()));
+        for (const QJsonValue &value : points) {
+            // [t_ms, r1, r2, r3, r4]
+            const QJsonArray point = value.toArray();
+            if (point.size() != 1 + ArmModel::JointCount)
+                return false;
+            ArmModel::TrajectoryPoint entry { point[0].toDouble(), {} };
+            for (int joint = 0; joint < ArmModel::JointCount; joint++)
+                entry.joints[joint] = point[1 + joint].toDouble();
+            // The fingerprint vouches for the collision checks, playback
+            // only needs the times in order
+            if (!trajectory.empty() && entry.timeMs < trajectory.back().timeMs)
+                return false;
+            trajectory.push_back(entry);
+        }
+    }
+    m_trajectories = std::move(trajectories);
+    return true;
+}
+
+bool PoseLibrary::writeCache(const QString &path) const
+{
+    QJsonArray entries;
+    for (const ArmModel::Trajectory &trajectory : m_trajectories) {
+        QJsonArray points;
+        for (const ArmModel::TrajectoryPoint &point : trajectory)
+            points.append(QJsonArray { point.timeMs, point.joints[0], point.joints[1], point.joints[2],
+                                       point.joints[3] });
+        entries.append(points);
+    }
+    QJsonObject root;
+    root["fingerprint"] = QString::number(m_fingerprint, 16);
+    root["trajectories"] = entries;
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
@@ -0,0 +1,66 @@
+#ifndef POSELIBRARY_H
+#define POSELIBRARY_H
+
+#include "armtrajectory.h"
+#include <QList>
+#include <QString>
+#include <vector>
+
+// Named poses with a precomputed trajectory between every pair of them.
+//
+// The library file is JSON:
+//   { "poses": [ { "name": "Pose 1", "joints": [30, 60, 90, 145] }, ... ],
+//     "limits": { "velocity": [...], "acceleration": [...] } }   // optional
+// Planning all pairs happens once; the trajectories are cached in the user's
+// cache directory in a file named after a fingerprint of the poses, the
+// motion limits, the arm model and the scene (see ArmModel::planFingerprint),
+// so editing any of them replans on the next load while unchanged libraries
+// load from the cache, and each scene keeps its own cache. With a scene set, the trajectories keep clear of its obstacles.
+// A cache with a matching fingerprint is trusted as it is, re-checking its
+// trajectories would cost as much as planning them.
+class PoseLibrary
+{
+public:
+    struct Pose
+    {
+        QString name;
+        ArmModel::JointVector joints;
+    };
+
+    bool load(const QString &path, QString *error = nullptr);
+    void clear();
+
+    // Obstacles to plan around, not owned, nullptr for none. Call again
+    // whenever the scene changed: a loaded library is replanned for it,
+    // or read from the cache when it was planned for that scene before.
+    void setScene(const ArmModel::ObstacleScene *scene);
+
+    bool isEmpty() const { return m_poses.isEmpty(); }
+    const QList<Pose> &poses() const { return m_poses; }
+    const ArmModel::MotionLimits &motionLimits() const { return m_limits; }
+
+    int indexOf(const QString &name) const;
+    // Library pose within toleranceDeg of joints on every joint, or -1
+    int poseAt(const ArmModel::JointVector &joints, double toleranceDeg = 0.5) const;
+    // nullptr when there is no collision-free trajectory between the two
+    const ArmModel::Trajectory *trajectory(int from, int to) const;
+
+    // Cache file of a library, named after the library file and the
+    // fingerprint of its trajectories
+    static QString cachePath(const QString &libraryPath, quint64 fingerprint);
+
+private:
+    bool readCache(const QString &path);
+    bool writeCache(const QString &path) const;
+    void prepare();
+    void plan();
+
+    QString m_path;
+    const ArmModel::ObstacleScene *m_scene = nullptr;
+    QList<Pose> m_poses;
+    ArmModel::MotionLimits m_limits;
+    std::vector<ArmModel::Trajectory> m_trajectories; // from * poses + to
+    quint64 m_fingerprint = 0;
+};
+
+#endif // POSELIBRARY_H
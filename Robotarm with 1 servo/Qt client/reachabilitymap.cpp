@@ -0,0 +1,56 @@
+#include "reachabilitymap.h"
+
+#include <cmath>
+#include <cstring>
+
+bool ReachabilityMap::attach(const void *data, size_t size)
+{
+    detach();
+    if (!data || size < sizeof(ReachabilityMapHeader))
+        return false;
+
+    const auto *header = static_cast<const ReachabilityMapHeader *>(data);
+    if (std::memcmp(header->magic, "ARMREACH", sizeof(header->magic)) != 0
+        || header->version != Version || !(header->voxelSize > 0.0f)
+        || size < fileSize(header->size))
+        return false;
+
+    m_header = header;
+    m_cells = reinterpret_cast<const ReachabilityMapCell *>(header + 1);
+    return true;
+}
+
+void ReachabilityMap::detach()
+{
+    m_header = nullptr;
+    m_cells = nullptr;
+}
+
+const ReachabilityMapCell *ReachabilityMap::cellAt(double x, double y, double z) const
+{
+    if (!m_header)
+        return nullptr;
+
+    const double position[3] = { x, y, z };
+    uint32_t index[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        const double voxel = std::floor((position[axis] - m_header->origin[axis]) / m_header->voxelSize);
+        if (!(voxel >= 0.0 && voxel < m_header->size[axis]))
+            return nullptr;
+        index[axis] = uint32_t(voxel);
+    }
+    const size_t offset = (size_t(index[1]) * m_header->size[2] + index[2]) * m_header->size[0] + index[0];
+    return m_cells + offset;
+}
+
+bool ReachabilityMap::isReachable(double x, double y, double z) const
+{
+    const ReachabilityMapCell *cell = cellAt(x, y, z);
+    return cell && cell->reach > 0;
+}
+
+size_t ReachabilityMap::fileSize(const uint32_t size[3])
+{
+    return sizeof(ReachabilityMapHeader)
+            + size_t(size[0]) * size[1] * size[2] * sizeof(ReachabilityMapCell);
+}
@@ -0,0 +1,55 @@
+#ifndef REACHABILITYMAP_H
+#define REACHABILITYMAP_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Voxel map of the positions the wrist (hand hinge) can reach without the
+// arm colliding with itself at some hand angle. Written by the reachmapgen
+// tool and meant to be memory-mapped: a fixed header followed by one Cell per
+// voxel, x fastest, then z, then y.
+//
+// World axes: x/z span the horizontal plane (the arm plane of the collision
+// model rotated by rotation4 around the vertical), y is the height.
+struct ReachabilityMapHeader
+{
+    char magic[8];      // "ARMREACH"
+    uint32_t version;
+    uint32_t size[3];   // voxels along x, y, z
+    float origin[3];    // world position of the corner of voxel (0, 0, 0)
+    float voxelSize;
+    uint64_t samples;   // joint samples used to build the map
+};
+static_assert(sizeof(ReachabilityMapHeader) == 48, "file layout");
+
+struct ReachabilityMapCell
+{
+    uint8_t reach;          // number of samples in this voxel, saturated at 255
+    uint8_t manipulability; // best wristManipulability in this voxel, scaled to 0..255
+};
+
+class ReachabilityMap
+{
+public:
+    static constexpr uint32_t Version = 1;
+
+    // Attaches to a file image without copying. The buffer must outlive the
+    // map. Returns false if the data is not a valid map.
+    bool attach(const void *data, size_t size);
+    void detach();
+    bool isValid() const { return m_header != nullptr; }
+
+    const ReachabilityMapHeader &header() const { return *m_header; }
+
+    // O(1) lookups, points outside the grid are unreachable
+    const ReachabilityMapCell *cellAt(double x, double y, double z) const;
+    bool isReachable(double x, double y, double z) const;
+
+    static size_t fileSize(const uint32_t size[3]);
+
+private:
+    const ReachabilityMapHeader *m_header = nullptr;
+    const ReachabilityMapCell *m_cells = nullptr;
+};
+
+#endif // REACHABILITYMAP_H
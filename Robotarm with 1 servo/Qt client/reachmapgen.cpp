@@ -0,0 +1,191 @@
+// Generates the wrist reachability map used by Backend::isReachable.
+//
+// usage: reachmapgen [--step degrees] [--voxel size] [--threads n] output.reach
+//
+// Samples rotation2/rotation3/rotation4 on a regular grid, keeps the samples
+// that pass the full self-collision check for some hand angle (rotation1
+// over its whole range, straight first) and bins the wrist position into a
+// voxel grid with a hit count and the best manipulability per voxel. The
+// hand does not move the wrist, so the map is a conservative pre-filter for
+// solveWrist(), which keeps the current hand angle.
+
+#include "armmodel.h"
+#include "reachabilitymap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+    double step = 1.0;
+    double voxelSize = 15.0;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string output;
+};
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--step" && hasValue)
+            options.step = std::atof(argv[++i]);
+        else if (arg == "--voxel" && hasValue)
+            options.voxelSize = std::atof(argv[++i]);
+        else if (arg == "--threads" && hasValue)
+            options.threads = unsigned(std::max(1, std::atoi(argv[++i])));
+        else if (!arg.empty() && arg[0] != '-' && options.output.empty())
+            options.output = arg;
+        else
+            return false;
+    }
+    return !options.output.empty() && options.step > 0.0 && options.voxelSize > 0.0;
+}
+
+std::vector<double> samples(const ArmModel::JointLimits &limits, double step)
+{
+    std::vector<double> values;
+    for (double value = limits.min; value <= limits.max + 1e-9; value += step)
+        values.push_back(value);
+    return values;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s [--step degrees] [--voxel size] [--threads n] output.reach\n", argv[0]);
+        return 1;
+    }
+
+    using namespace ArmModel;
+    const std::vector<double> rotation1 = samples(jointLimits(Rotation1), options.step);
+    const std::vector<double> rotation2 = samples(jointLimits(Rotation2), options.step);
+    const std::vector<double> rotation3 = samples(jointLimits(Rotation3), options.step);
+    const std::vector<double> rotation4 = samples(jointLimits(Rotation4), options.step);
+
+    // The wrist can't get further from the origin than shoulder + both links
+    const Vec2 shoulder = shoulderPosition();
+    const double reach = std::hypot(shoulder.x, shoulder.y) + forearmLength() + armLength();
+
+    ReachabilityMapHeader header = {};
+    std::memcpy(header.magic, "ARMREACH", sizeof(header.magic));
+    header.version = ReachabilityMap::Version;
+    header.voxelSize = float(options.voxelSize);
+    for (int axis = 0; axis < 3; ++axis) {
+        header.size[axis] = uint32_t(std::ceil(2.0 * reach / options.voxelSize));
+        header.origin[axis] = float(-reach);
+    }
+    const size_t cellCount = size_t(header.size[0]) * header.size[1] * header.size[2];
+    const double maxManipulability = forearmLength() * armLength();
+
+    // Rotating the base only moves the wrist around the vertical axis, so the
+    // planar pose is computed once per (rotation2, rotation3) and swept
+    // through a yaw table.
+    std::vector<double> yawCos, yawSin;
+    for (const double yaw : rotation4) {
+        yawCos.push_back(std::cos(yaw * 3.14159265358979323846 / 180.0));
+        yawSin.push_back(std::sin(yaw * 3.14159265358979323846 / 180.0));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<ReachabilityMapCell>> partial(options.threads);
+    std::atomic<size_t> nextRow(0);
+    std::atomic<uint64_t> accepted(0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < options.threads; ++t) {
+        workers.emplace_back([&, t]() {
+            std::vector<ReachabilityMapCell> &cells = partial[t];
+            cells.assign(cellCount, ReachabilityMapCell { 0, 0 });
+            uint64_t count = 0;
+            std::vector<double> r1(rotation2.size(), 0.0);
+            std::vector<double> r3(rotation2.size());
+            std::vector<unsigned char> colliding(rotation2.size());
+            std::vector<unsigned char> turned(rotation2.size());
+            for (size_t row = nextRow++; row < rotation3.size(); row = nextRow++) {
+                std::fill(r1.begin(), r1.end(), 0.0);
+                std::fill(r3.begin(), r3.end(), rotation3[row]);
+                isSelfCollidingBatch(r1.data(), rotation2.data(), r3.data(), rotation2.size(), colliding.data());
+                // Poses that hit with the hand straight may clear with it turned
+                for (size_t hand = 0; hand < rotation1.size(); ++hand) {
+                    if (std::find(colliding.begin(), colliding.end(), 1) == colliding.end())
+                        break;
+                    std::fill(r1.begin(), r1.end(), rotation1[hand]);
+                    isSelfCollidingBatch(r1.data(), rotation2.data(), r3.data(), rotation2.size(), turned.data());
+                    for (size_t column = 0; column < rotation2.size(); ++column)
+                        colliding[column] &= turned[column];
+                }
+                for (size_t column = 0; column < rotation2.size(); ++column) {
+                    if (colliding[column])
+                        continue;
+                    const JointVector joints = { 0.0, rotation2[column], rotation3[row], 0.0 };
+
+                    const Vec2 wrist = wristPosition(joints);
+                    const auto manipulability = uint8_t(
+                            std::lround(255.0 * wristManipulability(joints) / maxManipulability));
+                    const auto iy = uint32_t((wrist.y - header.origin[1]) / header.voxelSize);
+                    if (iy >= header.size[1])
+                        continue;
+
+                    for (size_t k = 0; k < yawCos.size(); ++k) {
+                        const auto ix = uint32_t((wrist.x * yawCos[k] - header.origin[0]) / header.voxelSize);
+                        const auto iz = uint32_t((wrist.x * yawSin[k] - header.origin[2]) / header.voxelSize);
+                        if (ix >= header.size[0] || iz >= header.size[2])
+                            continue;
+                        ReachabilityMapCell &cell = cells[(size_t(iy) * header.size[2] + iz) * header.size[0] + ix];
+                        if (cell.reach < 255)
+                            ++cell.reach;
+                        cell.manipulability = std::max(cell.manipulability, manipulability);
+                        ++count;
+                    }
+                }
+            }
+            accepted += count;
+        });
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+
+    // Merge the per-thread grids
+    std::vector<ReachabilityMapCell> cells = std::move(partial[0]);
+    for (unsigned t = 1; t < options.threads; ++t) {
+        for (size_t i = 0; i < cellCount; ++i) {
+            cells[i].reach = uint8_t(std::min(255, cells[i].reach + partial[t][i].reach));
+            cells[i].manipulability = std::max(cells[i].manipulability, partial[t][i].manipulability);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const uint64_t total = uint64_t(rotation2.size()) * rotation3.size() * rotation4.size();
+    header.samples = total;
+    std::ofstream file(options.output, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(cells.data()), std::streamsize(cells.size() * sizeof(ReachabilityMapCell)));
+    if (!file) {
+        std::fprintf(stderr, "Could not write %s\n", options.output.c_str());
+        return 1;
+    }
+
+    const size_t reachable = size_t(std::count_if(cells.begin(), cells.end(),
+                                                  [](const ReachabilityMapCell &cell) { return cell.reach > 0; }));
+    std::printf("Samples: %llu (%llu collision free) in %.3f s, %.1f M samples/s on %u threads\n",
+                static_cast<unsigned long long>(total), static_cast<unsigned long long>(accepted.load()),
+                seconds, total / seconds / 1e6, options.threads);
+    std::printf("Grid: %ux%ux%u voxels of %.1f, %zu reachable\n",
+                header.size[0], header.size[1], header.size[2], options.voxelSize, reachable);
+    std::printf("Wrote %s (%zu bytes)\n", options.output.c_str(), ReachabilityMap::fileSize(header.size));
+    return 0;
+}
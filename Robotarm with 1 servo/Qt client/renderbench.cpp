@@ -0,0 +1,258 @@
+// Offscreen render benchmark of the robot arm scene
+//
+// Loads MainScreen.qml (and with it RoboticArm.qml) into a QQuickWindow
+// driven by QQuickRenderControl, renders into an OpenGL texture on an
+// offscreen surface, and cycles the Backend through the four preset poses of
+// the UI. Frames are paced at 60 Hz so the joint animation runs as on
+// screen, and the work of each frame is timed per phase:
+//   polish   animation tick, bindings, layout
+//   sync     scene graph / Quick 3D synchronization
+//   render   rendering until the GPU (or llvmpipe) is done
+// Alongside, it counts Backend property notifications, each of which
+// re-evaluates the bindings reading that property, and detectCollision()
+// calls per frame.
+//
+// Without --gpu, Mesa's software rasterizer is forced, so it runs on a
+// GPU-less Linux box with the offscreen platform plugin.
+//
+// Usage: renderbench [--gpu] [--cycles N] [--size WxH] [--import dir] [MainScreen.qml]
+
+#include "backend.h"
+
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QMetaMethod>
+#include <QMetaProperty>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QQuickGraphicsDevice>
+#include <QQuickItem>
+#include <QQuickRenderControl>
+#include <QQuickRenderTarget>
+#include <QQuickWindow>
+#include <QThread>
+#include <QtQml/qqmlextensionplugin.h>
+#include <QtQuick3D/qquick3d.h>
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <vector>
+
+Q_IMPORT_QML_PLUGIN(BackendPlugin)
+
+namespace {
+
+constexpr double FrameIntervalMs = 1000.0 / 60.0;
+constexpr int FramesPerPreset = 90;
+
+// Presets of MainScreen.qml: rotation1..4
+const int Presets[][4] = {
+    { 30, 60, 90, 145 },
+    { 60, 45, 45, 60 },
+    { -90, -60, -45, -180 },
+    { 0, 0, 0, 0 },
+};
+
+// Counts every notify signal of an object's properties
+class NotificationCounter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NotificationCounter(QObject *target)
+    {
+        const QMetaObject *meta = target->metaObject();
+        const QMetaMethod slot = metaObject()->method(metaObject()->indexOfSlot("count()"));
+        for (int i = meta->propertyOffset(); i < meta->propertyCount(); i++) {
+            const QMetaProperty property = meta->property(i);
+            if (property.hasNotifySignal())
+                connect(target, property.notifySignal(), this, slot);
+        }
+    }
+
+    quint64 total = 0;
+
+public slots:
+    void count() { total++; }
+};
+
+struct Series
+{
+    std::vector<double> values;
+
+    void add(double value) { values.push_back(value); }
+
+    void print(const char *name, const char *unit) const
+    {
+        if (values.empty())
+            return;
+        std::vector<double> sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (const double value : sorted)
+            sum += value;
+        printf("%-24s mean %8.3f  p50 %8.3f  p95 %8.3f  max %8.3f %s\n", name, sum / double(sorted.size()),
+               sorted[sorted.size() / 2], sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)],
+               sorted.back(), unit);
+    }
+};
+
+double elapsedMs(const QElapsedTimer &timer)
+{
+    return timer.nsecsElapsed() / 1e6;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    bool useGpu = false;
+    for (int i = 1; i < argc; i++)
+        useGpu |= qstrcmp(argv[i], "--gpu") == 0;
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    if (!useGpu)
+        qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+
+    QQuickWindow::setGraphicsApi(QSGRendererInterface::OpenGL);
+    QSurfaceFormat::setDefaultFormat(QQuick3D::idealSurfaceFormat());
+    QGuiApplication app(argc, argv);
+
+    int cycles = 3;
+    QSize size(1280, 720);
+    QString qmlFile = QStringLiteral(RENDERBENCH_QML);
+    QStringList importPaths;
+    const QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); i++) {
+        const QString &arg = args[i];
+        if (arg == "--gpu")
+            continue;
+        if (arg == "--cycles" && i + 1 < args.size()) {
+            cycles = qMax(1, args[++i].toInt());
+        } else if (arg == "--size" && i + 1 < args.size()) {
+            const QStringList wh = args[++i].split('x');
+            if (wh.size() == 2)
+                size = QSize(wh[0].toInt(), wh[1].toInt());
+        } else if (arg == "--import" && i + 1 < args.size()) {
+            importPaths.append(args[++i]);
+        } else if (!arg.startsWith("--")) {
+            qmlFile = arg;
+        } else {
+            fprintf(stderr, "usage: renderbench [--gpu] [--cycles N] [--size WxH] [--import dir] [MainScreen.qml]\n");
+            return 1;
+        }
+    }
+
+    // --- OpenGL context on an offscreen surface ---
+    QOpenGLContext context;
+    context.setFormat(QSurfaceFormat::defaultFormat());
+    if (!context.create()) {
+        fprintf(stderr, "Cannot create an OpenGL context\n");
+        return 1;
+    }
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+    if (!context.makeCurrent(&surface)) {
+        fprintf(stderr, "Cannot make the OpenGL context current\n");
+        return 1;
+    }
+    printf("renderer: %s\n", reinterpret_cast<const char *>(context.functions()->glGetString(GL_RENDERER)));
+
+    QQuickRenderControl renderControl;
+    QQuickWindow window(&renderControl);
+    window.setGraphicsDevice(QQuickGraphicsDevice::fromOpenGLContext(&context));
+    window.resize(size);
+    if (!renderControl.initialize()) {
+        fprintf(stderr, "QQuickRenderControl::initialize() failed\n");
+        return 1;
+    }
+
+    QOpenGLFramebufferObject target(size, QOpenGLFramebufferObject::CombinedDepthStencil);
+    window.setRenderTarget(QQuickRenderTarget::fromOpenGLTexture(target.texture(), size));
+
+    // --- Scene ---
+    QQmlEngine engine;
+    for (const QString &path : importPaths)
+        engine.addImportPath(path);
+    QQmlComponent component(&engine, QUrl::fromLocalFile(qmlFile));
+    QObject *root = component.create();
+    auto *rootItem = qobject_cast<QQuickItem *>(root);
+    if (!rootItem) {
+        fprintf(stderr, "Cannot load %s: %s\n", qPrintable(qmlFile), qPrintable(component.errorString()));
+        return 1;
+    }
+    rootItem->setParentItem(window.contentItem());
+    rootItem->setSize(size);
+
+    Backend *backend = root->findChild<Backend *>();
+    if (!backend) {
+        fprintf(stderr, "No Backend in %s\n", qPrintable(qmlFile));
+        return 1;
+    }
+    NotificationCounter notifications(backend);
+
+    // --- Frames ---
+    Series polishTimes, syncTimes, renderTimes, frameTimes, notificationCounts, collisionCounts;
+    QElapsedTimer pacing;
+    pacing.start();
+    const int presetCount = int(std::size(Presets));
+    const int frameCount = cycles * presetCount * FramesPerPreset;
+
+    for (int frame = 0; frame < frameCount; frame++) {
+        if (frame % FramesPerPreset == 0) {
+            const int *preset = Presets[(frame / FramesPerPreset) % presetCount];
+            backend->setRot1Angle(preset[0]);
+            backend->setRot2Angle(preset[1]);
+            backend->setRot3Angle(preset[2]);
+            backend->setRot4Angle(preset[3]);
+        }
+
+        const quint64 notificationsBefore = notifications.total;
+        const quint64 collisionsBefore = backend->collisionCheckCount();
+
+        QElapsedTimer timer;
+        timer.start();
+        QCoreApplication::processEvents();
+        renderControl.polishItems();
+        const double polished = elapsedMs(timer);
+
+        renderControl.beginFrame();
+        renderControl.sync();
+        const double synced = elapsedMs(timer);
+        renderControl.render();
+        renderControl.endFrame();
+        context.functions()->glFinish();
+        const double rendered = elapsedMs(timer);
+
+        polishTimes.add(polished);
+        syncTimes.add(synced - polished);
+        renderTimes.add(rendered - synced);
+        frameTimes.add(rendered);
+        notificationCounts.add(double(notifications.total - notificationsBefore));
+        collisionCounts.add(double(backend->collisionCheckCount() - collisionsBefore));
+
+        // Hold 60 Hz so the animations advance as on a display
+        const double next = (frame + 1) * FrameIntervalMs;
+        const double now = elapsedMs(pacing);
+        if (next > now)
+            QThread::usleep(static_cast<unsigned long>((next - now) * 1000.0));
+    }
+
+    printf("%d frames at %dx%d, %d preset cycles\n", frameCount, size.width(), size.height(), cycles);
+    frameTimes.print("frame", "ms");
+    polishTimes.print("  polish", "ms");
+    syncTimes.print("  sync", "ms");
+    renderTimes.print("  render", "ms");
+    notificationCounts.print("backend notifications", "/frame");
+    collisionCounts.print("detectCollision calls", "/frame");
+
+    delete root;
+    return 0;
+}
+
+#include "renderbench.moc"
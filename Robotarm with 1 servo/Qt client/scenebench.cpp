@@ -0,0 +1,162 @@
+// Arm to scene distance queries against a cluttered work cell.
+//
+// usage: scenebench [--obstacles n] [--poses n] [--seed n]
+//
+// Scatters boxes, upright cylinders and small meshes around the arm, builds
+// the ObstacleScene hierarchy and times sceneClearance() and
+// isSceneColliding() over random arm poses. The same queries on one scene
+// per obstacle, a linear scan, give the reference result and time.
+
+#include "armmodel.h"
+#include "obstaclescene.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+    int obstacles = 1000;
+    int poses = 20000;
+    unsigned seed = 1;
+};
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        const char *value = argv[++i];
+        if (arg == "--obstacles")
+            options.obstacles = std::atoi(value);
+        else if (arg == "--poses")
+            options.poses = std::atoi(value);
+        else if (arg == "--seed")
+            options.seed = unsigned(std::atoi(value));
+        else
+            return false;
+    }
+    return options.obstacles > 0 && options.poses > 0;
+}
+
+double seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Octahedron, the smallest closed mesh that is not a box
+ArmModel::MeshObstacle octahedron(const ArmModel::Vec3 &center, double radius)
+{
+    ArmModel::MeshObstacle mesh;
+    mesh.vertices = {
+        { center.x + radius, center.y, center.z }, { center.x - radius, center.y, center.z },
+        { center.x, center.y + radius, center.z }, { center.x, center.y - radius, center.z },
+        { center.x, center.y, center.z + radius }, { center.x, center.y, center.z - radius },
+    };
+    mesh.triangles = { { 0, 2, 4 }, { 2, 1, 4 }, { 1, 3, 4 }, { 3, 0, 4 },
+                       { 2, 0, 5 }, { 1, 2, 5 }, { 3, 1, 5 }, { 0, 3, 5 } };
+    return mesh;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [--obstacles n] [--poses n] [--seed n]\n", argv[0]);
+        return 1;
+    }
+
+    // Fixtures in a ring around the base, up to the height the arm reaches
+    std::mt19937 random(options.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    ArmModel::ObstacleScene scene;
+    std::vector<ArmModel::ObstacleScene> single(size_t(options.obstacles));
+    for (int i = 0; i < options.obstacles; i++) {
+        const double angle = 2.0 * 3.14159265358979323846 * unit(random);
+        const double distance = 250.0 + 1250.0 * unit(random);
+        const ArmModel::Vec3 center = { distance * std::cos(angle), 900.0 * unit(random), distance * std::sin(angle) };
+        const double size = 5.0 + 20.0 * unit(random);
+        const double kind = unit(random);
+        if (kind < 0.45) {
+            const ArmModel::BoxObstacle box { center, { size, size * (0.5 + unit(random)), size }, 90.0 * unit(random) };
+            scene.addBox(box);
+            single[size_t(i)].addBox(box);
+        } else if (kind < 0.9) {
+            const ArmModel::CylinderObstacle cylinder { center, size, size * (0.5 + unit(random)) };
+            scene.addCylinder(cylinder);
+            single[size_t(i)].addCylinder(cylinder);
+        } else {
+            const ArmModel::MeshObstacle mesh = octahedron(center, size);
+            scene.addMesh(mesh);
+            single[size_t(i)].addMesh(mesh);
+        }
+        single[size_t(i)].build();
+    }
+    auto start = std::chrono::steady_clock::now();
+    scene.build();
+    printf("%d obstacles, hierarchy built in %.2f ms\n", options.obstacles, seconds(start) * 1e3);
+
+    std::vector<ArmModel::JointVector> poses(size_t(options.poses));
+    for (ArmModel::JointVector &joints : poses) {
+        for (int joint = 0; joint < ArmModel::JointCount; joint++) {
+            const ArmModel::JointLimits limits = ArmModel::jointLimits(joint);
+            joints[joint] = limits.min + (limits.max - limits.min) * unit(random);
+        }
+    }
+
+    // --- Hierarchy ---
+    std::vector<double> clearance(poses.size());
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < poses.size(); i++)
+        clearance[i] = ArmModel::sceneClearance(scene, poses[i]).distance;
+    const double clearanceTime = seconds(start);
+
+    std::vector<unsigned char> colliding(poses.size());
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < poses.size(); i++)
+        colliding[i] = ArmModel::isSceneColliding(scene, poses[i]);
+    const double collidingTime = seconds(start);
+
+    // --- Linear scan over the same spheres, on a subset since it is slow ---
+    const size_t scanned = std::min<size_t>(poses.size(), 500);
+    size_t mismatches = 0;
+    ArmModel::LinkSpheres spheres;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < scanned; i++) {
+        const ArmModel::LinkBoxes boxes = ArmModel::linkBoxes(poses[i]);
+        spheres.clear();
+        for (const int link : { ArmModel::ForearmLink, ArmModel::ArmLink, ArmModel::HandLink })
+            ArmModel::linkSpheres(boxes[link], poses[i][ArmModel::Rotation4], spheres);
+        double reference = std::numeric_limits<double>::infinity();
+        for (const ArmModel::Sphere &sphere : spheres) {
+            for (const ArmModel::ObstacleScene &obstacle : single)
+                reference = std::min(reference, obstacle.distance(sphere.center) - sphere.radius);
+        }
+        // Penetration depths may differ when the arm is inside several
+        // obstacles, only the sign matters there
+        const bool agree = reference > 0.0 ? std::abs(reference - clearance[i]) < 1e-9 : clearance[i] <= 0.0;
+        mismatches += !agree || (clearance[i] <= 0.0) != bool(colliding[i]);
+    }
+    const double scanTime = seconds(start);
+
+    size_t hits = 0;
+    for (const unsigned char c : colliding)
+        hits += c;
+    printf("sceneClearance        %8.2f us/pose\n", clearanceTime / double(poses.size()) * 1e6);
+    printf("isSceneColliding      %8.2f us/pose, %zu of %zu poses collide\n",
+           collidingTime / double(poses.size()) * 1e6, hits, poses.size());
+    printf("linear scan           %8.2f us/pose, %zu mismatches in %zu poses\n", scanTime / double(scanned) * 1e6,
+           mismatches, scanned);
+    return mismatches == 0 ? 0 : 2;
+}
@@ -0,0 +1,158 @@
+#include "scenefile.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtMath>
+
+namespace {
+
+bool readVec3(const QJsonValue &value, ArmModel::Vec3 &v)
+{
+    const QJsonArray array = value.toArray();
+    if (array.size() != 3 || !array[0].isDouble() || !array[1].isDouble() || !array[2].isDouble())
+        return false;
+    v = { array[0].toDouble(), array[1].toDouble(), array[2].toDouble() };
+    return true;
+}
+
+// Faces are fanned into triangles, texture and normal indices are ignored
+bool readObj(const QString &path, ArmModel::MeshObstacle &mesh, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = path + ": " + file.errorString();
+        return false;
+    }
+
+    int lineNumber = 0;
+    while (!file.atEnd()) {
+        const QList<QByteArray> fields = file.readLine().simplified().split(' ');
+        lineNumber++;
+        if (fields[0] == "v" && fields.size() >= 4) {
+            mesh.vertices.push_back({ fields[1].toDouble(), fields[2].toDouble(), fields[3].toDouble() });
+        } else if (fields[0] == "f" && fields.size() >= 4) {
+            std::vector<uint32_t> face;
+            for (int i = 1; i < fields.size(); i++) {
+                // Negative indices count back from the last vertex
+                const int index = fields[i].split('/').first().toInt();
+                const qsizetype resolved = index < 0 ? qsizetype(mesh.vertices.size()) + index : index - 1;
+                if (index == 0 || resolved < 0 || resolved >= qsizetype(mesh.vertices.size())) {
+                    *error = QStringLiteral("%1:%2: bad vertex index").arg(path).arg(lineNumber);
+                    return false;
+                }
+                face.push_back(uint32_t(resolved));
+            }
+            for (size_t i = 2; i < face.size(); i++)
+                mesh.triangles.push_back({ face[0], face[i - 1], face[i] });
+        }
+    }
+    return true;
+}
+
+bool readInlineMesh(const QJsonObject &entry, ArmModel::MeshObstacle &mesh)
+{
+    for (const QJsonValue &value : entry["vertices"].toArray()) {
+        ArmModel::Vec3 vertex;
+        if (!readVec3(value, vertex))
+            return false;
+        mesh.vertices.push_back(vertex);
+    }
+    for (const QJsonValue &value : entry["triangles"].toArray()) {
+        const QJsonArray triangle = value.toArray();
+        if (triangle.size() != 3)
+            return false;
+        std::array<uint32_t, 3> indices;
+        for (int i = 0; i < 3; i++) {
+            const int index = triangle[i].toInt(-1);
+            if (index < 0 || size_t(index) >= mesh.vertices.size())
+                return false;
+            indices[size_t(i)] = uint32_t(index);
+        }
+        mesh.triangles.push_back(indices);
+    }
+    return !mesh.triangles.empty();
+}
+
+// Scales, turns and moves mesh vertices into the scene, turning the same way
+// as a box yaw
+void placeMesh(ArmModel::MeshObstacle &mesh, const ArmModel::Vec3 &position, double scale, double yaw)
+{
+    const double c = qCos(qDegreesToRadians(yaw));
+    const double s = qSin(qDegreesToRadians(yaw));
+    for (ArmModel::Vec3 &v : mesh.vertices) {
+        const ArmModel::Vec3 local = { v.x * scale, v.y * scale, v.z * scale };
+        v = { position.x + c * local.x + s * local.z, position.y + local.y, position.z - s * local.x + c * local.z };
+    }
+}
+
+} // namespace
+
+bool loadSceneFile(const QString &path, ArmModel::ObstacleScene &scene, QString *error)
+{
+    scene.clear();
+    QString message;
+    auto fail = [&](const QString &text) {
+        scene.clear();
+        if (error)
+            *error = text;
+        return false;
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return fail(file.errorString());
+    QJsonParseError parseError;
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll(), &parseError).object();
+    if (parseError.error != QJsonParseError::NoError)
+        return fail(parseError.errorString());
+
+    const QDir directory = QFileInfo(path).dir();
+    const QJsonArray obstacles = root["obstacles"].toArray();
+    for (qsizetype i = 0; i < obstacles.size(); i++) {
+        const QJsonObject entry = obstacles[i].toObject();
+        const QString type = entry["type"].toString();
+        const QString invalid = QStringLiteral("Invalid %1 obstacle %2").arg(type).arg(i);
+
+        if (type == "box") {
+            ArmModel::BoxObstacle box;
+            ArmModel::Vec3 size;
+            if (!readVec3(entry["center"], box.center) || !readVec3(entry["size"], size)
+                || size.x <= 0.0 || size.y <= 0.0 || size.z <= 0.0)
+                return fail(invalid);
+            box.halfExtents = { 0.5 * size.x, 0.5 * size.y, 0.5 * size.z };
+            box.yaw = entry["yaw"].toDouble(0.0);
+            scene.addBox(box);
+        } else if (type == "cylinder") {
+            ArmModel::CylinderObstacle cylinder;
+            cylinder.radius = entry["radius"].toDouble(0.0);
+            cylinder.halfHeight = 0.5 * entry["height"].toDouble(0.0);
+            if (!readVec3(entry["center"], cylinder.center) || cylinder.radius <= 0.0 || cylinder.halfHeight <= 0.0)
+                return fail(invalid);
+            scene.addCylinder(cylinder);
+        } else if (type == "mesh") {
+            ArmModel::MeshObstacle mesh;
+            if (entry.contains("source")) {
+                if (!readObj(directory.filePath(entry["source"].toString()), mesh, &message))
+                    return fail(message);
+                if (mesh.triangles.empty())
+                    return fail(invalid);
+            } else if (!readInlineMesh(entry, mesh)) {
+                return fail(invalid);
+            }
+            ArmModel::Vec3 position = { 0.0, 0.0, 0.0 };
+            if (entry.contains("position") && !readVec3(entry["position"], position))
+                return fail(invalid);
+            placeMesh(mesh, position, entry["scale"].toDouble(1.0), entry["yaw"].toDouble(0.0));
+            scene.addMesh(mesh);
+        } else {
+            return fail(QStringLiteral("Unknown obstacle type \"%1\"").arg(type));
+        }
+    }
+
+    scene.build();
+    return true;
+}
@@ -0,0 +1,20 @@
+#ifndef SCENEFILE_H
+#define SCENEFILE_H
+
+#include "obstaclescene.h"
+#include <QString>
+
+// Reads the fixtures of the work cell into a built ObstacleScene. The scene
+// file is JSON, positions and sizes in scene coordinates (see
+// obstaclescene.h), angles in degrees:
+//   { "obstacles": [
+//       { "type": "box", "center": [x, y, z], "size": [x, y, z], "yaw": 0 },
+//       { "type": "cylinder", "center": [x, y, z], "radius": 40, "height": 300 },
+//       { "type": "mesh", "source": "fixture.obj",
+//         "position": [x, y, z], "scale": 1, "yaw": 0 },
+//       { "type": "mesh", "vertices": [[x, y, z], ...], "triangles": [[0, 1, 2], ...] } ] }
+// Mesh sources are Wavefront OBJ files relative to the scene file; only
+// their vertices and faces are read. On failure the scene is left empty.
+bool loadSceneFile(const QString &path, ArmModel::ObstacleScene &scene, QString *error = nullptr);
+
+#endif // SCENEFILE_H
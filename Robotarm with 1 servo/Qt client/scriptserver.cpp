@@ -0,0 +1,369 @@
+#include "scriptserver.h"
+
+#include "backend.h"
+#include "esp32client.h"
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalSocket>
+#include <QTimer>
+#include <cmath>
+
+namespace {
+
+// A trajectory of a few thousand points fits comfortably
+constexpr qsizetype MaxLineBytes = 4 * 1024 * 1024;
+constexpr double DefaultRateHz = 30.0;
+constexpr double MaxRateHz = 120.0;
+
+QJsonObject error(const QString &message)
+{
+    QJsonObject response;
+    response["status"] = "error";
+    response["message"] = message;
+    return response;
+}
+
+QJsonObject success()
+{
+    QJsonObject response;
+    response["status"] = "success";
+    return response;
+}
+
+} // namespace
+
+ScriptServer::ScriptServer(QObject *parent) : QObject(parent)
+{
+    // Only the user running the client may drive the arm
+    m_server.setSocketOptions(QLocalServer::UserAccessOption);
+    connect(&m_server, &QLocalServer::newConnection, this, &ScriptServer::onNewConnection);
+}
+
+ScriptServer::~ScriptServer()
+{
+    stop();
+}
+
+Backend *ScriptServer::backend() const
+{
+    return m_backend;
+}
+
+void ScriptServer::setBackend(Backend *backend)
+{
+    if (backend == m_backend)
+        return;
+    for (const QMetaObject::Connection &connection : std::as_const(m_backendConnections))
+        disconnect(connection);
+    m_backendConnections.clear();
+
+    m_backend = backend;
+    if (m_backend) {
+        m_backendConnections << connect(m_backend, &Backend::telemetryReceived, this,
+                                        [this](int index, double position) {
+            QJsonObject message;
+            message["type"] = "telemetry";
+            message["timestamp"] = QDateTime::currentMSecsSinceEpoch();
+            message["index"] = index;
+            message["position"] = position;
+            broadcast(message, true);
+        });
+        m_backendConnections << connect(m_backend, &Backend::trajectoryFinished, this, [this](bool completed) {
+            QJsonObject message;
+            message["type"] = "trajectory_done";
+            message["completed"] = completed;
+            broadcast(message, false);
+        });
+    }
+    emit backendChanged();
+}
+
+QString ScriptServer::socketName() const
+{
+    return m_socketName;
+}
+
+void ScriptServer::setSocketName(const QString &name)
+{
+    if (name == m_socketName)
+        return;
+    m_socketName = name;
+    emit socketNameChanged();
+}
+
+bool ScriptServer::isListening() const
+{
+    return m_server.isListening();
+}
+
+int ScriptServer::clientCount() const
+{
+    return int(m_clients.size());
+}
+
+bool ScriptServer::start()
+{
+    stop();
+    if (!m_server.listen(m_socketName)) {
+        // A socket file left by a crashed instance blocks listen(), one that
+        // still accepts connections belongs to a running instance
+        if (m_server.serverError() != QAbstractSocket::AddressInUseError || isServerRunning(m_socketName)
+            || !QLocalServer::removeServer(m_socketName) || !m_server.listen(m_socketName)) {
+            emit errorOccurred(m_server.errorString());
+            return false;
+        }
+    }
+    emit listeningChanged();
+    return true;
+}
+
+bool ScriptServer::isServerRunning(const QString &name)
+{
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    const bool running = probe.waitForConnected(500);
+    probe.abort();
+    return running;
+}
+
+void ScriptServer::stop()
+{
+    const QList<QLocalSocket *> sockets = m_clients.keys();
+    for (QLocalSocket *socket : sockets) {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+    m_clients.clear();
+
+    if (m_server.isListening()) {
+        m_server.close();
+        emit listeningChanged();
+    }
+    if (!sockets.isEmpty())
+        emit clientCountChanged();
+}
+
+void ScriptServer::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server.nextPendingConnection()) {
+        m_clients.insert(socket, Client {});
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() { onDisconnected(socket); });
+        emit clientCountChanged();
+    }
+}
+
+void ScriptServer::onDisconnected(QLocalSocket *socket)
+{
+    // The subscription timers are children of the socket
+    if (m_clients.remove(socket))
+        emit clientCountChanged();
+    socket->deleteLater();
+}
+
+void ScriptServer::onReadyRead(QLocalSocket *socket)
+{
+    auto it = m_clients.find(socket);
+    if (it == m_clients.end())
+        return;
+    it->buffer += socket->readAll();
+
+    qsizetype newline;
+    while ((newline = it->buffer.indexOf('\n')) >= 0) {
+        const QByteArray line = it->buffer.left(newline).trimmed();
+        it->buffer.remove(0, newline + 1);
+        if (line.isEmpty())
+            continue;
+
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+        QJsonObject response;
+        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+            response = error("Invalid JSON");
+        } else {
+            const QJsonObject request = doc.object();
+            response = handleCommand(socket, request);
+            if (request.contains("id"))
+                response["id"] = request["id"];
+        }
+        send(socket, response);
+    }
+
+    if (it->buffer.size() > MaxLineBytes) {
+        send(socket, error("Message too long"));
+        socket->disconnectFromServer();
+    }
+}
+
+QJsonObject ScriptServer::handleCommand(QLocalSocket *socket, const QJsonObject &request)
+{
+    const QString command = request["command"].toString();
+    if (command == "ping")
+        return success();
+    if (command == "subscribe" || command == "unsubscribe")
+        return subscribe(socket, request, command == "subscribe");
+    if (!m_backend)
+        return error("No backend");
+
+    if (command == "get_status") {
+        QJsonObject response = statusMessage();
+        response["status"] = "success";
+        return response;
+    }
+    if (command == "get_metrics") {
+        QJsonObject response = metricsMessage();
+        response["status"] = "success";
+        return response;
+    }
+
+    if (command == "set_pose") {
+        const QJsonArray joints = request["joints"].toArray();
+        if (joints.size() != ArmModel::JointCount)
+            return error("joints must hold 4 angles");
+        // Checked like playTrajectory(), before anything moves
+        ArmModel::JointVector pose;
+        for (int joint = 0; joint < ArmModel::JointCount; joint++) {
+            const ArmModel::JointLimits limits = ArmModel::jointLimits(joint);
+            if (!joints[joint].isDouble())
+                return error(QStringLiteral("Joint %1 is not a number").arg(joint + 1));
+            pose[joint] = qRound(joints[joint].toDouble());
+            if (pose[joint] < limits.min || pose[joint] > limits.max)
+                return error(QStringLiteral("Joint %1 outside [%2, %3]")
+                                     .arg(joint + 1)
+                                     .arg(limits.min)
+                                     .arg(limits.max));
+        }
+        // Same range as the claw toggle of MainScreen.qml
+        const int claws = qRound(request["claws"].toDouble());
+        if (request.contains("claws") && (!request["claws"].isDouble() || claws < 0 || claws > 90))
+            return error("claws outside [0, 90]");
+        if (ArmModel::isSelfColliding(pose) || ArmModel::isSceneColliding(m_backend->obstacleScene(), pose))
+            return error("Pose is colliding");
+
+        m_backend->stopTrajectory();
+        m_backend->setRot1Angle(int(pose[0]));
+        m_backend->setRot2Angle(int(pose[1]));
+        m_backend->setRot3Angle(int(pose[2]));
+        m_backend->setRot4Angle(int(pose[3]));
+        if (request.contains("claws"))
+            m_backend->setClawsAngle(claws);
+
+        QJsonObject response = success();
+        response["collision"] = m_backend->isColliding();
+        return response;
+    }
+
+    if (command == "submit_trajectory") {
+        const QJsonArray points = request["points"].toArray();
+        if (!m_backend->playTrajectory(points.toVariantList()))
+            return error("Invalid trajectory");
+        QJsonObject response = success();
+        response["points"] = points.size();
+        response["duration_ms"] = points.last().toObject()["t_ms"].toDouble();
+        return response;
+    }
+    if (command == "stop_trajectory") {
+        m_backend->stopTrajectory();
+        return success();
+    }
+
+    return error("Unknown command");
+}
+
+QJsonObject ScriptServer::subscribe(QLocalSocket *socket, const QJsonObject &request, bool enable)
+{
+    Client &client = m_clients[socket];
+    const QString topic = request["topic"].toString();
+    if (topic == "telemetry") {
+        client.telemetry = enable;
+        return success();
+    }
+
+    QTimer **timer = nullptr;
+    if (topic == "pose")
+        timer = &client.poseTimer;
+    else if (topic == "metrics")
+        timer = &client.metricsTimer;
+    else
+        return error("Unknown topic");
+
+    delete *timer;
+    *timer = nullptr;
+    if (!enable)
+        return success();
+
+    const double rate = qBound(0.1, request["rate_hz"].toDouble(DefaultRateHz), MaxRateHz);
+    *timer = new QTimer(socket);
+    (*timer)->setInterval(qRound(1000.0 / rate));
+    const bool pose = topic == "pose";
+    connect(*timer, &QTimer::timeout, this, [this, socket, pose]() {
+        if (m_backend)
+            send(socket, pose ? poseMessage() : metricsMessage());
+    });
+    (*timer)->start();
+    return success();
+}
+
+QJsonObject ScriptServer::statusMessage() const
+{
+    QJsonObject message;
+    message["connected"] = m_backend->isConnected();
+    message["collision"] = m_backend->isColliding();
+    message["trajectory_running"] = m_backend->isTrajectoryRunning();
+    message["text"] = m_backend->status();
+    message["joints"] = QJsonArray { m_backend->rotation1Angle(), m_backend->rotation2Angle(),
+                                     m_backend->rotation3Angle(), m_backend->rotation4Angle() };
+    message["claws"] = m_backend->clawsAngle();
+    message["speed_scale"] = m_backend->speedScale();
+    if (std::isfinite(m_backend->sceneClearance()))
+        message["scene_clearance"] = m_backend->sceneClearance();
+    return message;
+}
+
+QJsonObject ScriptServer::metricsMessage() const
+{
+    QJsonObject message;
+    message["type"] = "metrics";
+    message["timestamp"] = QDateTime::currentMSecsSinceEpoch();
+    message["prediction"] = QJsonObject::fromVariantMap(m_backend->predictionStats());
+    message["collision_checks"] = double(m_backend->collisionCheckCount());
+    message["script_clients"] = clientCount();
+    if (const ESP32Client *client = m_backend->client()) {
+        const ESP32Client::Stats stats = client->stats();
+        QJsonObject link;
+        link["messages_sent"] = double(stats.messagesSent);
+        link["bytes_sent"] = double(stats.bytesSent);
+        link["messages_received"] = double(stats.messagesReceived);
+        link["bytes_received"] = double(stats.bytesReceived);
+        message["link"] = link;
+    }
+    return message;
+}
+
+QJsonObject ScriptServer::poseMessage() const
+{
+    QJsonObject message;
+    message["type"] = "pose";
+    message["timestamp"] = QDateTime::currentMSecsSinceEpoch();
+    message["predicted"] = QJsonArray::fromVariantList(m_backend->predictedPose());
+    message["animated"] = QJsonArray { m_backend->rotation1Angle(), m_backend->rotation2Angle(),
+                                     m_backend->rotation3Angle(), m_backend->rotation4Angle() };
+    return message;
+}
+
+void ScriptServer::send(QLocalSocket *socket, const QJsonObject &message)
+{
+    if (socket->state() != QLocalSocket::ConnectedState)
+        return;
+    socket->write(QJsonDocument(message).toJson(QJsonDocument::Compact) + "\n");
+}
+
+void ScriptServer::broadcast(const QJsonObject &message, bool telemetryOnly)
+{
+    for (auto it = m_clients.cbegin(); it != m_clients.cend(); ++it) {
+        if (!telemetryOnly || it->telemetry)
+            send(it.key(), message);
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef SCRIPTSERVER_H
+#define SCRIPTSERVER_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QObject>
+#include <QPointer>
+#include <qqmlregistration.h>
+
+class Backend;
+class QLocalSocket;
+class QTimer;
+
+// Local scripting API of the client on a Unix domain socket.
+//
+// Scripts talk newline-delimited JSON, in the style of the firmware
+// protocol. Every request may carry an "id", which is echoed back with
+// {"status": "success" | "error", ...}:
+//   {"command": "ping"}
+//   {"command": "get_status"}
+//   {"command": "get_metrics"}
+//   {"command": "set_pose", "joints": [r1, r2, r3, r4], "claws": 45}
+//       (rejected without moving when outside the slider limits or colliding)
+//   {"command": "submit_trajectory", "points": [{"t_ms": 0, "joints": [...]}, ...]}
+//   {"command": "stop_trajectory"}
+//   {"command": "subscribe", "topic": "telemetry" | "pose" | "metrics", "rate_hz": 30}
+//   {"command": "unsubscribe", "topic": ...}
+// Subscriptions push {"type": <topic>, ...}; "trajectory_done" is pushed to
+// every client. Everything goes through the Backend, so commands share the
+// collision check and the rate-limited, authenticated link to the ESP32
+// with the UI.
+class ScriptServer : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(Backend *backend READ backend WRITE setBackend NOTIFY backendChanged)
+    // Socket file name, created in the temporary directory unless it is a
+    // full path, see QLocalServer::listen()
+    Q_PROPERTY(QString socketName READ socketName WRITE setSocketName NOTIFY socketNameChanged)
+    Q_PROPERTY(bool listening READ isListening NOTIFY listeningChanged)
+    Q_PROPERTY(int clientCount READ clientCount NOTIFY clientCountChanged)
+
+public:
+    explicit ScriptServer(QObject *parent = nullptr);
+    ~ScriptServer();
+
+    Backend *backend() const;
+    void setBackend(Backend *backend);
+    QString socketName() const;
+    void setSocketName(const QString &name);
+    bool isListening() const;
+    int clientCount() const;
+
+    // Fails while another instance is listening on the socket name. A stale
+    // socket left by a crashed instance, which accepts no connections, is
+    // removed and taken over.
+    Q_INVOKABLE bool start();
+    Q_INVOKABLE void stop();
+
+signals:
+    void backendChanged();
+    void socketNameChanged();
+    void listeningChanged();
+    void clientCountChanged();
+    void errorOccurred(const QString &error);
+
+private:
+    struct Client
+    {
+        QByteArray buffer;
+        bool telemetry = false;
+        QTimer *poseTimer = nullptr;
+        QTimer *metricsTimer = nullptr;
+    };
+
+    void onNewConnection();
+    void onReadyRead(QLocalSocket *socket);
+    void onDisconnected(QLocalSocket *socket);
+    QJsonObject handleCommand(QLocalSocket *socket, const QJsonObject &request);
+    QJsonObject subscribe(QLocalSocket *socket, const QJsonObject &request, bool enable);
+    QJsonObject statusMessage() const;
+    QJsonObject metricsMessage() const;
+    QJsonObject poseMessage() const;
+    void send(QLocalSocket *socket, const QJsonObject &message);
+    void broadcast(const QJsonObject &message, bool telemetryOnly);
+    static bool isServerRunning(const QString &name);
+
+    QLocalServer m_server;
+    QPointer<Backend> m_backend;
+    QList<QMetaObject::Connection> m_backendConnections;
+    QString m_socketName = QStringLiteral("esp32-arm");
+    QHash<QLocalSocket *, Client> m_clients;
+};
+
+#endif // SCRIPTSERVER_H
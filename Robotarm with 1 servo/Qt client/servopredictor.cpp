@@ -0,0 +1,127 @@
+#include "servopredictor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Integration step of the model, fine enough for time constants of ~20 ms
+constexpr double MaxStepMs = 5.0;
+// Same settle threshold as ServoModel in servo_sim
+constexpr double SettledDeg = 0.05;
+
+} // namespace
+
+ServoPredictor::ServoPredictor(double initialAngle)
+{
+    reset(initialAngle, 0.0);
+}
+
+void ServoPredictor::setPlant(const ServoPlant &plant)
+{
+    m_plant = plant;
+}
+
+void ServoPredictor::reset(double angle, double nowMs)
+{
+    m_state = State();
+    m_state.timeMs = nowMs;
+    m_state.position = angle;
+    m_state.target = angle;
+    // Where the device really is stays unknown until the first sample
+    m_state.variance = 90.0 * 90.0;
+    m_commands.clear();
+}
+
+void ServoPredictor::command(double angle, double sentMs)
+{
+    const double effectiveMs = sentMs + m_linkLatencyMs + m_plant.delayMs;
+    // A latency estimate that shrank must not reorder the queue
+    const double earliest = m_commands.empty() ? m_state.timeMs : m_commands.back().effectiveMs;
+    m_commands.push_back({ std::max(effectiveMs, earliest), angle });
+}
+
+double ServoPredictor::measure(double position, double receivedMs)
+{
+    // Late samples describe the device one latency ago. Samples older than
+    // the filter state are fused at the state time rather than dropped.
+    const double sampleMs = std::max(receivedMs - m_linkLatencyMs, m_state.timeMs);
+    propagate(m_state, sampleMs);
+
+    while (!m_commands.empty() && m_commands.front().effectiveMs <= m_state.timeMs)
+        m_commands.pop_front();
+
+    const double innovation = position - m_state.position;
+    const double measurementVariance = std::max(m_plant.noiseDeg * m_plant.noiseDeg, 1e-4);
+    const double gain = m_state.variance / (m_state.variance + measurementVariance);
+    m_state.position += gain * innovation;
+    m_state.variance *= 1.0 - gain;
+
+    // Resume tracking if the measured error leaves the deadband, the servo
+    // would do the same
+    if (std::fabs(m_state.target - m_state.position) > m_plant.deadbandDeg)
+        m_state.tracking = true;
+    return innovation;
+}
+
+double ServoPredictor::predict(double nowMs) const
+{
+    State state = m_state;
+    propagate(state, nowMs);
+    return state.position;
+}
+
+bool ServoPredictor::isSettled(double nowMs) const
+{
+    if (!m_commands.empty() && m_commands.back().effectiveMs > nowMs)
+        return false;
+    State state = m_state;
+    propagate(state, nowMs);
+    return !state.tracking;
+}
+
+void ServoPredictor::propagate(State &state, double toMs) const
+{
+    const double tau = std::max(m_plant.timeConstantMs, 1e-3);
+    auto command = std::find_if(m_commands.begin(), m_commands.end(),
+                                [&](const Command &c) { return c.effectiveMs > state.timeMs; });
+
+    // Commands already due were folded in by measure(), apply them in case the
+    // state has not caught up yet
+    for (auto it = m_commands.begin(); it != command; ++it)
+        state.target = it->angle;
+
+    while (state.timeMs < toMs) {
+        double stepEnd = std::min(toMs, state.timeMs + MaxStepMs);
+        if (command != m_commands.end() && command->effectiveMs < stepEnd)
+            stepEnd = command->effectiveMs;
+        const double dtMs = stepEnd - state.timeMs;
+
+        double error = state.target - state.position;
+        if (!state.tracking && std::fabs(error) > m_plant.deadbandDeg)
+            state.tracking = true;
+
+        // Linearised model: unsaturated first-order motion shrinks the
+        // uncertainty, slew-limited or idle motion keeps it
+        double decay = 1.0;
+        if (state.tracking && dtMs > 0.0) {
+            const double desired = error / tau;
+            const double limit = m_plant.maxSlewDps / 1000.0;
+            double moveBy = std::clamp(desired, -limit, limit) * dtMs;
+            if (std::fabs(moveBy) > std::fabs(error))
+                moveBy = error;
+            if (std::fabs(desired) < limit)
+                decay = std::max(0.0, 1.0 - dtMs / tau);
+            state.position += moveBy;
+            if (std::fabs(state.target - state.position) < SettledDeg)
+                state.tracking = false;
+        }
+        state.variance = decay * decay * state.variance + m_processNoise * dtMs / 1000.0;
+        state.timeMs = stepEnd;
+
+        while (command != m_commands.end() && command->effectiveMs <= state.timeMs) {
+            state.target = command->angle;
+            ++command;
+        }
+    }
+}
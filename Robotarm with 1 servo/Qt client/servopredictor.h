@@ -0,0 +1,81 @@
+#ifndef SERVOPREDICTOR_H
+#define SERVOPREDICTOR_H
+
+#include <deque>
+
+// Plant parameters of one servo, as fitted by servo_fit (see
+// servo_sim/src/ServoCalibration.h for the calibration file)
+struct ServoPlant
+{
+    double delayMs = 20.0;        // command to motion start on the device
+    double timeConstantMs = 80.0; // first-order lag towards the target
+    double maxSlewDps = 300.0;    // speed limit in degrees per second
+    double deadbandDeg = 1.0;     // errors smaller than this are not corrected
+    double noiseDeg = 0.3;        // standard deviation of the reported position
+};
+
+// Estimates where a servo is *now* from the commands we sent and the
+// position telemetry, which arrives one link latency late.
+//
+// A scalar Kalman filter tracks the position at the time of the last
+// telemetry sample. The servo model propagates it through the commands
+// (shifted by link latency plus device delay) up to each new sample, where
+// the sample is fused, and predict() runs the same model from there to the
+// current time. All times are in milliseconds on the client clock.
+// It has no Qt dependency so that command line tools can reuse it.
+class ServoPredictor
+{
+public:
+    explicit ServoPredictor(double initialAngle = 90.0);
+
+    void setPlant(const ServoPlant &plant);
+    const ServoPlant &plant() const { return m_plant; }
+
+    // One-way latency between the client and the device
+    void setLinkLatency(double ms) { m_linkLatencyMs = ms; }
+    double linkLatency() const { return m_linkLatencyMs; }
+
+    // Random walk of the position not explained by the model, in deg^2/s
+    void setProcessNoise(double degSqPerSecond) { m_processNoise = degSqPerSecond; }
+
+    // Starts over at angle with a large uncertainty
+    void reset(double angle, double nowMs);
+    void command(double angle, double sentMs);
+
+    // Fuses a position sample received at receivedMs. Returns the prediction
+    // error, i.e. sample minus the model's prior estimate for that moment.
+    double measure(double position, double receivedMs);
+
+    double predict(double nowMs) const;
+    // True when no command is still on its way and the model has come to
+    // rest on the last one at nowMs, predict() will not change until the
+    // next command or sample
+    bool isSettled(double nowMs) const;
+    double variance() const { return m_state.variance; }
+
+private:
+    struct State
+    {
+        double timeMs = 0.0;
+        double position = 90.0;
+        double variance = 0.0;
+        double target = 90.0;
+        bool tracking = false;
+    };
+
+    struct Command
+    {
+        double effectiveMs;
+        double angle;
+    };
+
+    void propagate(State &state, double toMs) const;
+
+    ServoPlant m_plant;
+    double m_linkLatencyMs = 0.0;
+    double m_processNoise = 20.0;
+    State m_state;
+    std::deque<Command> m_commands; // not yet folded into m_state
+};
+
+#endif // SERVOPREDICTOR_H
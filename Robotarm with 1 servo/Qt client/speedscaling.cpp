@@ -0,0 +1,61 @@
+#include "speedscaling.h"
+
+#include <algorithm>
+
+namespace ArmModel {
+
+namespace {
+
+// Clearance is not linear in the joint angles, so the scaled step is checked
+// and halved until it keeps the allowed distance
+constexpr int MaxHalvings = 6;
+
+JointVector partialStep(const JointVector &from, const JointVector &step, double fraction)
+{
+    JointVector joints;
+    for (int joint = 0; joint < JointCount; joint++)
+        joints[joint] = from[joint] + step[joint] * fraction;
+    return joints;
+}
+
+} // namespace
+
+double stepScale(const ObstacleScene &scene, const JointVector &from, const JointVector &step, double dt,
+                 const SpeedScaling &scaling, double *clearance)
+{
+    const double before = sceneClearance(scene, from).distance;
+    if (clearance)
+        *clearance = before;
+    if (scene.isEmpty())
+        return 1.0;
+
+    // Only distances below the current one matter
+    const double after = sceneClearance(scene, partialStep(from, step, 1.0), before).distance;
+    if (after >= before)
+        return 1.0;
+
+    // Already closer than stopDistance, or inside an obstacle: only moving
+    // away is allowed, which was handled above
+    const double gap = before - scaling.stopDistance;
+    if (gap <= 0.0)
+        return 0.0;
+
+    const double closing = gap * std::min(1.0, dt / std::max(scaling.brakeTime, 1e-6));
+    const double allowed = before - closing;
+    if (after >= allowed)
+        return 1.0;
+    double scale = closing / (before - after);
+    for (int i = 0; i < MaxHalvings && scale > 0.0; i++) {
+        if (sceneClearance(scene, partialStep(from, step, scale), allowed).distance >= allowed)
+            return scale;
+        scale *= 0.5;
+    }
+    return 0.0;
+}
+
+double slowDownDistance(double speed, const SpeedScaling &scaling)
+{
+    return scaling.stopDistance + speed * scaling.brakeTime;
+}
+
+} // namespace ArmModel
@@ -0,0 +1,34 @@
+#ifndef SPEEDSCALING_H
+#define SPEEDSCALING_H
+
+#include "obstaclescene.h"
+
+// Speed and separation limit for the arm near the obstacles of a scene.
+//
+// Instead of one conservative speed everywhere, every step of the joints is
+// checked against the clearance it leaves: a step that keeps or increases
+// the distance to the scene runs at full speed, one that closes in may only
+// take a fraction of the remaining gap to stopDistance per brakeTime. The
+// approach therefore slows down smoothly, exponentially in the gap, and
+// comes to rest at stopDistance, while moving away is never held back.
+namespace ArmModel {
+
+struct SpeedScaling
+{
+    double stopDistance = 10.0; // model units between the arm and the scene at rest
+    double brakeTime = 0.25;    // seconds, time constant of the approach
+};
+
+// Fraction in [0, 1] of a joint step taking dt seconds that respects the
+// scaling. clearance receives the scene clearance before the step.
+double stepScale(const ObstacleScene &scene, const JointVector &from, const JointVector &step, double dt,
+                 const SpeedScaling &scaling = SpeedScaling(), double *clearance = nullptr);
+
+// Clearance beyond which a part of the arm closing in at speed model units
+// per second is never held back: stopDistance plus the gap it closes in
+// brakeTime.
+double slowDownDistance(double speed, const SpeedScaling &scaling = SpeedScaling());
+
+} // namespace ArmModel
+
+#endif // SPEEDSCALING_H
@@ -0,0 +1,116 @@
+#include "workstealingpool.h"
+
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(unsigned threads)
+{
+    threads = std::max(1u, threads);
+    for (unsigned i = 0; i < threads; i++)
+        m_queues.push_back(std::make_unique<Queue>());
+    for (unsigned i = 1; i < threads; i++)
+        m_workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread &worker : m_workers)
+        worker.join();
+}
+
+void WorkStealingPool::parallelFor(size_t count, size_t grain, const Body &body)
+{
+    if (count == 0)
+        return;
+    std::lock_guard<std::mutex> job(m_jobMutex);
+    grain = std::max<size_t>(1, grain);
+    m_cancelled = false;
+
+    // Round-robin, so that every queue starts at the low end of the range
+    size_t chunk = 0;
+    for (size_t begin = 0; begin < count; begin += grain, chunk++) {
+        Queue &queue = *m_queues[chunk % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.chunks.emplace_back(begin, std::min(count, begin + grain));
+    }
+
+    // A single chunk is not worth waking anybody
+    const bool wakeWorkers = !m_workers.empty() && chunk > 1;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_body = &body;
+        if (wakeWorkers) {
+            m_busyWorkers = unsigned(m_workers.size());
+            m_generation++;
+        }
+    }
+    if (wakeWorkers)
+        m_wake.notify_all();
+
+    participate(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_busyWorkers == 0; });
+    m_body = nullptr;
+}
+
+void WorkStealingPool::workerLoop(unsigned index)
+{
+    unsigned generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]() { return m_stopping || m_generation != generation; });
+            if (m_stopping)
+                return;
+            generation = m_generation;
+        }
+
+        participate(index);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busyWorkers == 0)
+            m_done.notify_all();
+    }
+}
+
+void WorkStealingPool::participate(unsigned index)
+{
+    Chunk chunk;
+    while (takeChunk(index, chunk)) {
+        // Cancelled chunks are still taken off the queues, just not run
+        if (m_cancelled.load(std::memory_order_relaxed))
+            continue;
+        if (!(*m_body)(chunk.first, chunk.second))
+            m_cancelled.store(true, std::memory_order_relaxed);
+    }
+}
+
+bool WorkStealingPool::takeChunk(unsigned index, Chunk &chunk)
+{
+    {
+        Queue &own = *m_queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.chunks.empty()) {
+            chunk = own.chunks.front();
+            own.chunks.pop_front();
+            return true;
+        }
+    }
+
+    const size_t count = m_queues.size();
+    for (size_t i = 1; i < count; i++) {
+        Queue &victim = *m_queues[(index + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.chunks.empty()) {
+            chunk = victim.chunks.back();
+            victim.chunks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
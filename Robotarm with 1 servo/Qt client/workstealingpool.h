@@ -0,0 +1,70 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops.
+//
+// parallelFor() cuts the range into chunks and deals them out round-robin
+// to one queue per participant (the workers and the calling thread). Each
+// participant works through its own queue front to back, so the low indices
+// of the range are processed first everywhere, and steals from the back of
+// the other queues once its own is empty, which evens out chunks of uneven
+// cost. It has no Qt dependency so that command line tools can reuse it.
+class WorkStealingPool
+{
+public:
+    // Body of a loop over [begin, end). Returning false cancels the chunks
+    // nobody has started yet.
+    using Body = std::function<bool(size_t begin, size_t end)>;
+
+    // threads is the total parallelism including the calling thread, so
+    // 1 runs everything on the caller
+    explicit WorkStealingPool(unsigned threads = std::thread::hardware_concurrency());
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    unsigned threadCount() const { return unsigned(m_queues.size()); }
+
+    // Returns once every chunk has run or was cancelled. Calls from several
+    // threads are serialised.
+    void parallelFor(size_t count, size_t grain, const Body &body);
+
+private:
+    using Chunk = std::pair<size_t, size_t>;
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    void workerLoop(unsigned index);
+    void participate(unsigned index);
+    bool takeChunk(unsigned index, Chunk &chunk);
+
+    std::vector<std::unique_ptr<Queue>> m_queues; // [0] belongs to the calling thread
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_jobMutex; // one parallelFor at a time
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const Body *m_body = nullptr;
+    unsigned m_generation = 0;
+    unsigned m_busyWorkers = 0;
+    bool m_stopping = false;
+    std::atomic<bool> m_cancelled { false };
+};
+
+#endif // WORKSTEALINGPOOL_H
@@ -55,6 +55,8 @@ void loop() {
 
     // Check for incoming data from the client
     if (client.available()) {
+        // Stage times for command traces, see the set_servo reply below
+        unsigned long receivedUs = micros();
         String line = client.readStringUntil('\n');
         Serial.print("Received: ");
         Serial.println(line);
@@ -71,6 +73,8 @@ void loop() {
             return;
         }
 
+        unsigned long parsedUs = micros();
+
         // Process the command
         const char* command = doc["command"];
 
@@ -89,9 +93,22 @@ void loop() {
             if (clientAuthenticated) {
                 int angle = doc["angle"];
                 if (angle >= 0 && angle <= 180) {
+                    unsigned long writeUs = micros();
                     myServo.write(angle);
+                    unsigned long writtenUs = micros();
                     Serial.printf("Servo moved to %d degrees\n", angle);
-                    client.println("{\"status\":\"success\"}");
+                    if (doc["id"].is<unsigned long>()) {
+                        // Traced command: echo the id with the micros() of each stage,
+                        // the client maps them onto its clock
+                        char reply[192];
+                        snprintf(reply, sizeof(reply),
+                                 "{\"status\":\"success\",\"id\":%lu,\"trace\":{\"rx\":%lu,\"parsed\":%lu,"
+                                 "\"write\":%lu,\"written\":%lu,\"tx\":%lu}}",
+                                 doc["id"].as<unsigned long>(), receivedUs, parsedUs, writeUs, writtenUs, micros());
+                        client.println(reply);
+                    } else {
+                        client.println("{\"status\":\"success\"}");
+                    }
                 } else {
                      client.println("{\"status\":\"error\",\"message\":\"Invalid angle\"}");
                 }
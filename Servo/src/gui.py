@@ -1,125 +1,20 @@
 import tkinter as tk
 from tkinter import ttk, messagebox
-import socket
-import json
 import threading
 import queue
 import os
 import sys
 
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", ".."))
+
+from esp32link import ESP32Client, LatestValueSender
+
 # --- Configuration ---
 CONFIG_FILE = "esp32_connection.conf"
 DEFAULT_IP = "192.168.1.100"
 DEFAULT_PORT = 8080
 AUTH_PASSWORD = "IoTDevice2024"
-
-class ESP32ClientThread(threading.Thread):
-    """
-    Handles all network communication in a separate thread to prevent the GUI from freezing.
-    """
-    def __init__(self, host, port, gui_queue):
-        super().__init__()
-        self.host = host
-        self.port = port
-        self.gui_queue = gui_queue
-        self.sock = None
-        self.is_running = True
-        self.is_authenticated = False
-
-    def run(self):
-        """Main loop for the network thread."""
-        try:
-            # Create and connect the socket
-            self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-            self.sock.settimeout(5.0) # 5-second timeout for connection
-            self.sock.connect((self.host, self.port))
-            self.sock.settimeout(1.0) # 1-second timeout for subsequent operations
-            
-            # Authenticate with the server
-            self._send_command({"command": "auth", "password": AUTH_PASSWORD})
-
-            # Listen for responses
-            buffer = ""
-            while self.is_running:
-                try:
-                    data = self.sock.recv(1024)
-                    if not data:
-                        # Server closed connection
-                        self._report_disconnected()
-                        break
-
-                    buffer += data.decode('utf-8')
-                    
-                    # Process all complete JSON messages in the buffer
-                    while '\n' in buffer:
-                        message_str, buffer = buffer.split('\n', 1)
-                        if message_str:
-                            self._process_server_message(message_str)
-
-                except socket.timeout:
-                    # No data received, loop continues to check is_running
-                    continue
-                except Exception as e:
-                    self._report_error(f"Receive error: {e}")
-                    break
-
-        except socket.timeout:
-            self._report_error("Connection timed out. Check IP and server status.")
-        except ConnectionRefusedError:
-            self._report_error("Connection refused. Is the ESP32 server running?")
-        except Exception as e:
-            self._report_error(f"Connection failed: {e}")
-        finally:
-            self._report_disconnected()
-            self.close()
-
-    def _process_server_message(self, message_str):
-        """Parses a JSON message from the server and acts on it."""
-        try:
-            message = json.loads(message_str)
-            if message.get("status") == "success":
-                if not self.is_authenticated:
-                    self.is_authenticated = True
-                    self.gui_queue.put({"status": "connected"})
-            elif message.get("status") == "error":
-                error_msg = message.get("message", "Unknown error from ESP32")
-                self._report_error(f"ESP32 Error: {error_msg}")
-        except json.JSONDecodeError:
-            print(f"Received non-JSON message: {message_str}")
-
-    def _send_command(self, command_dict):
-        """Sends a JSON command to the ESP32."""
-        if self.sock:
-            try:
-                message = json.dumps(command_dict) + "\n"
-                self.sock.sendall(message.encode('utf-8'))
-            except Exception as e:
-                self._report_error(f"Send error: {e}")
-
-    def send_servo_angle(self, angle):
-        """Specifically sends the servo control command."""
-        if self.is_authenticated:
-            self._send_command({"command": "set_servo", "angle": angle})
-
-    def _report_error(self, error_msg):
-        self.gui_queue.put({"status": "error", "message": error_msg})
-
-    def _report_disconnected(self):
-        self.gui_queue.put({"status": "disconnected"})
-
-    def close(self):
-        """Stops the thread and closes the socket."""
-        self.is_running = False
-        if self.sock:
-            try:
-                self.sock.shutdown(socket.SHUT_RDWR)
-                self.sock.close()
-            except OSError:
-                # Socket might already be closed
-                pass
-            self.sock = None
-            self.is_authenticated = False
-
+SERVO_SEND_RATE_HZ = 20 # Slider commands per second while dragging
 
 class ServoControllerApp(tk.Tk):
     def __init__(self):
@@ -128,10 +23,11 @@ class ServoControllerApp(tk.Tk):
         self.geometry("450x200")
         self.resizable(False, False)
 
-        self.client_thread = None
+        self.client = None
         self.gui_queue = queue.Queue()
         self.is_connected = False
-        self.last_sent_angle = 90 # To avoid flooding the server
+        # Sends the latest slider angle at a fixed rate, to avoid flooding the server
+        self.servo_sender = LatestValueSender(self.send_servo_angle, self.after, SERVO_SEND_RATE_HZ)
 
         self._create_widgets()
         self.load_last_connection_info()
@@ -175,6 +71,8 @@ class ServoControllerApp(tk.Tk):
         self.servo_slider = ttk.Scale(servo_group, from_=0, to=180, orient=tk.HORIZONTAL,
                                       variable=self.angle_var, command=self.on_slider_change)
         self.servo_slider.grid(row=0, column=1, sticky="ew", padx=10)
+        # The angle the slider was released at goes out immediately
+        self.servo_slider.bind("<ButtonRelease-1>", lambda event: self.servo_sender.flush())
 
         self.angle_label = ttk.Label(servo_group, text="90°", width=5)
         self.angle_label.grid(row=0, column=2)
@@ -203,24 +101,40 @@ class ServoControllerApp(tk.Tk):
         self.save_last_connection_info(ip, port)
         self.connect_button.config(text="Connecting...", state=tk.DISABLED)
         
-        # Start the network thread
-        self.client_thread = ESP32ClientThread(ip, port, self.gui_queue)
-        self.client_thread.start()
+        # Connecting blocks until the ESP32 answers, so it runs in a thread;
+        # the traffic itself is handled by the esp32link event loop
+        self.client = ESP32Client(ip, port, AUTH_PASSWORD)
+        threading.Thread(target=self._connect_worker, args=(self.client,), daemon=True).start()
+
+    def _connect_worker(self, client):
+        if client.connect() and client.authenticate():
+            client.register_connection_callback(self.on_connection_event)
+            self.gui_queue.put({"status": "connected"})
+        else:
+            self.gui_queue.put({"status": "error", "message": client.error})
+            client.close()
+
+    def on_connection_event(self, connected, message):
+        """Called from the esp32link event loop when the connection ends"""
+        if not connected:
+            self.gui_queue.put({"status": "disconnected"})
 
     def disconnect_from_esp(self):
-        if self.client_thread and self.client_thread.is_alive():
-            self.client_thread.close()
-        # The thread will put a 'disconnected' message in the queue, which will update the UI.
+        if self.client:
+            self.client.close()
+        # The client reports 'disconnected' through the queue, which will update the UI.
 
     def on_slider_change(self, value):
         angle = int(float(value))
         self.angle_label.config(text=f"{angle}°")
         
-        # Only send if the angle has changed and we are connected
-        if angle != self.last_sent_angle and self.is_connected:
-            self.last_sent_angle = angle
-            if self.client_thread:
-                self.client_thread.send_servo_angle(angle)
+        # The sender skips unchanged angles and holds back fast drags
+        if self.is_connected:
+            self.servo_sender.update(0, angle)
+
+    def send_servo_angle(self, key, angle):
+        if self.is_connected and self.client:
+            self.client.control_servo(angle)
     
     def process_queue(self):
         """
@@ -234,6 +148,7 @@ class ServoControllerApp(tk.Tk):
                     messagebox.showinfo("Success", f"Connected to ESP32 at {self.ip_var.get()}:{self.port_var.get()}")
                 elif message["status"] == "disconnected":
                     self.is_connected = False
+                    self.servo_sender.reset()
                 elif message["status"] == "error":
                     messagebox.showerror("Connection Error", message["message"])
                     self.is_connected = False # Ensure disconnected state on error
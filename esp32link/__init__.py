@@ -0,0 +1,20 @@
+"""
+Client library for the ESP32 TCP firmwares, shared by the Python GUIs
+"""
+
+from .aio import AsyncESP32Client, AuthenticationError
+from .client import ESP32Client
+from .history import HistoryBackfill
+from .protocol import NATIVE
+from .throttle import LatestValueSender
+from .timeseries import TimeSeriesStore
+
+# Blocking client of the C++ protocol core with its own I/O thread and
+# reconnect, None when the module is not built
+try:
+    from ._esp32proto import Client as NativeClient
+except ImportError:
+    NativeClient = None
+
+__all__ = ["AsyncESP32Client", "AuthenticationError", "ESP32Client", "HistoryBackfill", "LatestValueSender",
+           "NATIVE", "NativeClient", "TimeSeriesStore"]
@@ -0,0 +1,232 @@
+"""
+Asyncio client for the ESP32 firmwares
+
+Commands are pipelined: they are written without waiting for the previous
+reply and the replies are matched to them in order. Every command carries a
+request "id", which the firmwares ignore today; a reply that echoes it is
+matched by id instead. All messages queued within one event loop iteration
+go out in a single write, so a burst of commands costs one TCP segment
+rather than one each.
+"""
+
+import asyncio
+import collections
+import socket
+
+from .protocol import LineFramer, decode, encode, is_challenge, is_history, is_status
+
+
+class AuthenticationError(Exception):
+    pass
+
+
+_Pending = collections.namedtuple("_Pending", "id command future")
+
+
+class _Protocol(asyncio.Protocol):
+    def __init__(self, client):
+        self._client = client
+        self._framer = LineFramer()
+
+    def connection_made(self, transport):
+        sock = transport.get_extra_info("socket")
+        if sock is not None and sock.family in (socket.AF_INET, socket.AF_INET6):
+            # Commands are already coalesced, Nagle would only delay them
+            sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self._client._transport = transport
+
+    def data_received(self, data):
+        for line in self._framer.feed(data):
+            self._client._dispatch(line)
+
+    def connection_lost(self, exc):
+        self._client._lost(exc)
+
+
+class AsyncESP32Client:
+    def __init__(self, host, port=8080, auth_password="IoTDevice2024", status_queue_size=16):
+        self.host = host
+        self.port = port
+        self.auth_password = auth_password
+        self.authenticated = False
+        self.latest_status = {}
+        self._status_queue_size = status_queue_size
+        self._transport = None
+        self._loop = None
+        self._next_id = 0
+        self._pending = collections.deque()
+        self._outgoing = []
+        self._flush_scheduled = False
+        self._status_queues = []
+        self._status_listeners = []
+        self._history_listeners = []
+        self._connection_listeners = []
+        self._keep_alive_task = None
+        self._closed = None
+
+    @property
+    def connected(self):
+        return self._transport is not None and not self._transport.is_closing()
+
+    def add_status_listener(self, callback):
+        """Call callback(status) for every status message"""
+        self._status_listeners.append(callback)
+
+    def add_history_listener(self, callback):
+        """Call callback(message) for every block of recorded telemetry, see history.py"""
+        self._history_listeners.append(callback)
+
+    def add_connection_listener(self, callback):
+        """Call callback(exc) when the connection is lost, exc is None on a clean close"""
+        self._connection_listeners.append(callback)
+
+    async def connect(self, timeout=10.0):
+        """Open the connection. The LED board's auth challenge needs no waiting for,
+        it is skipped when it arrives."""
+        self._loop = asyncio.get_running_loop()
+        self._closed = self._loop.create_future()
+        await asyncio.wait_for(
+            self._loop.create_connection(lambda: _Protocol(self), self.host, self.port), timeout)
+
+    async def authenticate(self, timeout=5.0):
+        """Log in with the password, raises AuthenticationError when refused"""
+        reply = await self.request({"command": "auth", "password": self.auth_password}, timeout)
+        if reply.get("status") != "success":
+            raise AuthenticationError(reply.get("message", str(reply)))
+        self.authenticated = True
+        return reply
+
+    def send(self, message):
+        """Queue a command without waiting for its reply"""
+        self._queue(message, None)
+
+    async def request(self, message, timeout=5.0):
+        """Send a command and return its reply"""
+        future = self._loop.create_future()
+        self._queue(message, future)
+        return await asyncio.wait_for(future, timeout)
+
+    async def statuses(self):
+        """Iterate over status messages until the connection closes. A consumer that
+        falls behind loses the oldest ones, only recent status is of interest."""
+        queue = asyncio.Queue(self._status_queue_size)
+        self._status_queues.append(queue)
+        try:
+            while True:
+                status = await queue.get()
+                if status is None:
+                    return
+                yield status
+        finally:
+            self._status_queues.remove(queue)
+
+    def start_keep_alive(self, interval=25.0):
+        """Ping periodically so the firmware does not drop an idle client"""
+        if self._keep_alive_task is None:
+            self._keep_alive_task = self._loop.create_task(self._keep_alive(interval))
+
+    async def set_led(self, led_number, state):
+        return await self.request({"command": "set_led", "led": led_number, "state": state})
+
+    async def set_all_leds(self, state):
+        return await self.request({"command": "set_all_leds", "state": state})
+
+    async def set_servo(self, angle):
+        return await self.request({"command": "set_servo", "angle": angle})
+
+    async def get_status(self):
+        return await self.request({"command": "get_status"})
+
+    async def ping(self):
+        return await self.request({"command": "ping"})
+
+    async def subscribe_history(self, since=0):
+        """Have the board send the telemetry it recorded after board time since"""
+        return await self.request({"command": "subscribe_history", "since": since})
+
+    async def close(self):
+        if self._transport is not None:
+            self._flush()
+            self._transport.close()
+            await self._closed
+
+    async def _keep_alive(self, interval):
+        while self.connected:
+            await asyncio.sleep(interval)
+            if self.connected:
+                self.send({"command": "ping"})
+
+    def _queue(self, message, future):
+        if not self.connected:
+            raise ConnectionError("Not connected")
+        self._next_id += 1
+        self._pending.append(_Pending(self._next_id, message.get("command"), future))
+        self._outgoing.append(encode(dict(message, id=self._next_id)))
+        if not self._flush_scheduled:
+            self._flush_scheduled = True
+            self._loop.call_soon(self._flush)
+
+    def _flush(self):
+        self._flush_scheduled = False
+        if self._outgoing and self.connected:
+            self._transport.write(b"".join(self._outgoing))
+        self._outgoing.clear()
+
+    def _dispatch(self, line):
+        message = decode(line)
+        if message is None or is_challenge(message):
+            return
+
+        if is_history(message):
+            for callback in self._history_listeners:
+                callback(message)
+            return
+
+        if is_status(message):
+            self.latest_status = message
+            for queue in self._status_queues:
+                _put_latest(queue, message)
+            for callback in self._status_listeners:
+                callback(message)
+            # A push that arrives before the reply is as recent as the reply
+            if not self._pending or self._pending[0].command != "get_status":
+                return
+            self._resolve(self._pending.popleft(), message)
+            return
+
+        if "id" in message:
+            for pending in self._pending:
+                if pending.id == message["id"]:
+                    self._pending.remove(pending)
+                    self._resolve(pending, message)
+                    return
+        if self._pending:
+            self._resolve(self._pending.popleft(), message)
+
+    @staticmethod
+    def _resolve(pending, message):
+        if pending.future is not None and not pending.future.done():
+            pending.future.set_result(message)
+
+    def _lost(self, exc):
+        self._transport = None
+        self.authenticated = False
+        if self._keep_alive_task is not None:
+            self._keep_alive_task.cancel()
+            self._keep_alive_task = None
+        while self._pending:
+            future = self._pending.popleft().future
+            if future is not None and not future.done():
+                future.set_exception(ConnectionError(str(exc) if exc else "Connection closed"))
+        for queue in self._status_queues:
+            _put_latest(queue, None)
+        if not self._closed.done():
+            self._closed.set_result(None)
+        for callback in self._connection_listeners:
+            callback(exc)
+
+
+def _put_latest(queue, item):
+    if queue.full():
+        queue.get_nowait()
+    queue.put_nowait(item)
@@ -0,0 +1,253 @@
+"""
+Commands per second of AsyncESP32Client against the blocking socket client
+the GUIs used before
+
+usage: python -m esp32link.bench [--commands n] [--latency ms] [--host h --port p]
+
+Without --host a stand-in for the LED board firmware is started locally,
+which answers every line in order after --latency milliseconds, the round
+trip of the Wi-Fi link. servo_sim in LED board mode can be given with
+--host/--port instead. Parsing of status pushes is timed for the pure
+Python code and, when built, the esp32proto module.
+"""
+
+import argparse
+import asyncio
+import collections
+import json
+import socket
+import threading
+import time
+
+from . import protocol
+from .aio import AsyncESP32Client
+from .protocol import LineFramer, encode
+
+PASSWORD = "IoTDevice2024"
+
+
+class _BoardProtocol(asyncio.Protocol):
+    """Replies to every command line after a fixed delay, preserving the order"""
+
+    def __init__(self, latency):
+        self._latency = latency
+        self._framer = LineFramer()
+        self._replies = collections.deque()
+        self._wakeup = asyncio.Event()
+        self._transport = None
+        self._task = None
+
+    def connection_made(self, transport):
+        self._transport = transport
+        transport.get_extra_info("socket").setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        transport.write(encode({"status": "auth_required", "message": "Send authentication"}))
+        self._task = asyncio.get_running_loop().create_task(self._send_replies())
+
+    def data_received(self, data):
+        due = time.monotonic() + self._latency
+        for line in self._framer.feed(data):
+            command = json.loads(line).get("command")
+            if command == "get_status":
+                reply = {"type": "status", "servo": {"angle": 90}}
+            elif command == "ping":
+                reply = {"status": "success", "message": "pong"}
+            else:
+                reply = {"status": "success", "message": "OK"}
+            self._replies.append((due, encode(reply)))
+        self._wakeup.set()
+
+    def connection_lost(self, exc):
+        self._task.cancel()
+
+    async def _send_replies(self):
+        while True:
+            await self._wakeup.wait()
+            self._wakeup.clear()
+            while self._replies:
+                delay = self._replies[0][0] - time.monotonic()
+                if delay > 0:
+                    await asyncio.sleep(delay)
+                batch = []
+                now = time.monotonic()
+                while self._replies and self._replies[0][0] <= now:
+                    batch.append(self._replies.popleft()[1])
+                self._transport.write(b"".join(batch))
+
+
+def start_board(latency):
+    """Serve the firmware stand-in from a thread, return its port"""
+    loop = asyncio.new_event_loop()
+    started = threading.Event()
+    port = []
+
+    async def serve():
+        server = await loop.create_server(lambda: _BoardProtocol(latency), "127.0.0.1", 0)
+        port.append(server.sockets[0].getsockname()[1])
+        started.set()
+
+    threading.Thread(target=loop.run_forever, daemon=True).start()
+    asyncio.run_coroutine_threadsafe(serve(), loop)
+    started.wait()
+    return port[0]
+
+
+class LegacyClient:
+    """The socket handling of the former connection.py: one send() per command
+    and replies read line by line"""
+
+    def __init__(self, host, port):
+        self.socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.socket.settimeout(10)
+        self.socket.connect((host, port))
+        self.buffer = ""
+        self.receive_message()  # auth challenge
+        self.send_message({"command": "auth", "password": PASSWORD})
+        self.receive_message()
+
+    def send_message(self, message):
+        self.socket.send((json.dumps(message) + "\n").encode())
+
+    def receive_message(self):
+        while "\n" not in self.buffer:
+            self.buffer += self.socket.recv(1024).decode()
+        line, self.buffer = self.buffer.split("\n", 1)
+        return json.loads(line)
+
+    def close(self):
+        self.socket.close()
+
+
+def rate(commands, seconds):
+    return commands / seconds if seconds > 0 else float("inf")
+
+
+def bench_legacy_round_trip(host, port, commands):
+    """Send, then wait for the reply before the next command"""
+    client = LegacyClient(host, port)
+    start = time.perf_counter()
+    for i in range(commands):
+        client.send_message({"command": "set_servo", "angle": i % 181})
+        client.receive_message()
+    elapsed = time.perf_counter() - start
+    client.close()
+    return rate(commands, elapsed)
+
+
+def bench_legacy_stream(host, port, commands):
+    """Send without waiting while a thread reads the replies, as the GUIs did"""
+    client = LegacyClient(host, port)
+    done = threading.Event()
+
+    def read_replies():
+        for _ in range(commands):
+            client.receive_message()
+        done.set()
+
+    threading.Thread(target=read_replies, daemon=True).start()
+    start = time.perf_counter()
+    for i in range(commands):
+        client.send_message({"command": "set_servo", "angle": i % 181})
+    done.wait()
+    elapsed = time.perf_counter() - start
+    client.close()
+    return rate(commands, elapsed)
+
+
+def bench_legacy_control(host, port, commands):
+    """control_servo() of the former connection.py, which slept 0.1 s and asked
+    for the status after every command"""
+    client = LegacyClient(host, port)
+    start = time.perf_counter()
+    for i in range(commands):
+        client.send_message({"command": "set_servo", "angle": i % 181})
+        time.sleep(0.1)
+        client.send_message({"command": "get_status"})
+    elapsed = time.perf_counter() - start
+    for _ in range(2 * commands):
+        client.receive_message()
+    client.close()
+    return rate(commands, elapsed)
+
+
+async def _async_client(host, port):
+    client = AsyncESP32Client(host, port, PASSWORD)
+    await client.connect()
+    await client.authenticate()
+    return client
+
+
+async def bench_async_requests(host, port, commands):
+    """Every command awaited for its reply, but all of them in flight at once"""
+    client = await _async_client(host, port)
+    start = time.perf_counter()
+    await asyncio.gather(*(client.set_servo(i % 181) for i in range(commands)))
+    elapsed = time.perf_counter() - start
+    await client.close()
+    return rate(commands, elapsed)
+
+
+async def bench_async_send(host, port, commands):
+    """Fire and forget, timed until the reply to the last command"""
+    client = await _async_client(host, port)
+    start = time.perf_counter()
+    for i in range(commands - 1):
+        client.send({"command": "set_servo", "angle": i % 181})
+        if i % 64 == 63:
+            await asyncio.sleep(0)
+    await client.set_servo(90)
+    elapsed = time.perf_counter() - start
+    await client.close()
+    return rate(commands, elapsed)
+
+
+def bench_parse(framer_type, decode, messages):
+    """Frame and decode a stream of LED board status pushes, messages per second"""
+    status = {"type": "status", "timestamp": 123456,
+              "leds": [{"id": i + 1, "state": i % 2 == 0} for i in range(5)],
+              "buttons": [{"id": i + 1, "pressed": False} for i in range(5)],
+              "potentiometer": {"raw": 2048, "voltage": 1.65, "percent": 50}, "servo": {"angle": 90}}
+    stream = protocol.python_encode(status) * messages
+    framer = framer_type()
+    start = time.perf_counter()
+    for offset in range(0, len(stream), 1460):
+        for line in framer.feed(stream[offset:offset + 1460]):
+            decode(line)
+    return rate(messages, time.perf_counter() - start)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--commands", type=int, default=5000)
+    parser.add_argument("--latency", type=float, default=5.0, help="reply delay of the local board in ms")
+    parser.add_argument("--host")
+    parser.add_argument("--port", type=int, default=8080)
+    args = parser.parse_args()
+
+    if args.host:
+        host, port = args.host, args.port
+        print(f"ESP32 at {host}:{port}, {args.commands} commands")
+    else:
+        host, port = "127.0.0.1", start_board(args.latency / 1000.0)
+        print(f"local board with {args.latency:g} ms reply latency, {args.commands} commands")
+
+    def report(name, run, commands):
+        print(f"{name:30s}{run(host, port, commands):10.0f} commands/s")
+
+    # The round trip is bounded by the latency, a few hundred commands suffice
+    round_trips = min(args.commands, max(20, int(2000 / max(args.latency, 1.0))))
+    report("legacy control_servo()", bench_legacy_control, 20)
+    report("legacy send + wait for reply", bench_legacy_round_trip, round_trips)
+    report("legacy send, replies threaded", bench_legacy_stream, args.commands)
+    report("async pipelined request()", lambda *a: asyncio.run(bench_async_requests(*a)), args.commands)
+    report("async send()", lambda *a: asyncio.run(bench_async_send(*a)), args.commands)
+
+    # Parsing, per TCP segment sized chunk of status pushes
+    print(f"python framing + json.loads   {bench_parse(protocol.PythonLineFramer, protocol.python_decode, 50000):10.0f} messages/s")
+    if protocol.NATIVE:
+        print(f"esp32proto framing + decode   {bench_parse(protocol.LineFramer, protocol.decode, 50000):10.0f} messages/s")
+    else:
+        print("esp32proto                    not built, see esp32proto/CMakeLists.txt")
+
+
+if __name__ == "__main__":
+    main()
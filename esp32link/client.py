@@ -0,0 +1,160 @@
+"""
+Blocking front end of AsyncESP32Client for the Tk applications
+
+All clients share one event loop running in a daemon thread. Commands are
+handed to it without waiting, so the GUI thread never blocks on the network,
+and callbacks are called from the loop thread; GUIs forward them to their
+own thread with root.after() or a queue.
+"""
+
+import asyncio
+import threading
+
+from .aio import AsyncESP32Client
+
+_loop = None
+_loop_lock = threading.Lock()
+
+
+def event_loop():
+    """The shared event loop, started on first use"""
+    global _loop
+    with _loop_lock:
+        if _loop is None:
+            _loop = asyncio.new_event_loop()
+            threading.Thread(target=_loop.run_forever, name="esp32link", daemon=True).start()
+    return _loop
+
+
+class ESP32Client:
+    def __init__(self, host, port=8080, auth_password="IoTDevice2024"):
+        self.host = host
+        self.port = port
+        self.auth_password = auth_password
+        self.running = False
+        self.error = ""
+        self.latest_status = {}
+        self.lock = threading.Lock()
+        self.connection_callbacks = []
+        self.status_callbacks = []
+        self.history_callbacks = []
+        self._loop = event_loop()
+        self._client = AsyncESP32Client(host, port, auth_password)
+        self._client.add_status_listener(self._on_status)
+        self._client.add_history_listener(self._on_history)
+        self._client.add_connection_listener(self._on_connection_lost)
+        self._closing = False
+
+    @property
+    def authenticated(self):
+        return self._client.authenticated
+
+    def register_connection_callback(self, callback):
+        """Register a callback for connection events"""
+        self.connection_callbacks.append(callback)
+
+    def register_status_callback(self, callback):
+        """Register a callback for status updates"""
+        self.status_callbacks.append(callback)
+
+    def register_history_callback(self, callback):
+        """Register a callback for blocks of telemetry history"""
+        self.history_callbacks.append(callback)
+
+    def _notify_connection_event(self, connected, message=""):
+        for callback in self.connection_callbacks:
+            callback(connected, message)
+
+    def _run(self, coroutine):
+        return asyncio.run_coroutine_threadsafe(coroutine, self._loop).result()
+
+    def _fail(self, message):
+        self.error = message
+        self._notify_connection_event(False, message)
+        return False
+
+    def connect(self):
+        """Establish connection to ESP32, blocks until connected or failed"""
+        try:
+            self._run(self._client.connect())
+            print(f"Connected to ESP32 at {self.host}:{self.port}")
+            return True
+        except Exception as e:
+            return self._fail(f"Could not connect: {e}")
+
+    def authenticate(self):
+        """Authenticate with ESP32, blocks until the reply arrives"""
+        try:
+            self._run(self._client.authenticate())
+        except Exception as e:
+            return self._fail(f"Authentication failed: {e}")
+        self._notify_connection_event(True, "Authentication successful")
+        return True
+
+    def start_monitoring(self):
+        """Start the keep-alive, status updates are delivered from connect() on"""
+        self.running = True
+        self._loop.call_soon_threadsafe(self._client.start_keep_alive)
+
+    def send_message(self, message):
+        """Queue a message for the ESP32 without waiting"""
+        self._loop.call_soon_threadsafe(self._send, message)
+
+    def _send(self, message):
+        try:
+            self._client.send(message)
+        except ConnectionError as e:
+            print(f"Send error: {e}")
+
+    def _on_status(self, status):
+        with self.lock:
+            self.latest_status = status
+        for callback in self.status_callbacks:
+            callback(status)
+
+    def _on_history(self, message):
+        for callback in self.history_callbacks:
+            callback(message)
+
+    def _on_connection_lost(self, exc):
+        self.running = False
+        if not self._closing:
+            self._notify_connection_event(False, f"Lost connection: {exc or 'closed by ESP32'}")
+
+    def control_led(self, led_number, state):
+        """Control an individual LED"""
+        self.send_message({"command": "set_led", "led": led_number, "state": state})
+
+    def control_all_leds(self, state):
+        """Control all LEDs at once"""
+        self.send_message({"command": "set_all_leds", "state": state})
+
+    def control_servo(self, angle, servo_index=None):
+        """Control servo position, servo_index selects one of the servo_server servos"""
+        message = {"command": "set_servo", "angle": angle}
+        if servo_index is not None:
+            message["servo_index"] = servo_index
+        self.send_message(message)
+
+    def get_status(self):
+        """Request current status, it arrives through the status callbacks"""
+        self.send_message({"command": "get_status"})
+
+    def ping(self):
+        """Send ping to ESP32"""
+        self.send_message({"command": "ping"})
+
+    def subscribe_history(self, since=0):
+        """Request the telemetry the ESP32 recorded after board time since,
+        it arrives through the history callbacks"""
+        self.send_message({"command": "subscribe_history", "since": since})
+
+    def close(self):
+        """Close connection to ESP32"""
+        self.running = False
+        self._closing = True
+        try:
+            self._run(self._client.close())
+        except Exception:
+            pass
+        self._notify_connection_event(False, "Disconnected")
@@ -0,0 +1,94 @@
+"""
+Commands sent per slider drag, with and without LatestValueSender
+
+usage: python -m esp32link.drag_bench [--duration s] [--events-per-second n] [--rate hz ...]
+
+Replays a drag of a 0-180° servo slider from one end to the other the way a
+Tk scale reports it: one command callback per pointer motion event, with a
+float position. Time is simulated, so the counts do not depend on the
+machine. For each sender rate the commands sent per drag are printed, and
+how far behind the slider the servo target got.
+"""
+
+import argparse
+import heapq
+
+from .throttle import LatestValueSender
+
+
+class _SimulatedTime:
+    """Clock and after() replacement driven by the replay"""
+
+    def __init__(self):
+        self.now = 0.0
+        self._timers = []
+        self._sequence = 0
+
+    def __call__(self):
+        return self.now
+
+    def after(self, delay_ms, callback):
+        self._sequence += 1
+        heapq.heappush(self._timers, (self.now + delay_ms / 1000.0, self._sequence, callback))
+
+    def advance(self, until):
+        while self._timers and self._timers[0][0] <= until:
+            due, _, callback = heapq.heappop(self._timers)
+            self.now = due
+            callback()
+        self.now = until
+
+
+def drag_positions(duration, events_per_second):
+    """(time, slider value) of the motion events of an end to end drag"""
+    events = max(2, int(duration * events_per_second))
+    return [(i / events_per_second, 180.0 * i / (events - 1)) for i in range(events)]
+
+
+def replay_unlimited(positions):
+    """The GUIs before: a command whenever the integer angle changed"""
+    sent = 0
+    last = None
+    for _, value in positions:
+        angle = int(value)
+        if angle != last:
+            last = angle
+            sent += 1
+    return sent, 0.0
+
+
+def replay_limited(positions, rate):
+    """Commands sent and the largest gap in degrees between slider and servo target"""
+    time = _SimulatedTime()
+    target = [None]
+    sender = LatestValueSender(lambda key, value: target.__setitem__(0, value), time.after, rate, time)
+    lag = 0.0
+    for when, value in positions:
+        time.advance(when)
+        if target[0] is not None:
+            lag = max(lag, abs(int(value) - target[0]))
+        sender.update(0, int(value))
+    # Release
+    sender.flush(0)
+    assert target[0] == int(positions[-1][1])
+    return sender.sent, lag
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--duration", type=float, default=0.5, help="length of the drag in seconds")
+    parser.add_argument("--events-per-second", type=float, default=250.0, help="pointer motion events")
+    parser.add_argument("--rate", type=float, nargs="*", default=[10.0, 20.0, 50.0], help="sender rates in Hz")
+    args = parser.parse_args()
+
+    positions = drag_positions(args.duration, args.events_per_second)
+    print(f"0-180° drag in {args.duration:g} s, {len(positions)} slider callbacks")
+    sent, _ = replay_unlimited(positions)
+    print(f"{'every angle change':24s}{sent:6d} commands/drag")
+    for rate in args.rate:
+        sent, lag = replay_limited(positions, rate)
+        print(f"{f'limited to {rate:g} Hz':24s}{sent:6d} commands/drag, target up to {lag:.0f}° behind")
+
+
+if __name__ == "__main__":
+    main()
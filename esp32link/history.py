@@ -0,0 +1,161 @@
+"""
+Telemetry history the LED board recorded while no client was connected
+
+The board samples the potentiometer, servo, LEDs and buttons into Gorilla
+encoded blocks (Esp-32_LED/src/TelemetryModule.cpp): timestamps as delta of
+delta, values as float32 XORed with the previous value. After
+subscribe_history it sends the blocks recorded after a given board time as
+"history" messages, between commands so live control is not delayed.
+HistoryBackfill asks for them when a client (re)connects and inserts the
+samples into the gap of a TimeSeriesStore.
+"""
+
+import array
+import base64
+import collections
+import threading
+import time
+
+# Status messages whose arrival times give the board clock offset
+OFFSET_SAMPLES = 16
+
+
+class _BitReader:
+    def __init__(self, data):
+        self._value = int.from_bytes(data, "big")
+        self._remaining = len(data) * 8
+
+    def read(self, count):
+        self._remaining -= count
+        if self._remaining < 0:
+            raise ValueError("history block is truncated")
+        return (self._value >> self._remaining) & ((1 << count) - 1)
+
+
+def _read_delta_of_delta(reader):
+    if not reader.read(1):
+        return 0
+    if not reader.read(1):
+        return reader.read(7) - 63
+    if not reader.read(1):
+        return reader.read(9) - 255
+    if not reader.read(1):
+        return reader.read(12) - 2047
+    value = reader.read(32)
+    return value - (1 << 32) if value >= 1 << 31 else value
+
+
+def decode_block(message):
+    """Board times in ms and {channel: values} of a history message"""
+    channels = message["channels"]
+    count = message["count"]
+    times = []
+    columns = [array.array("I") for _ in channels]
+    if count:
+        reader = _BitReader(base64.b64decode(message["data"]))
+        t = message["t0"]
+        delta = 0
+        previous = [reader.read(32) for _ in channels]
+        leading = [None] * len(channels)
+        trailing = [0] * len(channels)
+        for n in range(count):
+            if n:
+                delta += _read_delta_of_delta(reader)
+                t = (t + delta) & 0xFFFFFFFF
+                for i in range(len(channels)):
+                    if not reader.read(1):
+                        continue
+                    if reader.read(1):
+                        leading[i] = reader.read(5)
+                        length = reader.read(5) + 1
+                        trailing[i] = 32 - leading[i] - length
+                    else:
+                        length = 32 - leading[i] - trailing[i]
+                    previous[i] ^= reader.read(length) << trailing[i]
+            times.append(t)
+            for column, value in zip(columns, previous):
+                column.append(value)
+    # The bits are float32 values
+    return times, {name: array.array("f", column.tobytes()).tolist() for name, column in zip(channels, columns)}
+
+
+def board_time_after(t, since):
+    """Whether board time t is later than since, across millis() wrapping around"""
+    return 0 < (t - since) & 0xFFFFFFFF < 1 << 31
+
+
+class HistoryBackfill:
+    """Fills the gaps in a TimeSeriesStore from the board's recorded history
+
+    The board's millis() is mapped to wall clock time through the timestamps
+    of the recent status messages. Each arrival is late by the network and
+    scheduling delay, so the smallest wall clock minus board clock offset of
+    the last OFFSET_SAMPLES is used. After a reboot of the board the previous
+    board time is ahead of its clock and nothing is backfilled.
+    """
+
+    def __init__(self, store):
+        self.store = store
+        self._lock = threading.Lock()
+        self._board_time = None  # timestamp of the latest status
+        self._offset = None      # wall clock minus board clock in seconds
+        self._offsets = collections.deque(maxlen=OFFSET_SAMPLES)
+        self._since = 0
+        self._resume = None      # timestamp of the first status after begin()
+        self._waiting = False
+        self.samples = 0         # samples inserted, for the log
+        self.dropped = 0         # samples not inserted: outside the gap or before any status
+        self._callbacks = []
+
+    def attach(self, client):
+        """Follow the status and history messages of an ESP32Client or AsyncESP32Client"""
+        if hasattr(client, "register_status_callback"):
+            client.register_status_callback(self._on_status)
+            client.register_history_callback(self._on_history)
+        else:
+            client.add_status_listener(self._on_status)
+            client.add_history_listener(self._on_history)
+
+    def register_callback(self, callback):
+        """callback(inserted, dropped) after each history message, from the client thread"""
+        self._callbacks.append(callback)
+
+    def begin(self):
+        """Board time to pass to subscribe_history: the last status seen, or 0 for
+        everything the board kept when none was seen yet"""
+        with self._lock:
+            self._since = self._board_time or 0
+            self._resume = None
+            self._waiting = True
+            return self._since
+
+    def _on_status(self, status):
+        board_time = status.get("timestamp")
+        if isinstance(board_time, int):
+            with self._lock:
+                # The board clock restarted, the old offsets are meaningless
+                if self._board_time is not None and board_time_after(self._board_time, board_time):
+                    self._offsets.clear()
+                self._board_time = board_time
+                self._offsets.append(time.time() - board_time / 1000.0)
+                self._offset = min(self._offsets)
+                if self._waiting:
+                    self._resume, self._waiting = board_time, False
+
+    def _on_history(self, message):
+        times, columns = decode_block(message)
+        with self._lock:
+            since, resume, offset = self._since, self._resume, self._offset
+        inserted = 0
+        if offset is not None:
+            # Only the outage: after the last status before it, before the first one after it
+            keep = [i for i, t in enumerate(times)
+                    if (since == 0 or board_time_after(t, since)) and (resume is None or board_time_after(resume, t))]
+            wall_times = [offset + times[i] / 1000.0 for i in keep]
+            for name, values in columns.items():
+                inserted += self.store.backfill(name, wall_times, [values[i] for i in keep])
+        dropped = len(times) * len(columns) - inserted
+        self.samples += inserted
+        self.dropped += dropped
+        for callback in self._callbacks:
+            callback(inserted, dropped)
@@ -0,0 +1,68 @@
+"""
+Line based JSON protocol spoken by the ESP32 firmwares
+
+Every command is one JSON object per line and is answered by exactly one
+line, in order. Besides the replies the LED board sends an auth challenge
+when a client connects and pushes status messages ("type": "status") once a
+second, which are also the reply to get_status. After subscribe_history it
+also sends blocks of recorded telemetry ("type": "history") between replies.
+
+encode, decode and LineFramer come from the C++ protocol core in esp32proto/
+when its Python module is built, and from the pure Python versions below
+otherwise. Both produce the same messages.
+"""
+
+import json
+
+
+def python_encode(message):
+    """Serialize a message to one protocol line"""
+    return (json.dumps(message, separators=(",", ":")) + "\n").encode()
+
+
+def python_decode(line):
+    """Parse one protocol line, None when it is not a JSON object"""
+    try:
+        message = json.loads(line)
+    except ValueError:
+        return None
+    return message if isinstance(message, dict) else None
+
+
+class PythonLineFramer:
+    """Splits a byte stream into lines, keeping a partial line until the rest arrives"""
+
+    def __init__(self):
+        self._buffer = b""
+
+    def feed(self, data):
+        """Add received bytes, return the complete non-empty lines"""
+        if b"\n" not in data:
+            self._buffer += data
+            return []
+        lines = (self._buffer + data).split(b"\n")
+        self._buffer = lines.pop()
+        return [line for line in lines if line.strip()]
+
+
+try:
+    from ._esp32proto import LineFramer, decode, encode
+    NATIVE = True
+except ImportError:
+    encode, decode, LineFramer = python_encode, python_decode, PythonLineFramer
+    NATIVE = False
+
+
+def is_status(message):
+    """Status push, or the reply to get_status"""
+    return message.get("type") == "status"
+
+
+def is_history(message):
+    """Block of telemetry the board recorded, sent after subscribe_history"""
+    return message.get("type") == "history"
+
+
+def is_challenge(message):
+    """Auth challenge the LED board sends to new clients"""
+    return message.get("status") == "auth_required"
@@ -0,0 +1,73 @@
+"""
+Rate limiting of slider driven commands
+
+A Tk scale calls its command for every pointer motion, hundreds of times a
+second on a fast drag, while the firmwares handle one line at a time. The
+sender below passes on at most `rate` values a second per key (one key per
+servo), always the latest one, and sends what is still held back once the
+interval has passed or the slider is released.
+"""
+
+import math
+import time
+
+_NONE = object()
+
+
+class LatestValueSender:
+    def __init__(self, send, schedule, rate=20.0, clock=time.monotonic):
+        """send(key, value) sends a value, schedule(delay_ms, callback) runs
+        callback later on the GUI thread, e.g. a Tk widget's after()"""
+        self._send = send
+        self._schedule = schedule
+        self._clock = clock
+        self.interval = 1.0 / rate
+        self._last_time = {}
+        self._last_value = {}
+        self._pending = {}
+        self._timers = set()
+        # Totals since construction, for measuring how much a drag sends
+        self.updates = 0
+        self.sent = 0
+
+    def update(self, key, value):
+        """Take a new value, sent now if the key's interval has passed and later otherwise"""
+        self.updates += 1
+        if value == self._last_value.get(key, _NONE):
+            # Back where the last sent value was, nothing needs to go out
+            self._pending.pop(key, None)
+            return
+
+        wait = self._last_time.get(key, -math.inf) + self.interval - self._clock()
+        if wait <= 0:
+            self._pending.pop(key, None)
+            self._emit(key, value)
+            return
+
+        self._pending[key] = value
+        if key not in self._timers:
+            self._timers.add(key)
+            self._schedule(math.ceil(wait * 1000), lambda: self._on_timer(key))
+
+    def flush(self, key=None):
+        """Send the held back value of key, or of all keys, right away"""
+        for k in ([key] if key is not None else list(self._pending)):
+            value = self._pending.pop(k, _NONE)
+            if value is not _NONE:
+                self._emit(k, value)
+
+    def reset(self):
+        """Forget held back and sent values, e.g. after the connection was lost"""
+        self._pending.clear()
+        self._last_value.clear()
+        self._last_time.clear()
+
+    def _on_timer(self, key):
+        self._timers.discard(key)
+        self.flush(key)
+
+    def _emit(self, key, value):
+        self._last_time[key] = self._clock()
+        self._last_value[key] = value
+        self.sent += 1
+        self._send(key, value)
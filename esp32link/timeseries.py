@@ -0,0 +1,358 @@
+"""
+Client side time series store for status telemetry
+
+Every numeric field of the status messages becomes a signal, named by its
+path ("potentiometer.percent", "leds.3.state"; list entries by their "id").
+A signal keeps its raw samples and min/max/mean buckets of a few fixed
+widths, each in a ring buffer that drops the oldest entries when full. A
+query returns the finest level that covers the requested range in at most
+the requested number of points, so a plot of hours of data only ever
+touches about as many points as it has pixels.
+
+The store is saved as a columnar file: a JSON header followed by one float64
+column per level and field, oldest entry first.
+"""
+
+import array
+import collections
+import json
+import math
+import os
+import struct
+import sys
+import threading
+import time
+
+# Bucket widths of the downsampled levels in seconds
+DEFAULT_TIERS = (10.0, 60.0, 600.0)
+
+# Entries kept per level and signal, a day of 1 s status pushes for raw samples
+DEFAULT_CAPACITY = 100000
+
+_MAGIC = b"ESPTS\x01"
+
+# Bucket times are the start of the bucket
+Series = collections.namedtuple("Series", "times mins maxs means")
+
+
+def flatten(message, prefix=""):
+    """(signal name, value) of every number and bool in a status message"""
+    for key, value in message.items():
+        name = prefix + str(key)
+        if isinstance(value, (bool, int, float)):
+            yield name, float(value)
+        elif isinstance(value, dict):
+            yield from flatten(value, name + ".")
+        elif isinstance(value, list):
+            for index, item in enumerate(value):
+                if isinstance(item, dict):
+                    label = item.get("id", index)
+                    yield from flatten({k: v for k, v in item.items() if k != "id"}, f"{name}.{label}.")
+                elif isinstance(item, (bool, int, float)):
+                    yield f"{name}.{index}", float(item)
+
+
+class _Ring:
+    """Columns of float64 with a fixed capacity, the oldest row overwritten when full"""
+
+    def __init__(self, columns, capacity):
+        self.capacity = capacity
+        self.columns = [array.array("d") for _ in range(columns)]
+        self.start = 0
+        self.count = 0
+
+    def append(self, row):
+        if self.count < self.capacity:
+            for column, value in zip(self.columns, row):
+                column.append(value)
+            self.count += 1
+            return
+        for column, value in zip(self.columns, row):
+            column[self.start] = value
+        self.start = (self.start + 1) % self.capacity
+
+    @property
+    def full(self):
+        return self.count == self.capacity
+
+    def time(self, n):
+        return self.columns[0][(self.start + n) % self.capacity]
+
+    def index(self, t, right=False):
+        """Number of rows older than t, or not newer than t when right"""
+        lo, hi = 0, self.count
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if self.time(mid) < t or (right and self.time(mid) == t):
+                lo = mid + 1
+            else:
+                hi = mid
+        return lo
+
+    def slice(self, first, last):
+        """Rows first to last - 1, oldest first, one array per column"""
+        n = last - first
+        if n <= 0:
+            return [array.array("d") for _ in self.columns]
+        begin = (self.start + first) % self.capacity
+        if begin + n <= self.count:
+            return [column[begin:begin + n] for column in self.columns]
+        return [column[begin:] + column[:begin + n - self.count] for column in self.columns]
+
+    def ordered(self):
+        return self.slice(0, self.count)
+
+    def replace(self, columns):
+        """Hold the rows of columns instead, the newest capacity ones"""
+        self.columns = [column if len(column) <= self.capacity else column[-self.capacity:]
+                        for column in columns]
+        self.start = 0
+        self.count = len(self.columns[0])
+
+    def truncate(self, count):
+        """Keep the oldest count rows"""
+        if self.start:
+            self.replace(self.ordered())
+        for column in self.columns:
+            del column[count:]
+        self.count = count
+
+
+class _Tier:
+    """Buckets of a fixed width: the closed ones in a ring, the current one open"""
+
+    def __init__(self, width, capacity):
+        self.width = width
+        self.ring = _Ring(4, capacity)
+        self.open = None  # [start, min, max, sum, count]
+
+    def add(self, t, value):
+        start = math.floor(t / self.width) * self.width
+        bucket = self.open
+        if bucket is not None and bucket[0] == start:
+            bucket[1] = min(bucket[1], value)
+            bucket[2] = max(bucket[2], value)
+            bucket[3] += value
+            bucket[4] += 1
+            return
+        if bucket is not None:
+            self.ring.append((bucket[0], bucket[1], bucket[2], bucket[3] / bucket[4]))
+        self.open = [start, value, value, value, 1]
+
+
+# Raw samples on either side of a backfilled block that give the usual step
+_STEP_CONTEXT = 8
+
+
+def _median(values):
+    """Median of a list, 0 for an empty one"""
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    middle = len(ordered) // 2
+    return ordered[middle] if len(ordered) % 2 else (ordered[middle - 1] + ordered[middle]) / 2
+
+
+class _Signal:
+    def __init__(self, tiers, capacity):
+        self.raw = _Ring(2, capacity)
+        self.tiers = [_Tier(width, capacity) for width in tiers]
+
+    def add(self, t, value):
+        if self.raw.count and t < self.raw.time(self.raw.count - 1):
+            return  # Clock went backwards, the rings must stay sorted
+        self.raw.append((t, value))
+        for tier in self.tiers:
+            tier.add(t, value)
+
+    def backfill(self, times, values):
+        """Insert sorted samples where the raw samples have a gap: between two
+        raw samples further apart than twice the usual step of either. Samples
+        that overlap recorded ones are dropped. Returns the number inserted."""
+        raw = self.raw
+        if not times:
+            return 0
+        # Raw samples from the last one before the block to the first one after it
+        first, last = raw.index(times[0]), raw.index(times[-1], right=True)
+        bounds = ([raw.time(first - 1) if first else -math.inf] + list(raw.slice(first, last)[0])
+                  + [raw.time(last) if last < raw.count else math.inf])
+        # The usual raw step, from a few samples on either side as well, so a
+        # block inside one gap still sees the spacing around it
+        around = raw.slice(max(first - _STEP_CONTEXT, 0), min(last + _STEP_CONTEXT, raw.count))[0]
+        steps = [_median([b - a for a, b in zip(series, series[1:])]) for series in (times, around)]
+        threshold = 2.0 * max(steps)
+
+        groups = []  # (raw index, [sample index, ...]) of every gap the block fills
+        n = 0
+        for index, (after, before) in enumerate(zip(bounds, bounds[1:])):
+            while n < len(times) and times[n] <= after:
+                n += 1
+            group = []
+            while n < len(times) and times[n] < before:
+                group.append(n)
+                n += 1
+            if group and before - after > threshold:
+                groups.append((first + index, group))
+        if not groups:
+            return 0
+
+        # Once unwrapped, inserting only moves the samples after each gap,
+        # the last gap first so the indices of the earlier ones stay valid
+        t_column, value_column = raw.ordered() if raw.start else raw.columns
+        for index, group in reversed(groups):
+            t_column[index:index] = array.array("d", (times[n] for n in group))
+            value_column[index:index] = array.array("d", (values[n] for n in group))
+        raw.replace([t_column, value_column])
+
+        # Rebuild the buckets from the first changed one on from the raw samples
+        for tier in self.tiers:
+            start = math.floor(times[groups[0][1][0]] / tier.width) * tier.width
+            if tier.open is not None:
+                start = min(start, tier.open[0])
+            tier.ring.truncate(tier.ring.index(start))
+            tier.open = None
+            first = raw.index(start)
+            for t, value in zip(*raw.slice(first, raw.count)):
+                tier.add(t, value)
+        return sum(len(group) for _, group in groups)
+
+    def query(self, start, end, max_points):
+        levels = [(self.raw, None)] + [(tier.ring, tier) for tier in self.tiers]
+        for n, (ring, tier) in enumerate(levels):
+            first, last = ring.index(start), ring.index(end, right=True)
+            # A level that dropped data older than start leaves a gap, unless it is the last
+            covers = not ring.full or (ring.count and ring.time(0) <= start)
+            if (last - first <= max_points and covers) or n == len(levels) - 1:
+                break
+
+        columns = ring.slice(first, last)
+        if tier is None:
+            times, values = columns
+            return Series(times, values, values, values)
+        times, mins, maxs, means = columns
+        bucket = tier.open
+        if bucket is not None and start <= bucket[0] <= end:
+            times.append(bucket[0])
+            mins.append(bucket[1])
+            maxs.append(bucket[2])
+            means.append(bucket[3] / bucket[4])
+        return Series(times, mins, maxs, means)
+
+
+class TimeSeriesStore:
+    def __init__(self, tiers=DEFAULT_TIERS, capacity=DEFAULT_CAPACITY):
+        self.tiers = tuple(float(width) for width in tiers)
+        self.capacity = capacity
+        self._signals = {}
+        self._lock = threading.Lock()
+
+    def attach(self, client):
+        """Record the status messages of an ESP32Client or AsyncESP32Client"""
+        if hasattr(client, "register_status_callback"):
+            client.register_status_callback(self.add_status)
+        else:
+            client.add_status_listener(self.add_status)
+
+    def add_status(self, status, timestamp=None):
+        """Record every numeric field of a status message, at its arrival time by default"""
+        t = time.time() if timestamp is None else timestamp
+        with self._lock:
+            for name, value in flatten(status):
+                self._signal(name).add(t, value)
+
+    def add(self, name, value, timestamp=None):
+        """Record one sample of a signal"""
+        t = time.time() if timestamp is None else timestamp
+        with self._lock:
+            self._signal(name).add(t, float(value))
+
+    def signals(self):
+        with self._lock:
+            return sorted(self._signals)
+
+    def time_range(self, name):
+        """(oldest, newest) sample time of a signal, None when it has no samples"""
+        with self._lock:
+            signal = self._signals.get(name)
+            if signal is None or not signal.raw.count:
+                return None
+            oldest = [signal.raw.time(0)] + [tier.ring.time(0) for tier in signal.tiers if tier.ring.count]
+            return min(oldest), signal.raw.time(signal.raw.count - 1)
+
+    def query(self, name, start=None, end=None, max_points=1000):
+        """Samples or buckets of a signal between start and end, at most about
+        max_points of them. Raw samples have min == max == mean."""
+        with self._lock:
+            signal = self._signals.get(name)
+            if signal is None:
+                empty = array.array("d")
+                return Series(empty, empty, empty, empty)
+            return signal.query(-math.inf if start is None else start,
+                                math.inf if end is None else end, max_points)
+
+    def backfill(self, name, times, values):
+        """Insert samples recorded elsewhere while no status arrived, e.g. by the
+        board during a disconnect (see history.py). Only the samples that fall
+        into gaps of the recorded ones are taken. Returns how many were."""
+        with self._lock:
+            return self._signal(name).backfill(times, [float(value) for value in values])
+
+    def save(self, path):
+        """Write the store to path, replacing it atomically"""
+        with self._lock:
+            header = {"byteorder": sys.byteorder, "tiers": self.tiers, "capacity": self.capacity,
+                      "signals": []}
+            columns = []
+            for name, signal in self._signals.items():
+                levels = [signal.raw] + [tier.ring for tier in signal.tiers]
+                header["signals"].append({"name": name, "counts": [ring.count for ring in levels],
+                                          "open": [tier.open for tier in signal.tiers]})
+                for ring in levels:
+                    columns.extend(ring.ordered())
+
+        encoded = json.dumps(header).encode()
+        temporary = path + ".tmp"
+        with open(temporary, "wb") as f:
+            f.write(_MAGIC)
+            f.write(struct.pack("<I", len(encoded)))
+            f.write(encoded)
+            for column in columns:
+                column.tofile(f)
+        os.replace(temporary, path)
+
+    @classmethod
+    def load(cls, path):
+        """Read a store written by save(), raises ValueError for other files"""
+        with open(path, "rb") as f:
+            data = f.read()
+        if not data.startswith(_MAGIC):
+            raise ValueError(f"{path} is not a time series file")
+        offset = len(_MAGIC)
+        (length,) = struct.unpack_from("<I", data, offset)
+        offset += 4
+        header = json.loads(data[offset:offset + length])
+        offset += length
+
+        store = cls(header["tiers"], header["capacity"])
+        swap = header["byteorder"] != sys.byteorder
+        for entry in header["signals"]:
+            signal = store._signal(entry["name"])
+            levels = [signal.raw] + [tier.ring for tier in signal.tiers]
+            for ring, count in zip(levels, entry["counts"]):
+                for column in ring.columns:
+                    column.frombytes(data[offset:offset + 8 * count])
+                    if swap:
+                        column.byteswap()
+                    offset += 8 * count
+                ring.count = count
+            for tier, bucket in zip(signal.tiers, entry["open"]):
+                tier.open = bucket
+        if offset != len(data):
+            raise ValueError(f"{path} is truncated or corrupt")
+        return store
+
+    def _signal(self, name):
+        signal = self._signals.get(name)
+        if signal is None:
+            signal = self._signals[name] = _Signal(self.tiers, self.capacity)
+        return signal
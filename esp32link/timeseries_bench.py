@@ -0,0 +1,70 @@
+"""
+Recording and query times of TimeSeriesStore
+
+usage: python -m esp32link.timeseries_bench [--hours h] [--rate hz] [--points n]
+
+Records --hours of LED board status pushes arriving --rate times a second
+and times the queries a zoomable plot makes: the whole recording, an hour
+and a minute, each for --points points. Saving and loading the store are
+timed too.
+"""
+
+import argparse
+import math
+import os
+import tempfile
+import time
+
+from .timeseries import TimeSeriesStore
+
+
+def status(t):
+    percent = int(50 + 50 * math.sin(t / 300.0))
+    return {"type": "status", "timestamp": int(t * 1000),
+            "leds": [{"id": i + 1, "state": int(t / (60 * (i + 1))) % 2 == 0} for i in range(5)],
+            "buttons": [{"id": i + 1, "pressed": False} for i in range(5)],
+            "potentiometer": {"raw": percent * 4095 // 100, "voltage": percent * 0.033, "percent": percent},
+            "servo": {"angle": percent * 180 // 100}}
+
+
+def timed(function, repeat=1):
+    start = time.perf_counter()
+    for _ in range(repeat):
+        result = function()
+    return (time.perf_counter() - start) / repeat, result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--hours", type=float, default=8.0)
+    parser.add_argument("--rate", type=float, default=1.0, help="status pushes per second")
+    parser.add_argument("--points", type=int, default=1000, help="points per query, about a plot's width")
+    args = parser.parse_args()
+
+    store = TimeSeriesStore()
+    messages = int(args.hours * 3600 * args.rate)
+    t0 = 1.7e9
+    start = time.perf_counter()
+    for i in range(messages):
+        store.add_status(status(i / args.rate), t0 + i / args.rate)
+    elapsed = time.perf_counter() - start
+    signals = len(store.signals())
+    print(f"{messages} status messages, {signals} signals: {messages / elapsed:.0f} messages/s recorded")
+
+    oldest, newest = store.time_range("potentiometer.percent")
+    for name, span in (("whole recording", newest - oldest), ("last hour", 3600.0), ("last minute", 60.0)):
+        seconds, series = timed(
+            lambda: store.query("potentiometer.percent", newest - span, newest, args.points), 20)
+        print(f"query {name:16s}{seconds * 1000:8.2f} ms, {len(series.times)} points")
+
+    path = os.path.join(tempfile.mkdtemp(), "telemetry.ests")
+    seconds, _ = timed(lambda: store.save(path))
+    print(f"save {seconds * 1000:.0f} ms, {os.path.getsize(path) / 1e6:.1f} MB")
+    seconds, loaded = timed(lambda: TimeSeriesStore.load(path))
+    assert loaded.query("servo.angle", max_points=args.points) == store.query("servo.angle", max_points=args.points)
+    print(f"load {seconds * 1000:.0f} ms")
+    os.remove(path)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,416 @@
+#include "Client.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <future>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace esp32proto {
+
+namespace {
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+std::string systemError(const char* what) {
+    return std::string(what) + ": " + std::strerror(errno);
+}
+
+Json authCommand(const std::string& password) {
+    Json message = Json::object();
+    message.set("command", "auth");
+    message.set("password", password);
+    return message;
+}
+
+}
+
+Client::Client(ClientConfig config) : config(std::move(config)) {
+    int fds[2];
+    if (pipe(fds) == 0) {
+        wakeRead = fds[0];
+        wakeWrite = fds[1];
+        setNonBlocking(wakeRead);
+        setNonBlocking(wakeWrite);
+    }
+}
+
+Client::~Client() {
+    close();
+    if (wakeRead >= 0) ::close(wakeRead);
+    if (wakeWrite >= 0) ::close(wakeWrite);
+}
+
+int Client::openSocket(std::string& error) const {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICSERV;
+    addrinfo* addresses = nullptr;
+    int status = getaddrinfo(config.host.c_str(), std::to_string(config.port).c_str(), &hints, &addresses);
+    if (status != 0) {
+        error = std::string("Host not found: ") + gai_strerror(status);
+        return -1;
+    }
+
+    int socketFd = -1;
+    error = "No address to connect to";
+    for (addrinfo* address = addresses; address && socketFd < 0; address = address->ai_next) {
+        socketFd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (socketFd < 0) {
+            error = systemError("socket");
+            continue;
+        }
+        // Non-blocking connect so the timeout applies
+        setNonBlocking(socketFd);
+        if (::connect(socketFd, address->ai_addr, address->ai_addrlen) != 0 && errno != EINPROGRESS) {
+            error = systemError("Could not connect");
+        } else {
+            pollfd pending = {socketFd, POLLOUT, 0};
+            int ready = poll(&pending, 1, config.connectTimeoutMs);
+            int socketError = 0;
+            socklen_t length = sizeof(socketError);
+            getsockopt(socketFd, SOL_SOCKET, SO_ERROR, &socketError, &length);
+            if (ready == 1 && socketError == 0) continue;
+            error = ready == 0 ? std::string("Connection timed out")
+                               : std::string("Could not connect: ") + std::strerror(socketError ? socketError : errno);
+        }
+        ::close(socketFd);
+        socketFd = -1;
+    }
+    freeaddrinfo(addresses);
+    if (socketFd >= 0) {
+        // Commands are already coalesced, Nagle would only delay them
+        int noDelay = 1;
+        setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    }
+    return socketFd;
+}
+
+bool Client::connect(std::string* error) {
+    close();
+
+    std::string reason;
+    int socketFd = openSocket(reason);
+    if (socketFd < 0) {
+        if (error) *error = reason;
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fd = socketFd;
+        running = true;
+        stopping = false;
+        keepConnected = false;
+        authenticated = false;
+        status = Json();
+    }
+    framer.clear();
+    writing.clear();
+    ioThread = std::thread(&Client::run, this);
+
+    // The LED board's auth challenge needs no waiting for, it is skipped
+    // when it arrives
+    Json reply;
+    if (!request(authCommand(config.password), reply, config.connectTimeoutMs, &reason)) {
+        close();
+        if (error) *error = "Authentication failed: " + reason;
+        return false;
+    }
+    if (reply["status"].toString() != "success") {
+        close();
+        if (error) *error = "Authentication failed: " + reply["message"].toString();
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        authenticated = true;
+        keepConnected = true;
+    }
+    notifyConnection(true, "Authentication successful");
+    return true;
+}
+
+void Client::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        stopping = true;
+        keepConnected = false;
+    }
+    stateChanged.notify_all();
+    wake();
+    if (ioThread.joinable()) ioThread.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    running = false;
+    stopping = false;
+}
+
+bool Client::isConnected() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fd >= 0 && authenticated;
+}
+
+bool Client::send(const Json& message, std::string* error) {
+    return queue(message, nullptr, error);
+}
+
+bool Client::request(const Json& message, Json& reply, int timeoutMs, std::string* error) {
+    struct Result {
+        bool ok = false;
+        Json reply;
+        std::string error;
+    };
+    auto promise = std::make_shared<std::promise<Result>>();
+    std::future<Result> future = promise->get_future();
+    Completion done = [promise](const Json* reply, const std::string& error) {
+        Result result;
+        result.ok = reply != nullptr;
+        if (reply) result.reply = *reply;
+        result.error = error;
+        promise->set_value(std::move(result));
+    };
+    if (!queue(message, std::move(done), error)) return false;
+
+    if (future.wait_for(std::chrono::milliseconds(timeoutMs)) != std::future_status::ready) {
+        // The reply still consumes its place in the order when it arrives
+        if (error) *error = "Timed out waiting for the reply";
+        return false;
+    }
+    Result result = future.get();
+    if (!result.ok) {
+        if (error) *error = result.error;
+        return false;
+    }
+    reply = std::move(result.reply);
+    return true;
+}
+
+void Client::setStatusHandler(StatusHandler handler) {
+    // The previous handler is destroyed outside the lock
+    std::lock_guard<std::mutex> lock(handlerMutex);
+    std::swap(statusHandler, handler);
+}
+
+void Client::setHistoryHandler(HistoryHandler handler) {
+    std::lock_guard<std::mutex> lock(handlerMutex);
+    std::swap(historyHandler, handler);
+}
+
+void Client::setConnectionHandler(ConnectionHandler handler) {
+    std::lock_guard<std::mutex> lock(handlerMutex);
+    std::swap(connectionHandler, handler);
+}
+
+Json Client::latestStatus() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return status;
+}
+
+Client::Stats Client::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+bool Client::queue(const Json& message, Completion done, std::string* error) {
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fd < 0 || stopping) {
+            if (error) *error = "Not connected";
+            return false;
+        }
+        uint64_t id = matcher.add(message["command"].toString(), std::move(done));
+        wasEmpty = outgoing.empty();
+        outgoing += encodeCommand(message, id);
+        outgoingMessages++;
+    }
+    // A wakeup is already pending when the I/O thread has not taken the
+    // previous commands yet
+    if (wasEmpty) wake();
+    return true;
+}
+
+void Client::wake() {
+    char byte = 1;
+    if (wakeWrite >= 0 && write(wakeWrite, &byte, 1) < 0) {
+        // Pipe full, the thread wakes up anyway
+    }
+}
+
+void Client::run() {
+    std::string reason = serve();
+    int delayMs = config.reconnectDelayMs;
+    while (true) {
+        lost(reason);
+
+        int socketFd = -1;
+        while (socketFd < 0) {
+            {
+                // close() cuts the wait short
+                std::unique_lock<std::mutex> lock(mutex);
+                if (stopping || !config.reconnect || !keepConnected) return;
+                stateChanged.wait_for(lock, std::chrono::milliseconds(delayMs), [this] { return stopping; });
+                if (stopping) return;
+            }
+            socketFd = openSocket(reason);
+            delayMs = std::min(delayMs * 2, config.reconnectMaxDelayMs);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) {
+                ::close(socketFd);
+                return;
+            }
+            fd = socketFd;
+            counters.reconnects++;
+        }
+        delayMs = config.reconnectDelayMs;
+        framer.clear();
+        writing.clear();
+        reauthenticate();
+        reason = serve();
+    }
+}
+
+std::string Client::serve() {
+    char buffer[4096];
+    std::vector<std::string> lines;
+    int socketFd;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        socketFd = fd;
+    }
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) return "Disconnected";
+            if (!outgoing.empty()) {
+                writing += outgoing;
+                counters.messagesSent += outgoingMessages;
+                outgoing.clear();
+                outgoingMessages = 0;
+            }
+        }
+
+        // Everything queued since the last pass goes out in one call
+        if (!writing.empty()) {
+            ssize_t written = ::send(socketFd, writing.data(), writing.size(), MSG_NOSIGNAL);
+            if (written > 0) {
+                writing.erase(0, size_t(written));
+                std::lock_guard<std::mutex> lock(mutex);
+                counters.bytesSent += uint64_t(written);
+                counters.writes++;
+            } else if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                return systemError("Send failed");
+            }
+        }
+
+        pollfd fds[2] = {
+            {socketFd, static_cast<short>(POLLIN | (writing.empty() ? 0 : POLLOUT)), 0},
+            {wakeRead, POLLIN, 0},
+        };
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return systemError("poll");
+        }
+        if (fds[1].revents & POLLIN) {
+            char drain[64];
+            while (read(wakeRead, drain, sizeof(drain)) > 0) {
+            }
+        }
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t received = recv(socketFd, buffer, sizeof(buffer), 0);
+            if (received == 0) return "Connection closed by ESP32";
+            if (received < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+                return systemError("Receive failed");
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                counters.bytesReceived += uint64_t(received);
+            }
+            lines.clear();
+            framer.feed(buffer, size_t(received), lines);
+            for (const std::string& line : lines) dispatch(line);
+        }
+    }
+}
+
+void Client::dispatch(const std::string& line) {
+    Json message;
+    if (!Json::parse(line, message) || !message.isObject()) return;
+
+    const MessageKind kind = classify(message);
+    PendingCommand answered;
+    bool matched;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.messagesReceived++;
+        if (kind == MessageKind::Status) status = message;
+        matched = matcher.match(message, answered);
+    }
+    if (kind == MessageKind::Status) {
+        std::lock_guard<std::mutex> lock(handlerMutex);
+        if (statusHandler) statusHandler(message);
+    } else if (kind == MessageKind::History) {
+        std::lock_guard<std::mutex> lock(handlerMutex);
+        if (historyHandler) historyHandler(message);
+    }
+    if (matched && answered.done) answered.done(&message, std::string());
+}
+
+void Client::lost(const std::string& reason) {
+    std::vector<PendingCommand> failed;
+    bool wasAuthenticated;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        wasAuthenticated = authenticated;
+        authenticated = false;
+        failed = matcher.takeAll();
+        outgoing.clear();
+        outgoingMessages = 0;
+    }
+    for (PendingCommand& command : failed) {
+        if (command.done) command.done(nullptr, reason);
+    }
+    if (wasAuthenticated) notifyConnection(false, reason);
+}
+
+void Client::reauthenticate() {
+    queue(authCommand(config.password), [this](const Json* reply, const std::string&) {
+        // Without a reply the connection was lost again and run() retries
+        if (!reply) return;
+        if ((*reply)["status"].toString() != "success") {
+            notifyConnection(false, "Authentication failed: " + (*reply)["message"].toString());
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            authenticated = true;
+        }
+        notifyConnection(true, "Reconnected");
+    }, nullptr);
+}
+
+void Client::notifyConnection(bool connected, const std::string& message) {
+    std::lock_guard<std::mutex> lock(handlerMutex);
+    if (connectionHandler) connectionHandler(connected, message);
+}
+
+}
@@ -0,0 +1,112 @@
+#ifndef ESP32PROTO_CLIENT_H
+#define ESP32PROTO_CLIENT_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Json.h"
+#include "Protocol.h"
+
+namespace esp32proto {
+
+struct ClientConfig {
+    std::string host;
+    int port = 8080;
+    std::string password = "IoTDevice2024";
+    int connectTimeoutMs = 10000;
+    bool reconnect = true;            // reconnect and log in again after a lost connection
+    int reconnectDelayMs = 250;       // first retry, doubled up to reconnectMaxDelayMs
+    int reconnectMaxDelayMs = 5000;
+};
+
+// TCP client for the ESP32 firmwares with one I/O thread per connection.
+//
+// Commands are pipelined and everything queued while the thread was busy
+// goes out in a single write. Handlers are called from the I/O thread and
+// must not call close(). Methods may be called from any thread.
+class Client {
+public:
+    using StatusHandler = std::function<void(const Json& status)>;
+    using HistoryHandler = std::function<void(const Json& block)>;
+    using ConnectionHandler = std::function<void(bool connected, const std::string& message)>;
+
+    struct Stats {
+        uint64_t messagesSent = 0;
+        uint64_t bytesSent = 0;
+        uint64_t writes = 0;
+        uint64_t messagesReceived = 0;
+        uint64_t bytesReceived = 0;
+        uint64_t reconnects = 0;
+    };
+
+    explicit Client(ClientConfig config);
+    ~Client();
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    // Connects and logs in, blocking until the firmware answered
+    bool connect(std::string* error = nullptr);
+    void close();
+    bool isConnected() const;
+
+    // Queues a command without waiting for its reply
+    bool send(const Json& message, std::string* error = nullptr);
+    // Sends a command and waits up to timeoutMs for its reply
+    bool request(const Json& message, Json& reply, int timeoutMs = 5000, std::string* error = nullptr);
+
+    void setStatusHandler(StatusHandler handler);
+    void setHistoryHandler(HistoryHandler handler);
+    void setConnectionHandler(ConnectionHandler handler);
+
+    Json latestStatus() const;
+    Stats stats() const;
+
+private:
+    int openSocket(std::string& error) const;
+    bool queue(const Json& message, Completion done, std::string* error);
+    void wake();
+    void run();
+    std::string serve();
+    void dispatch(const std::string& line);
+    void lost(const std::string& reason);
+    void reauthenticate();
+    void notifyConnection(bool connected, const std::string& message);
+
+    ClientConfig config;
+    std::thread ioThread;
+    int wakeRead = -1;
+    int wakeWrite = -1;
+
+    mutable std::mutex mutex;
+    std::condition_variable stateChanged;
+    int fd = -1;
+    bool running = false;
+    bool stopping = false;
+    bool authenticated = false;
+    bool keepConnected = false;       // logged in once, reconnect when lost
+    ReplyMatcher matcher;
+    std::string outgoing;
+    size_t outgoingMessages = 0;
+    Json status;
+    Stats counters;
+
+    // Only touched by the I/O thread
+    LineFramer framer;
+    std::string writing;
+
+    // Handlers are called without holding mutex
+    std::mutex handlerMutex;
+    StatusHandler statusHandler;
+    HistoryHandler historyHandler;
+    ConnectionHandler connectionHandler;
+};
+
+}
+
+#endif
@@ -0,0 +1,411 @@
+#include "Json.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace esp32proto {
+
+class JsonParser {
+public:
+    JsonParser(const char* text, size_t size) : text(text), end(text + size) {}
+
+    bool parseDocument(Json& out) {
+        skipSpace();
+        if (!parseValue(out, 0)) return false;
+        skipSpace();
+        return pos == end || fail("Trailing characters");
+    }
+
+    std::string error;
+
+private:
+    static const int MAX_DEPTH = 32;
+
+    const char* text;
+    const char* end;
+    const char* pos = text;
+
+    bool fail(const char* message) {
+        if (error.empty()) error = std::string(message) + " at offset " + std::to_string(pos - text);
+        return false;
+    }
+
+    void skipSpace() {
+        while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n')) pos++;
+    }
+
+    bool consume(const char* literal) {
+        size_t length = std::strlen(literal);
+        if (size_t(end - pos) < length || std::memcmp(pos, literal, length) != 0) return false;
+        pos += length;
+        return true;
+    }
+
+    bool parseValue(Json& out, int depth) {
+        if (depth > MAX_DEPTH) return fail("Nesting too deep");
+        if (pos >= end) return fail("Unexpected end");
+
+        char c = *pos;
+        if (c == '{') return parseObject(out, depth);
+        if (c == '[') return parseArray(out, depth);
+        if (c == '"') {
+            out.valueType = Json::String;
+            return parseString(out.stringValue);
+        }
+        if (consume("true")) { out = Json(true); return true; }
+        if (consume("false")) { out = Json(false); return true; }
+        if (consume("null")) { out = Json(); return true; }
+        // Python writes these for non-finite floats
+        if (consume("NaN")) { out = Json(std::nan("")); return true; }
+        if (consume("Infinity")) { out = Json(HUGE_VAL); return true; }
+        if (consume("-Infinity")) { out = Json(-HUGE_VAL); return true; }
+        return parseNumber(out);
+    }
+
+    bool parseNumber(Json& out) {
+        const char* start = pos;
+        const char* p = pos;
+        if (p < end && *p == '-') p++;
+        bool integral = true;
+        while (p < end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-')) {
+            if (*p == '.' || *p == 'e' || *p == 'E') integral = false;
+            p++;
+        }
+        if (integral) {
+            int64_t value = 0;
+            std::from_chars_result result = std::from_chars(start, p, value);
+            if (result.ec == std::errc() && result.ptr == p && p > start) {
+                pos = p;
+                out = Json(value);
+                return true;
+            }
+            // Out of range integers fall back to double like JavaScript
+        }
+        double value = 0.0;
+        std::from_chars_result result = std::from_chars(start, p, value);
+        if (result.ec != std::errc() || result.ptr == start) return fail("Invalid value");
+        pos = result.ptr;
+        out = Json(value);
+        return true;
+    }
+
+    bool parseHex4(unsigned& code) {
+        if (end - pos < 4) return false;
+        std::from_chars_result result = std::from_chars(pos, pos + 4, code, 16);
+        if (result.ptr != pos + 4) return false;
+        pos += 4;
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out += char(code);
+        } else if (code < 0x800) {
+            out += char(0xC0 | (code >> 6));
+            out += char(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += char(0xE0 | (code >> 12));
+            out += char(0x80 | ((code >> 6) & 0x3F));
+            out += char(0x80 | (code & 0x3F));
+        } else {
+            out += char(0xF0 | (code >> 18));
+            out += char(0x80 | ((code >> 12) & 0x3F));
+            out += char(0x80 | ((code >> 6) & 0x3F));
+            out += char(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parseString(std::string& out) {
+        pos++; // opening quote
+        while (pos < end) {
+            // Copy runs of plain characters at once
+            const char* run = pos;
+            while (pos < end && *pos != '"' && *pos != '\\') pos++;
+            out.append(run, pos);
+            if (pos >= end) break;
+            if (*pos++ == '"') return true;
+            if (pos >= end) break;
+            char escaped = *pos++;
+            switch (escaped) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    unsigned code = 0;
+                    if (!parseHex4(code)) return fail("Bad escape");
+                    // Characters outside the BMP come as a surrogate pair
+                    if (code >= 0xD800 && code < 0xDC00 && end - pos >= 6 && pos[0] == '\\' && pos[1] == 'u') {
+                        const char* low = pos;
+                        pos += 2;
+                        unsigned second = 0;
+                        if (parseHex4(second) && second >= 0xDC00 && second < 0xE000) {
+                            code = 0x10000 + ((code - 0xD800) << 10) + (second - 0xDC00);
+                        } else {
+                            pos = low;
+                        }
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default: out += escaped; break;
+            }
+        }
+        return fail("Unterminated string");
+    }
+
+    bool parseArray(Json& out, int depth) {
+        out = Json::array();
+        pos++;
+        skipSpace();
+        if (pos < end && *pos == ']') { pos++; return true; }
+        while (true) {
+            out.arrayValue.emplace_back();
+            skipSpace();
+            if (!parseValue(out.arrayValue.back(), depth + 1)) return false;
+            skipSpace();
+            if (pos < end && *pos == ',') { pos++; continue; }
+            if (pos < end && *pos == ']') { pos++; return true; }
+            return fail("Expected , or ]");
+        }
+    }
+
+    bool parseObject(Json& out, int depth) {
+        out = Json::object();
+        pos++;
+        skipSpace();
+        if (pos < end && *pos == '}') { pos++; return true; }
+        while (true) {
+            skipSpace();
+            if (pos >= end || *pos != '"') return fail("Expected key");
+            std::string key;
+            if (!parseString(key)) return false;
+            skipSpace();
+            if (pos >= end || *pos != ':') return fail("Expected :");
+            pos++;
+            skipSpace();
+            Json value;
+            if (!parseValue(value, depth + 1)) return false;
+            out.set(key, std::move(value));
+            skipSpace();
+            if (pos < end && *pos == ',') { pos++; continue; }
+            if (pos < end && *pos == '}') { pos++; return true; }
+            return fail("Expected , or }");
+        }
+    }
+};
+
+namespace {
+
+// Python's float repr: shortest round trip digits, positional notation for
+// exponents from -4 to 15 and always a fraction or an exponent
+void appendDouble(std::string& out, double value) {
+    if (std::isnan(value)) { out += "NaN"; return; }
+    if (std::isinf(value)) { out += value < 0 ? "-Infinity" : "Infinity"; return; }
+
+    char buffer[64];
+    std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::scientific);
+    std::string scientific(buffer, result.ptr);
+    size_t e = scientific.find('e');
+    int exponent = std::atoi(scientific.c_str() + e + 1);
+    if (exponent < -4 || exponent >= 16) {
+        out += scientific;
+        return;
+    }
+
+    bool negative = scientific[0] == '-';
+    std::string digits;
+    for (size_t i = negative ? 1 : 0; i < e; i++) {
+        if (scientific[i] != '.') digits += scientific[i];
+    }
+    if (negative) out += '-';
+    if (exponent < 0) {
+        out += "0.";
+        out.append(size_t(-exponent - 1), '0');
+        out += digits;
+    } else if (size_t(exponent) + 1 >= digits.size()) {
+        out += digits;
+        out.append(size_t(exponent) + 1 - digits.size(), '0');
+        out += ".0";
+    } else {
+        out.append(digits, 0, size_t(exponent) + 1);
+        out += '.';
+        out.append(digits, size_t(exponent) + 1, std::string::npos);
+    }
+}
+
+void appendEscape(std::string& out, unsigned code) {
+    char escaped[8];
+    std::snprintf(escaped, sizeof(escaped), "\\u%04x", code);
+    out += escaped;
+}
+
+// Same output as json.dumps with ensure_ascii, which the Python clients use
+void appendQuoted(std::string& out, const std::string& value) {
+    out += '"';
+    for (size_t i = 0; i < value.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        switch (c) {
+            case '"': out += "\\\""; continue;
+            case '\\': out += "\\\\"; continue;
+            case '\n': out += "\\n"; continue;
+            case '\r': out += "\\r"; continue;
+            case '\t': out += "\\t"; continue;
+            case '\b': out += "\\b"; continue;
+            case '\f': out += "\\f"; continue;
+            default: break;
+        }
+        if (c < 0x20) {
+            appendEscape(out, c);
+        } else if (c < 0x80) {
+            out += char(c);
+        } else {
+            // Decode one UTF-8 sequence, invalid bytes pass as U+FFFD
+            int length = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 0;
+            unsigned code = length == 4 ? c & 0x07 : length == 3 ? c & 0x0F : c & 0x1F;
+            bool valid = length > 0 && i + length <= value.size();
+            for (int k = 1; valid && k < length; k++) {
+                unsigned char next = static_cast<unsigned char>(value[i + k]);
+                valid = (next & 0xC0) == 0x80;
+                code = (code << 6) | (next & 0x3F);
+            }
+            if (!valid) {
+                appendEscape(out, 0xFFFD);
+                continue;
+            }
+            i += length - 1;
+            if (code >= 0x10000) {
+                code -= 0x10000;
+                appendEscape(out, 0xD800 + (code >> 10));
+                appendEscape(out, 0xDC00 + (code & 0x3FF));
+            } else {
+                appendEscape(out, code);
+            }
+        }
+    }
+    out += '"';
+}
+
+}
+
+Json Json::array() {
+    Json json;
+    json.valueType = Array;
+    return json;
+}
+
+Json Json::object() {
+    Json json;
+    json.valueType = Object;
+    return json;
+}
+
+bool Json::parse(const char* text, size_t size, Json& out, std::string* error) {
+    out = Json();
+    JsonParser parser(text, size);
+    if (parser.parseDocument(out)) return true;
+    if (error) *error = parser.error;
+    out = Json();
+    return false;
+}
+
+bool Json::toBool() const {
+    if (valueType == Bool) return boolValue;
+    if (valueType == Integer) return integerValue != 0;
+    return valueType == Double && doubleValue != 0.0;
+}
+
+int64_t Json::toInteger(int64_t fallback) const {
+    if (valueType == Integer) return integerValue;
+    if (valueType == Double && std::isfinite(doubleValue)) return int64_t(doubleValue);
+    return fallback;
+}
+
+double Json::toDouble(double fallback) const {
+    if (valueType == Double) return doubleValue;
+    if (valueType == Integer) return double(integerValue);
+    return fallback;
+}
+
+const std::string& Json::toString() const {
+    static const std::string empty;
+    return valueType == String ? stringValue : empty;
+}
+
+const Json* Json::find(const std::string& key) const {
+    if (valueType != Object) return nullptr;
+    for (const auto& item : objectValue) {
+        if (item.first == key) return &item.second;
+    }
+    return nullptr;
+}
+
+const Json& Json::operator[](const std::string& key) const {
+    static const Json null;
+    const Json* value = find(key);
+    return value ? *value : null;
+}
+
+Json& Json::set(const std::string& key, Json value) {
+    if (valueType != Object) *this = object();
+    for (auto& item : objectValue) {
+        if (item.first == key) {
+            item.second = std::move(value);
+            return item.second;
+        }
+    }
+    objectValue.emplace_back(key, std::move(value));
+    return objectValue.back().second;
+}
+
+Json& Json::push(Json value) {
+    if (valueType != Array) *this = array();
+    arrayValue.push_back(std::move(value));
+    return arrayValue.back();
+}
+
+size_t Json::size() const {
+    if (valueType == Array) return arrayValue.size();
+    if (valueType == Object) return objectValue.size();
+    return 0;
+}
+
+std::string Json::dump() const {
+    std::string out;
+    dumpTo(out);
+    return out;
+}
+
+void Json::dumpTo(std::string& out) const {
+    switch (valueType) {
+        case Null: out += "null"; break;
+        case Bool: out += boolValue ? "true" : "false"; break;
+        case Integer: out += std::to_string(integerValue); break;
+        case Double: appendDouble(out, doubleValue); break;
+        case String: appendQuoted(out, stringValue); break;
+        case Array:
+            out += '[';
+            for (size_t i = 0; i < arrayValue.size(); i++) {
+                if (i > 0) out += ',';
+                arrayValue[i].dumpTo(out);
+            }
+            out += ']';
+            break;
+        case Object:
+            out += '{';
+            for (size_t i = 0; i < objectValue.size(); i++) {
+                if (i > 0) out += ',';
+                appendQuoted(out, objectValue[i].first);
+                out += ':';
+                objectValue[i].second.dumpTo(out);
+            }
+            out += '}';
+            break;
+    }
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef ESP32PROTO_JSON_H
+#define ESP32PROTO_JSON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace esp32proto {
+
+// JSON value for the protocol messages. Objects keep their keys in order and
+// integers stay integers, so a message written by dump() reads the same as
+// one written by Python's json.dumps with compact separators.
+class Json {
+public:
+    enum Type { Null, Bool, Integer, Double, String, Array, Object };
+
+    Json() = default;
+    Json(bool value) : valueType(Bool), boolValue(value) {}
+    Json(int value) : valueType(Integer), integerValue(value) {}
+    Json(int64_t value) : valueType(Integer), integerValue(value) {}
+    Json(double value) : valueType(Double), doubleValue(value) {}
+    Json(const char* value) : valueType(String), stringValue(value) {}
+    Json(std::string value) : valueType(String), stringValue(std::move(value)) {}
+
+    static Json array();
+    static Json object();
+
+    static bool parse(const char* text, size_t size, Json& out, std::string* error = nullptr);
+    static bool parse(const std::string& text, Json& out, std::string* error = nullptr) {
+        return parse(text.data(), text.size(), out, error);
+    }
+
+    Type type() const { return valueType; }
+    bool isNull() const { return valueType == Null; }
+    bool isNumber() const { return valueType == Integer || valueType == Double; }
+    bool isString() const { return valueType == String; }
+    bool isArray() const { return valueType == Array; }
+    bool isObject() const { return valueType == Object; }
+
+    // Forgiving like ArduinoJson: the wrong type reads as false / 0 / "",
+    // numbers read as true when they are not 0
+    bool toBool() const;
+    int64_t toInteger(int64_t fallback = 0) const;
+    double toDouble(double fallback = 0.0) const;
+    const std::string& toString() const;
+
+    // Objects
+    const Json* find(const std::string& key) const;
+    bool contains(const std::string& key) const { return find(key) != nullptr; }
+    const Json& operator[](const std::string& key) const;
+    Json& set(const std::string& key, Json value);
+    const std::vector<std::pair<std::string, Json>>& items() const { return objectValue; }
+
+    // Arrays
+    const std::vector<Json>& elements() const { return arrayValue; }
+    Json& push(Json value);
+    size_t size() const;
+
+    std::string dump() const;
+    void dumpTo(std::string& out) const;
+
+private:
+    friend class JsonParser;
+
+    Type valueType = Null;
+    bool boolValue = false;
+    int64_t integerValue = 0;
+    double doubleValue = 0.0;
+    std::string stringValue;
+    std::vector<Json> arrayValue;
+    std::vector<std::pair<std::string, Json>> objectValue;
+};
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+#include "Protocol.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esp32proto {
+
+MessageKind classify(const Json& message) {
+    if (message["type"].toString() == "status") return MessageKind::Status;
+    if (message["type"].toString() == "history") return MessageKind::History;
+    if (message["status"].toString() == "auth_required") return MessageKind::Challenge;
+    return MessageKind::Reply;
+}
+
+std::string encodeCommand(const Json& message, uint64_t id) {
+    Json numbered = message;
+    numbered.set("id", Json(int64_t(id)));
+    std::string line;
+    numbered.dumpTo(line);
+    line += '\n';
+    return line;
+}
+
+void LineFramer::feed(const char* data, size_t size, std::vector<std::string>& lines) {
+    const char* end = data + size;
+    const char* newline = static_cast<const char*>(std::memchr(data, '\n', size));
+    if (!newline) {
+        buffer.append(data, size);
+        return;
+    }
+
+    auto emit = [&lines](const char* begin, const char* stop) {
+        if (std::any_of(begin, stop, [](char c) { return c != ' ' && c != '\t' && c != '\r'; }))
+            lines.emplace_back(begin, stop);
+    };
+    // The first line completes the buffered partial one
+    buffer.append(data, newline);
+    emit(buffer.data(), buffer.data() + buffer.size());
+    buffer.clear();
+
+    const char* start = newline + 1;
+    while ((newline = static_cast<const char*>(std::memchr(start, '\n', size_t(end - start))))) {
+        emit(start, newline);
+        start = newline + 1;
+    }
+    buffer.assign(start, end);
+}
+
+uint64_t ReplyMatcher::add(const std::string& command, Completion done) {
+    pending.push_back({++nextId, command, std::move(done)});
+    return nextId;
+}
+
+bool ReplyMatcher::match(const Json& message, PendingCommand& out) {
+    if (pending.empty()) return false;
+
+    switch (classify(message)) {
+        case MessageKind::Challenge:
+        case MessageKind::History:
+            return false;
+        case MessageKind::Status:
+            // A push that arrives before the reply is as recent as the reply
+            if (pending.front().command != "get_status") return false;
+            break;
+        case MessageKind::Reply:
+            if (const Json* id = message.find("id")) {
+                for (auto it = pending.begin(); it != pending.end(); ++it) {
+                    if (int64_t(it->id) == id->toInteger(-1)) {
+                        out = std::move(*it);
+                        pending.erase(it);
+                        return true;
+                    }
+                }
+            }
+            break;
+    }
+    out = std::move(pending.front());
+    pending.pop_front();
+    return true;
+}
+
+std::vector<PendingCommand> ReplyMatcher::takeAll() {
+    std::vector<PendingCommand> all(std::make_move_iterator(pending.begin()), std::make_move_iterator(pending.end()));
+    pending.clear();
+    return all;
+}
+
+}
@@ -0,0 +1,71 @@
+#ifndef ESP32PROTO_PROTOCOL_H
+#define ESP32PROTO_PROTOCOL_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Json.h"
+
+// Line based JSON protocol of the ESP32 firmwares, without any I/O.
+//
+// Every command is one JSON object per line and is answered by exactly one
+// line, in order. Besides the replies the LED board sends an auth challenge
+// when a client connects and pushes status messages ("type": "status") once
+// a second, which are also the reply to get_status. After subscribe_history it
+// also sends blocks of recorded telemetry ("type": "history") between replies.
+// These are the same rules esp32link/protocol.py and esp32link/aio.py follow
+// in Python.
+namespace esp32proto {
+
+enum class MessageKind { Reply, Status, Challenge, History };
+
+MessageKind classify(const Json& message);
+
+// One protocol line for message, with the request id added
+std::string encodeCommand(const Json& message, uint64_t id);
+
+// Splits a byte stream into lines, keeping a partial line until the rest arrives
+class LineFramer {
+public:
+    // Appends the complete non-empty lines to lines
+    void feed(const char* data, size_t size, std::vector<std::string>& lines);
+    void clear() { buffer.clear(); }
+
+private:
+    std::string buffer;
+};
+
+// Called with the reply, or with nullptr and the reason the command failed
+using Completion = std::function<void(const Json* reply, const std::string& error)>;
+
+struct PendingCommand {
+    uint64_t id = 0;
+    std::string command;
+    Completion done;
+};
+
+// Matches replies to pipelined commands. Commands are answered in order;
+// a reply that echoes the request id is matched by id instead.
+class ReplyMatcher {
+public:
+    uint64_t add(const std::string& command, Completion done);
+
+    // Removes the command message answers into out, false when it answers none
+    bool match(const Json& message, PendingCommand& out);
+
+    // Removes all unanswered commands, for failing them on a lost connection
+    std::vector<PendingCommand> takeAll();
+
+    size_t size() const { return pending.size(); }
+
+private:
+    std::deque<PendingCommand> pending;
+    uint64_t nextId = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,242 @@
+// Python bindings of the protocol core, imported by esp32link as _esp32proto.
+//
+// The GIL is released while the client waits on the network; handlers are
+// called from the I/O thread with the GIL taken for the call only.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pybind11/pybind11.h>
+
+#include "Client.h"
+#include "Json.h"
+#include "Protocol.h"
+
+namespace py = pybind11;
+using esp32proto::Json;
+
+namespace {
+
+py::object toPython(const Json& value) {
+    switch (value.type()) {
+        case Json::Null: return py::none();
+        case Json::Bool: return py::bool_(value.toBool());
+        case Json::Integer: return py::int_(value.toInteger());
+        case Json::Double: return py::float_(value.toDouble());
+        case Json::String: {
+            const std::string& text = value.toString();
+            PyObject* string = PyUnicode_DecodeUTF8(text.data(), Py_ssize_t(text.size()), "replace");
+            if (!string) throw py::error_already_set();
+            return py::reinterpret_steal<py::object>(string);
+        }
+        case Json::Array: {
+            py::list list(value.size());
+            for (size_t i = 0; i < value.size(); i++) list[i] = toPython(value.elements()[i]);
+            return std::move(list);
+        }
+        case Json::Object: {
+            py::dict dict;
+            for (const auto& item : value.items()) dict[py::str(item.first)] = toPython(item.second);
+            return std::move(dict);
+        }
+    }
+    return py::none();
+}
+
+// Accepts what json.dumps accepts for the protocol: dicts, lists, tuples,
+// strings, numbers, booleans and None
+Json fromPython(py::handle value) {
+    if (value.is_none()) return Json();
+    if (py::isinstance<py::bool_>(value)) return Json(value.cast<bool>());
+    if (py::isinstance<py::int_>(value)) {
+        try {
+            return Json(value.cast<int64_t>());
+        } catch (const py::cast_error&) {
+            return Json(value.cast<double>());
+        }
+    }
+    if (py::isinstance<py::float_>(value)) return Json(value.cast<double>());
+    if (py::isinstance<py::str>(value)) return Json(value.cast<std::string>());
+    if (py::isinstance<py::dict>(value)) {
+        Json object = Json::object();
+        for (auto item : value.cast<py::dict>()) object.set(py::str(item.first).cast<std::string>(), fromPython(item.second));
+        return object;
+    }
+    if (py::isinstance<py::list>(value) || py::isinstance<py::tuple>(value)) {
+        Json array = Json::array();
+        for (py::handle element : value) array.push(fromPython(element));
+        return array;
+    }
+    throw py::type_error("Object of type " + py::str(value.get_type().attr("__name__")).cast<std::string>()
+                         + " is not JSON serializable");
+}
+
+std::string bytesOrString(py::handle line) {
+    if (py::isinstance<py::bytes>(line)) return line.cast<std::string>();
+    if (py::isinstance<py::str>(line)) return line.cast<std::string>();
+    throw py::type_error("expected bytes or str");
+}
+
+// A Python callable that the I/O thread may copy and drop without the GIL
+std::shared_ptr<py::object> share(py::object callable) {
+    return std::shared_ptr<py::object>(new py::object(std::move(callable)), [](py::object* object) {
+        py::gil_scoped_acquire acquire;
+        delete object;
+    });
+}
+
+// Releases the GIL while the client shuts down, since the I/O thread may be
+// waiting for it in a handler
+class PyClient {
+public:
+    explicit PyClient(esp32proto::ClientConfig config) : client(std::move(config)) {}
+    ~PyClient() {
+        py::gil_scoped_release release;
+        client.close();
+    }
+
+    esp32proto::Client client;
+};
+
+[[noreturn]] void raisePython(PyObject* type, const std::string& message) {
+    PyErr_SetString(type, message.c_str());
+    throw py::error_already_set();
+}
+
+}
+
+PYBIND11_MODULE(_esp32proto, m) {
+    m.doc() = "C++ protocol core of the ESP32 clients";
+
+    m.def("decode", [](py::handle line) -> py::object {
+        Json message;
+        std::string text = bytesOrString(line);
+        if (!Json::parse(text, message) || !message.isObject()) return py::none();
+        return toPython(message);
+    }, "Parse one protocol line, None when it is not a JSON object");
+
+    m.def("encode", [](py::handle message) {
+        std::string line = fromPython(message).dump();
+        line += '\n';
+        return py::bytes(line);
+    }, "Serialize a message to one protocol line");
+
+    py::class_<esp32proto::LineFramer>(m, "LineFramer")
+        .def(py::init<>())
+        .def("feed", [](esp32proto::LineFramer& framer, py::bytes data) {
+            char* buffer = nullptr;
+            Py_ssize_t size = 0;
+            PyBytes_AsStringAndSize(data.ptr(), &buffer, &size);
+            std::vector<std::string> lines;
+            framer.feed(buffer, size_t(size), lines);
+            py::list result(lines.size());
+            for (size_t i = 0; i < lines.size(); i++) result[i] = py::bytes(lines[i]);
+            return result;
+        }, "Add received bytes, return the complete non-empty lines");
+
+    py::class_<PyClient>(m, "Client")
+        .def(py::init([](std::string host, int port, std::string password, bool reconnect, double connectTimeout) {
+            esp32proto::ClientConfig config;
+            config.host = std::move(host);
+            config.port = port;
+            config.password = std::move(password);
+            config.reconnect = reconnect;
+            config.connectTimeoutMs = int(connectTimeout * 1000.0);
+            return new PyClient(std::move(config));
+        }), py::arg("host"), py::arg("port") = 8080, py::arg("auth_password") = "IoTDevice2024",
+            py::arg("reconnect") = true, py::arg("connect_timeout") = 10.0)
+        .def("connect", [](PyClient& self) {
+            std::string error;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = self.client.connect(&error);
+            }
+            if (!ok) raisePython(PyExc_ConnectionError, error);
+        }, "Connect and log in, raises ConnectionError")
+        .def("close", [](PyClient& self) { self.client.close(); }, py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("connected", [](PyClient& self) { return self.client.isConnected(); })
+        .def("send", [](PyClient& self, py::dict message) {
+            Json command = fromPython(message);
+            std::string error;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = self.client.send(command, &error);
+            }
+            if (!ok) raisePython(PyExc_ConnectionError, error);
+        }, py::arg("message"), "Queue a command without waiting for its reply")
+        .def("request", [](PyClient& self, py::dict message, double timeout) {
+            Json command = fromPython(message);
+            Json reply;
+            std::string error;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = self.client.request(command, reply, int(timeout * 1000.0), &error);
+            }
+            if (!ok) {
+                // Client::request() reports a missing reply as "Timed out ..."
+                raisePython(error.rfind("Timed out", 0) == 0 ? PyExc_TimeoutError : PyExc_ConnectionError, error);
+            }
+            return toPython(reply);
+        }, py::arg("message"), py::arg("timeout") = 5.0, "Send a command and return its reply")
+        .def("set_status_handler", [](PyClient& self, py::object callback) {
+            esp32proto::Client::StatusHandler handler;
+            if (!callback.is_none()) {
+                handler = [callable = share(std::move(callback))](const Json& status) {
+                    py::gil_scoped_acquire acquire;
+                    try {
+                        (*callable)(toPython(status));
+                    } catch (py::error_already_set& error) {
+                        error.discard_as_unraisable("esp32proto status handler");
+                    }
+                };
+            }
+            py::gil_scoped_release release;
+            self.client.setStatusHandler(std::move(handler));
+        }, "Call callback(status) from the I/O thread for every status message")
+        .def("set_history_handler", [](PyClient& self, py::object callback) {
+            esp32proto::Client::HistoryHandler handler;
+            if (!callback.is_none()) {
+                handler = [callable = share(std::move(callback))](const Json& block) {
+                    py::gil_scoped_acquire acquire;
+                    try {
+                        (*callable)(toPython(block));
+                    } catch (py::error_already_set& error) {
+                        error.discard_as_unraisable("esp32proto history handler");
+                    }
+                };
+            }
+            py::gil_scoped_release release;
+            self.client.setHistoryHandler(std::move(handler));
+        }, "Call callback(block) from the I/O thread for every block of telemetry history")
+        .def("set_connection_handler", [](PyClient& self, py::object callback) {
+            esp32proto::Client::ConnectionHandler handler;
+            if (!callback.is_none()) {
+                handler = [callable = share(std::move(callback))](bool connected, const std::string& message) {
+                    py::gil_scoped_acquire acquire;
+                    try {
+                        (*callable)(connected, message);
+                    } catch (py::error_already_set& error) {
+                        error.discard_as_unraisable("esp32proto connection handler");
+                    }
+                };
+            }
+            py::gil_scoped_release release;
+            self.client.setConnectionHandler(std::move(handler));
+        }, "Call callback(connected, message) from the I/O thread on connection changes")
+        .def_property_readonly("latest_status", [](PyClient& self) { return toPython(self.client.latestStatus()); })
+        .def_property_readonly("stats", [](PyClient& self) {
+            esp32proto::Client::Stats stats = self.client.stats();
+            py::dict result;
+            result["messages_sent"] = stats.messagesSent;
+            result["bytes_sent"] = stats.bytesSent;
+            result["writes"] = stats.writes;
+            result["messages_received"] = stats.messagesReceived;
+            result["bytes_received"] = stats.bytesReceived;
+            result["reconnects"] = stats.reconnects;
+            return result;
+        });
+}
@@ -1,103 +1,21 @@
 import tkinter as tk
 from tkinter import ttk, messagebox
-import socket
-import json
 import threading
 import queue
 import os
 import sys
 
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", ".."))
+
+from esp32link import ESP32Client, LatestValueSender
+
 # --- Configuration ---
 CONFIG_FILE = "esp32_connection.conf"
 DEFAULT_IP = "192.168.1.100" # Change if your ESP32 has a different IP
 DEFAULT_PORT = 8080
 AUTH_PASSWORD = "IoTDevice2024"
 NUM_SERVOS = 4
-
-class ESP32ClientThread(threading.Thread):
-    # This entire class is correct and has no changes.
-    # ... (code from previous response is unchanged) ...
-    def __init__(self, host, port, gui_queue):
-        super().__init__()
-        self.host = host
-        self.port = port
-        self.gui_queue = gui_queue
-        self.sock = None
-        self.is_running = True
-        self.is_authenticated = False
-
-    def run(self):
-        try:
-            self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)   #what is this
-            self.sock.settimeout(5.0)
-            self.sock.connect((self.host, self.port))
-            self.sock.settimeout(1.0)
-            
-            self._send_command({"command": "auth", "password": AUTH_PASSWORD})
-
-            buffer = ""
-            while self.is_running:
-                try:
-                    data = self.sock.recv(1024)
-                    if not data:
-                        self._report_disconnected()
-                        break
-                    buffer += data.decode('utf-8')
-                    while '\n' in buffer:
-                        message_str, buffer = buffer.split('\n', 1)
-                        if message_str: self._process_server_message(message_str)
-                except socket.timeout:
-                    continue
-                except Exception as e:
-                    self._report_error(f"Receive error: {e}"); break
-        except socket.timeout:
-            self._report_error("Connection timed out. Check IP and server status.")
-        except ConnectionRefusedError:
-            self._report_error("Connection refused. Is the ESP32 server running?")
-        except Exception as e:
-            self._report_error(f"Connection failed: {e}")
-        finally:
-            self._report_disconnected()
-            self.close()
-
-    def _process_server_message(self, message_str):
-        try:
-            message = json.loads(message_str)
-            if message.get("status") == "success":
-                if not self.is_authenticated:
-                    self.is_authenticated = True
-                    self.gui_queue.put({"status": "connected"})
-            elif message.get("status") == "error":
-                self._report_error(f"ESP32 Error: {message.get('message', 'Unknown')}")
-        except json.JSONDecodeError:
-            print(f"Received non-JSON message: {message_str}")
-
-    def _send_command(self, command_dict):
-        if self.sock and self.is_running:
-            try:
-                message = json.dumps(command_dict) + "\n"
-                self.sock.sendall(message.encode('utf-8'))
-            except Exception as e:
-                self._report_error(f"Send error: {e}")
-
-    def send_servo_command(self, servo_index, angle):
-        if self.is_authenticated:
-            self._send_command({"command": "set_servo", "servo_index": servo_index, "angle": angle})
-
-    def _report_error(self, error_msg):
-        if self.is_running: self.gui_queue.put({"status": "error", "message": error_msg})
-
-    def _report_disconnected(self):
-        if self.is_running: self.gui_queue.put({"status": "disconnected"})
-
-    def close(self):
-        self.is_running = False
-        if self.sock:
-            try: self.sock.shutdown(socket.SHUT_RDWR); self.sock.close()
-            except OSError: pass
-            self.sock = None
-        self.is_authenticated = False
-
+SERVO_SEND_RATE_HZ = 20 # Slider commands per second and servo while dragging
 
 class ServoControllerApp(tk.Tk):
     def __init__(self):
@@ -106,11 +24,11 @@ class ServoControllerApp(tk.Tk):
         self.geometry("450x450")
         self.resizable(False, False)
 
-        self.client_thread = None
+        self.client = None
         self.gui_queue = queue.Queue()
         self.is_connected = False
         
-        self.last_sent_angles = [90] * NUM_SERVOS
+        self.servo_sender = LatestValueSender(self.send_servo_angle, self.after, SERVO_SEND_RATE_HZ)
         self.angle_vars = []
         self.angle_labels = []
         self.servo_sliders = []
@@ -156,6 +74,7 @@ class ServoControllerApp(tk.Tk):
                                variable=angle_var, 
                                command=lambda value, index=i: self.on_slider_change(value, index))
             slider.grid(row=i, column=1, sticky="ew", padx=10, pady=5)
+            slider.bind("<ButtonRelease-1>", lambda event, index=i: self.servo_sender.flush(index))
             self.servo_sliders.append(slider)
             
             angle_label = ttk.Label(servo_group, text="90°", width=5)
@@ -167,10 +86,12 @@ class ServoControllerApp(tk.Tk):
         
         self.angle_labels[servo_index].config(text=f"{angle}°")
         
-        if angle != self.last_sent_angles[servo_index] and self.is_connected:
-            self.last_sent_angles[servo_index] = angle
-            if self.client_thread:
-                self.client_thread.send_servo_command(servo_index, angle)
+        if self.is_connected:
+            self.servo_sender.update(servo_index, angle)
+
+    def send_servo_angle(self, servo_index, angle):
+        if self.is_connected and self.client:
+            self.client.control_servo(angle, servo_index)
 
     # --- No other changes below this line ---
     # ... (rest of the code is unchanged) ...
@@ -186,19 +107,31 @@ class ServoControllerApp(tk.Tk):
         
         self.save_last_connection_info(ip, port)
         self.connect_button.config(text="Connecting...", state=tk.DISABLED)
-        self.client_thread = ESP32ClientThread(ip, port, self.gui_queue)
-        self.client_thread.start()
+        self.client = ESP32Client(ip, port, AUTH_PASSWORD)
+        threading.Thread(target=self._connect_worker, args=(self.client,), daemon=True).start()
+
+    def _connect_worker(self, client):
+        if client.connect() and client.authenticate():
+            client.register_connection_callback(self.on_connection_event)
+            self.gui_queue.put({"status": "connected"})
+        else:
+            self.gui_queue.put({"status": "error", "message": client.error})
+            client.close()
+
+    def on_connection_event(self, connected, message):
+        if not connected: self.gui_queue.put({"status": "disconnected"})
 
     def disconnect_from_esp(self):
-        if self.client_thread and self.client_thread.is_alive():
-            self.client_thread.close()
+        if self.client: self.client.close()
 
     def process_queue(self):
         try:
             while True:
                 message = self.gui_queue.get_nowait()
                 if message["status"] == "connected": self.is_connected = True
-                elif message["status"] == "disconnected": self.is_connected = False
+                elif message["status"] == "disconnected":
+                    self.is_connected = False
+                    self.servo_sender.reset()
                 elif message["status"] == "error":
                     messagebox.showerror("Connection Error", message["message"])
                     self.is_connected = False
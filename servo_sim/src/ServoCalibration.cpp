@@ -0,0 +1,74 @@
+#include "ServoCalibration.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "Json.h"
+
+using esp32proto::Json;
+
+bool loadCalibration(const std::string& path, std::vector<JointCalibration>& joints, std::string* error) {
+    std::ifstream file(path);
+    if (!file) {
+        if (error) *error = "Cannot open " + path;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    Json doc;
+    if (!Json::parse(text.str(), doc, error)) return false;
+    if (!doc["joints"].isArray()) {
+        if (error) *error = "Missing \"joints\" array";
+        return false;
+    }
+
+    joints.clear();
+    const ServoParams defaults;
+    const std::vector<Json>& entries = doc["joints"].elements();
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Json& entry = entries[i];
+        JointCalibration joint;
+        joint.joint = static_cast<int>(entry["joint"].toInteger(static_cast<int64_t>(i)));
+        joint.params.delayMs = entry["delay_ms"].toDouble(defaults.delayMs);
+        joint.params.timeConstantMs = entry["time_constant_ms"].toDouble(defaults.timeConstantMs);
+        joint.params.maxSlewDps = entry["max_slew_dps"].toDouble(defaults.maxSlewDps);
+        joint.params.deadbandDeg = entry["deadband_deg"].toDouble(defaults.deadbandDeg);
+        joint.params.noiseDeg = entry["noise_deg"].toDouble(defaults.noiseDeg);
+        joint.rmsErrorDeg = entry["rms_error_deg"].toDouble();
+        joint.samples = static_cast<long>(entry["samples"].toDouble());
+        joints.push_back(joint);
+    }
+    return true;
+}
+
+bool saveCalibration(const std::string& path, const std::vector<JointCalibration>& joints) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) return false;
+
+    fprintf(file, "{\n    \"version\": 1,\n    \"joints\": [\n");
+    for (size_t i = 0; i < joints.size(); i++) {
+        const JointCalibration& joint = joints[i];
+        fprintf(file,
+                "        {\"joint\": %d, \"delay_ms\": %.2f, \"time_constant_ms\": %.2f, \"max_slew_dps\": %.1f, "
+                "\"deadband_deg\": %.3f, \"noise_deg\": %.3f, \"rms_error_deg\": %.3f, \"samples\": %ld}%s\n",
+                joint.joint, joint.params.delayMs, joint.params.timeConstantMs, joint.params.maxSlewDps,
+                joint.params.deadbandDeg, joint.params.noiseDeg, joint.rmsErrorDeg, joint.samples,
+                i + 1 < joints.size() ? "," : "");
+    }
+    fprintf(file, "    ]\n}\n");
+    return fclose(file) == 0;
+}
+
+std::vector<ServoParams> calibrationParams(const std::vector<JointCalibration>& joints, const ServoParams& fallback) {
+    int count = 0;
+    for (const JointCalibration& joint : joints) count = std::max(count, joint.joint + 1);
+
+    std::vector<ServoParams> params(count, fallback);
+    for (const JointCalibration& joint : joints) {
+        if (joint.joint >= 0) params[joint.joint] = joint.params;
+    }
+    return params;
+}
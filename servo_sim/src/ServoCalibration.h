@@ -0,0 +1,34 @@
+#ifndef SERVO_CALIBRATION_H
+#define SERVO_CALIBRATION_H
+
+#include <string>
+#include <vector>
+
+#include "ServoModel.h"
+
+// Per-joint plant parameters written by servo_fit and read by servo_sim and
+// the clients. File format (JSON):
+//
+// {
+//   "version": 1,
+//   "joints": [
+//     {"joint": 0, "delay_ms": 21.5, "time_constant_ms": 78.2, "max_slew_dps": 295.0,
+//      "deadband_deg": 1.1, "noise_deg": 0.31, "rms_error_deg": 0.42, "samples": 180000},
+//     ...
+//   ]
+// }
+struct JointCalibration {
+    int joint = 0;
+    ServoParams params;
+    double rmsErrorDeg = 0.0;  // fit quality, model vs recorded positions
+    long samples = 0;
+};
+
+bool loadCalibration(const std::string& path, std::vector<JointCalibration>& joints, std::string* error = nullptr);
+bool saveCalibration(const std::string& path, const std::vector<JointCalibration>& joints);
+
+// Expands a calibration into one ServoParams per joint index, using fallback
+// for joints missing from the file
+std::vector<ServoParams> calibrationParams(const std::vector<JointCalibration>& joints, const ServoParams& fallback);
+
+#endif
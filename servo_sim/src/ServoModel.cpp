@@ -0,0 +1,56 @@
+#include "ServoModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+ServoModel::ServoModel(const ServoParams& params, double initialAngle)
+    : params(params), commandedAngle(initialAngle), activeTarget(initialAngle), position(initialAngle) {
+}
+
+void ServoModel::command(double angle, double nowMs) {
+    commandedAngle = angle;
+    pending.push_back({nowMs + params.delayMs, angle});
+}
+
+void ServoModel::step(double nowMs, double dtMs) {
+    while (!pending.empty() && pending.front().applyAtMs <= nowMs) {
+        activeTarget = pending.front().angle;
+        pending.pop_front();
+    }
+
+    double error = activeTarget - position;
+
+    // Deadband with hysteresis: the controller starts correcting once the
+    // error leaves the band and keeps going until it is back at the target.
+    if (!tracking && std::fabs(error) > params.deadbandDeg) {
+        tracking = true;
+    }
+    if (!tracking) {
+        velocity = 0.0;
+        return;
+    }
+
+    double dt = dtMs / 1000.0;
+    double tau = std::max(params.timeConstantMs, 1e-3) / 1000.0;
+    double desired = std::clamp(error / tau, -params.maxSlewDps, params.maxSlewDps);
+
+    // Don't overshoot in one step when tau is close to the step size
+    double moveBy = desired * dt;
+    if (std::fabs(moveBy) > std::fabs(error)) moveBy = error;
+    position += moveBy;
+    velocity = moveBy / dt;
+
+    if (std::fabs(activeTarget - position) < 0.05) {
+        tracking = false;
+    }
+}
+
+double ServoModel::measure(std::mt19937_64& rng) {
+    if (params.noiseDeg <= 0.0) return position;
+    std::normal_distribution<double> noise(0.0, params.noiseDeg);
+    return position + noise(rng);
+}
+
+bool ServoModel::isSettled() const {
+    return pending.empty() && !tracking;
+}
@@ -0,0 +1,51 @@
+#ifndef SERVO_MODEL_H
+#define SERVO_MODEL_H
+
+#include <deque>
+#include <random>
+
+// Plant parameters of one hobby servo
+struct ServoParams {
+    double delayMs = 20.0;         // command to motion start (PWM frame + controller)
+    double timeConstantMs = 80.0;  // first-order lag towards the target
+    double maxSlewDps = 300.0;     // speed limit in degrees per second
+    double deadbandDeg = 1.0;      // errors smaller than this are not corrected
+    double noiseDeg = 0.3;         // standard deviation of the reported position
+};
+
+// First-order servo with transport delay, slew limit and deadband.
+// Advanced in fixed steps by the simulator, so a run is reproducible for a
+// given seed and command timeline.
+class ServoModel {
+public:
+    explicit ServoModel(const ServoParams& params = ServoParams(), double initialAngle = 90.0);
+
+    void setParams(const ServoParams& params) { this->params = params; }
+    const ServoParams& getParams() const { return params; }
+
+    // Queue a new target, it takes effect delayMs after nowMs
+    void command(double angle, double nowMs);
+    void step(double nowMs, double dtMs);
+
+    double getTarget() const { return commandedAngle; }  // last commanded angle
+    double getPosition() const { return position; }       // true shaft angle
+    double getVelocity() const { return velocity; }       // degrees per second
+    double measure(std::mt19937_64& rng);                  // position plus sensor noise
+    bool isSettled() const;
+
+private:
+    struct PendingCommand {
+        double applyAtMs;
+        double angle;
+    };
+
+    ServoParams params;
+    std::deque<PendingCommand> pending;
+    double commandedAngle;
+    double activeTarget;
+    double position;
+    double velocity = 0.0;
+    bool tracking = false;
+};
+
+#endif
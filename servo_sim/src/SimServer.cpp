@@ -0,0 +1,454 @@
+#include "SimServer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdarg>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using esp32proto::Json;
+
+namespace {
+
+const unsigned long HEARTBEAT_TIMEOUT = 300000;  // same as CommunicationModule
+const int LED_BOARD_MAX_CLIENTS = 5;
+const int POT_RAW = 2048;                        // the simulated pot rests in the middle
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+}
+
+SimServer::SimServer(const SimConfig& config)
+    : config(config), rng(config.seed) {
+    if (this->config.mode == FirmwareMode::LedBoard) {
+        this->config.servoCount = 1;
+    }
+    maxClients = this->config.mode == FirmwareMode::LedBoard ? LED_BOARD_MAX_CLIENTS : 1;
+
+    for (int i = 0; i < this->config.servoCount; i++) {
+        ServoParams params = i < int(this->config.perServo.size()) ? this->config.perServo[i] : this->config.servo;
+        servos.emplace_back(params, 90.0);
+    }
+}
+
+SimServer::~SimServer() {
+    for (size_t i = clients.size(); i > 0; i--) {
+        closeClient(i - 1);
+    }
+    if (listenFd >= 0) close(listenFd);
+    if (recordFile) fclose(recordFile);
+}
+
+bool SimServer::start() {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        perror("[SIM] socket");
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(config.port));
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(listenFd, 8) != 0 || !setNonBlocking(listenFd)) {
+        perror("[SIM] bind/listen");
+        return false;
+    }
+
+    socklen_t length = sizeof(address);
+    getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+    port = ntohs(address.sin_port);
+
+    if (!config.recordPath.empty()) {
+        recordFile = fopen(config.recordPath.c_str(), "w");
+        if (!recordFile) {
+            perror("[SIM] record file");
+            return false;
+        }
+        fprintf(recordFile, "t_ms,joint,kind,angle\n");
+    }
+
+    wallStart = std::chrono::steady_clock::now();
+    nowMs = 0.0;
+    nextStatusMs = config.statusIntervalMs;
+    nextRecordMs = 0.0;
+
+    log("TCP server started on port %d (%s, %d servo%s, %.1fx real time, seed %llu)",
+        port, config.mode == FirmwareMode::LedBoard ? "Esp-32_LED" : "servo_server",
+        config.servoCount, config.servoCount == 1 ? "" : "s", config.speed,
+        static_cast<unsigned long long>(config.seed));
+    return true;
+}
+
+void SimServer::run(volatile sig_atomic_t& stopRequested) {
+    std::vector<pollfd> fds;
+    while (!stopRequested) {
+        fds.clear();
+        // servo_server only looks for a new client while it has none
+        bool accepting = clients.size() < maxClients || config.mode == FirmwareMode::LedBoard;
+        fds.push_back({accepting ? listenFd : -1, POLLIN, 0});
+        for (const SimClient& client : clients) {
+            short events = POLLIN;
+            if (!client.output.empty()) events |= POLLOUT;
+            fds.push_back({client.fd, events, 0});
+        }
+
+        // Sleep until the next scheduled status push or telemetry sample
+        double waitSimMs = std::max(0.0, nextEventMs() - wallToSimMs());
+        int timeoutMs = static_cast<int>(std::min(50.0, std::ceil(waitSimMs / config.speed)));
+        int ready = poll(fds.data(), fds.size(), timeoutMs);
+        if (ready < 0 && errno != EINTR) {
+            perror("[SIM] poll");
+            return;
+        }
+
+        advanceTo(wallToSimMs());
+
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            acceptClients();
+        }
+        // Client order is stable within one iteration, closes happen afterwards
+        std::vector<size_t> closed;
+        for (size_t i = 1; i < fds.size() && i - 1 < clients.size(); i++) {
+            SimClient& client = clients[i - 1];
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                if (!readClient(client)) closed.push_back(i - 1);
+            }
+        }
+        for (size_t i = 0; i < clients.size(); i++) {
+            if (std::find(closed.begin(), closed.end(), i) != closed.end()) continue;
+            flushClient(clients[i]);
+            if (config.mode == FirmwareMode::LedBoard && nowMs - clients[i].lastActivityMs > HEARTBEAT_TIMEOUT) {
+                log("Removing inactive client: %s", clients[i].clientId.c_str());
+                closed.push_back(i);
+            }
+        }
+        std::sort(closed.rbegin(), closed.rend());
+        closed.erase(std::unique(closed.begin(), closed.end()), closed.end());
+        for (size_t index : closed) closeClient(index);
+    }
+}
+
+double SimServer::wallToSimMs() const {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - wallStart;
+    return elapsed.count() * config.speed;
+}
+
+double SimServer::nextEventMs() const {
+    double next = nowMs + 1000.0;
+    if (config.statusIntervalMs > 0) next = std::min(next, nextStatusMs);
+    if (recordFile) next = std::min(next, nextRecordMs);
+    return next;
+}
+
+void SimServer::advanceTo(double simMs) {
+    // Fixed steps keep the dynamics independent of how often poll() wakes up
+    while (nowMs + config.stepMs <= simMs) {
+        nowMs += config.stepMs;
+        for (ServoModel& servo : servos) {
+            servo.step(nowMs, config.stepMs);
+        }
+        if (recordFile && nowMs >= nextRecordMs) {
+            for (size_t i = 0; i < servos.size(); i++) {
+                recordRow(static_cast<int>(i), "pos", servos[i].measure(rng));
+            }
+            nextRecordMs += config.recordIntervalMs;
+        }
+        if (config.statusIntervalMs > 0 && nowMs >= nextStatusMs) {
+            sendStatusPush();
+            nextStatusMs += config.statusIntervalMs;
+        }
+    }
+}
+
+void SimServer::acceptClients() {
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) return;
+        setNonBlocking(fd);
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        if (clients.size() >= maxClients) {
+            // Esp-32_LED rejects extra clients, servo_server never accepts them
+            std::string full = "{\"status\":\"error\",\"message\":\"Server full\"}\r\n";
+            (void)!send(fd, full.data(), full.size(), MSG_NOSIGNAL);
+            close(fd);
+            log("Connection rejected: Server full");
+            continue;
+        }
+
+        SimClient client;
+        client.fd = fd;
+        client.lastActivityMs = nowMs;
+        client.clientId = "Client_" + std::to_string(nextClientNumber++);
+        clients.push_back(client);
+        log("New client connected: %s", client.clientId.c_str());
+
+        if (config.mode == FirmwareMode::LedBoard) {
+            sendLine(clients.back(), createResponseJson("auth_required",
+                "Send authentication: {\"command\":\"auth\",\"password\":\"your_password\"}"));
+        }
+        if (config.mode == FirmwareMode::ServoServer) return;
+    }
+}
+
+bool SimServer::readClient(SimClient& client) {
+    char buffer[4096];
+    while (true) {
+        ssize_t count = recv(client.fd, buffer, sizeof(buffer), 0);
+        if (count > 0) {
+            client.input.append(buffer, static_cast<size_t>(count));
+            continue;
+        }
+        if (count == 0) return false;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        if (errno == EINTR) continue;
+        return false;
+    }
+    client.receivedUs = micros();
+
+    size_t newline;
+    while (client.fd >= 0 && (newline = client.input.find('\n')) != std::string::npos) {
+        std::string line = client.input.substr(0, newline);
+        client.input.erase(0, newline + 1);
+        processLine(client, line);
+    }
+    return client.fd >= 0;
+}
+
+void SimServer::flushClient(SimClient& client) {
+    while (!client.output.empty()) {
+        ssize_t sent = send(client.fd, client.output.data(), client.output.size(), MSG_NOSIGNAL);
+        if (sent <= 0) return;
+        client.output.erase(0, static_cast<size_t>(sent));
+    }
+}
+
+void SimServer::closeClient(size_t index) {
+    flushClient(clients[index]);
+    if (clients[index].fd >= 0) close(clients[index].fd);
+    log("Client %s disconnected", clients[index].clientId.c_str());
+    clients.erase(clients.begin() + static_cast<long>(index));
+}
+
+void SimServer::sendLine(SimClient& client, const std::string& line) {
+    // Arduino's println terminates with \r\n
+    client.output += line;
+    client.output += "\r\n";
+}
+
+void SimServer::processLine(SimClient& client, const std::string& rawLine) {
+    std::string line = rawLine;
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+    if (config.mode == FirmwareMode::LedBoard && line.empty()) return;
+
+    log("Message from %s: %s", client.clientId.c_str(), line.c_str());
+    client.lastActivityMs = nowMs;
+
+    Json doc;
+    if (!Json::parse(line, doc)) {
+        if (config.mode == FirmwareMode::LedBoard) {
+            sendLine(client, createResponseJson("error", "Invalid JSON"));
+        } else {
+            sendLine(client, "{\"status\":\"error\",\"message\":\"Invalid JSON\"}");
+        }
+        return;
+    }
+    client.parsedUs = micros();
+
+    if (config.mode == FirmwareMode::LedBoard) {
+        processLedBoard(client, doc);
+    } else {
+        processServoServer(client, doc);
+    }
+}
+
+void SimServer::processServoServer(SimClient& client, const Json& doc) {
+    const std::string& command = doc["command"].toString();
+
+    if (command == "auth") {
+        if (doc["password"].toString() == config.password) {
+            client.authenticated = true;
+            log("Client authenticated successfully.");
+            sendLine(client, "{\"status\":\"success\",\"message\":\"Authenticated\"}");
+        } else {
+            log("Authentication failed.");
+            sendLine(client, "{\"status\":\"error\",\"message\":\"Authentication failed\"}");
+            flushClient(client);
+            close(client.fd);
+            client.fd = -1;
+        }
+    } else if (command == "set_servo") {
+        if (!client.authenticated) {
+            sendLine(client, "{\"status\":\"error\",\"message\":\"Not authenticated\"}");
+            return;
+        }
+        int servoIndex = int(doc["servo_index"].toInteger());
+        int angle = int(doc["angle"].toInteger());
+        if (servoIndex >= 0 && servoIndex < config.servoCount && angle >= 0 && angle <= 180) {
+            uint32_t writeUs = micros();
+            commandServo(servoIndex, angle);
+            sendLine(client, "{\"status\":\"success\"" + traceJson(client, doc, writeUs, micros()) + "}");
+        } else {
+            sendLine(client, "{\"status\":\"error\",\"message\":\"Invalid servo index or angle\"}");
+        }
+    }
+    // Unknown commands get no reply, like the firmware
+}
+
+void SimServer::processLedBoard(SimClient& client, const Json& doc) {
+    const std::string& command = doc["command"].toString();
+
+    if (!client.authenticated) {
+        if (command == "auth") {
+            if (doc["password"].toString() == config.password) {
+                client.authenticated = true;
+                sendLine(client, createResponseJson("success", "Authenticated"));
+                log("Client %s authenticated", client.clientId.c_str());
+            } else {
+                sendLine(client, createResponseJson("error", "Invalid password"));
+            }
+        } else {
+            sendLine(client, createResponseJson("error", "Authentication required"));
+        }
+        return;
+    }
+
+    if (command == "set_led") {
+        int ledNum = int(doc["led"].toInteger());
+        bool state = doc["state"].toBool();
+        if (ledNum >= 1 && ledNum <= 5) {
+            leds[ledNum - 1] = state;
+            sendLine(client, createResponseJson("success",
+                "LED " + std::to_string(ledNum) + " set to " + (state ? "ON" : "OFF")));
+        } else {
+            sendLine(client, createResponseJson("error", "Invalid LED number (1-5)"));
+        }
+    } else if (command == "set_all_leds") {
+        bool state = doc["state"].toBool();
+        std::fill(std::begin(leds), std::end(leds), state);
+        sendLine(client, createResponseJson("success", std::string("All LEDs set to ") + (state ? "ON" : "OFF")));
+    } else if (command == "set_servo") {
+        int angle = int(doc["angle"].toInteger());
+        if (angle >= 0 && angle <= 180) {
+            uint32_t writeUs = micros();
+            commandServo(0, angle);
+            uint32_t writtenUs = micros();
+            std::string response = createResponseJson("success", "Servo set to " + std::to_string(angle) + " degrees");
+            response.insert(response.size() - 1, traceJson(client, doc, writeUs, writtenUs));
+            sendLine(client, response);
+        } else {
+            sendLine(client, createResponseJson("error", "Invalid angle (0-180)"));
+        }
+    } else if (command == "get_status") {
+        sendLine(client, createStatusJson());
+    } else if (command == "ping") {
+        sendLine(client, createResponseJson("success", "pong"));
+    } else {
+        sendLine(client, createResponseJson("error", "Unknown command"));
+    }
+}
+
+void SimServer::commandServo(int index, int angle) {
+    servos[index].command(angle, nowMs);
+    recordRow(index, "cmd", angle);
+    log("Servo %d moved to %d degrees", index, angle);
+}
+
+uint32_t SimServer::micros() const {
+    auto elapsed = std::chrono::steady_clock::now() - wallStart;
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+}
+
+// Same fields as the arm firmware: commands carrying an "id" get it back
+// with the micros() of each handling stage, for the client's command trace
+std::string SimServer::traceJson(const SimClient& client, const Json& doc,
+                                 uint32_t writeUs, uint32_t writtenUs) const {
+    if (!doc["id"].isNumber()) return "";
+    char buffer[160];
+    snprintf(buffer, sizeof(buffer),
+             ",\"id\":%.0f,\"trace\":{\"rx\":%u,\"parsed\":%u,\"write\":%u,\"written\":%u,\"tx\":%u}",
+             doc["id"].toDouble(), client.receivedUs, client.parsedUs, writeUs, writtenUs, micros());
+    return buffer;
+}
+
+std::string SimServer::createResponseJson(const std::string& status, const std::string& message) const {
+    std::string json = "{\"status\":";
+    Json(status).dumpTo(json);
+    json += ",\"message\":";
+    Json(message).dumpTo(json);
+    json += ",\"timestamp\":" + std::to_string(millis()) + "}";
+    return json;
+}
+
+std::string SimServer::createStatusJson() {
+    char buffer[128];
+    std::string json = "{\"type\":\"status\",\"timestamp\":" + std::to_string(millis());
+
+    if (config.mode == FirmwareMode::LedBoard) {
+        json += ",\"leds\":[";
+        for (int i = 0; i < 5; i++) {
+            json += std::string(i ? "," : "") + "{\"id\":" + std::to_string(i + 1)
+                  + ",\"state\":" + (leds[i] ? "true" : "false") + "}";
+        }
+        json += "],\"buttons\":[";
+        for (int i = 0; i < 5; i++) {
+            json += std::string(i ? "," : "") + "{\"id\":" + std::to_string(i + 1) + ",\"pressed\":false}";
+        }
+        snprintf(buffer, sizeof(buffer), "],\"potentiometer\":{\"raw\":%d,\"voltage\":%.2f,\"percent\":%d}",
+                 POT_RAW, POT_RAW * 3.3 / 4095.0, POT_RAW * 100 / 4095);
+        json += buffer;
+        json += ",\"servo\":{\"angle\":" + std::to_string(static_cast<int>(servos[0].getTarget())) + "}";
+    }
+
+    // Simulator extension: commanded and measured angle of every servo
+    json += ",\"servos\":[";
+    for (size_t i = 0; i < servos.size(); i++) {
+        snprintf(buffer, sizeof(buffer), "%s{\"index\":%zu,\"angle\":%d,\"position\":%.2f}",
+                 i ? "," : "", i, static_cast<int>(servos[i].getTarget()), servos[i].measure(rng));
+        json += buffer;
+    }
+    json += "]}";
+    return json;
+}
+
+void SimServer::sendStatusPush() {
+    bool anyAuthenticated = false;
+    for (const SimClient& client : clients) anyAuthenticated |= client.authenticated;
+    if (!anyAuthenticated) return;
+
+    std::string status = createStatusJson();
+    for (SimClient& client : clients) {
+        if (client.authenticated) sendLine(client, status);
+    }
+}
+
+void SimServer::recordRow(int joint, const char* kind, double angle) {
+    if (!recordFile) return;
+    fprintf(recordFile, "%.1f,%d,%s,%.2f\n", nowMs, joint, kind, angle);
+}
+
+void SimServer::log(const char* format, ...) const {
+    if (!config.verbose) return;
+    fprintf(stderr, "[SIM %10.1f] ", nowMs);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
@@ -0,0 +1,108 @@
+#ifndef SIM_SERVER_H
+#define SIM_SERVER_H
+
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Json.h"
+#include "ServoModel.h"
+
+// Which firmware the simulator impersonates
+enum class FirmwareMode {
+    ServoServer,  // servo_server/src/main.cpp: 4 servos, one client, no challenge
+    LedBoard      // Esp-32_LED: challenge, LEDs, pot, 1 servo, 5 clients, status pushes
+};
+
+struct SimConfig {
+    FirmwareMode mode = FirmwareMode::ServoServer;
+    int port = 8080;
+    std::string password = "IoTDevice2024";
+    int servoCount = 4;
+    double speed = 1.0;               // simulated ms per wall ms
+    double stepMs = 1.0;              // physics step
+    uint64_t seed = 1;
+    int statusIntervalMs = 0;         // 0 disables status pushes
+    ServoParams servo;
+    std::vector<ServoParams> perServo; // overrides servo for the first entries
+    std::string recordPath;           // telemetry CSV, empty to disable
+    int recordIntervalMs = 20;
+    bool verbose = false;
+};
+
+// Linux TCP stand-in for the ESP32 firmware. Speaks the same line based JSON
+// protocol and drives simulated servos in a fixed-step simulation clock that
+// can run faster than real time.
+class SimServer {
+public:
+    explicit SimServer(const SimConfig& config);
+    ~SimServer();
+
+    bool start();
+    void run(volatile sig_atomic_t& stopRequested);
+    int boundPort() const { return port; }
+
+private:
+    struct SimClient {
+        int fd = -1;
+        std::string input;
+        std::string output;
+        bool authenticated = false;
+        double lastActivityMs = 0.0;
+        std::string clientId;
+        // micros() when the line being processed was read and parsed
+        uint32_t receivedUs = 0;
+        uint32_t parsedUs = 0;
+    };
+
+    // Clock and physics
+    double wallToSimMs() const;
+    void advanceTo(double simMs);
+    double nextEventMs() const;
+    unsigned long millis() const { return static_cast<unsigned long>(nowMs); }
+    // Wall clock like the firmware's micros(), command traces measure real time
+    uint32_t micros() const;
+
+    // Sockets
+    void acceptClients();
+    bool readClient(SimClient& client);
+    void flushClient(SimClient& client);
+    void closeClient(size_t index);
+    void sendLine(SimClient& client, const std::string& line);
+
+    // Protocol
+    void processLine(SimClient& client, const std::string& line);
+    void processServoServer(SimClient& client, const esp32proto::Json& doc);
+    void processLedBoard(SimClient& client, const esp32proto::Json& doc);
+    void commandServo(int index, int angle);
+    std::string traceJson(const SimClient& client, const esp32proto::Json& doc, uint32_t writeUs, uint32_t writtenUs) const;
+    std::string createResponseJson(const std::string& status, const std::string& message) const;
+    std::string createStatusJson();
+    void sendStatusPush();
+
+    void recordRow(int joint, const char* kind, double angle);
+    void log(const char* format, ...) const;
+
+    SimConfig config;
+    int listenFd = -1;
+    int port = 0;
+    size_t maxClients;
+    std::vector<SimClient> clients;
+    int nextClientNumber = 1;
+
+    std::vector<ServoModel> servos;
+    std::mt19937_64 rng;
+    bool leds[5] = {false, false, false, false, false};
+
+    std::chrono::steady_clock::time_point wallStart;
+    double nowMs = 0.0;
+    double nextStatusMs = 0.0;
+    double nextRecordMs = 0.0;
+    FILE* recordFile = nullptr;
+};
+
+#endif
@@ -0,0 +1,132 @@
+/*
+ * ESP32 Servo Digital Twin - Linux stand-in for the firmware
+ *
+ * Speaks the TCP/JSON protocol of servo_server (default) or Esp-32_LED
+ * (--mode led) and simulates the servos with transport delay, first-order
+ * lag, slew limit, deadband and measurement noise. The simulation clock runs
+ * in fixed steps and can be sped up, and all randomness comes from --seed,
+ * so clients and trajectory tuning can be exercised without hardware.
+ *
+ * Usage:
+ *   servo_sim [--mode servo_server|led] [--port 8080] [--password IoTDevice2024]
+ *             [--servos 4] [--speed 1.0] [--step-ms 1] [--seed 1]
+ *             [--status-ms N] [--delay-ms 20] [--tau-ms 80] [--slew-dps 300]
+ *             [--deadband-deg 1] [--noise-deg 0.3] [--calibration calibration.json]
+ *             [--record telemetry.csv] [--record-ms 20] [--verbose]
+ *
+ * Status pushes ({"type":"status",...}) go out every --status-ms to
+ * authenticated clients; the default is 1000 in led mode (like the firmware)
+ * and off in servo_server mode. Both modes add a "servos" array with the
+ * commanded and measured angle of every servo.
+ *
+ * A set_servo carrying an "id" is answered with that id and a "trace" of
+ * wall clock micros() at each handling stage, like the arm firmware, so
+ * the Qt client's command trace works against the simulator too.
+ *
+ * --record writes a CSV of commands and sampled positions:
+ *   t_ms,joint,kind,angle     kind is "cmd" or "pos"
+ * servo_fit turns such a recording into a calibration file, which
+ * --calibration loads as per-servo parameters (the other flags apply to
+ * servos missing from the file).
+ */
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "ServoCalibration.h"
+#include "SimServer.h"
+
+namespace {
+
+volatile sig_atomic_t stopRequested = 0;
+
+void onSignal(int) {
+    stopRequested = 1;
+}
+
+void printUsage(const char* program) {
+    fprintf(stderr,
+            "usage: %s [--mode servo_server|led] [--port N] [--password P] [--servos N]\n"
+            "          [--speed X] [--step-ms X] [--seed N] [--status-ms N]\n"
+            "          [--delay-ms X] [--tau-ms X] [--slew-dps X] [--deadband-deg X] [--noise-deg X]\n"
+            "          [--calibration calibration.json]\n"
+            "          [--record file.csv] [--record-ms N] [--verbose]\n",
+            program);
+}
+
+bool parseArguments(int argc, char* argv[], SimConfig& config) {
+    int statusMs = -1;
+    std::string calibrationPath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--verbose") {
+            config.verbose = true;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        const char* value = argv[++i];
+
+        if (arg == "--mode") {
+            if (strcmp(value, "led") == 0) config.mode = FirmwareMode::LedBoard;
+            else if (strcmp(value, "servo_server") == 0) config.mode = FirmwareMode::ServoServer;
+            else return false;
+        }
+        else if (arg == "--port") config.port = atoi(value);
+        else if (arg == "--password") config.password = value;
+        else if (arg == "--servos") config.servoCount = atoi(value);
+        else if (arg == "--speed") config.speed = atof(value);
+        else if (arg == "--step-ms") config.stepMs = atof(value);
+        else if (arg == "--seed") config.seed = strtoull(value, nullptr, 10);
+        else if (arg == "--status-ms") statusMs = atoi(value);
+        else if (arg == "--delay-ms") config.servo.delayMs = atof(value);
+        else if (arg == "--tau-ms") config.servo.timeConstantMs = atof(value);
+        else if (arg == "--slew-dps") config.servo.maxSlewDps = atof(value);
+        else if (arg == "--deadband-deg") config.servo.deadbandDeg = atof(value);
+        else if (arg == "--noise-deg") config.servo.noiseDeg = atof(value);
+        else if (arg == "--calibration") calibrationPath = value;
+        else if (arg == "--record") config.recordPath = value;
+        else if (arg == "--record-ms") config.recordIntervalMs = atoi(value);
+        else return false;
+    }
+
+    if (!calibrationPath.empty()) {
+        std::vector<JointCalibration> joints;
+        std::string error;
+        if (!loadCalibration(calibrationPath, joints, &error)) {
+            fprintf(stderr, "Calibration: %s\n", error.c_str());
+            return false;
+        }
+        config.perServo = calibrationParams(joints, config.servo);
+    }
+
+    if (statusMs < 0) statusMs = config.mode == FirmwareMode::LedBoard ? 1000 : 0;
+    config.statusIntervalMs = statusMs;
+    return config.speed > 0.0 && config.stepMs > 0.0 && config.servoCount > 0
+        && config.recordIntervalMs > 0 && config.port >= 0 && config.port < 65536;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    SimConfig config;
+    if (!parseArguments(argc, argv, config)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    SimServer server(config);
+    if (!server.start()) return 1;
+
+    // Scripts using --port 0 read the chosen port from here
+    printf("Listening on port %d\n", server.boundPort());
+    fflush(stdout);
+
+    server.run(stopRequested);
+    return 0;
+}
@@ -0,0 +1,331 @@
+/*
+ * Servo model identification from recorded telemetry
+ *
+ * Reads a t_ms,joint,kind,angle CSV (as written by servo_sim --record or a
+ * client telemetry log; kind is "cmd" for a commanded angle and "pos" for a
+ * measured position) and fits the ServoModel parameters of every joint:
+ * transport delay, time constant, slew limit, deadband and sensor noise.
+ * The result is a calibration JSON for servo_sim --calibration and the
+ * clients.
+ *
+ * Usage:
+ *   servo_fit [--step-ms 1] [--rounds 3] telemetry.csv calibration.json
+ *
+ * Noise comes from the spread of second differences, slew and delay get
+ * initial guesses from the step responses, then all four dynamic
+ * parameters are refined by coordinate descent on the RMS error between
+ * the replayed model and the recording. Joints are fitted in parallel.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ServoCalibration.h"
+#include "ServoModel.h"
+
+namespace {
+
+struct Sample {
+    double t;
+    double angle;
+};
+
+struct JointLog {
+    std::vector<Sample> commands;
+    std::vector<Sample> positions;
+};
+
+struct FitOptions {
+    double stepMs = 1.0;
+    double coarseStepMs = 4.0;
+    int rounds = 3;
+};
+
+// Hand-rolled parser, hour-long logs are a few hundred thousand lines
+bool readLog(const std::string& path, std::map<int, JointLog>& joints, long& lines) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    lines = 0;
+    const char* p = data.c_str();
+    const char* end = p + data.size();
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!lineEnd) lineEnd = end;
+        // CRLF logs; strtod/strtol skip line breaks as whitespace, so every
+        // parse below must stop at stop or it reads the next line
+        const char* stop = lineEnd;
+        if (stop > p && stop[-1] == '\r') stop--;
+        if (stop == p) {
+            p = lineEnd + 1;
+            continue;
+        }
+
+        char* next = nullptr;
+        double t = strtod(p, &next);
+        if (next != p && next < stop && *next == ',') {
+            const char* field = next + 1;
+            long joint = strtol(field, &next, 10);
+            if (next != field && next < stop && *next == ',') {
+                const char* kind = next + 1;
+                const char* comma = static_cast<const char*>(memchr(kind, ',', stop - kind));
+                if (comma) {
+                    double angle = strtod(comma + 1, &next);
+                    if (next != comma + 1 && next <= stop) {
+                        JointLog& log = joints[static_cast<int>(joint)];
+                        if (comma - kind == 3 && strncmp(kind, "cmd", 3) == 0) {
+                            log.commands.push_back({t, angle});
+                            lines++;
+                        } else if (comma - kind == 3 && strncmp(kind, "pos", 3) == 0) {
+                            log.positions.push_back({t, angle});
+                            lines++;
+                        }
+                    }
+                }
+            }
+        }
+        p = lineEnd + 1;
+    }
+
+    for (auto& entry : joints) {
+        auto byTime = [](const Sample& a, const Sample& b) { return a.t < b.t; };
+        std::stable_sort(entry.second.commands.begin(), entry.second.commands.end(), byTime);
+        std::stable_sort(entry.second.positions.begin(), entry.second.positions.end(), byTime);
+    }
+    return true;
+}
+
+double median(std::vector<double> values) {
+    if (values.empty()) return 0.0;
+    size_t middle = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+    return values[middle];
+}
+
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) return 0.0;
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// White noise adds 6 sigma^2 to the variance of second differences, the
+// median absolute deviation keeps real motion from inflating it.
+double estimateNoise(const JointLog& log) {
+    std::vector<double> second;
+    for (size_t i = 1; i + 1 < log.positions.size(); i++) {
+        second.push_back(std::fabs(log.positions[i - 1].angle - 2.0 * log.positions[i].angle + log.positions[i + 1].angle));
+    }
+    return 1.4826 * median(second) / std::sqrt(6.0);
+}
+
+// Fastest sustained motion, measured over ~100 ms so noise averages out
+double estimateSlew(const JointLog& log) {
+    std::vector<double> speeds;
+    size_t j = 0;
+    for (size_t i = 0; i < log.positions.size(); i++) {
+        while (j < log.positions.size() && log.positions[j].t - log.positions[i].t < 100.0) j++;
+        if (j >= log.positions.size()) break;
+        double dt = (log.positions[j].t - log.positions[i].t) / 1000.0;
+        speeds.push_back(std::fabs(log.positions[j].angle - log.positions[i].angle) / dt);
+    }
+    return std::max(10.0, percentile(speeds, 0.995));
+}
+
+// Time from a large command step until the position visibly starts moving
+double estimateDelay(const JointLog& log, double noise) {
+    std::vector<double> delays;
+    size_t k = 0;
+    double threshold = std::max(0.5, 4.0 * noise);
+    for (size_t c = 0; c < log.commands.size(); c++) {
+        const Sample& command = log.commands[c];
+        double nextCommand = c + 1 < log.commands.size() ? log.commands[c + 1].t : 1e300;
+        while (k < log.positions.size() && log.positions[k].t < command.t) k++;
+        if (k == 0 || k >= log.positions.size()) continue;
+
+        double before = log.positions[k - 1].angle;
+        if (std::fabs(command.angle - before) < 5.0) continue;
+        double direction = command.angle > before ? 1.0 : -1.0;
+        for (size_t i = k; i < log.positions.size() && log.positions[i].t < nextCommand; i++) {
+            if ((log.positions[i].angle - before) * direction > threshold) {
+                delays.push_back(log.positions[i].t - command.t);
+                break;
+            }
+        }
+    }
+    return delays.empty() ? 20.0 : median(delays);
+}
+
+// Replays the commands through the model and compares with the recording
+double simulationRms(const JointLog& log, const ServoParams& params, double stepMs) {
+    if (log.positions.empty()) return 0.0;
+
+    ServoParams exact = params;
+    exact.noiseDeg = 0.0;
+    ServoModel model(exact, log.positions.front().angle);
+
+    size_t nextCommand = 0;
+    double t = log.positions.front().t;
+    double sum = 0.0;
+    for (const Sample& sample : log.positions) {
+        // A settled servo stays put until the next command, skip ahead
+        if (model.isSettled() && (nextCommand >= log.commands.size() || log.commands[nextCommand].t > sample.t)) {
+            t += std::floor((sample.t - t) / stepMs) * stepMs;
+        }
+        while (t + stepMs <= sample.t) {
+            t += stepMs;
+            while (nextCommand < log.commands.size() && log.commands[nextCommand].t <= t) {
+                model.command(log.commands[nextCommand].angle, log.commands[nextCommand].t);
+                nextCommand++;
+            }
+            model.step(t, stepMs);
+        }
+        double error = model.getPosition() - sample.angle;
+        sum += error * error;
+    }
+    return std::sqrt(sum / log.positions.size());
+}
+
+// Golden-section search of one parameter, the others stay fixed
+void refine(const JointLog& log, ServoParams& params, double ServoParams::*field,
+            double low, double high, double stepMs, int iterations, double& bestRms) {
+    const double ratio = 0.6180339887498949;
+    double a = low, b = high;
+    double c = b - ratio * (b - a), d = a + ratio * (b - a);
+    ServoParams trial = params;
+    trial.*field = c;
+    double fc = simulationRms(log, trial, stepMs);
+    trial.*field = d;
+    double fd = simulationRms(log, trial, stepMs);
+
+    for (int i = 0; i < iterations; i++) {
+        if (fc < fd) {
+            b = d; d = c; fd = fc;
+            c = b - ratio * (b - a);
+            trial.*field = c;
+            fc = simulationRms(log, trial, stepMs);
+        } else {
+            a = c; c = d; fc = fd;
+            d = a + ratio * (b - a);
+            trial.*field = d;
+            fd = simulationRms(log, trial, stepMs);
+        }
+    }
+
+    double candidate = fc < fd ? c : d;
+    double candidateRms = std::min(fc, fd);
+    if (candidateRms < bestRms) {
+        params.*field = candidate;
+        bestRms = candidateRms;
+    }
+}
+
+JointCalibration fitJoint(int joint, const JointLog& log, const FitOptions& options) {
+    JointCalibration result;
+    result.joint = joint;
+    result.samples = static_cast<long>(log.positions.size());
+
+    ServoParams& params = result.params;
+    params.noiseDeg = estimateNoise(log);
+    params.maxSlewDps = estimateSlew(log);
+    params.delayMs = estimateDelay(log, params.noiseDeg);
+    params.deadbandDeg = std::max(0.1, 2.0 * params.noiseDeg);
+
+    double rms = 0.0;
+    for (int round = 0; round < options.rounds; round++) {
+        // Early rounds search wide on a coarse clock, the last one polishes
+        // at full resolution. Every round narrows the window.
+        bool last = round + 1 == options.rounds;
+        double stepMs = last ? options.stepMs : std::max(options.stepMs, options.coarseStepMs);
+        int iterations = last ? 8 : 12;
+        double scale = 1.0 / (round + 1);
+        rms = simulationRms(log, params, stepMs);
+
+        refine(log, params, &ServoParams::delayMs,
+               std::max(0.0, params.delayMs - 200.0 * scale), params.delayMs + 200.0 * scale,
+               stepMs, iterations, rms);
+        refine(log, params, &ServoParams::timeConstantMs,
+               std::max(1.0, params.timeConstantMs * (1.0 - 0.9 * scale)), params.timeConstantMs * (1.0 + 4.0 * scale),
+               stepMs, iterations, rms);
+        refine(log, params, &ServoParams::maxSlewDps,
+               params.maxSlewDps * (1.0 - 0.5 * scale), params.maxSlewDps * (1.0 + 1.0 * scale),
+               stepMs, iterations, rms);
+        refine(log, params, &ServoParams::deadbandDeg,
+               0.0, params.deadbandDeg + 5.0 * scale, stepMs, iterations, rms);
+    }
+    if (options.rounds == 0) rms = simulationRms(log, params, options.stepMs);
+    result.rmsErrorDeg = rms;
+    return result;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    FitOptions options;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--step-ms" && i + 1 < argc) options.stepMs = atof(argv[++i]);
+        else if (arg == "--rounds" && i + 1 < argc) options.rounds = atoi(argv[++i]);
+        else paths.push_back(arg);
+    }
+    if (paths.size() != 2 || options.stepMs <= 0.0 || options.rounds < 0) {
+        fprintf(stderr, "usage: %s [--step-ms 1] [--rounds 3] telemetry.csv calibration.json\n", argv[0]);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::map<int, JointLog> logs;
+    long lines = 0;
+    if (!readLog(paths[0], logs, lines)) {
+        fprintf(stderr, "Cannot read %s\n", paths[0].c_str());
+        return 1;
+    }
+    double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<JointCalibration> results;
+    std::vector<std::thread> workers;
+    for (const auto& entry : logs) {
+        if (entry.second.positions.size() < 10) {
+            fprintf(stderr, "Joint %d: not enough position samples, skipped\n", entry.first);
+            continue;
+        }
+        results.emplace_back();
+        results.back().joint = entry.first;
+    }
+    for (JointCalibration& result : results) {
+        workers.emplace_back([&result, &logs, &options]() {
+            result = fitJoint(result.joint, logs.at(result.joint), options);
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (results.empty()) {
+        fprintf(stderr, "No joint could be fitted\n");
+        return 1;
+    }
+    if (!saveCalibration(paths[1], results)) {
+        fprintf(stderr, "Cannot write %s\n", paths[1].c_str());
+        return 1;
+    }
+
+    printf("%-5s %9s %9s %10s %9s %8s %9s\n", "joint", "delay_ms", "tau_ms", "slew_dps", "deadband", "noise", "rms_deg");
+    for (const JointCalibration& result : results) {
+        printf("%-5d %9.1f %9.1f %10.1f %9.2f %8.2f %9.3f\n", result.joint, result.params.delayMs,
+               result.params.timeConstantMs, result.params.maxSlewDps, result.params.deadbandDeg,
+               result.params.noiseDeg, result.rmsErrorDeg);
+    }
+    printf("%ld rows parsed in %.3f s, fitted in %.3f s total\n", lines, parseSeconds, totalSeconds);
+    return 0;
+}